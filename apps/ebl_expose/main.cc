@@ -0,0 +1,242 @@
+// main.cc - Dose maps of layout patterns from a simulated PSF
+#include "PSFResultFile.hh"
+#include "ExposureKernel.hh"
+#include "ExposureEngine.hh"
+#include "PatternSource.hh"
+#include "DoseMapFile.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4UnitsTable.hh"
+#include "G4ios.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    // Widest kernel accepted; the FFT tiles are at least twice as wide
+    const G4int kMaxKernelWidth = 4096;
+
+    // Physical memory not in use, 0 if unknown
+    std::size_t AvailableMemory()
+    {
+#ifdef _WIN32
+        MEMORYSTATUSEX status;
+        status.dwLength = sizeof(status);
+        return GlobalMemoryStatusEx(&status) ? static_cast<std::size_t>(status.ullAvailPhys) : 0;
+#elif defined(_SC_AVPHYS_PAGES)
+        long pages = sysconf(_SC_AVPHYS_PAGES);
+        long pageSize = sysconf(_SC_PAGESIZE);
+        return pages > 0 && pageSize > 0 ? static_cast<std::size_t>(pages) * pageSize : 0;
+#else
+        return 0;
+#endif
+    }
+
+    std::string FormatBytes(std::size_t bytes)
+    {
+        std::ostringstream text;
+        text.precision(3);
+        if (bytes >= (std::size_t(1) << 30)) text << bytes / G4double(1 << 30) << " GiB";
+        else text << bytes / G4double(1 << 20) << " MiB";
+        return text.str();
+    }
+}
+
+// Function to print usage info
+void PrintUsage()
+{
+    G4cerr << "Usage: ebl_expose --psf RESULT (--bitmap FILE | --rects FILE) --pixel NM -o OUTPUT [OPTION]..." << G4endl;
+    G4cerr << "Convolves a pattern with the PSF of a run (ebl_psf_result.bin) and writes" << G4endl;
+    G4cerr << "the absorbed energy density in the resist (eV/nm^3) as a float32 .npy map." << G4endl;
+    G4cerr << "Options:" << G4endl;
+    G4cerr << "  --psf FILE         PSF result file of the run (or of ebl_merge)" << G4endl;
+    G4cerr << "  --point N          Sweep point of the PSF (default 0)" << G4endl;
+    G4cerr << "  --bitmap FILE      PBM/PGM pattern, one pixel per map pixel" << G4endl;
+    G4cerr << "  --rects FILE       Rectangle list, \"x0 y0 x1 y1 [dose]\" in nm per line" << G4endl;
+    G4cerr << "  --margin NM        Field margin around the rectangles (default 0)" << G4endl;
+    G4cerr << "  --pixel NM         Pixel size" << G4endl;
+    G4cerr << "  --dose UC_CM2      Nominal dose in uC/cm^2 (default 100)" << G4endl;
+    G4cerr << "  --radius UM        Kernel radius (default: outer PSF edge)" << G4endl;
+    G4cerr << "  --fft N            FFT tile size, a power of two (default: from the kernel)" << G4endl;
+    G4cerr << "  --threads N        Worker threads (default: all hardware threads)" << G4endl;
+    G4cerr << "  --max-memory GB    Memory budget; fewer threads if needed (default: free memory)" << G4endl;
+    G4cerr << "  -o OUTPUT          Dose map (.npy)" << G4endl;
+    G4cerr << "  -h                 Print this help and exit" << G4endl;
+}
+
+int main(int argc, char** argv)
+{
+    G4String psfFile;
+    G4String bitmapFile;
+    G4String rectFile;
+    G4String output;
+    G4int point = 0;
+    G4double pixelSize = 0.;
+    G4double dose = 100. * microcoulomb / cm2;
+    G4double radius = 0.;
+    G4double margin = 0.;
+    G4int fftSize = 0;
+    G4int numThreads = 0;
+    G4double maxMemory = 0.;
+
+    for (G4int i = 1; i < argc; i++) {
+        G4String arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            PrintUsage();
+            return 0;
+        }
+        else if (arg == "--psf" && i + 1 < argc) {
+            psfFile = argv[++i];
+        }
+        else if (arg == "--point" && i + 1 < argc) {
+            point = std::stoi(argv[++i]);
+        }
+        else if (arg == "--bitmap" && i + 1 < argc) {
+            bitmapFile = argv[++i];
+        }
+        else if (arg == "--rects" && i + 1 < argc) {
+            rectFile = argv[++i];
+        }
+        else if (arg == "--margin" && i + 1 < argc) {
+            margin = std::stod(argv[++i]) * nm;
+        }
+        else if (arg == "--pixel" && i + 1 < argc) {
+            pixelSize = std::stod(argv[++i]) * nm;
+        }
+        else if (arg == "--dose" && i + 1 < argc) {
+            dose = std::stod(argv[++i]) * microcoulomb / cm2;
+        }
+        else if (arg == "--radius" && i + 1 < argc) {
+            radius = std::stod(argv[++i]) * micrometer;
+        }
+        else if (arg == "--fft" && i + 1 < argc) {
+            fftSize = std::stoi(argv[++i]);
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            numThreads = std::stoi(argv[++i]);
+        }
+        else if (arg == "--max-memory" && i + 1 < argc) {
+            maxMemory = std::stod(argv[++i]) * (1 << 30);
+        }
+        else if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        }
+        else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (psfFile.empty() || output.empty() || pixelSize <= 0. ||
+        bitmapFile.empty() == rectFile.empty()) {
+        PrintUsage();
+        return 1;
+    }
+
+    PSFResultFile result;
+    if (!result.Read(psfFile)) return 1;
+    if (point < 0 || point >= result.GetNumberOfPoints()) {
+        G4cerr << "Error: " << psfFile << " has " << result.GetNumberOfPoints() << " sweep points" << G4endl;
+        return 1;
+    }
+    if (result.GetResistThickness() <= 0.) {
+        G4cerr << "Error: " << psfFile << " does not record the resist thickness" << G4endl;
+        return 1;
+    }
+
+    ExposureKernel kernel;
+    if (!kernel.Build(result, point, pixelSize, radius)) return 1;
+    if (kernel.GetWidth() > kMaxKernelWidth) {
+        G4cerr << "Error: kernel of " << kernel.GetWidth() << " pixels is wider than " << kMaxKernelWidth
+            << "; use a larger --pixel or a smaller --radius" << G4endl;
+        return 1;
+    }
+
+    std::unique_ptr<PatternSource> pattern;
+    if (!bitmapFile.empty()) {
+        auto bitmap = std::make_unique<BitmapPattern>();
+        if (!bitmap->Open(bitmapFile)) return 1;
+        pattern = std::move(bitmap);
+    }
+    else {
+        auto rects = std::make_unique<RectanglePattern>();
+        if (!rects->Open(rectFile, pixelSize, margin)) return 1;
+        G4cout << rectFile << ": " << rects->GetNumberOfRectangles() << " rectangles" << G4endl;
+        pattern = std::move(rects);
+    }
+
+    // Every thread holds an N x N complex tile besides the shared kernel
+    // spectrum: fit the thread count into the memory budget
+    fftSize = ExposureEngine::ChooseFFTSize(kernel, fftSize);
+    const G4int tilesPerStrip = (pattern->GetWidth() + fftSize - 2 * kernel.GetHalfWidth() - 1) /
+        (fftSize - 2 * kernel.GetHalfWidth());
+    if (numThreads <= 0) {
+        numThreads = std::max(1, static_cast<G4int>(std::thread::hardware_concurrency()));
+    }
+    numThreads = std::min(numThreads, tilesPerStrip);
+    const std::size_t sharedMemory =
+        ExposureEngine::GetSharedMemory(fftSize, kernel.GetHalfWidth(), pattern->GetWidth());
+    const std::size_t threadMemory = ExposureEngine::GetThreadMemory(fftSize);
+    const std::size_t budget = maxMemory > 0. ? static_cast<std::size_t>(maxMemory) : AvailableMemory();
+    if (budget > 0) {
+        if (sharedMemory + threadMemory > budget) {
+            G4cerr << "Error: FFT " << fftSize << " needs " << FormatBytes(sharedMemory + threadMemory)
+                << " with one thread, above the " << FormatBytes(budget)
+                << " budget; use a larger --pixel, a smaller --radius or --max-memory" << G4endl;
+            return 1;
+        }
+        G4int fitting = static_cast<G4int>(std::min<std::size_t>((budget - sharedMemory) / threadMemory,
+                                                                 numThreads));
+        if (fitting < numThreads) {
+            G4cout << "Memory: " << FormatBytes(budget) << " budget, using " << fitting
+                << " of " << numThreads << " threads" << G4endl;
+            numThreads = fitting;
+        }
+    }
+    G4cout << "Memory: " << FormatBytes(sharedMemory + numThreads * threadMemory) << " ("
+        << FormatBytes(sharedMemory) << " shared + " << numThreads << " x "
+        << FormatBytes(threadMemory) << " per thread)" << G4endl;
+
+    ExposureEngine engine(kernel, fftSize, numThreads);
+
+    G4cout << "PSF: " << psfFile << ", " << G4BestUnit(result.GetBeamEnergy(point), "Energy")
+        << ", " << result.GetEvents(point) << " events" << G4endl;
+    G4cout << "Kernel: " << kernel.GetWidth() << " x " << kernel.GetWidth() << " pixels of "
+        << G4BestUnit(pixelSize, "Length") << ", radius " << G4BestUnit(kernel.GetRadius(), "Length")
+        << ", " << G4BestUnit(kernel.GetTotal(), "Energy") << " per electron" << G4endl;
+    G4cout << "Field: " << pattern->GetWidth() << " x " << pattern->GetHeight() << " pixels, "
+        << engine.GetTileSize() << " pixel tiles (FFT " << engine.GetFFTSize() << "), "
+        << engine.GetNumberOfThreads() << " threads" << G4endl;
+
+    // Primaries per pixel at the nominal dose; map pixels hold the energy
+    // deposited in the resist column under them
+    const G4double pixelArea = pixelSize * pixelSize;
+    const G4double electronsPerPixel = dose * pixelArea / eplus;
+    const G4double unit = pixelArea * result.GetResistThickness() * (eV / (nm * nm * nm));
+
+    DoseMapFile map;
+    if (!map.Open(output, pattern->GetWidth(), pattern->GetHeight())) return 1;
+
+    auto start = std::chrono::steady_clock::now();
+    G4bool ok = engine.Run(*pattern, electronsPerPixel,
+        [&](const std::vector<G4double>& row) { return map.WriteRow(row, unit); });
+    ok = map.Close() && ok;
+    auto seconds = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!ok) return 1;
+    G4cout << "Dose map saved to: " << output << " (peak " << map.GetMaximum() << " eV/nm^3, "
+        << seconds << " s)" << G4endl;
+    return 0;
+}
@@ -0,0 +1,142 @@
+// main.cc - Merge PSF result shards of independent runs
+#include "PSFResultFile.hh"
+#include "PSFExport.hh"
+#include "PSFConvolution.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    // beamer_psf.dat -> beamer_psf_30keV.dat for sweep points, as the run
+    // action names them
+    G4String PointFilename(const G4String& filename, const PSFResultFile& result, G4int point)
+    {
+        std::string name(filename);
+        if (result.GetNumberOfPoints() < 2) return name;
+
+        std::ostringstream suffix;
+        suffix << "_" << result.GetBeamEnergy(point) / CLHEP::keV << "keV";
+        size_t dot = name.find_last_of('.');
+        if (dot == std::string::npos) return name + suffix.str();
+        return name.substr(0, dot) + suffix.str() + name.substr(dot);
+    }
+}
+
+// Function to print usage info
+void PrintUsage()
+{
+    G4cerr << "Usage: ebl_merge -o OUTPUT [OPTION] SHARD..." << G4endl;
+    G4cerr << "Adds the tallies of PSF result files (.bin) of independent runs" << G4endl;
+    G4cerr << "with the same binning and beam energies; distinct seeds required." << G4endl;
+    G4cerr << "Options:" << G4endl;
+    G4cerr << "  -o OUTPUT          Merged PSF result file" << G4endl;
+    G4cerr << "  --csv FILE         Also write the merged PSF table" << G4endl;
+    G4cerr << "  --beamer FILE      Also write the merged BEAMER file(s)" << G4endl;
+    G4cerr << "  --spot NM          Also write the exports blurred by a Gaussian beam of" << G4endl;
+    G4cerr << "                     this FWHM (_spot<NM>nm files); repeatable" << G4endl;
+    G4cerr << "  -h                 Print this help and exit" << G4endl;
+}
+
+int main(int argc, char** argv)
+{
+    G4String output;
+    G4String csvFile;
+    G4String beamerFile;
+    std::vector<G4String> shards;
+    std::vector<G4double> spotSizes;
+
+    for (G4int i = 1; i < argc; i++) {
+        G4String arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            PrintUsage();
+            return 0;
+        }
+        else if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        }
+        else if (arg == "--csv" && i + 1 < argc) {
+            csvFile = argv[++i];
+        }
+        else if (arg == "--beamer" && i + 1 < argc) {
+            beamerFile = argv[++i];
+        }
+        else if (arg == "--spot" && i + 1 < argc) {
+            spotSizes.push_back(std::stod(argv[++i]) * nm);
+        }
+        else if (arg[0] != '-') {
+            shards.push_back(arg);
+        }
+        else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (output.empty() || shards.empty()) {
+        PrintUsage();
+        return 1;
+    }
+
+    PSFResultFile merged;
+    std::set<G4long> seeds;
+    for (size_t i = 0; i < shards.size(); i++) {
+        PSFResultFile shard;
+        if (!shard.Read(shards[i])) return 1;
+
+        // Shards run with the same seed repeat the same events; adding them
+        // would understate the error. Seed -1 means unknown.
+        if (shard.GetSeed() != -1 && !seeds.insert(shard.GetSeed()).second) {
+            G4cerr << "Error: " << shards[i] << " has the same seed (" << shard.GetSeed()
+                << ") as an earlier shard" << G4endl;
+            return 1;
+        }
+
+        if (i == 0) {
+            merged = shard;
+        }
+        else if (!merged.Merge(shard)) {
+            G4cerr << "Error: " << shards[i] << " does not match " << shards[0] << G4endl;
+            return 1;
+        }
+        G4cout << shards[i] << ": " << shard.GetTotalEvents() << " events, seed "
+            << shard.GetSeed() << G4endl;
+    }
+
+    G4cout << "Merged " << shards.size() << " shards, " << merged.GetTotalEvents()
+        << " events" << G4endl;
+
+    if (!merged.Write(output)) return 1;
+    G4cout << "PSF result saved to: " << output << G4endl;
+
+    G4bool ok = true;
+    if (!csvFile.empty()) {
+        ok = PSFExport::WriteCSV(merged, csvFile, merged.GetNumberOfPoints() > 1) && ok;
+    }
+    if (!beamerFile.empty()) {
+        for (G4int point = 0; point < merged.GetNumberOfPoints(); point++) {
+            ok = PSFExport::WriteBEAMER(merged, point, PointFilename(beamerFile, merged, point)) && ok;
+        }
+    }
+
+    // Spot-size PSFs of point-source shards, from the merged sums
+    for (G4double spotSize : spotSizes) {
+        PSFResultFile spot;
+        PSFConvolution::Gaussian(merged, spotSize, spot);
+        if (!csvFile.empty()) {
+            ok = PSFExport::WriteCSV(spot, PSFConvolution::SpotFilename(csvFile, spotSize),
+                                     spot.GetNumberOfPoints() > 1) && ok;
+        }
+        if (!beamerFile.empty()) {
+            G4String spotBeamer = PSFConvolution::SpotFilename(beamerFile, spotSize);
+            for (G4int point = 0; point < spot.GetNumberOfPoints(); point++) {
+                ok = PSFExport::WriteBEAMER(spot, point, PointFilename(spotBeamer, spot, point)) && ok;
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -1,9 +1,27 @@
-﻿// main.cc - Sequential Mode (No Multithreading)
+﻿// main.cc - Multithreaded/tasking run manager with reproducible seeding
 #include "DetectorConstruction.hh"
 #include "ActionInitialization.hh"
+#include "ScoringPipeline.hh"
 #include "PhysicsList.hh"
+#include "DataManager.hh"
+#include "PerfMonitor.hh"
+#include "TraceRecorder.hh"
+#include "ImportanceBiasing.hh"
+#include "BackscatterFastSim.hh"
+#include "ParameterSweep.hh"
+#include "ConvergenceControl.hh"
+#include "ShotList.hh"
+#include "ResultLibrary.hh"
+#include "PhaseSpace.hh"
+#include "PhysicsTableCache.hh"
+#include "DistributedRun.hh"
+#include "AsyncWriter.hh"
+#include "MasterSeed.hh"
 
 #include "G4RunManager.hh"
+#include "G4RunManagerFactory.hh"
+#include "G4MTRunManager.hh"
+#include "G4Threading.hh"
 #include "G4UImanager.hh"
 #include "G4UIcommand.hh"
 #include "G4VisExecutive.hh"
@@ -11,23 +29,50 @@
 #include "Randomize.hh"
 #include "G4SystemOfUnits.hh"
 
+#ifdef EBL_USE_MPI
+#include "G4MPImanager.hh"
+#include "G4MPIsession.hh"
+#endif
+
 #include <iostream>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
 
 // Function to print usage info
 void PrintUsage()
 {
     G4cerr << "Usage: ebl_sim [OPTION] [MACRO]" << G4endl;
     G4cerr << "Options:" << G4endl;
-    G4cerr << "  -m MACRO   Execute macro file" << G4endl;
-    G4cerr << "  -u         Start UI session" << G4endl;
-    G4cerr << "  -h         Print this help and exit" << G4endl;
+    G4cerr << "  -m MACRO           Execute macro file" << G4endl;
+    G4cerr << "  -u                 Start UI session" << G4endl;
+    G4cerr << "  -t, --threads N    Number of worker threads (default: all cores)" << G4endl;
+    G4cerr << "  --serial           Use the sequential run manager" << G4endl;
+    G4cerr << "  --mt               Use the classic MT run manager instead of tasking" << G4endl;
+    G4cerr << "  --seed S           Master random seed (default: time-based)" << G4endl;
+    G4cerr << "  --resume DIR       Continue the batched run checkpointed in DIR" << G4endl;
+    G4cerr << "  --scoring MODE     Scoring pipeline: radial (default), depth, weighted, full" << G4endl;
+    G4cerr << "                     or diagnostics" << G4endl;
+    G4cerr << "  -h                 Print this help and exit" << G4endl;
+#ifdef EBL_USE_MPI
+    G4cerr << "Under mpirun every rank runs the macro with its own seed stream;" << G4endl;
+    G4cerr << "rank 0 writes the output of all ranks." << G4endl;
+#endif
 }
 
 int main(int argc, char** argv)
 {
+    // Time origin of the /ebl/perf/trace timeline
+    TraceRecorder::Instance();
+
     // Parse command line options
     G4String macro;
     G4bool interactive = false;
+    G4int nThreads = 0;
+    G4bool seedGiven = false;
+    std::uint64_t seed = 0;
+    G4String resumeDirectory;
+    G4RunManagerType runManagerType = G4RunManagerType::Tasking;
 
     for (G4int i = 1; i < argc; i++) {
         G4String arg = argv[i];
@@ -42,6 +87,34 @@ int main(int argc, char** argv)
         else if (arg == "-m" && i + 1 < argc) {
             macro = argv[++i];
         }
+        else if ((arg == "-t" || arg == "--threads") && i + 1 < argc) {
+            nThreads = std::atoi(argv[++i]);
+            if (nThreads < 1) {
+                G4cerr << "Error: thread count must be at least 1" << G4endl;
+                return 1;
+            }
+        }
+        else if (arg == "--serial") {
+            runManagerType = G4RunManagerType::SerialOnly;
+        }
+        else if (arg == "--mt") {
+            runManagerType = G4RunManagerType::MT;
+        }
+        else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+            seedGiven = true;
+        }
+        else if (arg == "--resume" && i + 1 < argc) {
+            resumeDirectory = argv[++i];
+        }
+        else if (arg == "--scoring" && i + 1 < argc) {
+            Scoring::Mode mode;
+            if (!Scoring::ParseMode(argv[++i], mode)) {
+                G4cerr << "Error: unknown scoring mode " << argv[i] << G4endl;
+                return 1;
+            }
+            Scoring::SetMode(mode);
+        }
         else if (arg[0] != '-') {
             // Assume it's a macro filename
             macro = arg;
@@ -52,14 +125,73 @@ int main(int argc, char** argv)
         }
     }
 
-    // Choose the Random engine and initialize with time-based seed
+#ifdef EBL_USE_MPI
+    // Initializes MPI; macro commands executed through it reach every rank
+    G4MPImanager* g4MPI = new G4MPImanager();
+#endif
+    const G4int rank = DistributedRun::Instance()->GetRank();
+
+    if (nThreads == 0) {
+        nThreads = G4Threading::G4GetNumberOfCores();
+    }
+    if (nThreads == 1 && runManagerType != G4RunManagerType::SerialOnly) {
+        runManagerType = G4RunManagerType::Serial;
+    }
+
+    // Choose the Random engine. Without --seed we still fall back to a
+    // time-based seed, but it is printed so the run can be repeated.
     CLHEP::HepRandom::setTheEngine(new CLHEP::RanecuEngine());
-    G4long seed = static_cast<G4long>(time(NULL));
-    CLHEP::HepRandom::setTheSeed(seed);
+    if (!seedGiven) {
+        seed = static_cast<std::uint64_t>(time(NULL));
+    }
+#ifdef EBL_USE_MPI
+    // Time-based seeds differ between nodes; all ranks use the one of rank 0
+    std::uint64_t rankSeed = seed;
+    MPI_Bcast(&rankSeed, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+    seed = rankSeed;
+#endif
+    MasterSeed::Apply(seed, rank);
+    DataManager::Instance()->SetRunSeed(static_cast<G4long>(seed));
+    G4cout << "====> Random seed: " << seed
+        << (seedGiven ? "" : " (time-based, pass --seed to reproduce)") << G4endl;
+    if (DistributedRun::Instance()->IsDistributed()) {
+        G4cout << "====> MPI rank " << rank << " of " << DistributedRun::Instance()->GetSize()
+            << G4endl;
+    }
 
-    // Construct the sequential run manager
-    G4RunManager* runManager = new G4RunManager();
-    G4cout << "====> Running in sequential mode" << G4endl;
+    // Construct the run manager (task-based by default)
+    G4RunManager* runManager =
+        G4RunManagerFactory::CreateRunManager(runManagerType, nThreads);
+
+    if (auto* mtRunManager = dynamic_cast<G4MTRunManager*>(runManager)) {
+        // Seeds are generated per event (not per event bunch), which keeps
+        // results independent of /run/eventModulo and of thread scheduling
+        mtRunManager->SetSeedOncePerCommunication(0);
+        G4cout << "====> Running with " << mtRunManager->GetNumberOfThreads()
+            << " worker threads" << G4endl;
+    }
+    else {
+        G4cout << "====> Running in sequential mode" << G4endl;
+    }
+
+    // Create the process-wide helpers on the master so their /ebl/perf/,
+    // /ebl/bias/, /ebl/fastsim/, /ebl/sweep/, /ebl/cache/, /ebl/run/, /ebl/shots/,
+    // /ebl/library/ and /ebl/phasespace/ commands are registered before any macro runs
+    PerfMonitor::Instance();
+    ImportanceBiasing::Instance();
+    BackscatterFastSim::Instance();
+    ParameterSweep::Instance();
+    PhysicsTableCache::Instance();
+    ConvergenceControl::Instance();
+    ShotList::Instance();
+    ResultLibrary::Instance();
+    PhaseSpace::Instance();
+
+    // The next /ebl/run/beamOn or /ebl/run/converge of the macro picks up
+    // the checkpoint (tallies, event count, seed and engine state)
+    if (!resumeDirectory.empty()) {
+        ConvergenceControl::Instance()->Resume(resumeDirectory);
+    }
 
     // Set mandatory user initialization classes
     DetectorConstruction* detConstruction = new DetectorConstruction();
@@ -71,9 +203,6 @@ int main(int argc, char** argv)
     ActionInitialization* actionInitialization = new ActionInitialization(detConstruction);
     runManager->SetUserInitialization(actionInitialization);
 
-    // Initialize G4 kernel
-    runManager->Initialize();
-
     // Initialize visualization
     G4VisManager* visManager = new G4VisExecutive("Quiet");
     visManager->Initialize();
@@ -82,14 +211,30 @@ int main(int argc, char** argv)
     G4UImanager* UImanager = G4UImanager::GetUIpointer();
 
     if (!macro.empty()) {
-        // Batch mode - execute macro
+        // Batch mode - execute macro. The macro calls /run/initialize
+        // itself, so PreInit-only commands before it (e.g.
+        // /process/em/preset) take effect.
+#ifdef EBL_USE_MPI
+        g4MPI->ExecuteMacroFile(macro, true);
+#else
         G4String command = "/control/execute " + macro;
         UImanager->ApplyCommand(command);
+#endif
+    }
+#ifdef EBL_USE_MPI
+    else if (interactive) {
+        // Commands typed on rank 0 are broadcast; no visualization
+        runManager->Initialize();
+        g4MPI->GetMPIsession()->SessionStart();
     }
+#else
     else if (interactive) {
         // Interactive mode with visualization
         G4UIExecutive* ui = new G4UIExecutive(argc, argv);
 
+        // Initialize G4 kernel
+        runManager->Initialize();
+
         // Initialize default visualization
         UImanager->ApplyCommand("/control/execute macros/runs/init_vis.mac");
 
@@ -97,6 +242,7 @@ int main(int argc, char** argv)
         ui->SessionStart();
         delete ui;
     }
+#endif
     else {
         // No macro or UI specified - just run a simple simulation
         UImanager->ApplyCommand("/run/initialize");
@@ -104,9 +250,13 @@ int main(int argc, char** argv)
         UImanager->ApplyCommand("/run/beamOn 1000");
     }
 
-    // Job termination
+    // Job termination, once the queued output files are written
+    AsyncWriter::Instance()->Flush();
     delete visManager;
+#ifdef EBL_USE_MPI
+    delete g4MPI;
+#endif
     delete runManager;
 
     return 0;
-}
\ No newline at end of file
+}
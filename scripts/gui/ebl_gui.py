@@ -59,17 +59,40 @@ class SimulationWorker(QObject):
     """Worker thread for running simulations with optimized progress tracking"""
     output = Signal(str)
     progress = Signal(int)
+    status = Signal(dict)
     finished = Signal(bool, str)
 
-    def __init__(self, executable_path, macro_path, working_dir):
+    def __init__(self, executable_path, macro_path, working_dir, status_path=None):
         super().__init__()
         self.executable_path = executable_path
         self.macro_path = macro_path
         self.working_dir = working_dir
+        self.status_path = status_path
         self.process = None
         self.should_stop = False
         self.total_events = None
         self.last_reported_progress = -1
+        self.status_seen = False
+
+    def poll_status(self, interval=0.5):
+        """Poll the JSON status record written by ebl_sim (/ebl/perf/statusFile).
+
+        The file is replaced atomically, so every successful read is a
+        complete record; it is only re-read when its mtime changes.
+        """
+        last_mtime = None
+        while self.process is not None and self.process.poll() is None:
+            try:
+                mtime = os.path.getmtime(self.status_path)
+                if mtime != last_mtime:
+                    with open(self.status_path, 'r') as f:
+                        record = json.load(f)
+                    last_mtime = mtime
+                    self.status_seen = True
+                    self.status.emit(record)
+            except (OSError, ValueError):
+                pass
+            time.sleep(interval)
 
     def run_simulation(self):
         """Run the simulation in this thread with optimized progress tracking"""
@@ -108,21 +131,21 @@ class SimulationWorker(QObject):
                 creationflags=subprocess.CREATE_NO_WINDOW if platform.system() == 'Windows' else 0
             )
 
+            # Structured progress channel; stdout is only shown in the log
+            if self.status_path:
+                threading.Thread(target=self.poll_status, daemon=True).start()
+
             # OPTIMIZED progress tracking for large simulations
             line_count = 0
             max_gui_lines = 3000  # Reduce GUI overhead for large sims
 
-            # Enhanced tracking variables
+            # Fallback progress tracking when no status record arrives
             last_event_number = 0
-            energy_reports_count = 0
-            track_reports_count = 0
-            estimated_progress = 0
-            last_progress_update = time.time()
 
             # Keywords for filtering important output
             important_keywords = [
-                "Processing event", "Progress:", "Resist energy deposits:",
-                "StackingAction:", "ERROR", "WARNING", "Complete", "MeV", "Milestone"
+                "Processing event", "Progress:", "Batch", "Perf:",
+                "ERROR", "WARNING", "Complete", "MeV", "Milestone"
             ]
 
             while True:
@@ -154,64 +177,28 @@ class SimulationWorker(QObject):
                             self.total_events = int(match.group(1))
                             self.output.emit(f">>> Total events to process: {self.total_events}")
 
-                    # ENHANCED PROGRESS TRACKING
+                    # Progress from stdout only until the status record takes over
                     progress_updated = False
-                    current_time = time.time()
-
-                    # Method 1: Direct "Processing event X" messages
-                    if "Processing event" in line and "complete" in line:
-                        match = re.search(r'Processing event\s+(\d+)', line)
-                        if match:
-                            event_num = int(match.group(1))
-                            last_event_number = event_num
-                            self.progress.emit(event_num)
-                            progress_updated = True
-
-                    # Method 2: Milestone messages for very large sims
-                    elif "Milestone:" in line:
-                        match = re.search(r'(\d+)/(\d+) events', line)
-                        if match:
-                            event_num = int(match.group(1))
-                            last_event_number = event_num
-                            self.progress.emit(event_num)
-                            progress_updated = True
-
-                    # Method 3: Use energy deposition reports for estimation
-                    elif "Resist energy deposits:" in line and "Total energy:" in line:
-                        energy_reports_count += 1
-
-                        # Estimate based on energy reports (they come every ~10-20k events)
-                        if self.total_events and self.total_events > 50000:
-                            # Dynamic estimation based on simulation size
-                            if self.total_events <= 100000:
-                                estimate_factor = 8000
-                            elif self.total_events <= 1000000:
-                                estimate_factor = 12000
-                            else:
-                                estimate_factor = 20000  # For very large sims
-
-                            estimated_events = energy_reports_count * estimate_factor
-                            if estimated_events > last_event_number:
-                                estimated_progress = min(estimated_events, self.total_events)
-                                self.progress.emit(int(estimated_progress))
+                    if not self.status_seen:
+                        # Direct "Processing event X" messages
+                        if "Processing event" in line and "complete" in line:
+                            match = re.search(r'Processing event\s+(\d+)', line)
+                            if match:
+                                last_event_number = int(match.group(1))
+                                self.progress.emit(last_event_number)
                                 progress_updated = True
 
-                    # Method 4: Use track processing reports for very large sims
-                    elif "StackingAction: Processed" in line and "tracks" in line:
-                        track_reports_count += 1
-
-                        # For 1M+ events, use track reports as backup indicator
-                        if self.total_events and self.total_events >= 1000000:
-                            estimated_from_tracks = track_reports_count * 3000
-                            if estimated_from_tracks > max(last_event_number, estimated_progress):
-                                estimated_progress = min(estimated_from_tracks, self.total_events)
-                                if abs(estimated_progress - last_event_number) > 5000:
-                                    self.progress.emit(int(estimated_progress))
-                                    progress_updated = True
+                        # Milestone messages for very large sims
+                        elif "Milestone:" in line:
+                            match = re.search(r'(\d+)/(\d+) events', line)
+                            if match:
+                                last_event_number = int(match.group(1))
+                                self.progress.emit(last_event_number)
+                                progress_updated = True
 
                     # Report percentage progress with adaptive thresholds
                     if progress_updated and self.total_events and self.total_events > 0:
-                        current_progress = max(last_event_number, estimated_progress)
+                        current_progress = last_event_number
                         percentage = (current_progress / self.total_events) * 100
 
                         # Dynamic reporting threshold based on simulation size
@@ -417,10 +404,10 @@ class Enhanced2DPlotWidget(QWidget):
         if self.log_scale_check.isChecked():
             # Add small value to avoid log(0)
             energy_plot = np.log10(energy + 1e-10)
-            label = 'Log10(Energy Deposition) [eV/nm²]'
+            label = 'Log10(Energy Deposition) [eV/nm³]'
         else:
             energy_plot = energy
-            label = 'Energy Deposition [eV/nm²]'
+            label = 'Energy Deposition [eV/nm³]'
         
         # Create heatmap
         cmap = self.colormap_combo.currentText()
@@ -460,10 +447,10 @@ class Enhanced2DPlotWidget(QWidget):
         # Apply log scale if selected
         if self.log_scale_check.isChecked():
             energy_plot = np.log10(energy + 1e-10)
-            label = 'Log10(Energy) [eV/nm²]'
+            label = 'Log10(Energy) [eV/nm³]'
         else:
             energy_plot = energy
-            label = 'Energy [eV/nm²]'
+            label = 'Energy [eV/nm³]'
         
         # Create surface plot
         cmap = self.colormap_combo.currentText()
@@ -494,11 +481,11 @@ class Enhanced2DPlotWidget(QWidget):
         if self.log_scale_check.isChecked():
             energy_plot = np.log10(energy + 1e-10)
             levels = np.logspace(-2, np.log10(energy.max()), 20)
-            label = 'Energy Deposition [eV/nm²]'
+            label = 'Energy Deposition [eV/nm³]'
         else:
             energy_plot = energy
             levels = 20
-            label = 'Energy Deposition [eV/nm²]'
+            label = 'Energy Deposition [eV/nm³]'
         
         # Create contour plot
         cmap = self.colormap_combo.currentText()
@@ -539,7 +526,7 @@ class Enhanced2DPlotWidget(QWidget):
             ax1.set_yscale('log')
             ax1.set_xscale('log')
         ax1.set_xlabel('Radius [nm]')
-        ax1.set_ylabel('Energy Deposition [eV/nm²]')
+        ax1.set_ylabel('Energy Deposition [eV/nm³]')
         ax1.set_title(f'Radial Profile at Depth = {current_depth:.1f} nm')
         ax1.grid(True, alpha=0.3)
         
@@ -553,7 +540,7 @@ class Enhanced2DPlotWidget(QWidget):
         if self.log_scale_check.isChecked():
             ax2.set_yscale('log')
         ax2.set_xlabel('Depth [nm]')
-        ax2.set_ylabel('Energy Deposition [eV/nm²]')
+        ax2.set_ylabel('Energy Deposition [eV/nm³]')
         ax2.set_title('Depth Profiles at Various Radii')
         ax2.grid(True, alpha=0.3)
         ax2.legend()
@@ -757,11 +744,16 @@ class PlotWidget(QWidget):
     def load_data(self):
         """Load data from CSV file"""
         file_path, _ = QFileDialog.getOpenFileName(
-            self, "Load PSF Data", "", "CSV files (*.csv);;All files (*.*)"
+            self, "Load PSF Data", "",
+            "CSV files (*.csv);;PSF result files (*.bin);;All files (*.*)"
         )
 
         if file_path:
             try:
+                if file_path.endswith('.bin'):
+                    self.load_result_file(file_path)
+                    return
+
                 # Store the path for BEAMER conversion
                 self.current_csv_path = file_path
                 
@@ -790,6 +782,26 @@ class PlotWidget(QWidget):
             except Exception as e:
                 QMessageBox.critical(self, "Error", f"Failed to load data: {str(e)}")
 
+    def load_result_file(self, file_path):
+        """Load a binary PSF result (memory-mapped, first sweep point)"""
+        from psf_result import PSFResult
+
+        result = PSFResult(file_path)
+        if result.num_points > 1:
+            QMessageBox.information(self, "Energy Sweep",
+                f"{Path(file_path).name} holds {result.num_points} beam energies; "
+                f"showing {result.beam_energies[0]:g} keV")
+
+        # The BEAMER tools work on the CSV table, so export it next to the file
+        csv_path = str(Path(file_path).with_suffix('.csv'))
+        result.to_dataframe(point=0).to_csv(csv_path, index=False)
+        self.current_csv_path = csv_path
+
+        self.plot_data(result.centers, result.density(0),
+                       f"PSF - {Path(file_path).stem} ({result.beam_energies[0]:g} keV)")
+        self.beamer_button.setEnabled(True)
+        self.validate_button.setEnabled(True)
+
     def load_multiple(self):
         """Load multiple datasets for comparison"""
         file_paths, _ = QFileDialog.getOpenFileNames(
@@ -1817,6 +1829,10 @@ class EBLMainWindow(QMainWindow):
         self.visualization_check.setChecked(False)
         physics_layout.addWidget(self.visualization_check)
 
+        self.depth_scoring_check = QCheckBox("Score Depth Profile (2D tab)")
+        self.depth_scoring_check.setChecked(False)
+        physics_layout.addWidget(self.depth_scoring_check)
+
         physics_group.setLayout(physics_layout)
 
         # Control buttons
@@ -2513,6 +2529,11 @@ class EBLMainWindow(QMainWindow):
                 f.write(f"/ebl/output/setSummaryFile {summary_filename}\n")
                 f.write(f"/ebl/output/setBeamerFile {beamer_filename}\n\n")
 
+                if self.depth_scoring_check.isChecked():
+                    f.write("# Depth-resolved (r,z) scoring for the 2D tab\n")
+                    f.write("/ebl/psf/scoring depth\n")
+                    f.write("/ebl/psf/depth true\n\n")
+
                 # OPTIMIZED verbosity for large simulations
                 if num_events <= 10000:
                     verbose_level = min(self.verbose_spin.value(), 2)
@@ -2525,6 +2546,14 @@ class EBLMainWindow(QMainWindow):
                 f.write(f"/event/verbose {max(0, verbose_level-1)}\n")
                 f.write(f"/tracking/verbose 0\n\n")  # Always disable for performance
 
+                # Progress, rates and the live PSF come from the status
+                # record, so the run prints nothing while it runs
+                self.status_path = os.path.join(self.working_dir, "ebl_status.json")
+                f.write("# Structured progress channel polled by the GUI\n")
+                f.write(f"/ebl/perf/statusFile {self.status_path}\n")
+                f.write("/ebl/perf/interval 1 s\n")
+                f.write("/ebl/perf/print false\n\n")
+
                 # Add performance optimizations for large simulations
                 if num_events > 100000:
                     f.write("# Performance optimizations for large simulation\n")
@@ -2585,9 +2614,10 @@ class EBLMainWindow(QMainWindow):
                 elif self.visualization_check.isChecked():
                     f.write("# Visualization disabled for large simulation\n\n")
 
-                # Run simulation
+                # Run simulation in batches; every batch updates the live PSF
                 f.write("# Run simulation\n")
-                f.write(f"/run/beamOn {num_events}\n")
+                f.write(f"/ebl/run/batchSize {max(1000, num_events // 20)}\n")
+                f.write(f"/ebl/run/beamOn {num_events}\n")
 
             self.log_output(f"Optimized macro generated: {macro_path}")
             self.log_output(f"Target events: {num_events:,}")
@@ -2648,12 +2678,18 @@ class EBLMainWindow(QMainWindow):
 
         # Create worker thread
         self.simulation_thread = QThread()
-        self.simulation_worker = SimulationWorker(self.executable_path, macro_path, self.working_dir)
+        status_path = getattr(self, 'status_path', None)
+        if status_path and os.path.exists(status_path):
+            os.remove(status_path)  # stale record of an earlier run
+        self.live_psf_events = 0
+        self.simulation_worker = SimulationWorker(self.executable_path, macro_path, self.working_dir,
+                                                  status_path)
         self.simulation_worker.moveToThread(self.simulation_thread)
 
         # Connect signals
         self.simulation_worker.output.connect(self.log_output)
         self.simulation_worker.progress.connect(self.update_progress)
+        self.simulation_worker.status.connect(self.update_status)
         self.simulation_worker.finished.connect(self.simulation_finished)
         self.simulation_thread.started.connect(self.simulation_worker.run_simulation)
 
@@ -2799,6 +2835,27 @@ class EBLMainWindow(QMainWindow):
         progress = (event_num / self.events_spin.value()) * 100
         self.status_label.setText(f"Simulation running... {event_num}/{self.events_spin.value()} ({progress:.1f}%)")
 
+    def update_status(self, status):
+        """Show a status record of the running simulation: progress, rate, ETA, live PSF"""
+        events = status.get('events', 0)
+        if status.get('loop_events_target', 0) > 0:
+            events += status.get('loop_events_done', 0)
+        self.progress_bar.setValue(min(events, self.progress_bar.maximum()))
+
+        text = f"Simulation running... {events:,}/{self.events_spin.value():,}"
+        if status.get('rate'):
+            text += f" - {status['rate']:,.0f} events/s"
+        if status.get('eta_s') is not None:
+            text += f", ETA {time.strftime('%H:%M:%S', time.gmtime(status['eta_s']))}"
+        self.status_label.setText(text)
+
+        # Redraw the PSF only when a new batch has been merged
+        psf = status.get('psf')
+        if psf and psf.get('points') and psf.get('events', 0) != self.live_psf_events:
+            self.live_psf_events = psf['events']
+            self.plot_widget.plot_data(psf['radius_nm'], psf['points'][0]['density'],
+                                       title=f"Live PSF ({psf['events']:,} events)")
+
     def log_output(self, message):
         """Add message to output log"""
         timestamp = time.strftime("%H:%M:%S")
@@ -2893,6 +2950,7 @@ class EBLMainWindow(QMainWindow):
                     self.fluorescence_check.setChecked(config['simulation'].get('fluorescence', True))
                     self.auger_check.setChecked(config['simulation'].get('auger', True))
                     self.visualization_check.setChecked(config['simulation'].get('visualization', False))
+                    self.depth_scoring_check.setChecked(config['simulation'].get('depth_scoring', False))
                 
                 QMessageBox.information(self, "Success", "Configuration loaded successfully")
                 
@@ -2924,7 +2982,8 @@ class EBLMainWindow(QMainWindow):
                 'verbose': self.verbose_spin.value(),
                 'fluorescence': self.fluorescence_check.isChecked(),
                 'auger': self.auger_check.isChecked(),
-                'visualization': self.visualization_check.isChecked()
+                'visualization': self.visualization_check.isChecked(),
+                'depth_scoring': self.depth_scoring_check.isChecked()
             }
         }
         
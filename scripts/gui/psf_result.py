@@ -0,0 +1,272 @@
+"""
+Reader for the binary PSF result files written by ebl_sim (ebl_psf_result.bin)
+
+The file holds the raw radial tallies of a run - per-bin sums of the event
+deposits, sums of their squares and hit counts for every beam energy of a
+sweep - behind a fixed 192-byte header (src/common/src/PSFResultFile.cc).
+All arrays are mapped with numpy.memmap, so loading is independent of the
+number of bins. Densities, per-bin errors, the CSV table and the BEAMER
+export are derived from the sums, and results of independent runs merge
+losslessly.
+
+Usage:
+    python psf_result.py info ebl_psf_result.bin
+    python psf_result.py csv ebl_psf_result.bin -o ebl_psf_data.csv
+    python psf_result.py merge run1.bin run2.bin -o merged.bin
+"""
+
+import argparse
+import sys
+
+import numpy as np
+
+MAGIC = b"EBLPSF\x00\x00"
+VERSION = 1
+ALIGNMENT = 64
+
+FLAG_WEIGHTED = 1 << 0
+FLAG_MERGED = 1 << 1
+
+HEADER_DTYPE = np.dtype([
+    ("magic", "S8"),
+    ("version", "<u4"),
+    ("header_size", "<u4"),
+    ("binning_mode", "<u4"),
+    ("num_bins", "<u4"),
+    ("num_points", "<u4"),
+    ("flags", "<u4"),
+    ("total_events", "<i8"),
+    ("seed", "<i8"),
+    ("min_radius_nm", "<f8"),
+    ("max_radius_nm", "<f8"),
+    ("resist_thickness_nm", "<f8"),
+    ("resist_density_gcm3", "<f8"),
+    ("composition", "S64"),
+    ("edges_offset", "<u8"),
+    ("energies_offset", "<u8"),
+    ("events_offset", "<u8"),
+    ("sum_offset", "<u8"),
+    ("sum_squares_offset", "<u8"),
+    ("hits_offset", "<u8"),
+])
+assert HEADER_DTYPE.itemsize == 192
+
+
+class PSFResult:
+    """Memory-mapped PSF result; arrays are read-only views into the file"""
+
+    def __init__(self, path):
+        self.path = str(path)
+        header = np.fromfile(self.path, dtype=HEADER_DTYPE, count=1)
+        if len(header) != 1 or header["magic"][0] != MAGIC.rstrip(b"\x00"):
+            raise ValueError(f"{self.path} is not a PSF result file")
+        self.header = header[0]
+        if self.header["version"] != VERSION or self.header["header_size"] != HEADER_DTYPE.itemsize:
+            raise ValueError(f"{self.path} has PSF result format version "
+                             f"{self.header['version']}, expected {VERSION}")
+
+        n_bins = int(self.header["num_bins"])
+        n_points = int(self.header["num_points"])
+        self.edges = self._map("edges_offset", "<f8", (n_bins + 1,))
+        self.beam_energies = self._map("energies_offset", "<f8", (n_points,))
+        self.events = self._map("events_offset", "<i8", (n_points,))
+        self.sum = self._map("sum_offset", "<f8", (n_points, n_bins))
+        self.sum_squares = self._map("sum_squares_offset", "<f8", (n_points, n_bins))
+        self.hits = self._map("hits_offset", "<i8", (n_points, n_bins))
+
+    def _map(self, offset_field, dtype, shape):
+        return np.memmap(self.path, dtype=dtype, mode="r",
+                         offset=int(self.header[offset_field]), shape=shape)
+
+    # --- Metadata -------------------------------------------------------
+
+    @property
+    def num_bins(self):
+        return int(self.header["num_bins"])
+
+    @property
+    def num_points(self):
+        return int(self.header["num_points"])
+
+    @property
+    def binning(self):
+        return "log" if self.header["binning_mode"] == 1 else "linear"
+
+    @property
+    def seed(self):
+        return int(self.header["seed"])
+
+    @property
+    def weighted(self):
+        return bool(self.header["flags"] & FLAG_WEIGHTED)
+
+    @property
+    def merged(self):
+        return bool(self.header["flags"] & FLAG_MERGED)
+
+    @property
+    def resist_composition(self):
+        return self.header["composition"].decode("ascii", errors="replace")
+
+    # --- Derived quantities ---------------------------------------------
+
+    @property
+    def centers(self):
+        """Bin centres (nm), geometric for log binning as in PSFBinning"""
+        lower, upper = self.edges[:-1], self.edges[1:]
+        if self.binning == "log":
+            # The first bin is extended down to r = 0; its centre stays at
+            # the geometric mean of the minimum radius and its upper edge
+            lower = lower.copy()
+            lower[0] = self.header["min_radius_nm"]
+            return np.sqrt(lower * upper)
+        return 0.5 * (lower + upper)
+
+    @property
+    def areas(self):
+        """Annular bin areas (nm^2)"""
+        return np.pi * (self.edges[1:] ** 2 - self.edges[:-1] ** 2)
+
+    def mean(self, point=0):
+        """Mean deposit per event and bin (eV)"""
+        n = max(int(self.events[point]), 1)
+        return self.sum[point] / n
+
+    def error(self, point=0):
+        """Standard error of mean() per bin (eV)"""
+        n = max(int(self.events[point]), 1)
+        mean = self.sum[point] / n
+        variance = np.maximum(self.sum_squares[point] / n - mean ** 2, 0.0)
+        return np.sqrt(variance / max(n - 1, 1))
+
+    def density(self, point=0):
+        """Energy density per event (eV/nm^2), as in the CSV export"""
+        return self.mean(point) / self.areas
+
+    def density_error(self, point=0):
+        return self.error(point) / self.areas
+
+    def to_dataframe(self, point=None):
+        """CSV-equivalent table; all sweep points when point is None"""
+        import pandas as pd
+
+        points = range(self.num_points) if point is None else [point]
+        frames = []
+        for p in points:
+            frame = pd.DataFrame({
+                "Radius(nm)": self.centers,
+                "EnergyDeposition(eV/nm^2)": self.density(p),
+                "Error(eV/nm^2)": self.density_error(p),
+                "BinLower(nm)": self.edges[:-1],
+                "BinUpper(nm)": self.edges[1:],
+                "Events": int(self.events[p]),
+                "Hits": np.asarray(self.hits[p]),
+            })
+            if point is None and self.num_points > 1:
+                frame.insert(0, "BeamEnergy(keV)", float(self.beam_energies[p]))
+                frame.insert(0, "Point", p)
+            frames.append(frame)
+        return pd.concat(frames, ignore_index=True)
+
+    def describe(self):
+        lines = [
+            f"{self.path}: format version {int(self.header['version'])}",
+            f"  binning: {self.binning}, {self.num_bins} bins, "
+            f"{self.header['min_radius_nm']:g} - {self.header['max_radius_nm']:g} nm",
+            f"  resist: {self.resist_composition}, {self.header['resist_thickness_nm']:g} nm, "
+            f"{self.header['resist_density_gcm3']:g} g/cm3",
+            f"  events: {int(self.header['total_events'])}, seed: {self.seed}"
+            + (" (merged)" if self.merged else "")
+            + (", weighted (importance biasing)" if self.weighted else ""),
+        ]
+        for p in range(self.num_points):
+            lines.append(f"  point {p}: {self.beam_energies[p]:g} keV, {int(self.events[p])} events, "
+                         f"{float(self.sum[p].sum()) / 1e3:g} keV deposited")
+        return "\n".join(lines)
+
+
+def _align(offset):
+    return (offset + ALIGNMENT - 1) // ALIGNMENT * ALIGNMENT
+
+
+def write_result(path, header, edges, beam_energies, events, sums, sum_squares, hits):
+    """Write a result file with the layout of PSFResultFile::Write"""
+    header = np.array(header, dtype=HEADER_DTYPE)
+    n_points, n_bins = sums.shape
+    header["magic"] = MAGIC
+    header["version"] = VERSION
+    header["header_size"] = HEADER_DTYPE.itemsize
+    header["num_bins"] = n_bins
+    header["num_points"] = n_points
+    header["total_events"] = int(np.sum(events))
+
+    arrays = [
+        ("edges_offset", np.asarray(edges, dtype="<f8")),
+        ("energies_offset", np.asarray(beam_energies, dtype="<f8")),
+        ("events_offset", np.asarray(events, dtype="<i8")),
+        ("sum_offset", np.asarray(sums, dtype="<f8")),
+        ("sum_squares_offset", np.asarray(sum_squares, dtype="<f8")),
+        ("hits_offset", np.asarray(hits, dtype="<i8")),
+    ]
+    offset = _align(HEADER_DTYPE.itemsize)
+    for field, array in arrays:
+        header[field] = offset
+        offset = _align(offset + array.nbytes)
+
+    with open(path, "wb") as f:
+        f.write(header.tobytes())
+        for field, array in arrays:
+            f.seek(int(header[field]))
+            f.write(array.tobytes())
+
+
+def merge(paths, output):
+    """Add the tallies of independent runs with identical binning and energies"""
+    results = [PSFResult(p) for p in paths]
+    first = results[0]
+    for other in results[1:]:
+        if (other.binning != first.binning
+                or not np.array_equal(other.edges, first.edges)
+                or not np.array_equal(other.beam_energies, first.beam_energies)):
+            raise ValueError(f"{other.path}: binning or beam energies differ from {first.path}")
+        if other.weighted != first.weighted:
+            raise ValueError(f"{other.path}: cannot merge weighted and unweighted results")
+
+    header = np.array(first.header, dtype=HEADER_DTYPE)
+    header["flags"] |= FLAG_MERGED
+    write_result(output, header, first.edges, first.beam_energies,
+                 sum(np.asarray(r.events) for r in results),
+                 sum(np.asarray(r.sum) for r in results),
+                 sum(np.asarray(r.sum_squares) for r in results),
+                 sum(np.asarray(r.hits) for r in results))
+    return PSFResult(output)
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Inspect, export and merge PSF result files")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    info = commands.add_parser("info", help="print the run metadata")
+    info.add_argument("file")
+
+    csv = commands.add_parser("csv", help="export the CSV table")
+    csv.add_argument("file")
+    csv.add_argument("-o", "--output", required=True)
+    csv.add_argument("--point", type=int, default=None, help="single sweep point")
+
+    merge_cmd = commands.add_parser("merge", help="merge independent runs")
+    merge_cmd.add_argument("files", nargs="+")
+    merge_cmd.add_argument("-o", "--output", required=True)
+
+    args = parser.parse_args(argv)
+    if args.command == "info":
+        print(PSFResult(args.file).describe())
+    elif args.command == "csv":
+        PSFResult(args.file).to_dataframe(args.point).to_csv(args.output, index=False)
+    elif args.command == "merge":
+        print(merge(args.files, args.output).describe())
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
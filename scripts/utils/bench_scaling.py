@@ -0,0 +1,238 @@
+#!/usr/bin/env python3
+"""End-to-end throughput and thread-scaling suite for ebl_sim.
+
+Runs each reference macro with a fixed seed at 1, 2, 4, ... N threads and
+records, per run, events/s and resist steps/s (from the
+/ebl/perf/statusFile written at the end of the run; all steps/s too with
+--scoring diagnostics, whose SteppingAction counts them), the init time (wall time outside the event
+loop), the peak RSS and the scaling efficiency against the smallest thread
+count. Optionally runs ebl_bench (BUILD_BENCHMARKS) and includes its
+microbenchmarks. The results are written as JSON; with --baseline the rates
+are compared against a stored result and the script exits with status 1 if
+any dropped by more than the tolerance.
+
+Usage:
+    python scripts/utils/bench_scaling.py --ebl-sim build/bin/ebl_sim \\
+        --bench build/bin/ebl_bench --output bench.json
+    python scripts/utils/bench_scaling.py --ebl-sim build/bin/ebl_sim \\
+        --baseline bench_baseline.json
+"""
+
+import argparse
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+REPO_ROOT = Path(__file__).resolve().parents[2]
+DEFAULT_MACRO = REPO_ROOT / "macros" / "benchmarks" / "reference.mac"
+
+
+def default_threads():
+    """1, 2, 4, ... up to the number of CPUs (which is always included)."""
+    cpus = os.cpu_count() or 1
+    threads = []
+    n = 1
+    while n < cpus:
+        threads.append(n)
+        n *= 2
+    threads.append(cpus)
+    return threads
+
+
+def run_process(command, log_path):
+    """Run command with its output in log_path; return (wall seconds, peak RSS MB or None)."""
+    start = time.perf_counter()
+    with open(log_path, "w") as log:
+        process = subprocess.Popen(command, stdout=log, stderr=subprocess.STDOUT)
+        peak_rss = None
+        if hasattr(os, "wait4"):
+            # Per-child rusage; ru_maxrss is in kB on Linux, bytes on macOS
+            _, status, usage = os.wait4(process.pid, 0)
+            process.returncode = os.waitstatus_to_exitcode(status)
+            scale = 1024.0 * 1024.0 if sys.platform == "darwin" else 1024.0
+            peak_rss = usage.ru_maxrss / scale
+        else:
+            process.wait()
+    wall = time.perf_counter() - start
+    if process.returncode != 0:
+        raise RuntimeError(f"{command[0]} exited with {process.returncode}, see {log_path}")
+    return wall, peak_rss
+
+
+def rate(count, seconds):
+    return count / seconds if count and seconds > 0 else None
+
+
+def run_ebl_sim(ebl_sim, macro, threads, seed, scoring, work_dir):
+    """One fixed-seed run of a reference macro; returns its result record."""
+    tag = f"{Path(macro).stem}_t{threads}"
+    status_file = work_dir / f"{tag}_status.json"
+    wrapper = work_dir / f"{tag}.mac"
+    wrapper.write_text(
+        f"/ebl/perf/statusFile {status_file.as_posix()}\n"
+        f"/ebl/perf/statusPSF false\n"
+        f"/control/execute {Path(macro).resolve().as_posix()}\n"
+    )
+
+    command = [str(ebl_sim), "-t", str(threads), "--seed", str(seed)]
+    if scoring:
+        command += ["--scoring", scoring]
+    command.append(str(wrapper))
+    wall, peak_rss = run_process(command, work_dir / f"{tag}.log")
+
+    # The status file holds the counters of the last run of the macro
+    status = json.loads(status_file.read_text())
+    elapsed = status["elapsed_s"]
+    events = status["events"]
+    counters = status["counters"]
+    return {
+        "macro": Path(macro).name,
+        "threads": threads,
+        "events": events,
+        "run_s": elapsed,
+        "wall_s": wall,
+        "init_s": max(wall - elapsed, 0.0),
+        "events_per_s": rate(events, elapsed),
+        "resist_steps_per_s": rate(counters.get("resist_steps"), elapsed),
+        "steps_per_s": rate(counters.get("steps"), elapsed),
+        "peak_rss_mb": peak_rss,
+    }
+
+
+def add_scaling_efficiency(runs):
+    """Efficiency = speed-up over the smallest thread count / thread ratio."""
+    for macro in {run["macro"] for run in runs}:
+        series = sorted((r for r in runs if r["macro"] == macro), key=lambda r: r["threads"])
+        reference = series[0]
+        for run in series:
+            if reference["events_per_s"] and run["events_per_s"]:
+                speedup = run["events_per_s"] / reference["events_per_s"]
+                run["scaling_efficiency"] = speedup * reference["threads"] / run["threads"]
+            else:
+                run["scaling_efficiency"] = None
+
+
+def run_microbenchmarks(ebl_bench, work_dir, min_time):
+    json_path = work_dir / "ebl_bench.json"
+    command = [str(ebl_bench), "--json", str(json_path), "--min-time", str(min_time),
+               "--output-dir", str(work_dir)]
+    run_process(command, work_dir / "ebl_bench.log")
+    return json.loads(json_path.read_text())["benchmarks"]
+
+
+def compare(result, baseline, tolerance):
+    """Print the rate changes against the baseline; return the regressions."""
+    regressions = []
+
+    def check(label, current, previous):
+        if not previous or current is None:
+            return
+        change = current / previous - 1.0
+        flag = ""
+        if change < -tolerance:
+            flag = "  REGRESSION"
+            regressions.append(label)
+        print(f"  {label:<48} {previous:12.4g} -> {current:12.4g}  {change:+7.1%}{flag}")
+
+    base_runs = {(r["macro"], r["threads"]): r for r in baseline.get("runs", [])}
+    for run in result["runs"]:
+        base = base_runs.get((run["macro"], run["threads"]))
+        if base is None:
+            continue
+        for key in ("events_per_s", "resist_steps_per_s", "steps_per_s"):
+            check(f"{run['macro']} t={run['threads']} {key}", run[key], base.get(key))
+
+    base_micro = {b["name"]: b for b in baseline.get("micro", [])}
+    for bench in result.get("micro", []):
+        base = base_micro.get(bench["name"])
+        if base is not None:
+            check(f"ebl_bench {bench['name']} ops_per_s", bench["ops_per_s"], base.get("ops_per_s"))
+
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="ebl_sim throughput and thread-scaling suite")
+    parser.add_argument("--ebl-sim", required=True, help="path to the ebl_sim executable")
+    parser.add_argument("--macro", action="append",
+                        help=f"reference macro, repeatable (default {DEFAULT_MACRO.relative_to(REPO_ROOT)})")
+    parser.add_argument("--threads", help="comma-separated thread counts (default 1,2,4,...,ncpu)")
+    parser.add_argument("--seed", type=int, default=12345, help="master seed of every run")
+    parser.add_argument("--scoring", help="ebl_sim --scoring mode (diagnostics also counts all steps)")
+    parser.add_argument("--bench", help="also run this ebl_bench executable")
+    parser.add_argument("--min-time", type=float, default=0.5,
+                        help="ebl_bench time per microbenchmark (s)")
+    parser.add_argument("--output", default="bench_result.json", help="result JSON")
+    parser.add_argument("--baseline", help="compare against this result JSON")
+    parser.add_argument("--tolerance", type=float, default=0.10,
+                        help="allowed relative drop in any rate (default 0.10)")
+    parser.add_argument("--keep", action="store_true",
+                        help="keep the logs and status files (printed directory)")
+    args = parser.parse_args()
+
+    macros = args.macro or [str(DEFAULT_MACRO)]
+    threads = [int(t) for t in args.threads.split(",")] if args.threads else default_threads()
+
+    work_dir = Path(tempfile.mkdtemp(prefix="ebl_bench_"))
+
+    result = {
+        "ebl_sim": str(Path(args.ebl_sim).resolve()),
+        "host": platform.node(),
+        "platform": platform.platform(),
+        "cpus": os.cpu_count(),
+        "seed": args.seed,
+        "scoring": args.scoring,
+        "date": time.strftime("%Y-%m-%dT%H:%M:%S"),
+        "runs": [],
+    }
+
+    for macro in macros:
+        for n in threads:
+            run = run_ebl_sim(args.ebl_sim, macro, n, args.seed, args.scoring, work_dir)
+            result["runs"].append(run)
+            line = f"{run['macro']} t={n}: {run['events_per_s'] or 0:.1f} events/s"
+            for key, label in (("resist_steps_per_s", "resist steps/s"), ("steps_per_s", "steps/s")):
+                if run[key] is not None:
+                    line += f", {run[key]:.3g} {label}"
+            line += f", init {run['init_s']:.1f} s"
+            if run["peak_rss_mb"] is not None:
+                line += f", peak RSS {run['peak_rss_mb']:.0f} MB"
+            print(line)
+    add_scaling_efficiency(result["runs"])
+    for run in result["runs"]:
+        if run["scaling_efficiency"] is not None:
+            print(f"  {run['macro']} t={run['threads']}: scaling efficiency "
+                  f"{run['scaling_efficiency']:.2f}")
+
+    if args.bench:
+        result["micro"] = run_microbenchmarks(args.bench, work_dir, args.min_time)
+        for bench in result["micro"]:
+            print(f"ebl_bench {bench['name']}: {bench['ns_per_op']:.3g} ns/op")
+
+    Path(args.output).write_text(json.dumps(result, indent=2) + "\n")
+    print(f"Results written to {args.output}")
+
+    status = 0
+    if args.baseline:
+        baseline = json.loads(Path(args.baseline).read_text())
+        print(f"Against {args.baseline} (tolerance {args.tolerance:.0%}):")
+        regressions = compare(result, baseline, args.tolerance)
+        if regressions:
+            print(f"{len(regressions)} rate(s) regressed")
+            status = 1
+
+    if args.keep:
+        print(f"Logs kept in {work_dir}")
+    else:
+        shutil.rmtree(work_dir, ignore_errors=True)
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""Check that the result library files different beams in different families.
+
+Runs a few short /ebl/library/beamOn runs into a scratch library. They share
+the beam energy and the resist, and each differs from the first in a single
+beam setting (/gun/beamSize, /gun/direction, /gun/position z,
+/gun/particle). Each run must create a setup family (<library>/<setup
+hash>/) of its own; if two runs end up in the same family, the library
+would serve or extend one beam's PSF for the other. Exits with status 1
+in that case.
+
+Usage:
+    python scripts/utils/check_library_key.py --ebl-sim build/bin/ebl_sim
+"""
+
+import argparse
+import shutil
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+BASE_BEAM = {
+    "/gun/particle": "e-",
+    "/gun/energy": "20 keV",
+    "/gun/position": "0 0 100 nm",
+    "/gun/direction": "0 0 -1",
+    "/gun/beamSize": "0 nm",
+}
+
+# Variants of the base beam, one setting changed each
+VARIANTS = [
+    ("base", {}),
+    ("beamSize", {"/gun/beamSize": "2 nm"}),
+    ("direction", {"/gun/direction": "0 0.1 -1"}),
+    ("height", {"/gun/position": "0 0 200 nm"}),
+    ("particle", {"/gun/particle": "e+"}),
+]
+
+
+def run_variant(ebl_sim, name, overrides, library, work_dir, events, seed):
+    beam = dict(BASE_BEAM, **overrides)
+    macro = work_dir / f"{name}.mac"
+    lines = [
+        "/run/verbose 0",
+        "/det/setResistThickness 30 nm",
+        "/det/setResistComposition \"Al:1,C:5,H:4,O:2\"",
+        "/det/update",
+        f"/ebl/library/directory {library.as_posix()}",
+        f"/ebl/output/setDirectory {(work_dir / name).as_posix()}",
+    ]
+    lines += [f"{command} {value}" for command, value in beam.items()]
+    lines += ["/run/initialize", f"/ebl/library/beamOn {events}"]
+    macro.write_text("\n".join(lines) + "\n")
+
+    log_path = work_dir / f"{name}.log"
+    with open(log_path, "w") as log:
+        process = subprocess.run([str(ebl_sim), "-t", "1", "--seed", str(seed), str(macro)],
+                                 stdout=log, stderr=subprocess.STDOUT)
+    if process.returncode != 0:
+        raise RuntimeError(f"{name}: ebl_sim exited with {process.returncode}, see {log_path}")
+
+
+def families(library):
+    return {path.name for path in library.iterdir() if path.is_dir()}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="result library beam-key check")
+    parser.add_argument("--ebl-sim", required=True, help="path to the ebl_sim executable")
+    parser.add_argument("--events", type=int, default=20, help="events per run")
+    parser.add_argument("--seed", type=int, default=12345, help="master seed of every run")
+    parser.add_argument("--keep", action="store_true",
+                        help="keep the library, macros and logs (printed directory)")
+    args = parser.parse_args()
+
+    work_dir = Path(tempfile.mkdtemp(prefix="ebl_library_key_"))
+    library = work_dir / "library"
+    library.mkdir()
+
+    failures = []
+    seen = set()
+    for name, overrides in VARIANTS:
+        run_variant(args.ebl_sim, name, overrides, library, work_dir, args.events, args.seed)
+        new = families(library) - seen
+        if len(new) != 1:
+            failures.append(name)
+            print(f"  {name:<10} FAILED: shares a family with an earlier variant")
+        else:
+            print(f"  {name:<10} family {next(iter(new))}")
+        seen |= new
+
+    if args.keep:
+        print(f"Work directory: {work_dir}")
+    else:
+        shutil.rmtree(work_dir, ignore_errors=True)
+
+    if failures:
+        print(f"{len(failures)} beam variant(s) not keyed: {', '.join(failures)}")
+        return 1
+    print(f"All {len(VARIANTS)} beam variants filed in separate families")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
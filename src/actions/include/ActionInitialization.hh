@@ -6,6 +6,8 @@
 
 // Forward declarations
 class DetectorConstruction;
+class PrimaryGeneratorAction;
+class StackingAction;
 
 class ActionInitialization : public G4VUserActionInitialization {
 public:
@@ -17,6 +19,14 @@ public:
 
 private:
     DetectorConstruction* fDetConstruction;
+
+    // Master-side generator: never fires events, but receives the broadcast
+    // /gun/ commands so the master RunAction knows the beam parameters
+    mutable PrimaryGeneratorAction* fMasterPrimaryGenerator;
+
+    // Master-side stacking action: holds the /ebl/stack/ commands on the
+    // master so they can be broadcast to the workers' copies
+    mutable StackingAction* fMasterStackingAction;
 };
 
 #endif
\ No newline at end of file
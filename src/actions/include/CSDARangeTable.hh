@@ -0,0 +1,49 @@
+// CSDARangeTable.hh - Per-material CSDA range lookup for early track killing
+#ifndef CSDARangeTable_h
+#define CSDARangeTable_h 1
+
+#include "globals.hh"
+#include <vector>
+
+class G4ParticleDefinition;
+class G4Material;
+
+// CSDA ranges of one particle type, sampled from G4EmCalculator on a
+// uniform log-energy grid for every material placed in the geometry.
+// Built once per run (physics tables must exist), then looked up with one
+// log and a linear interpolation instead of calling into the EM tables
+// for every new track.
+//
+// Lookups are conservative for killing: below the grid the range at the
+// lowest grid energy is returned (ranges grow with energy), and above the
+// grid or for a material without a table the range is "infinite".
+class CSDARangeTable {
+public:
+    CSDARangeTable();
+    ~CSDARangeTable() = default;
+
+    void Build(const G4ParticleDefinition* particle,
+               G4double minEnergy, G4double maxEnergy, G4int binsPerDecade);
+    void Clear();
+
+    G4bool IsBuilt() const { return fNumPoints > 0; }
+
+    // CSDA range of the particle with the given kinetic energy in the material
+    G4double GetRange(G4double energy, const G4Material* material) const;
+
+    // Print a few sample ranges per material
+    void Print() const;
+
+private:
+    const G4ParticleDefinition* fParticle;
+    G4double fMinEnergy;
+    G4double fMaxEnergy;
+    G4double fLogMinEnergy;
+    G4double fInvLogStep;
+    G4int fNumPoints;
+
+    // Indexed by G4Material::GetIndex(); empty inner vector = no table
+    std::vector<std::vector<G4double>> fRanges;
+};
+
+#endif
@@ -1,54 +1,92 @@
-﻿// EventAction.hh - BEAMER Optimized (radial PSF only)
+﻿// EventAction.hh - Per-event deposit buffers of the resist scoring
 #ifndef EVENTACTION_HH
 #define EVENTACTION_HH
 
 #include "G4UserEventAction.hh"
 #include "G4Types.hh"
+#include "EventDepositBuffer.hh"
+#include "DepositSink.hh"
 #include <vector>
 
 class RunAction;
 class DetectorConstruction;
+class PSFBinning;
+class PerfThreadCounters;
 class G4Event;
 
-class EventAction : public G4UserEventAction
+// Holds the sparse buffers of one event and flushes them to the RunAction.
+// The deposits themselves are scored by a ScoringPipeline<Policy>, which
+// implements AddEnergyDeposit with only the features of its policy; this
+// class cannot be instantiated on its own.
+class EventAction : public G4UserEventAction, public DepositSink
 {
 public:
-    EventAction(RunAction* runAction, DetectorConstruction* detConstruction);
     virtual ~EventAction();
 
     virtual void BeginOfEventAction(const G4Event* event);
     virtual void EndOfEventAction(const G4Event* event);
 
-    // Add energy deposit at given position
-    void AddEnergyDeposit(G4double edep, G4double x, G4double y, G4double z);
+    // Resist energy of the current event so far (StackingAction staging)
+    G4double GetResistEnergy() const { return fResistEnergy; }
+
+    // Deposit outside the resist at height z (diagnostics SteppingAction):
+    // above the resist for z > 0, in the substrate below
+    void AddOutsideDeposit(G4double edep, G4double z)
+    {
+        if (z > 0.) fAboveResistEnergy += edep;
+        else fSubstrateEnergy += edep;
+    }
+
+protected:
+    EventAction(RunAction* runAction, DetectorConstruction* detConstruction);
 
-    // Add track length - not used for BEAMER but kept for compatibility
-    void AddTrackLength(G4double length) { fTotalTrackLength += length; }
+    // Depth below the resist surface; the resist sits on the substrate at
+    // z = 0, points on the boundaries go to the first/last bin
+    G4int GetDepthBin(G4double z) const
+    {
+        G4int bin = static_cast<G4int>((fDepthRange - z) * fInvDepthBinWidth);
+        if (bin < 0) return 0;
+        if (bin >= fNumDepthBins) return fNumDepthBins - 1;
+        return bin;
+    }
 
-private:
     RunAction* fRunAction;
     DetectorConstruction* fDetConstruction;
 
-    // Event-level accumulation
-    G4double fEnergyDeposit;
-    G4double fTotalTrackLength;
-
-    // Energy by region - simplified for BEAMER
+    // Energy by region; outside the resist only filled in diagnostics runs
     G4double fResistEnergy;
     G4double fSubstrateEnergy;
     G4double fAboveResistEnergy;
+    G4long fNumDeposits;
+
+    // Radial energy distribution (1D) - this is all we need for BEAMER.
+    // Sparse: only bins touched in this event are flushed and cleared.
+    EventDepositBuffer fRadialEnergyDeposit;
+
+    // Depth-resolved (r,z) deposits, flat (point, radial bin, depth bin);
+    // only filled with /ebl/psf/depth true
+    EventDepositBuffer fDepthEnergyDeposit;
+    G4int fNumDepthBins;            // 0 while depth scoring is off
+    G4double fDepthRange;           // resist thickness, z of the top surface
+    G4double fInvDepthBinWidth;
+
+    // Lateral dose map of /ebl/shots/ runs, flat (y, x); replaces the
+    // radial profile while a shot list is loaded
+    EventDepositBuffer fLateralEnergyDeposit;
+    G4int fMapWidth;                // 0 outside shot runs
+    G4int fMapHeight;
+    G4double fMapX0;
+    G4double fMapY0;
+    G4double fInvMapPixel;
 
-    // Radial energy distribution (1D) - this is all we need for BEAMER
-    std::vector<G4double> fRadialEnergyDeposit;
+    // Shared radial binning owned by the RunAction
+    const PSFBinning* fBinning;
 
-    // 2D functionality removed for BEAMER efficiency
-    // static constexpr G4int NUM_DEPTH_BINS = 100;
-    // std::vector<std::vector<G4double>> f2DEnergyDeposit;
+    // First histogram bin of this event's sweep point (0 without a sweep)
+    G4int fPointOffset;
 
-    // Helper functions
-    G4int GetLogBin(G4double radius) const;
-    G4int GetDepthBin(G4double z) const;  // Kept for compatibility but not used
-    G4double GetBinRadius(G4int bin) const;
+    // This thread's counters, published once per event
+    PerfThreadCounters* fPerfCounters;
 };
 
 #endif
\ No newline at end of file
@@ -8,6 +8,9 @@
 class RunAction;
 class G4UIdirectory;
 class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithABool;
+class G4UIcmdWithADoubleAndUnit;
 
 class OutputMessenger : public G4UImessenger {
 public:
@@ -24,7 +27,24 @@ private:
     G4UIcmdWithAString* fPSF2DFileCmd;
     G4UIcmdWithAString* fSummaryFileCmd;
     G4UIcmdWithAString* fBeamerFileCmd;
+    G4UIcmdWithAString* fResultFileCmd;
+    G4UIcmdWithAString* fDoseMapFileCmd;
     G4UIcmdWithAString* fOutputDirCmd;
+    G4UIcmdWithABool* fAsyncCmd;
+
+    // Radial PSF binning
+    G4UIdirectory* fPSFDir;
+    G4UIcmdWithAString* fBinningCmd;
+    G4UIcmdWithAnInteger* fNumBinsCmd;
+    G4UIcmdWithADoubleAndUnit* fMinRadiusCmd;
+    G4UIcmdWithADoubleAndUnit* fMaxRadiusCmd;
+
+    // Depth-resolved scoring
+    G4UIcmdWithABool* fDepthCmd;
+    G4UIcmdWithAnInteger* fNumDepthBinsCmd;
+    G4UIcmdWithAString* fSpotSizesCmd;
+    G4UIcmdWithAString* fScoringCmd;
+    G4UIcmdWithAnInteger* fLibraryBeamOnCmd;
 };
 
 #endif
\ No newline at end of file
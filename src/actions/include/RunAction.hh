@@ -5,15 +5,21 @@
 #include "G4UserRunAction.hh"
 #include "globals.hh"
 #include <vector>
-#include <mutex>
 #include <chrono>
+#include <memory>
 #include "G4Accumulable.hh"
-#include "G4Threading.hh"
+#include "HistogramAccumulable.hh"
+#include "BackscatterResponse.hh"
+#include "PSFBinning.hh"
 
 class G4Run;
 class DetectorConstruction;
 class PrimaryGeneratorAction;
 class OutputMessenger;
+class EventDepositBuffer;
+class PSFResultFile;
+class RunCheckpoint;
+struct ResultKey;
 
 class RunAction : public G4UserRunAction {
 public:
@@ -26,27 +32,121 @@ public:
 
     // Methods to accumulate energy deposition data
     void AddEnergyDeposit(G4double edep, G4double x, G4double y, G4double z);
-    void AddRadialEnergyDeposit(const std::vector<G4double>& energyDeposit);
-    void Add2DEnergyDeposit(const std::vector<std::vector<G4double>>& energy2D);
+    void AddRadialEnergyDeposit(EventDepositBuffer& eventDeposit);
+    void AddDepthEnergyDeposit(EventDepositBuffer& eventDeposit);
+    void AddLateralEnergyDeposit(EventDepositBuffer& eventDeposit);
     void AddRegionEnergy(G4double resist, G4double substrate, G4double above);
 
     // Access methods for analysis
-    std::vector<G4double> GetRadialEnergyProfile() const { return fRadialEnergyProfile; }
+    const std::vector<G4double>& GetRadialEnergyProfile() const { return fRadialHistogram.GetValues(); }
+
+    // Sweep points of the current run (1 without a sweep); the radial
+    // histogram holds one block of bins per point
+    G4int GetNumberOfSweepPoints() const {
+        return fSweepEnergies.empty() ? 1 : static_cast<G4int>(fSweepEnergies.size());
+    }
     
+    // Radial binning - applied at the start of the next run
+    const PSFBinning& GetBinning() const { return fBinning; }
+    void SetBinningMode(const G4String& mode);
+    void SetNumberOfBins(G4int nBins) { fNumBins = nBins; }
+    void SetMinRadius(G4double radius) { fMinRadius = radius; }
+    void SetMaxRadius(G4double radius) { fMaxRadius = radius; }
+
+    // Depth-resolved (r,z) scoring - applied at the start of the next run.
+    // GetNumberOfDepthBins() is that of the current run, 0 when it is off.
+    void SetDepthScoring(G4bool enable) { fDepthScoring = enable; }
+    void SetNumberOfDepthBins(G4int nBins) { fNumDepthBins = nBins; }
+    G4int GetNumberOfDepthBins() const { return fActiveDepthBins; }
+    G4double GetDepthRange() const { return fDepthRange; }
+
+    // Spot sizes (FWHM) whose PSFs are derived from the run's PSF by
+    // Gaussian convolution at output time; empty for none
+    void SetSpotSizes(const std::vector<G4double>& sizes) { fSpotSizes = sizes; }
+
+    // Master: /ebl/library/beamOn - export the library entry of the current
+    // setup if it has enough events, else run only the missing ones (or
+    // interpolate, if enabled)
+    void LibraryBeamOn(G4int events);
+
+    // Lateral dose map of /ebl/shots/ runs, fixed at the start of the run;
+    // width 0 outside shot runs
+    G4int GetDoseMapWidth() const { return fDoseMapWidth; }
+    G4int GetDoseMapHeight() const { return fDoseMapHeight; }
+    G4double GetDoseMapX0() const { return fDoseMapX0; }
+    G4double GetDoseMapY0() const { return fDoseMapY0; }
+    G4double GetDoseMapPixelSize() const { return fDoseMapPixel; }
+
+    // Master: what the last run wrote, null if it wrote no PSF (or no
+    // depth table). The SaveResults copies are immutable and shared, so a
+    // holder (output writer, ebl Python module) keeps them past the next run.
+    using ResultSnapshot = std::shared_ptr<const PSFResultFile>;
+    struct DepthResult {
+        std::vector<G4double> sum;      // (point, radial bin, depth bin)
+        std::vector<G4int> events;      // per point
+        G4int numDepthBins;
+        G4double depthRange;
+    };
+    using DepthSnapshot = std::shared_ptr<const DepthResult>;
+    ResultSnapshot GetLastResult() const { return fLastResult; }
+    DepthSnapshot GetLastDepthResult() const { return fLastDepthResult; }
+
     // Output filename setters
     void SetOutputDirectory(const G4String& dir) { fOutputDirectory = dir; }
     void SetPSFFilename(const G4String& name) { fPSFFilename = name; }
     void SetPSF2DFilename(const G4String& name) { fPSF2DFilename = name; }
     void SetSummaryFilename(const G4String& name) { fSummaryFilename = name; }
     void SetBeamerFilename(const G4String& name) { fBeamerFilename = name; }
+    void SetResultFilename(const G4String& name) { fResultFilename = name; }
+    void SetDoseMapFilename(const G4String& name) { fDoseMapFilename = name; }
 
 private:
     DetectorConstruction* fDetConstruction;
     PrimaryGeneratorAction* fPrimaryGenerator;
 
-    // For energy deposition analysis - thread local storage
-    std::vector<G4double> fRadialEnergyProfile;
-    std::vector<std::vector<G4double>> f2DEnergyProfile;
+    // Active binning and the settings requested for the next run
+    PSFBinning fBinning;
+    PSFBinning::Mode fBinningMode;
+    G4int fNumBins;
+    G4double fMinRadius;
+    G4double fMaxRadius;
+
+    // Radial energy profile - one copy per thread, merged into the master
+    // copy by G4AccumulableManager at end of run
+    HistogramAccumulable fRadialHistogram;
+
+    // Depth-resolved profile, (point, radial bin, depth bin) row-major with
+    // the depth bins spanning the resist from its top surface down; a single
+    // unused bin while depth scoring is off
+    HistogramAccumulable fDepthHistogram;
+    G4bool fDepthScoring;
+    G4int fNumDepthBins;
+    G4int fActiveDepthBins;
+    G4double fDepthRange;
+    std::vector<G4int> fDepthPointEvents;   // events in the depth tallies
+
+    // Lateral dose map of shot runs, (y, x) row-major; a single unused bin
+    // outside them
+    HistogramAccumulable fDoseMap;
+    G4int fDoseMapWidth;
+    G4int fDoseMapHeight;
+    G4double fDoseMapX0;
+    G4double fDoseMapY0;
+    G4double fDoseMapPixel;
+
+    // /ebl/psf/spotSizes
+    std::vector<G4double> fSpotSizes;
+
+    // Library entry this run tops up; added to the output at the end
+    std::unique_ptr<PSFResultFile> fLibraryBase;
+    ResultSnapshot fLastResult;
+    DepthSnapshot fLastDepthResult;
+
+    // Beam energies of the /ebl/sweep/ points, fixed at run start
+    std::vector<G4double> fSweepEnergies;
+
+    // Backscatter response filled by /ebl/fastsim/calibrate runs
+    BackscatterResponse fBackscatterCalibration;
 
     // Only scalar accumulables - much more efficient!
     G4Accumulable<G4double> fTotalEnergyDeposit;
@@ -55,12 +155,7 @@ private:
     G4Accumulable<G4double> fAboveResistEnergyTotal;
 
     G4int fNumEvents;
-
-    // For thread-safe accumulation of histograms
-    static std::mutex fArrayMergeMutex;
-    static std::vector<G4double> fMasterRadialProfile;
-    static std::vector<std::vector<G4double>> fMaster2DProfile;
-    static G4bool fMasterArraysInitialized;
+    std::vector<G4int> fPointEvents;    // events per sweep point
 
     // Output filenames
     G4String fOutputDirectory;
@@ -68,26 +163,48 @@ private:
     G4String fPSF2DFilename;
     G4String fSummaryFilename;
     G4String fBeamerFilename;
+    G4String fResultFilename;
+    G4String fDoseMapFilename;
 
     // Messenger for output control
     OutputMessenger* fOutputMessenger;
     
     // Performance monitoring
     std::chrono::high_resolution_clock::time_point fStartTime;
+    std::chrono::steady_clock::time_point fEventLoopStart;  // /ebl/perf/trace
 
-    // Helper functions for logarithmic binning
-    G4double GetBinRadius(G4int bin) const;
-    void GetBinBoundaries(G4int bin, G4double& rInner, G4double& rOuter) const;
+    void UpdateBinning();
 
     // Analysis helpers
     void SaveResults();
-    void SaveCSVFormat(const std::string& outputDir);
-    void SaveBEAMERFormat(const std::string& outputDir);
+    std::string PrepareOutputDirectory() const;
+    void ExportResult(const std::string& outputDir, const PSFResultFile& result);
+    G4bool UsesLibrary() const;
+    ResultKey GetLibraryKey() const;
+    void FillResult(PSFResultFile& result) const;
+    void WriteCheckpoint(const G4String& directory, G4int batches);
+    void LoadCheckpoint(const RunCheckpoint& checkpoint);
+    std::vector<G4double> GetScalars() const;
+    void SumOverRanks(PSFResultFile& total, std::vector<G4double>& scalars) const;
+    void ApplyState(const PSFResultFile& result, const std::vector<G4double>& scalars);
+    void SumDepthOverRanks();
+
+    // The Save functions queue their files on the AsyncWriter, with a copy
+    // of the tallies that the next run cannot touch
+    void SaveResultFile(const std::string& outputDir, const ResultSnapshot& result);
+    void SaveCSVFormat(const std::string& outputDir, const ResultSnapshot& result);
+    void SaveBEAMERFormat(const std::string& outputDir, const ResultSnapshot& result);
+    void SaveSweepIndex(const std::string& outputDir);
+    void SaveSpotSizes(const std::string& outputDir, const PSFResultFile& result);
+    G4int GetEventsAtPoint(G4int point) const;
+    G4double EvaluateConvergence(const PSFResultFile& result, G4double& worstRadius) const;
+    G4double GetBeamEnergy(G4int point) const;
+    std::string GetPointFilename(const G4String& filename, G4int point) const;
     void Save2DFormat(const std::string& outputDir);
+    void SaveDoseMap(const std::string& outputDir);
     void SaveSummary(const std::string& outputDir);
-
-    // Thread-safe merge of local arrays to master
-    void MergeLocalArrays();
+    std::string SummaryPath(const std::string& outputDir) const;
+    void SaveTrace();  // Chrome trace next to the summary
 };
 
 #endif
\ No newline at end of file
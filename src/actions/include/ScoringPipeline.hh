@@ -0,0 +1,139 @@
+// ScoringPipeline.hh - Event actions specialised at compile time for a scoring mode
+#ifndef ScoringPipeline_h
+#define ScoringPipeline_h 1
+
+#include "EventAction.hh"
+#include "PSFBinning.hh"
+#include "globals.hh"
+#include <cmath>
+
+class RunAction;
+class DetectorConstruction;
+
+// Scoring policies: which features the per-deposit path handles. A feature
+// that is compiled out costs nothing per step; runs that need it are
+// refused at run start (see Scoring::MissingFeature).
+namespace ScoringPolicy {
+    // Radial PSF of unweighted deposits at a single energy
+    struct RadialOnly {
+        static constexpr G4bool kDepth = false;
+        static constexpr G4bool kWeighted = false;
+        static constexpr G4bool kSweep = false;
+        static constexpr G4bool kDoseMap = false;
+        static constexpr G4bool kDiagnostics = false;
+    };
+
+    // Radial PSF and the (r, depth) table of /ebl/psf/depth
+    struct RadialDepth {
+        static constexpr G4bool kDepth = true;
+        static constexpr G4bool kWeighted = false;
+        static constexpr G4bool kSweep = false;
+        static constexpr G4bool kDoseMap = false;
+        static constexpr G4bool kDiagnostics = false;
+    };
+
+    // Radial PSF of weighted deposits (importance biasing, phase-space replay)
+    struct Weighted {
+        static constexpr G4bool kDepth = false;
+        static constexpr G4bool kWeighted = true;
+        static constexpr G4bool kSweep = false;
+        static constexpr G4bool kDoseMap = false;
+        static constexpr G4bool kDiagnostics = false;
+    };
+
+    // Every run feature: depth, weights, energy sweeps and shot dose maps
+    struct Full {
+        static constexpr G4bool kDepth = true;
+        static constexpr G4bool kWeighted = true;
+        static constexpr G4bool kSweep = true;
+        static constexpr G4bool kDoseMap = true;
+        static constexpr G4bool kDiagnostics = false;
+    };
+
+    // Full, plus the SteppingAction and the energy deposited outside the
+    // resist (substrate and above), reported at the end of the run
+    struct Diagnostics {
+        static constexpr G4bool kDepth = true;
+        static constexpr G4bool kWeighted = true;
+        static constexpr G4bool kSweep = true;
+        static constexpr G4bool kDoseMap = true;
+        static constexpr G4bool kDiagnostics = true;
+    };
+}
+
+// The EventAction of one scoring policy. The buffers, their flush and the
+// per-event setup are shared (EventAction); only the deposit path, called
+// by ResistSensitiveDetector for every resist step, is specialised.
+template <class Policy>
+class ScoringPipeline final : public EventAction {
+public:
+    ScoringPipeline(RunAction* runAction, DetectorConstruction* detConstruction)
+        : EventAction(runAction, detConstruction) {}
+
+    void AddEnergyDeposit(G4double edep, G4double weight,
+                          G4double x, G4double y, G4double z) override
+    {
+        // Score the weighted deposit so biased runs stay unbiased
+        if constexpr (Policy::kWeighted) edep *= weight;
+
+        fResistEnergy += edep;
+        fNumDeposits++;
+
+        // Shot runs: absolute position in the dose map; deposits outside the
+        // map still count in the region totals
+        if constexpr (Policy::kDoseMap) {
+            if (fMapWidth > 0) {
+                G4int ix = static_cast<G4int>(std::floor((x - fMapX0) * fInvMapPixel));
+                G4int iy = static_cast<G4int>(std::floor((y - fMapY0) * fInvMapPixel));
+                if (ix >= 0 && ix < fMapWidth && iy >= 0 && iy < fMapHeight) {
+                    fLateralEnergyDeposit.Add(iy * fMapWidth + ix, edep);
+                }
+                return;
+            }
+        }
+
+        // Bin directly on the squared radius - no sqrt/log on the hot path;
+        // -1 means beyond the PSF range
+        G4int bin = fBinning->FindBinSquared(x * x + y * y);
+        if (bin < 0) return;
+        if constexpr (Policy::kSweep) bin += fPointOffset;
+
+        fRadialEnergyDeposit.Add(bin, edep);
+        if constexpr (Policy::kDepth) {
+            if (fNumDepthBins > 0) {
+                fDepthEnergyDeposit.Add(bin * fNumDepthBins + GetDepthBin(z), edep);
+            }
+        }
+    }
+};
+
+// Choice of the pipeline, radial by default. It is fixed when the event
+// actions are built (ActionInitialization::Build: at startup in sequential
+// mode, at the first run otherwise), so it is set on the command line
+// (--scoring) or with /ebl/psf/scoring before the first MT run.
+namespace Scoring {
+    enum class Mode { kRadial, kDepth, kWeighted, kFull, kDiagnostics };
+
+    void SetMode(Mode mode);
+    Mode GetMode();
+
+    // "radial", "depth", "weighted", "full", "diagnostics"
+    G4bool ParseMode(const G4String& name, Mode& mode);
+    const char* ModeName(Mode mode);
+
+    // True once an event action has been created with the current mode
+    G4bool IsBuilt();
+
+    // The event action of the mode
+    EventAction* CreateEventAction(Mode mode, RunAction* runAction,
+                                   DetectorConstruction* detConstruction);
+
+    // Narrowest mode that scores the given run features
+    Mode ModeFor(G4bool depth, G4bool weighted, G4bool sweep, G4bool doseMap);
+
+    // First run feature the mode's pipeline does not score, or nullptr
+    const char* MissingFeature(Mode mode, G4bool depth, G4bool weighted,
+                               G4bool sweep, G4bool doseMap);
+}
+
+#endif
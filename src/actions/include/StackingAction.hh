@@ -4,10 +4,40 @@
 
 #include "G4UserStackingAction.hh"
 #include "globals.hh"
+#include "CSDARangeTable.hh"
 
 class DetectorConstruction;
+class EventAction;
+class PerfThreadCounters;
+class StackingMessenger;
 class G4Track;
+class G4ParticleDefinition;
 
+// Early kill filter for new tracks that cannot deposit energy in the resist.
+// The geometry is a resist slab (0 < z < thickness) on a substrate (z < 0)
+// in vacuum, so the rules are:
+//  - out of range: an electron in the substrate whose CSDA range (from the
+//    per-material table, times a safety factor) is shorter than its
+//    straight-line distance to the resist can never reach it
+//  - escaping: anything above the resist moving away from it travels in
+//    vacuum without fields and never comes back
+//  - low-energy gamma: photons below a threshold, anywhere
+//  - roulette (only with /ebl/bias/enable): deep electrons heading away
+//    from the resist survive with probability p and weight w/p
+// Otherwise tracks inside the resist are never killed. Each rule can be switched off
+// with /ebl/stack/ commands and has its own counter (/ebl/perf/dump).
+//
+// Staging (/ebl/stack/waiting): secondaries created deeper than the defer
+// depth in the substrate go to the waiting stack, so primaries and tracks
+// in or near the resist are tracked first. When the urgent stack is empty
+// (NewStage) the waiting tracks are
+//  - drain: all tracked (same result, resist-first order)
+//  - budget: dropped if their energy is below the waiting budget; the
+//    resist energy this loses is estimated from the resist energy per unit
+//    of waiting energy of the stages that were tracked (end-of-run line)
+//  - roulette: tracked with probability p = min(1, energy / budget), with
+//    weight w/p, else dropped - unbiased, needs a weighted scoring pipeline
+// Secondaries of a drained stage can form the next stage in turn.
 class StackingAction : public G4UserStackingAction
 {
 public:
@@ -18,16 +48,64 @@ public:
     virtual void NewStage();
     virtual void PrepareNewEvent();
 
+    // Rule configuration (/ebl/stack/)
+    void SetRangeKill(G4bool enable) { fRangeKill = enable; }
+    void SetRangeSafetyFactor(G4double factor) { fRangeSafetyFactor = factor; }
+    void SetKillEscaping(G4bool enable) { fKillEscaping = enable; }
+    void SetGammaThreshold(G4double energy) { fGammaThreshold = energy; }
+
+    // Staging configuration (/ebl/stack/)
+    enum class WaitingMode { kOff, kDrain, kBudget, kRoulette };
+    void SetWaitingMode(WaitingMode mode) { fWaitingMode = mode; }
+    void SetWaitingBudget(G4double energy) { fWaitingBudget = energy; }
+    void SetDeferDepth(G4double depth) { fDeferDepth = depth; }
+    void PrintRules();
+
 private:
+    void BuildRangeTable();
+
+    // Resist energy of the event so far, from the event action
+    G4double GetResistEnergy() const;
+
+    // Books the resist energy of the drained stage that just ended
+    void CloseDrainedStage();
+
     DetectorConstruction* fDetector;
     G4double fResistTop;        // Top of resist layer
     G4double fResistBottom;     // Bottom of resist layer (0)
-    G4double fKillEnergyThreshold;  // Energy threshold for killing
 
-    // Statistics
-    G4int fKilledTracks;
-    G4int fTotalTracks;
+    // Rules
+    G4bool fRangeKill;
+    G4double fRangeSafetyFactor;
+    G4bool fKillEscaping;
+    G4double fGammaThreshold;   // 0 disables the rule
+
+    // Cached particle definitions for pointer comparison
+    const G4ParticleDefinition* fElectron;
+    const G4ParticleDefinition* fGamma;
+
+    // Electron CSDA ranges, rebuilt at the first event of every run
+    CSDARangeTable fElectronRanges;
+    G4int fRangeTableRunID;
+
+    G4bool fBiasingEnabled;     // cached from ImportanceBiasing per event
+
+    // Staging
+    WaitingMode fWaitingMode;
+    G4double fWaitingBudget;
+    G4double fDeferDepth;       // below the resist bottom, tracks above stay urgent
+    G4double fWaitingEnergy;    // weighted kinetic energy sent to waiting since the last stage
+    G4double fStageEnergy;      // of the drained stage being tracked, 0 if none
+    G4double fStageResistStart; // event resist energy when that stage started
+    G4double fReclassifyWeight; // > 0 while roulette survivors are reclassified
+    EventAction* fEventAction;
+
     G4int fEventNumber;
+
+    // Tracks pushed and kills per rule, see /ebl/perf/dump
+    PerfThreadCounters* fPerfCounters;
+
+    StackingMessenger* fMessenger;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,37 @@
+// StackingMessenger.hh - /ebl/stack/ commands
+#ifndef StackingMessenger_h
+#define StackingMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class StackingAction;
+class G4UIdirectory;
+class G4UIcmdWithABool;
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAString;
+class G4UIcmdWithoutParameter;
+
+class StackingMessenger : public G4UImessenger {
+public:
+    StackingMessenger(StackingAction* stackingAction);
+    virtual ~StackingMessenger();
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+
+private:
+    StackingAction* fStackingAction;
+
+    G4UIdirectory* fStackDir;
+    G4UIcmdWithABool* fRangeKillCmd;
+    G4UIcmdWithADouble* fRangeSafetyCmd;
+    G4UIcmdWithABool* fKillEscapingCmd;
+    G4UIcmdWithADoubleAndUnit* fGammaThresholdCmd;
+    G4UIcmdWithAString* fWaitingCmd;
+    G4UIcmdWithADoubleAndUnit* fWaitingBudgetCmd;
+    G4UIcmdWithADoubleAndUnit* fDeferDepthCmd;
+    G4UIcmdWithoutParameter* fPrintCmd;
+};
+
+#endif
@@ -8,6 +8,7 @@
 
 class EventAction;
 class DetectorConstruction;
+class PerfThreadCounters;
 
 class SteppingAction : public G4UserSteppingAction {
 public:
@@ -21,6 +22,10 @@ private:
     EventAction* fEventAction;
     DetectorConstruction* fDetConstruction;
     G4LogicalVolume* fScoringVolume;
+
+    G4long fResistDeposits;
+    G4double fResistEnergy;
+    PerfThreadCounters* fPerfCounters;
 };
 
 #endif
\ No newline at end of file
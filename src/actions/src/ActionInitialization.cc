@@ -3,6 +3,7 @@
 #include "PrimaryGeneratorAction.hh"
 #include "RunAction.hh"
 #include "EventAction.hh"
+#include "ScoringPipeline.hh"
 #include "SteppingAction.hh"
 #include "StackingAction.hh"
 #include "DetectorConstruction.hh"
@@ -10,19 +11,31 @@
 
 ActionInitialization::ActionInitialization(DetectorConstruction* detConstruction)
     : G4VUserActionInitialization(),
-    fDetConstruction(detConstruction)
+    fDetConstruction(detConstruction),
+    fMasterPrimaryGenerator(nullptr),
+    fMasterStackingAction(nullptr)
 {
 }
 
 ActionInitialization::~ActionInitialization()
 {
+    delete fMasterPrimaryGenerator;
+    delete fMasterStackingAction;
 }
 
 void ActionInitialization::BuildForMaster() const
 {
     // This method is only called for the master thread in MT mode
-    // Only RunAction needs to be created for the master
-    RunAction* runAction = new RunAction(fDetConstruction, nullptr);
+    // Only RunAction is registered for the master; the generator is kept
+    // so that output headers report the real beam energy, and the stacking
+    // action so that /ebl/stack/ commands exist on the master
+    if (!fMasterPrimaryGenerator) {
+        fMasterPrimaryGenerator = new PrimaryGeneratorAction(fDetConstruction);
+    }
+    if (!fMasterStackingAction) {
+        fMasterStackingAction = new StackingAction(fDetConstruction);
+    }
+    RunAction* runAction = new RunAction(fDetConstruction, fMasterPrimaryGenerator);
     SetUserAction(runAction);
 }
 
@@ -39,13 +52,17 @@ void ActionInitialization::Build() const
     RunAction* runAction = new RunAction(fDetConstruction, primary);
     SetUserAction(runAction);
 
-    // Event action - thread local
-    EventAction* eventAction = new EventAction(runAction, fDetConstruction);
+    // Event action - thread local, the scoring pipeline of the chosen mode
+    const Scoring::Mode mode = Scoring::GetMode();
+    EventAction* eventAction = Scoring::CreateEventAction(mode, runAction, fDetConstruction);
     SetUserAction(eventAction);
 
-    // Stepping action - thread local
-    SteppingAction* steppingAction = new SteppingAction(eventAction, fDetConstruction);
-    SetUserAction(steppingAction);
+    // Stepping action - diagnostics only. Resist scoring is done by the
+    // sensitive detector, so production runs carry no per-step user code.
+    if (mode == Scoring::Mode::kDiagnostics) {
+        SteppingAction* steppingAction = new SteppingAction(eventAction, fDetConstruction);
+        SetUserAction(steppingAction);
+    }
 
     // BEAMER OPTIMIZATION: Add stacking action for track killing
     StackingAction* stackingAction = new StackingAction(fDetConstruction);
@@ -54,8 +71,9 @@ void ActionInitialization::Build() const
     // Debug output to confirm thread creation
     if (G4Threading::IsWorkerThread()) {
         G4cout << ">>> Worker thread " << G4Threading::G4GetThreadId()
-            << " initialized with BEAMER optimizations" << G4endl;
+            << " initialized with the " << Scoring::ModeName(mode) << " scoring pipeline" << G4endl;
     } else {
-        G4cout << ">>> Sequential mode initialized with BEAMER optimizations" << G4endl;
+        G4cout << ">>> Sequential mode initialized with the " << Scoring::ModeName(mode)
+            << " scoring pipeline" << G4endl;
     }
 }
\ No newline at end of file
@@ -0,0 +1,120 @@
+// CSDARangeTable.cc - Per-material CSDA range lookup for early track killing
+#include "CSDARangeTable.hh"
+#include "G4EmCalculator.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4Material.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4UnitsTable.hh"
+#include "G4SystemOfUnits.hh"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+CSDARangeTable::CSDARangeTable()
+    : fParticle(nullptr),
+    fMinEnergy(0.),
+    fMaxEnergy(0.),
+    fLogMinEnergy(0.),
+    fInvLogStep(0.),
+    fNumPoints(0)
+{
+}
+
+void CSDARangeTable::Clear()
+{
+    fRanges.clear();
+    fNumPoints = 0;
+}
+
+void CSDARangeTable::Build(const G4ParticleDefinition* particle,
+                           G4double minEnergy, G4double maxEnergy, G4int binsPerDecade)
+{
+    Clear();
+    if (!particle || minEnergy <= 0. || maxEnergy <= minEnergy || binsPerDecade < 1) {
+        G4Exception("CSDARangeTable::Build", "RNG001", JustWarning,
+            "Invalid range table parameters, range-based killing disabled");
+        return;
+    }
+
+    fParticle = particle;
+    fMinEnergy = minEnergy;
+    fMaxEnergy = maxEnergy;
+    fLogMinEnergy = std::log(minEnergy);
+
+    G4double decades = std::log10(maxEnergy / minEnergy);
+    G4int nSteps = std::max(1, static_cast<G4int>(std::ceil(decades * binsPerDecade)));
+    G4double logStep = (std::log(maxEnergy) - fLogMinEnergy) / nSteps;
+    fInvLogStep = 1.0 / logStep;
+    fNumPoints = nSteps + 1;
+
+    // Only materials that are actually placed have couples and hence CSDA
+    // tables; walk the regions so every material is queried with a region
+    // it belongs to
+    G4EmCalculator calculator;
+    fRanges.assign(G4Material::GetNumberOfMaterials(), std::vector<G4double>());
+
+    for (const G4Region* region : *G4RegionStore::GetInstance()) {
+        auto materialIt = region->GetMaterialIterator();
+        for (size_t i = 0; i < region->GetNumberOfMaterials(); ++i, ++materialIt) {
+            const G4Material* material = *materialIt;
+            std::vector<G4double>& ranges = fRanges[material->GetIndex()];
+            if (!ranges.empty()) continue;
+
+            ranges.resize(fNumPoints);
+            for (G4int j = 0; j < fNumPoints; ++j) {
+                G4double energy = std::exp(fLogMinEnergy + j * logStep);
+                ranges[j] = calculator.GetCSDARange(energy, particle, material, region);
+            }
+
+            // No CSDA table (e.g. BuildCSDARange off): treat as unknown
+            if (ranges.back() <= 0.) {
+                ranges.clear();
+            }
+        }
+    }
+}
+
+G4double CSDARangeTable::GetRange(G4double energy, const G4Material* material) const
+{
+    if (!material || energy >= fMaxEnergy) return DBL_MAX;
+
+    size_t index = material->GetIndex();
+    if (index >= fRanges.size() || fRanges[index].empty()) return DBL_MAX;
+
+    const std::vector<G4double>& ranges = fRanges[index];
+    if (energy <= fMinEnergy) return ranges[0];
+
+    G4double x = (std::log(energy) - fLogMinEnergy) * fInvLogStep;
+    G4int bin = static_cast<G4int>(x);
+    if (bin >= fNumPoints - 1) return ranges[fNumPoints - 1];
+
+    G4double t = x - bin;
+    return ranges[bin] + t * (ranges[bin + 1] - ranges[bin]);
+}
+
+void CSDARangeTable::Print() const
+{
+    if (!IsBuilt()) {
+        G4cout << "CSDA range table: not built" << G4endl;
+        return;
+    }
+
+    const G4double energies[] = { 100 * eV, 1 * keV, 10 * keV, 100 * keV };
+    G4cout << "CSDA ranges (" << fParticle->GetParticleName() << ", "
+        << G4BestUnit(fMinEnergy, "Energy") << " - "
+        << G4BestUnit(fMaxEnergy, "Energy") << ", "
+        << fNumPoints << " points):" << G4endl;
+
+    const G4MaterialTable* materials = G4Material::GetMaterialTable();
+    for (const G4Material* material : *materials) {
+        if (material->GetIndex() >= fRanges.size() || fRanges[material->GetIndex()].empty()) continue;
+        G4cout << "  " << material->GetName() << ":";
+        for (G4double energy : energies) {
+            if (energy < fMinEnergy || energy > fMaxEnergy) continue;
+            G4cout << "  " << G4BestUnit(energy, "Energy") << " -> "
+                << G4BestUnit(GetRange(energy, material), "Length");
+        }
+        G4cout << G4endl;
+    }
+}
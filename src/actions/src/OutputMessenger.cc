@@ -1,8 +1,16 @@
 // OutputMessenger.cc
 #include "OutputMessenger.hh"
 #include "RunAction.hh"
+#include "ScoringPipeline.hh"
+#include "AsyncWriter.hh"
 #include "G4UIdirectory.hh"
 #include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UnitsTable.hh"
+#include "G4Tokenizer.hh"
+#include <vector>
 
 OutputMessenger::OutputMessenger(RunAction* runAction)
     : G4UImessenger(),
@@ -35,6 +43,103 @@ OutputMessenger::OutputMessenger(RunAction* runAction)
     fBeamerFileCmd->SetGuidance("Set BEAMER output filename");
     fBeamerFileCmd->SetParameterName("filename", false);
     fBeamerFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fResultFileCmd = new G4UIcmdWithAString("/ebl/output/setResultFile", this);
+    fResultFileCmd->SetGuidance("Set binary PSF result filename (numpy.memmap readable,");
+    fResultFileCmd->SetGuidance("see scripts/gui/psf_result.py)");
+    fResultFileCmd->SetParameterName("filename", false);
+    fResultFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fDoseMapFileCmd = new G4UIcmdWithAString("/ebl/output/setDoseMapFile", this);
+    fDoseMapFileCmd->SetGuidance("Set dose map filename of /ebl/shots/ runs (.npy)");
+    fDoseMapFileCmd->SetParameterName("filename", false);
+    fDoseMapFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Process-wide; the writer belongs to the master
+    fAsyncCmd = new G4UIcmdWithABool("/ebl/output/async", this);
+    fAsyncCmd->SetGuidance("Write the output files on a background thread (default true): the");
+    fAsyncCmd->SetGuidance("next run starts while they are written, each through <file>.tmp and");
+    fAsyncCmd->SetGuidance("a rename. false writes them before the run ends.");
+    fAsyncCmd->SetParameterName("enable", true);
+    fAsyncCmd->SetDefaultValue(true);
+    fAsyncCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fAsyncCmd->SetToBeBroadcasted(false);
+
+    fPSFDir = new G4UIdirectory("/ebl/psf/");
+    fPSFDir->SetGuidance("Radial PSF binning and depth scoring (applied at the next /run/beamOn)");
+
+    fBinningCmd = new G4UIcmdWithAString("/ebl/psf/binning", this);
+    fBinningCmd->SetGuidance("Set radial bin spacing");
+    fBinningCmd->SetParameterName("mode", false);
+    fBinningCmd->SetCandidates("log linear");
+    fBinningCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fNumBinsCmd = new G4UIcmdWithAnInteger("/ebl/psf/nBins", this);
+    fNumBinsCmd->SetGuidance("Set number of radial bins");
+    fNumBinsCmd->SetParameterName("nBins", false);
+    fNumBinsCmd->SetRange("nBins>0");
+    fNumBinsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fMinRadiusCmd = new G4UIcmdWithADoubleAndUnit("/ebl/psf/minRadius", this);
+    fMinRadiusCmd->SetGuidance("Set the start of the log grid (ignored for linear binning)");
+    fMinRadiusCmd->SetGuidance("Edges sit at minRadius*q^i; the first bin spans 0 to minRadius*q");
+    fMinRadiusCmd->SetParameterName("radius", false);
+    fMinRadiusCmd->SetRange("radius>0.");
+    fMinRadiusCmd->SetUnitCategory("Length");
+    fMinRadiusCmd->SetDefaultUnit("nm");
+    fMinRadiusCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fMaxRadiusCmd = new G4UIcmdWithADoubleAndUnit("/ebl/psf/maxRadius", this);
+    fMaxRadiusCmd->SetGuidance("Set outer edge of the last bin");
+    fMaxRadiusCmd->SetParameterName("radius", false);
+    fMaxRadiusCmd->SetRange("radius>0.");
+    fMaxRadiusCmd->SetUnitCategory("Length");
+    fMaxRadiusCmd->SetDefaultUnit("um");
+    fMaxRadiusCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fDepthCmd = new G4UIcmdWithABool("/ebl/psf/depth", this);
+    fDepthCmd->SetGuidance("Also score the deposits in (r, depth) bins over the resist thickness");
+    fDepthCmd->SetGuidance("Written to the /ebl/output/setPSF2DFile table");
+    fDepthCmd->SetParameterName("enable", true);
+    fDepthCmd->SetDefaultValue(true);
+    fDepthCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fNumDepthBinsCmd = new G4UIcmdWithAnInteger("/ebl/psf/depthBins", this);
+    fNumDepthBinsCmd->SetGuidance("Set number of depth bins across the resist");
+    fNumDepthBinsCmd->SetParameterName("nBins", false);
+    fNumDepthBinsCmd->SetRange("nBins>0");
+    fNumDepthBinsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fSpotSizesCmd = new G4UIcmdWithAString("/ebl/psf/spotSizes", this);
+    fSpotSizesCmd->SetGuidance("Beam spot sizes (FWHM) whose PSFs are derived from the run's PSF,");
+    fSpotSizesCmd->SetGuidance("followed by a unit; written next to the CSV and BEAMER files");
+    fSpotSizesCmd->SetGuidance("with a _spot<FWHM>nm suffix. Best with /gun/beamSize 0.");
+    fSpotSizesCmd->SetGuidance("  e.g. /ebl/psf/spotSizes 1 2 5 10 nm, or none");
+    fSpotSizesCmd->SetParameterName("sizes", false);
+    fSpotSizesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Process-wide; read when the worker event actions are built
+    fScoringCmd = new G4UIcmdWithAString("/ebl/psf/scoring", this);
+    fScoringCmd->SetGuidance("Scoring pipeline compiled for a set of features (default radial):");
+    fScoringCmd->SetGuidance("  radial: radial PSF only; depth: plus /ebl/psf/depth;");
+    fScoringCmd->SetGuidance("  weighted: radial PSF of weighted deposits; full: every feature;");
+    fScoringCmd->SetGuidance("  diagnostics: full plus per-step counts and outside-resist energies.");
+    fScoringCmd->SetGuidance("Must precede the first run; refused once the event actions are");
+    fScoringCmd->SetGuidance("built (at startup in sequential mode: use --scoring there).");
+    fScoringCmd->SetGuidance("Runs needing a feature the pipeline lacks are refused.");
+    fScoringCmd->SetParameterName("mode", false);
+    fScoringCmd->SetCandidates("radial depth weighted full diagnostics");
+    fScoringCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fScoringCmd->SetToBeBroadcasted(false);
+
+    // Runs from the master's run action only
+    fLibraryBeamOnCmd = new G4UIcmdWithAnInteger("/ebl/library/beamOn", this);
+    fLibraryBeamOnCmd->SetGuidance("Like /run/beamOn, but reuse the /ebl/library/ entry of the current");
+    fLibraryBeamOnCmd->SetGuidance("setup: no run if it has enough events, else only the missing ones.");
+    fLibraryBeamOnCmd->SetParameterName("events", false);
+    fLibraryBeamOnCmd->SetRange("events>0");
+    fLibraryBeamOnCmd->AvailableForStates(G4State_Idle);
+    fLibraryBeamOnCmd->SetToBeBroadcasted(false);
 }
 
 OutputMessenger::~OutputMessenger()
@@ -43,8 +148,21 @@ OutputMessenger::~OutputMessenger()
     delete fPSF2DFileCmd;
     delete fSummaryFileCmd;
     delete fBeamerFileCmd;
+    delete fResultFileCmd;
+    delete fDoseMapFileCmd;
     delete fOutputDirCmd;
+    delete fAsyncCmd;
     delete fOutputDir;
+    delete fBinningCmd;
+    delete fNumBinsCmd;
+    delete fMinRadiusCmd;
+    delete fMaxRadiusCmd;
+    delete fDepthCmd;
+    delete fNumDepthBinsCmd;
+    delete fSpotSizesCmd;
+    delete fScoringCmd;
+    delete fLibraryBeamOnCmd;
+    delete fPSFDir;
 }
 
 void OutputMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
@@ -64,4 +182,73 @@ void OutputMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
     else if (command == fBeamerFileCmd) {
         fRunAction->SetBeamerFilename(newValue);
     }
+    else if (command == fResultFileCmd) {
+        fRunAction->SetResultFilename(newValue);
+    }
+    else if (command == fDoseMapFileCmd) {
+        fRunAction->SetDoseMapFilename(newValue);
+    }
+    else if (command == fAsyncCmd) {
+        AsyncWriter::Instance()->SetEnabled(fAsyncCmd->GetNewBoolValue(newValue));
+    }
+    else if (command == fBinningCmd) {
+        fRunAction->SetBinningMode(newValue);
+    }
+    else if (command == fNumBinsCmd) {
+        fRunAction->SetNumberOfBins(fNumBinsCmd->GetNewIntValue(newValue));
+    }
+    else if (command == fMinRadiusCmd) {
+        fRunAction->SetMinRadius(fMinRadiusCmd->GetNewDoubleValue(newValue));
+    }
+    else if (command == fMaxRadiusCmd) {
+        fRunAction->SetMaxRadius(fMaxRadiusCmd->GetNewDoubleValue(newValue));
+    }
+    else if (command == fDepthCmd) {
+        fRunAction->SetDepthScoring(fDepthCmd->GetNewBoolValue(newValue));
+    }
+    else if (command == fNumDepthBinsCmd) {
+        fRunAction->SetNumberOfDepthBins(fNumDepthBinsCmd->GetNewIntValue(newValue));
+    }
+    else if (command == fSpotSizesCmd) {
+        // Values first, the unit last
+        std::vector<G4String> tokens;
+        G4Tokenizer next(newValue);
+        for (G4String token = next(); !token.empty(); token = next()) {
+            tokens.push_back(token);
+        }
+        if (tokens.size() == 1 && tokens[0] == "none") {
+            fRunAction->SetSpotSizes({});
+            return;
+        }
+        if (tokens.size() < 2 || !G4UnitDefinition::IsUnitDefined(tokens.back()) ||
+            G4UnitDefinition::GetCategory(tokens.back()) != "Length") {
+            G4Exception("OutputMessenger::SetNewValue", "SPOT002", JustWarning,
+                "Usage: /ebl/psf/spotSizes <FWHM1> <FWHM2> ... <unit>");
+            return;
+        }
+        G4double unit = G4UIcommand::ValueOf(tokens.back());
+        std::vector<G4double> sizes;
+        for (size_t i = 0; i + 1 < tokens.size(); ++i) {
+            sizes.push_back(G4UIcommand::ConvertToDouble(tokens[i]) * unit);
+        }
+        fRunAction->SetSpotSizes(sizes);
+    }
+    else if (command == fScoringCmd) {
+        Scoring::Mode mode;
+        if (!Scoring::ParseMode(newValue, mode)) return;
+        // Too late once built: refuse the command, so a macro stops here
+        // instead of running on with the old pipeline
+        if (Scoring::IsBuilt() && mode != Scoring::GetMode()) {
+            G4ExceptionDescription msg;
+            msg << "SCORE002: the event actions are already built with the "
+                << Scoring::ModeName(Scoring::GetMode())
+                << " scoring pipeline; use --scoring to choose it";
+            command->CommandFailed(msg);
+            return;
+        }
+        Scoring::SetMode(mode);
+    }
+    else if (command == fLibraryBeamOnCmd) {
+        fRunAction->LibraryBeamOn(fLibraryBeamOnCmd->GetNewIntValue(newValue));
+    }
 }
\ No newline at end of file
@@ -3,36 +3,67 @@
 #include "PrimaryGeneratorAction.hh"
 #include "DetectorConstruction.hh"
 #include "OutputMessenger.hh"
+#include "EventDepositBuffer.hh"
+#include "PerfMonitor.hh"
+#include "ImportanceBiasing.hh"
+#include "BackscatterFastSim.hh"
+#include "ParameterSweep.hh"
+#include "PhysicsTableCache.hh"
+#include "PSFResultFile.hh"
+#include "PSFExport.hh"
+#include "PSFConvolution.hh"
+#include "ResultLibrary.hh"
+#include "RunCheckpoint.hh"
+#include "ConvergenceControl.hh"
+#include "DistributedRun.hh"
+#include "DataManager.hh"
+#include "ShotList.hh"
+#include "PhaseSpace.hh"
+#include "SubstrateFastModel.hh"
+#include "ScoringPipeline.hh"
+#include "TraceRecorder.hh"
+#include "DoseMapFile.hh"
+#include "AsyncWriter.hh"
 #include "G4Run.hh"
 #include "G4RunManager.hh"
 #include "G4AccumulableManager.hh"
 #include "G4UnitsTable.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4Threading.hh"
-#include "G4AutoLock.hh"
+#include "G4Electron.hh"
+#include "G4Gamma.hh"
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
+#include <sstream>
 #include <filesystem>
 #include <cmath>
+#include <cfloat>
 #include <chrono>
 #include "EBLConstants.hh"
 
-// Initialize static members
-std::mutex RunAction::fArrayMergeMutex;
-std::vector<G4double> RunAction::fMasterRadialProfile;
-std::vector<std::vector<G4double>> RunAction::fMaster2DProfile;
-G4bool RunAction::fMasterArraysInitialized = false;
-
-// Define mutex for thread safety
-namespace {
-    G4Mutex arrayMergeMutex = G4MUTEX_INITIALIZER;
-}
-
 RunAction::RunAction(DetectorConstruction* detConstruction,
     PrimaryGeneratorAction* primaryGenerator)
     : G4UserRunAction(),
     fDetConstruction(detConstruction),
     fPrimaryGenerator(primaryGenerator),
+    fBinningMode(fBinning.GetMode()),
+    fNumBins(fBinning.GetNumberOfBins()),
+    fMinRadius(fBinning.GetMinRadius()),
+    fMaxRadius(fBinning.GetMaxRadius()),
+    fRadialHistogram("RadialEnergyProfile", fBinning.GetNumberOfBins()),
+    fDepthHistogram("DepthEnergyProfile", 1),
+    fDepthScoring(false),
+    fNumDepthBins(EBL::PSF::NUM_DEPTH_BINS),
+    fActiveDepthBins(0),
+    fDepthRange(0.),
+    fDoseMap("LateralDoseMap", 1),
+    fDoseMapWidth(0),
+    fDoseMapHeight(0),
+    fDoseMapX0(0.),
+    fDoseMapY0(0.),
+    fDoseMapPixel(0.),
+    fBackscatterCalibration("BackscatterCalibration"),
     fTotalEnergyDeposit("TotalEnergyDeposit", 0.0),
     fResistEnergyTotal("ResistEnergy", 0.0),
     fSubstrateEnergyTotal("SubstrateEnergy", 0.0),
@@ -43,29 +74,24 @@ RunAction::RunAction(DetectorConstruction* detConstruction,
     fPSF2DFilename("ebl_2d_data.csv"),
     fSummaryFilename("simulation_summary.txt"),
     fBeamerFilename("beamer_psf.dat"),
+    fResultFilename("ebl_psf_result.bin"),
+    fDoseMapFilename("ebl_dose_map.npy"),
     fOutputMessenger(nullptr)
 {
-    // Initialize LOCAL vectors for scoring (per thread)
-    const G4int numBins = EBL::PSF::NUM_RADIAL_BINS;
-    fRadialEnergyProfile.resize(numBins, 0.0);
-
-    // Skip 2D profile initialization for BEAMER-only mode
-    // We don't need depth-resolved data
-
-    // Register ONLY scalar accumulables
+    // Register accumulables - every thread registers the same set in the
+    // same order, which is what G4AccumulableManager::Merge() relies on
     G4AccumulableManager* accumulableManager = G4AccumulableManager::Instance();
     accumulableManager->Register(fTotalEnergyDeposit);
     accumulableManager->Register(fResistEnergyTotal);
     accumulableManager->Register(fSubstrateEnergyTotal);
     accumulableManager->Register(fAboveResistEnergyTotal);
+    accumulableManager->Register(&fRadialHistogram);
+    accumulableManager->Register(&fDepthHistogram);
+    accumulableManager->Register(&fDoseMap);
+    accumulableManager->Register(&fBackscatterCalibration);
 
-    // Initialize master arrays once (thread-safe)
-    G4AutoLock lock(&arrayMergeMutex);
-    if (!fMasterArraysInitialized && G4Threading::IsMasterThread()) {
-        fMasterRadialProfile.resize(numBins, 0.0);
-        // Skip 2D master profile for BEAMER mode
-        fMasterArraysInitialized = true;
-    }
+    // One RunAction per thread, so this is the table of the current thread
+    BackscatterFastSim::SetCalibrationTable(&fBackscatterCalibration);
 
     // Create messenger for output control
     fOutputMessenger = new OutputMessenger(this);
@@ -73,43 +99,196 @@ RunAction::RunAction(DetectorConstruction* detConstruction,
 
 RunAction::~RunAction()
 {
+    BackscatterFastSim::SetCalibrationTable(nullptr);
     delete fOutputMessenger;
 }
 
 void RunAction::BeginOfRunAction(const G4Run* run)
 {
+    // Further batches of /ebl/run/beamOn and /ebl/run/converge add to the
+    // master's tallies of the previous batches; workers always start from
+    // zero. The first batch after --resume starts from the checkpoint.
+    ConvergenceControl* convergence = ConvergenceControl::Instance();
+    const RunCheckpoint* resumeState =
+        G4Threading::IsMasterThread() ? convergence->GetResumeState() : nullptr;
+    G4bool continuing = G4Threading::IsMasterThread() && convergence->IsContinuing() &&
+        !resumeState;
+
     // Store start time for performance monitoring
-    fStartTime = std::chrono::high_resolution_clock::now();
+    if (!continuing) {
+        fStartTime = std::chrono::high_resolution_clock::now();
+    }
+    fLastResult.reset();
+    fLastDepthResult.reset();
 
     // Inform the runManager to save random number seed
     G4RunManager::GetRunManager()->SetRandomNumberStore(false);
 
-    // Reset accumulables to their initial values
-    G4AccumulableManager* accumulableManager = G4AccumulableManager::Instance();
-    accumulableManager->Reset();
+    // Rebuild the radial binning if /ebl/psf/ or /ebl/sweep/ settings
+    // changed. The /ebl/psf/ commands are broadcast and the sweep is
+    // process-wide, so master and workers end up with the same shape.
+    ParameterSweep* sweep = ParameterSweep::Instance();
+    fSweepEnergies.clear();
+    for (G4int i = 0; i < sweep->GetNumberOfPoints(); ++i) {
+        fSweepEnergies.push_back(sweep->GetEnergy(i));
+    }
+    UpdateBinning();
 
-    // Reset LOCAL data (thread-local storage)
-    const G4int numBins = EBL::PSF::NUM_RADIAL_BINS;
-    fRadialEnergyProfile.assign(numBins, 0.0);
+    // Calibration settings are process-wide, so every thread gets the same
+    // table layout; outside calibration runs the table stays empty
+    BackscatterFastSim* fastSim = BackscatterFastSim::Instance();
+    if (fastSim->IsCalibrating()) {
+        fastSim->ConfigureCalibration(fBackscatterCalibration);
+    }
 
-    fNumEvents = 0;
+    // Reset accumulables (scalars and histograms) to their initial values
+    if (!continuing) {
+        G4AccumulableManager* accumulableManager = G4AccumulableManager::Instance();
+        accumulableManager->Reset();
 
-    // Master thread: reset master arrays
-    if (G4Threading::IsMasterThread()) {
-        G4AutoLock lock(&arrayMergeMutex);
-        std::fill(fMasterRadialProfile.begin(), fMasterRadialProfile.end(), 0.0);
+        fNumEvents = 0;
+        fPointEvents.assign(GetNumberOfSweepPoints(), 0);
+        fDepthPointEvents.assign(GetNumberOfSweepPoints(), 0);
+    }
+
+    if (resumeState) {
+        LoadCheckpoint(*resumeState);
+        convergence->ResumeApplied();
+    }
 
+    if (G4Threading::IsMasterThread() && !continuing) {
         G4cout << "\n### BEAMER PSF Generation - Run " << run->GetRunID() << " ###" << G4endl;
         G4cout << "### Optimized for resist-only energy scoring" << G4endl;
-        G4cout << "### Using logarithmic binning: "
-            << EBL::PSF::NUM_RADIAL_BINS << " bins from "
-            << G4BestUnit(EBL::PSF::MIN_RADIUS, "Length") << " to "
-            << G4BestUnit(EBL::PSF::MAX_RADIUS, "Length") << G4endl;
+        G4cout << "### Using " << PSFBinning::ModeName(fBinning.GetMode()) << " binning: "
+            << fBinning.GetNumberOfBins() << " bins from "
+            << G4BestUnit(fBinning.GetMinRadius(), "Length") << " to "
+            << G4BestUnit(fBinning.GetMaxRadius(), "Length") << G4endl;
+        if (fActiveDepthBins > 0) {
+            G4cout << "### Depth-resolved scoring: " << fActiveDepthBins << " depth bins over "
+                << G4BestUnit(fDepthRange, "Length") << G4endl;
+        }
 
         if (G4Threading::IsMultithreadedApplication()) {
             G4cout << "### Running with " << G4Threading::GetNumberOfRunningWorkerThreads()
                 << " worker threads" << G4endl;
         }
+
+        // Region pointers for the biasing settings; workers only read them
+        ImportanceBiasing* biasing = ImportanceBiasing::Instance();
+        biasing->ResolveRegions();
+        if (biasing->IsEnabled()) {
+            G4cout << "### Importance biasing enabled - deposits are weighted" << G4endl;
+            biasing->Print();
+        }
+
+        if (!fSweepEnergies.empty()) {
+            G4cout << "### Sweeping " << fSweepEnergies.size()
+                << " beam energies in one run (event i at point i % N)" << G4endl;
+        }
+    }
+
+    if (G4Threading::IsMasterThread()) {
+        // Shot runs are a single event loop over the list: event IDs must
+        // not restart (batches) or repeat (MPI ranks)
+        ShotList* shots = ShotList::Instance();
+        if (shots->IsActive()) {
+            const char* conflict = nullptr;
+            if (fDoseMapWidth == 0) {
+                conflict = "the dose map is too large (/ebl/shots/pixel, /ebl/shots/margin)";
+            }
+            else if (convergence->IsRunning()) {
+                conflict = "batched runs restart the event IDs every batch, use /ebl/shots/beamOn";
+            }
+            else if (sweep->IsActive()) {
+                conflict = "beam energy sweeps cannot be combined with a shot list";
+            }
+            else if (DistributedRun::Instance()->IsDistributed()) {
+                conflict = "shot lists are not split over MPI ranks";
+            }
+            if (conflict) {
+                G4ExceptionDescription msg;
+                msg << "Cannot run the shot list: " << conflict;
+                G4Exception("RunAction::BeginOfRunAction", "SHOT004", FatalException, msg);
+            }
+            if (!continuing) {
+                G4cout << "### Shot list: scoring a " << fDoseMapWidth << " x " << fDoseMapHeight
+                    << " pixel dose map instead of the radial PSF" << G4endl;
+            }
+        }
+
+        // The scoring pipeline is compiled for a set of features
+        G4bool depth = fActiveDepthBins > 0;
+        G4bool weighted = ImportanceBiasing::Instance()->IsEnabled()
+                       || PhaseSpace::Instance()->IsReplaying();
+        const char* missing = Scoring::MissingFeature(Scoring::GetMode(), depth, weighted,
+            sweep->IsActive(), shots->IsActive());
+        if (missing) {
+            G4ExceptionDescription msg;
+            msg << "The " << Scoring::ModeName(Scoring::GetMode())
+                << " scoring pipeline does not score " << missing << "; start with --scoring "
+                << Scoring::ModeName(Scoring::ModeFor(depth, weighted,
+                                                      sweep->IsActive(), shots->IsActive()));
+            G4Exception("RunAction::BeginOfRunAction", "SCORE001", FatalException, msg);
+        }
+
+        // Recorded events are matched by their index in the launch, so the
+        // event loop must be the plain single-energy one of a single process
+        PhaseSpace* phaseSpace = PhaseSpace::Instance();
+        if (phaseSpace->GetMode() != PhaseSpace::Mode::kOff) {
+            const char* conflict = nullptr;
+            if (sweep->IsActive()) {
+                conflict = "beam energy sweeps";
+            }
+            else if (shots->IsActive()) {
+                conflict = "shot lists";
+            }
+            else if (fastSim->IsCalibrating()) {
+                conflict = "backscatter calibration runs";
+            }
+            else if (DistributedRun::Instance()->IsDistributed()) {
+                conflict = "MPI-distributed runs";
+            }
+            if (conflict) {
+                G4ExceptionDescription msg;
+                msg << "Phase-space recording and replay cannot be combined with " << conflict
+                    << " (/ebl/phasespace/stop)";
+                G4Exception("RunAction::BeginOfRunAction", "PHSP009", FatalException, msg);
+            }
+            if (fPrimaryGenerator && fDetConstruction) {
+                phaseSpace->BeginRun(fPrimaryGenerator->GetParticleGun()->GetParticleEnergy(),
+                                     fDetConstruction->GetActualResistThickness());
+            }
+        }
+
+        // Tables are built by now; file them for the next launch
+        PhysicsTableCache::Instance()->StoreIfNeeded();
+
+        // Response table for the fast simulation; workers only read it
+        fastSim->LoadTable();
+        if (fastSim->IsCalibrating() || fastSim->IsActive()) {
+            fastSim->Print();
+        }
+
+        // Start the progress/rate reporter for this run
+        PerfMonitor* perf = PerfMonitor::Instance();
+        if (convergence->IsRunning()) {
+            perf->SetLoopProgress(convergence->GetEvents(), convergence->GetEventBudget());
+        }
+        else {
+            perf->SetLoopProgress(0, 0);
+        }
+        perf->BeginRun(run->GetNumberOfEventToBeProcessed());
+    }
+
+    // Substrate steps only go through the fast-simulation process when the
+    // model can trigger; each thread switches its own process, the workers
+    // after the master has loaded the table
+    G4bool replaying = PhaseSpace::Instance()->IsReplaying();
+    SubstrateFastModel::SetFastSimulation(G4Electron::Definition(), fastSim->IsActive() || replaying);
+    SubstrateFastModel::SetFastSimulation(G4Gamma::Definition(), replaying);
+
+    if (TraceRecorder::Instance()->IsEnabled()) {
+        fEventLoopStart = TraceRecorder::Clock::now();
     }
 }
 
@@ -117,40 +296,109 @@ void RunAction::EndOfRunAction(const G4Run* run)
 {
     // Calculate elapsed time
     auto endTime = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::seconds>(endTime - fStartTime);
+    std::chrono::duration<G4double> duration = endTime - fStartTime;
 
+    // Event loop of this thread (on the master of an MT run: the whole run)
     G4int nofEvents = run->GetNumberOfEvent();
+    TraceRecorder* trace = TraceRecorder::Instance();
+    if (trace->IsEnabled()) {
+        trace->AddSpan("event loop", fEventLoopStart, TraceRecorder::Clock::now(), nofEvents);
+    }
+
+    if (G4Threading::IsMasterThread()) {
+        PerfMonitor::Instance()->EndRun();
+    }
+
     if (nofEvents == 0) return;
 
-    // Merge scalar accumulables
+    // Merge accumulables. On workers this adds the thread-local copies into
+    // the master ones; the master's EndOfRunAction runs after all workers
+    // have finished, so by then its histograms hold the full run.
     G4AccumulableManager* accumulableManager = G4AccumulableManager::Instance();
-    accumulableManager->Merge();
+    {
+        TraceScope scope("merge");
+        accumulableManager->Merge();
+    }
 
-    // For both master and sequential mode, we need to handle the arrays
-    if (G4Threading::IsMasterThread() || !G4Threading::IsMultithreadedApplication()) {
+    // Master (or sequential) thread writes the results
+    if (G4Threading::IsMasterThread()) {
+        // Event i of a run is at sweep point i % N
+        const G4int numPoints = GetNumberOfSweepPoints();
+        for (G4int point = 0; point < numPoints; point++) {
+            G4int events = nofEvents / numPoints + (point < nofEvents % numPoints ? 1 : 0);
+            fPointEvents[point] += events;
+            if (fActiveDepthBins > 0) fDepthPointEvents[point] += events;
+        }
+        // The only event count: in sequential mode the master also runs
+        // the events, so counting per event as well would count them twice
+        fNumEvents += nofEvents;
+        PhaseSpace::Instance()->EndRun(nofEvents);
+
+        // Calibration tables are not summed over MPI ranks; rank 0 writes its own
+        DistributedRun* distributed = DistributedRun::Instance();
+        BackscatterFastSim* fastSim = BackscatterFastSim::Instance();
+        if (fastSim->IsCalibrating()) {
+            // Primaries started in the substrate: there is no PSF to save
+            const G4String& fileName = fastSim->GetCalibrationFile();
+            if (distributed->IsMasterRank() && fBackscatterCalibration.Write(fileName)) {
+                G4cout << "\n=== Backscatter response table written to " << fileName << " ===" << G4endl;
+#if G4VERSION_NUMBER >= 1120
+                fBackscatterCalibration.Print();
+#endif
+            }
+            return;
+        }
 
-        // In sequential mode, the local arrays already have the data
-        // In MT mode, copy from master arrays after workers have merged
-        if (G4Threading::IsMultithreadedApplication()) {
-            // Wait for all workers to finish merging
-            G4Threading::WorkerThreadJoinsPool();
+        // Tallies of all MPI ranks (this rank's own with a single one)
+        PSFResultFile total;
+        std::vector<G4double> totalScalars;
+        {
+            TraceScope scope("sum over ranks");
+            SumOverRanks(total, totalScalars);
+        }
+
+        // Live PSF for readers of the status file
+        PerfMonitor* perf = PerfMonitor::Instance();
+        if (distributed->IsMasterRank() && perf->WantsPSFSnapshot()) {
+            perf->SetPSFSnapshot(total);
+        }
 
-            // Copy master arrays to local for saving
-            G4AutoLock lock(&arrayMergeMutex);
-            fRadialEnergyProfile = fMasterRadialProfile;
+        // Batched runs checkpoint every batch; only the last one writes the
+        // output. Checkpoints hold the rank's own tallies, the convergence
+        // check those of all ranks.
+        ConvergenceControl* convergence = ConvergenceControl::Instance();
+        if (convergence->IsRunning()) {
+            G4double worstRadius = 0.;
+            G4double worstError = EvaluateConvergence(total, worstRadius);
+            G4bool finished = convergence->EndBatch(distributed->Sum(static_cast<G4long>(nofEvents)),
+                                                    worstError, worstRadius);
+            if (!convergence->GetCheckpointDirectory().empty()) {
+                WriteCheckpoint(distributed->GetRankDirectory(convergence->GetCheckpointDirectory()),
+                                convergence->GetBatches());
+            }
+            if (!finished) return;
         }
 
-        fNumEvents = nofEvents;
+        // Rank 0 writes the output of all ranks
+        if (distributed->IsDistributed()) {
+            ApplyState(total, totalScalars);
+            if (fActiveDepthBins > 0) SumDepthOverRanks();
+        }
+        if (!distributed->IsMasterRank()) return;
 
         // Save only BEAMER-relevant results
-        SaveResults();
+        {
+            TraceScope scope("save results");
+            SaveResults();
+        }
+        if (trace->IsEnabled()) SaveTrace();
 
         // Print performance summary
         G4cout << "\n--------------------BEAMER PSF Generation Complete------------------------------" << G4endl;
-        G4cout << " Events processed: " << nofEvents << G4endl;
+        G4cout << " Events processed: " << fNumEvents << G4endl;
         G4cout << " Simulation time: " << duration.count() << " seconds" << G4endl;
         if (duration.count() > 0) {
-            G4cout << " Performance: " << nofEvents / duration.count() << " events/second" << G4endl;
+            G4cout << " Performance: " << fNumEvents / duration.count() << " events/second" << G4endl;
         }
         G4cout << " Total energy in resist: "
             << G4BestUnit(fResistEnergyTotal.GetValue(), "Energy") << G4endl;
@@ -160,107 +408,157 @@ void RunAction::EndOfRunAction(const G4Run* run)
             G4double resistFraction = fResistEnergyTotal.GetValue() / fTotalEnergyDeposit.GetValue();
             G4cout << " Fraction of energy in resist: " << resistFraction * 100 << "%" << G4endl;
         }
-    }
-    else {
-        // Worker thread in MT mode: merge local arrays to master
-        MergeLocalArrays();
+
+        // Only the diagnostics pipeline scores outside the resist
+        if (Scoring::GetMode() == Scoring::Mode::kDiagnostics) {
+            G4cout << " Energy in substrate: "
+                << G4BestUnit(fSubstrateEnergyTotal.GetValue(), "Energy") << G4endl;
+            G4cout << " Energy above resist: "
+                << G4BestUnit(fAboveResistEnergyTotal.GetValue(), "Energy") << G4endl;
+        }
     }
 }
 
-void RunAction::MergeLocalArrays()
+void RunAction::SetBinningMode(const G4String& mode)
 {
-    // Thread-safe merge of local arrays to master
-    G4AutoLock lock(&arrayMergeMutex);
-
-    // Merge radial profile
-    for (size_t i = 0; i < fRadialEnergyProfile.size(); ++i) {
-        fMasterRadialProfile[i] += fRadialEnergyProfile[i];
-    }
-
-    // Skip 2D profile merge for BEAMER mode
+    fBinningMode = (mode == "linear") ? PSFBinning::Mode::Linear : PSFBinning::Mode::Log;
 }
 
-void RunAction::AddRadialEnergyDeposit(const std::vector<G4double>& energyDeposit)
+void RunAction::UpdateBinning()
 {
-    // Just accumulate in thread-local arrays
-    G4double eventTotalEnergy = 0.0;
-    for (size_t i = 0; i < fRadialEnergyProfile.size() && i < energyDeposit.size(); i++) {
-        if (energyDeposit[i] > 0) {
-            fRadialEnergyProfile[i] += energyDeposit[i];
-            eventTotalEnergy += energyDeposit[i];
-        }
+    PSFBinning requested(fBinningMode, fNumBins, fMinRadius, fMaxRadius);
+    G4int nPoints = GetNumberOfSweepPoints();
+    if (requested != fBinning || fRadialHistogram.GetNx() != nPoints ||
+        fRadialHistogram.GetNy() != requested.GetNumberOfBins()) {
+        fBinning = requested;
+        fRadialHistogram.SetShape(nPoints, fBinning.GetNumberOfBins());
     }
 
-    // Update only the scalar accumulator
-    if (eventTotalEnergy > 0) {
-        fTotalEnergyDeposit += eventTotalEnergy;
+    // Depth bins span the resist as built for this run. Off, the histogram
+    // shrinks to one bin so that threads do not carry an unused array.
+    G4int nDepthBins = fDepthScoring && fDetConstruction ? fNumDepthBins : 0;
+    G4double depthRange = nDepthBins > 0 ? fDetConstruction->GetActualResistThickness() : 0.;
+    if (nDepthBins != fActiveDepthBins || depthRange != fDepthRange ||
+        fDepthHistogram.GetNx() != (nDepthBins > 0 ? nPoints * fBinning.GetNumberOfBins() : 1)) {
+        fActiveDepthBins = nDepthBins;
+        fDepthRange = depthRange;
+        if (nDepthBins > 0) {
+            fDepthHistogram.SetShape(nPoints * fBinning.GetNumberOfBins(), nDepthBins);
+        }
+        else {
+            fDepthHistogram.SetShape(1);
+        }
+        fDepthPointEvents.assign(nPoints, 0);
     }
 
-    fNumEvents++;
+    // Shot runs score a lateral map over the shot list instead; the list is
+    // process-wide, so every thread gets the same layout
+    ShotList* shots = ShotList::Instance();
+    G4int mapWidth = shots->IsActive() ? shots->GetMapWidth() : 0;
+    G4int mapHeight = mapWidth > 0 ? shots->GetMapHeight() : 0;
+    if (mapWidth != fDoseMapWidth || mapHeight != fDoseMapHeight) {
+        fDoseMapWidth = mapWidth;
+        fDoseMapHeight = mapHeight;
+        fDoseMap.SetShape(std::max(mapHeight, 1), std::max(mapWidth, 1));
+    }
+    fDoseMapX0 = shots->GetMapX0();
+    fDoseMapY0 = shots->GetMapY0();
+    fDoseMapPixel = shots->GetPixelSize();
 }
 
-void RunAction::Add2DEnergyDeposit(const std::vector<std::vector<G4double>>& energy2D)
+G4int RunAction::GetEventsAtPoint(G4int point) const
 {
-    // Skip for BEAMER mode - we don't need 2D data
+    if (fSweepEnergies.empty()) return fNumEvents;
+    return fPointEvents[point];
 }
 
-void RunAction::AddRegionEnergy(G4double resist, G4double substrate, G4double above)
+G4double RunAction::EvaluateConvergence(const PSFResultFile& result, G4double& worstRadius) const
 {
-    // Only update scalar accumulables
-    if (resist > 0) fResistEnergyTotal += resist;
-    if (substrate > 0) fSubstrateEnergyTotal += substrate;
-    if (above > 0) fAboveResistEnergyTotal += above;
+    // Largest relative error over the bins of all sweep points whose centre
+    // lies in the /ebl/run/range. Bins with fewer hits than
+    // MIN_COUNTS_FOR_STATISTICS have no meaningful error yet.
+    const ConvergenceControl* convergence = ConvergenceControl::Instance();
+    const G4double minRadius = convergence->GetMinRadius();
+    const G4double maxRadius = convergence->GetMaxRadius() > 0. ?
+        convergence->GetMaxRadius() : fBinning.GetMaxRadius();
+    const G4int numBins = fBinning.GetNumberOfBins();
+
+    G4double worstError = 0.;
+    worstRadius = 0.;
+    for (G4int point = 0; point < GetNumberOfSweepPoints(); point++) {
+        for (G4int i = 0; i < numBins; i++) {
+            G4double rCenter = fBinning.GetCenter(i);
+            if (rCenter < minRadius || rCenter > maxRadius) continue;
+
+            G4double error = result.GetHits(point, i) < EBL::PSF::MIN_COUNTS_FOR_STATISTICS ?
+                DBL_MAX : result.GetRelativeError(point, i);
+            if (error > worstError) {
+                worstError = error;
+                worstRadius = rCenter;
+            }
+        }
+    }
+    return worstError;
 }
 
-// Helper function to get radius for logarithmic bin
-G4double RunAction::GetBinRadius(G4int bin) const
+G4double RunAction::GetBeamEnergy(G4int point) const
 {
-    if (bin < 0) return 0.0;
-    if (bin >= EBL::PSF::NUM_RADIAL_BINS) return EBL::PSF::MAX_RADIUS;
-
-    if (!EBL::PSF::USE_LOG_BINNING) {
-        G4double binWidth = EBL::PSF::MAX_RADIUS / EBL::PSF::NUM_RADIAL_BINS;
-        return (bin + 0.5) * binWidth;
-    }
+    if (!fSweepEnergies.empty()) return fSweepEnergies[point];
+    return fPrimaryGenerator ? fPrimaryGenerator->GetParticleGun()->GetParticleEnergy() : 100.0 * CLHEP::keV;
+}
 
-    G4double logMin = std::log(EBL::PSF::MIN_RADIUS);
-    G4double logMax = std::log(EBL::PSF::MAX_RADIUS);
-    G4double logStep = (logMax - logMin) / EBL::PSF::NUM_RADIAL_BINS;
+std::string RunAction::GetPointFilename(const G4String& filename, G4int point) const
+{
+    // beamer_psf.dat -> beamer_psf_30keV.dat for sweep points
+    std::string name(filename);
+    if (fSweepEnergies.empty()) return name;
+
+    std::ostringstream suffix;
+    suffix << "_" << fSweepEnergies[point] / CLHEP::keV << "keV";
+    size_t dot = name.find_last_of('.');
+    if (dot == std::string::npos) return name + suffix.str();
+    return name.substr(0, dot) + suffix.str() + name.substr(dot);
+}
 
-    G4double logLower = logMin + bin * logStep;
-    G4double logUpper = logMin + (bin + 1) * logStep;
-    G4double logCenter = (logLower + logUpper) / 2.0;
+void RunAction::AddRadialEnergyDeposit(EventDepositBuffer& eventDeposit)
+{
+    // Fold this event's touched bins into the thread-local histogram,
+    // including the per-event squares needed for the bin variance
+    G4double eventTotalEnergy = eventDeposit.GetTotal();
+    eventDeposit.FlushTo(fRadialHistogram);
 
-    return std::exp(logCenter);
+    // Update only the scalar accumulator
+    if (eventTotalEnergy > 0) {
+        fTotalEnergyDeposit += eventTotalEnergy;
+    }
 }
 
-void RunAction::GetBinBoundaries(G4int bin, G4double& rInner, G4double& rOuter) const
+void RunAction::AddDepthEnergyDeposit(EventDepositBuffer& eventDeposit)
 {
-    if (!EBL::PSF::USE_LOG_BINNING) {
-        G4double binWidth = EBL::PSF::MAX_RADIUS / EBL::PSF::NUM_RADIAL_BINS;
-        rInner = bin * binWidth;
-        rOuter = (bin + 1) * binWidth;
-        return;
-    }
+    // Same per-event fold as the radial profile; the totals are counted there
+    eventDeposit.FlushTo(fDepthHistogram);
+}
 
-    G4double logMin = std::log(EBL::PSF::MIN_RADIUS);
-    G4double logMax = std::log(EBL::PSF::MAX_RADIUS);
-    G4double logStep = (logMax - logMin) / EBL::PSF::NUM_RADIAL_BINS;
+void RunAction::AddLateralEnergyDeposit(EventDepositBuffer& eventDeposit)
+{
+    // Shot runs: the event's deposits go to the dose map in place of the
+    // radial profile
+    G4double eventTotalEnergy = eventDeposit.GetTotal();
+    eventDeposit.FlushTo(fDoseMap);
 
-    if (bin == 0) {
-        rInner = 0.0;
-        rOuter = std::exp(logMin + logStep);
-    }
-    else if (bin < EBL::PSF::NUM_RADIAL_BINS) {
-        rInner = std::exp(logMin + bin * logStep);
-        rOuter = std::exp(logMin + (bin + 1) * logStep);
-    }
-    else {
-        rInner = EBL::PSF::MAX_RADIUS;
-        rOuter = EBL::PSF::MAX_RADIUS;
+    if (eventTotalEnergy > 0) {
+        fTotalEnergyDeposit += eventTotalEnergy;
     }
 }
 
+void RunAction::AddRegionEnergy(G4double resist, G4double substrate, G4double above)
+{
+    // Only update scalar accumulables
+    if (resist > 0) fResistEnergyTotal += resist;
+    if (substrate > 0) fSubstrateEnergyTotal += substrate;
+    if (above > 0) fAboveResistEnergyTotal += above;
+}
+
 void RunAction::AddEnergyDeposit(G4double edep, G4double x, G4double y, G4double z)
 {
     if (edep > 0) {
@@ -268,10 +566,8 @@ void RunAction::AddEnergyDeposit(G4double edep, G4double x, G4double y, G4double
     }
 }
 
-void RunAction::SaveResults()
+std::string RunAction::PrepareOutputDirectory() const
 {
-    G4cout << "\n=== Saving BEAMER PSF Results ===" << G4endl;
-
     std::string outputDir = fOutputDirectory.empty() ?
         EBL::Output::DEFAULT_DIRECTORY :
         std::string(fOutputDirectory);
@@ -285,207 +581,516 @@ void RunAction::SaveResults()
             outputDir = "";
         }
     }
-
-    // Save only BEAMER-relevant files
-    SaveCSVFormat(outputDir);      // Main PSF data
-    SaveBEAMERFormat(outputDir);    // Direct BEAMER format
-
-    // Optional: Save minimal summary
-    SaveSummary(outputDir);
-
-    // Skip 2D format for BEAMER mode
-    // Save2DFormat(outputDir);
+    return outputDir;
 }
 
-void RunAction::SaveCSVFormat(const std::string& outputDir)
+void RunAction::SaveResults()
 {
-    std::string actualOutputDir = fOutputDirectory.empty() ? outputDir : std::string(fOutputDirectory);
-    std::string outputPath = actualOutputDir.empty() ?
-        std::string(fPSFFilename) :
-        actualOutputDir + "/" + std::string(fPSFFilename);
+    G4cout << "\n=== Saving BEAMER PSF Results ===" << G4endl;
 
-    G4cout << "Saving PSF data to: " << outputPath << G4endl;
+    std::string outputDir = PrepareOutputDirectory();
 
-    std::ofstream psfFile(outputPath);
-    if (!psfFile.is_open()) {
-        G4cerr << "Error: Could not open output file: " << outputPath << G4endl;
+    // Shot runs have no PSF, only the map of the exposure
+    if (fDoseMapWidth > 0) {
+        SaveDoseMap(outputDir);
+        SaveSummary(outputDir);
         return;
     }
 
-    // Write header
-    psfFile << "Radius(nm),EnergyDeposition(eV/nm^2),BinLower(nm),BinUpper(nm),Events" << std::endl;
+    // The binary result holds the raw tallies; the text files are exports
+    PSFResultFile result;
+    FillResult(result);
+
+    // A /ebl/library/beamOn top-up: the output covers the entry as well.
+    // Every other single-energy run is offered to the library as is.
+    if (UsesLibrary()) {
+        ResultLibrary* library = ResultLibrary::Instance();
+        if (fLibraryBase && result.Merge(*fLibraryBase)) {
+            library->Replace(GetLibraryKey(), result);
+        }
+        else {
+            library->AddRun(GetLibraryKey(), result);
+        }
+    }
+    fLibraryBase.reset();
+
+    ExportResult(outputDir, result);
+    if (!fSweepEnergies.empty()) {
+        SaveSweepIndex(outputDir);
+    }
+
+    if (fActiveDepthBins > 0) {
+        Save2DFormat(outputDir);            // Depth-resolved (r,z) profile
+    }
 
-    G4int validBins = 0;
-    G4double totalEnergy = 0.0;
-    G4double maxDensity = 0.0;
+    // Optional: Save minimal summary
+    SaveSummary(outputDir);
+}
 
-    for (G4int i = 0; i < EBL::PSF::NUM_RADIAL_BINS; i++) {
-        G4double rCenter = GetBinRadius(i);
-        G4double rInner, rOuter;
-        GetBinBoundaries(i, rInner, rOuter);
+void RunAction::ExportResult(const std::string& outputDir, const PSFResultFile& result)
+{
+    // Shared by the queued writes and GetLastResult
+    ResultSnapshot snapshot = std::make_shared<const PSFResultFile>(result);
+    fLastResult = snapshot;
+    SaveResultFile(outputDir, snapshot);    // Sums, sums of squares and hits per bin
+    SaveCSVFormat(outputDir, snapshot);     // Main PSF data
+    SaveBEAMERFormat(outputDir, snapshot);  // Direct BEAMER format
+    if (!fSpotSizes.empty()) {
+        SaveSpotSizes(outputDir, result);   // Derived PSFs of larger beam spots
+    }
+}
 
-        // Calculate annular area for this bin
-        G4double area = CLHEP::pi * (rOuter * rOuter - rInner * rInner);
+G4bool RunAction::UsesLibrary() const
+{
+    // Entries are single-energy PSFs of one rank's output
+    return ResultLibrary::Instance()->IsEnabled() && fDetConstruction &&
+        !ParameterSweep::Instance()->IsActive() && !ShotList::Instance()->IsActive() &&
+        !BackscatterFastSim::Instance()->IsCalibrating() &&
+        !DistributedRun::Instance()->IsDistributed();
+}
+
+ResultKey RunAction::GetLibraryKey() const
+{
+    // Energy and thickness are the axes; everything else must match
+    std::ostringstream setup;
+    setup << std::setprecision(17);
+    setup << "Resist density=" << fDetConstruction->GetResistDensity() / (g / cm3) << " composition=";
+    for (const auto& element : fDetConstruction->GetResistElements()) {
+        setup << element.first << ":" << element.second << ",";
+    }
+    setup << "\nBinning " << PSFBinning::ModeName(fBinningMode) << " " << fNumBins << " "
+        << fMinRadius / nm << " " << fMaxRadius / nm << "\n";
+    if (fPrimaryGenerator) {
+        // The spot, angle, start and lateral offset all shape the PSF (and
+        // the derived /ebl/psf/spotSizes); the height is taken above the
+        // resist, so the thickness axis keeps one family
+        const G4ThreeVector& position = fPrimaryGenerator->GetBeamPosition();
+        const G4ThreeVector& direction = fPrimaryGenerator->GetBeamDirection();
+        setup << "Beam particle=" << fPrimaryGenerator->GetParticleName()
+            << " size=" << fPrimaryGenerator->GetBeamSize() / nm
+            << " height=" << fPrimaryGenerator->GetStartHeight() / nm
+            << " offset=" << position.x() / nm << "," << position.y() / nm
+            << " direction=" << direction.x() << "," << direction.y() << "," << direction.z() << "\n";
+    }
+    setup << "Biasing " << ImportanceBiasing::Instance()->IsEnabled()
+        << " FastSim " << BackscatterFastSim::Instance()->IsEnabled() << "\n";
+    if (PhaseSpace::Instance()->IsReplaying()) {
+        setup << "PhaseSpace " << PhaseSpace::Instance()->GetFileName() << "\n";
+    }
+    setup << PhysicsTableCache::Instance()->DescribeSetup();
 
-        // Calculate energy density per unit area per event
-        G4double energyDensity = (area > 0 && fNumEvents > 0) ?
-            fRadialEnergyProfile[i] / (area * fNumEvents) : 0.0;
+    ResultKey key;
+    key.beamEnergy = fPrimaryGenerator ? fPrimaryGenerator->GetParticleGun()->GetParticleEnergy() : 100.0 * CLHEP::keV;
+    key.resistThickness = fDetConstruction->GetActualResistThickness();
+    key.setup = setup.str();
+    return key;
+}
 
-        if (energyDensity > maxDensity) {
-            maxDensity = energyDensity;
+void RunAction::LibraryBeamOn(G4int events)
+{
+    G4RunManager* runManager = G4RunManager::GetRunManager();
+    ResultLibrary* library = ResultLibrary::Instance();
+    if (!UsesLibrary()) {
+        if (library->IsEnabled()) {
+            G4cout << "Result library: not used for sweeps, shot lists, calibration and MPI runs" << G4endl;
         }
+        runManager->BeamOn(events);
+        return;
+    }
 
-        if (fRadialEnergyProfile[i] > 0) {
-            validBins++;
-            totalEnergy += fRadialEnergyProfile[i];
+    const ResultKey key = GetLibraryKey();
+    PSFResultFile cached;
+    if (library->Find(key, cached)) {
+        G4long available = cached.GetTotalEvents();
+        if (available >= events) {
+            G4cout << "Result library: " << available << " events on file, no run needed" << G4endl;
+            ExportResult(PrepareOutputDirectory(), cached);
+            return;
         }
+        if (library->CanExtend(key, DataManager::Instance()->GetRunSeed())) {
+            G4cout << "Result library: " << available << " events on file, running the missing "
+                << events - available << G4endl;
+            fLibraryBase = std::make_unique<PSFResultFile>(cached);
+            runManager->BeamOn(static_cast<G4int>(events - available));
+            fLibraryBase.reset();
+            return;
+        }
+        G4cout << "Result library: the entry may hold this launch's events (same seed), running all "
+            << events << G4endl;
+    }
+    else if (library->IsInterpolating()) {
+        PSFResultFile interpolated;
+        G4double difference = 0.;
+        if (library->Interpolate(key, events, interpolated, difference)) {
+            ExportResult(PrepareOutputDirectory(), interpolated);
+            return;
+        }
+    }
+    runManager->BeamOn(events);
+}
+
+void RunAction::FillResult(PSFResultFile& result) const
+{
+    const G4int numPoints = GetNumberOfSweepPoints();
+    std::vector<G4double> beamEnergies;
+    for (G4int point = 0; point < numPoints; point++) {
+        beamEnergies.push_back(GetBeamEnergy(point));
+    }
 
-        // Output with full precision for analysis
-        psfFile << std::fixed << std::setprecision(3) << rCenter / CLHEP::nanometer << ","
-            << std::scientific << std::setprecision(6) << energyDensity / (CLHEP::eV / (CLHEP::nanometer * CLHEP::nanometer)) << ","
-            << std::fixed << std::setprecision(3) << rInner / CLHEP::nanometer << ","
-            << rOuter / CLHEP::nanometer << ","
-            << fNumEvents
-            << std::endl;
+    result.SetLayout(fBinning, beamEnergies);
+    for (G4int point = 0; point < numPoints; point++) {
+        result.SetEvents(point, GetEventsAtPoint(point));
     }
+    result.SetTallies(fRadialHistogram.GetValues(), fRadialHistogram.GetSumSquares(),
+                      fRadialHistogram.GetEntries());
+    result.SetSeed(DataManager::Instance()->GetRunSeed());
+    result.SetWeighted(ImportanceBiasing::Instance()->IsEnabled());
 
-    psfFile.close();
-    G4cout << "PSF data saved successfully" << G4endl;
-    G4cout << "Valid bins with energy: " << validBins << " / " << EBL::PSF::NUM_RADIAL_BINS << G4endl;
-    G4cout << "Total energy in radial profile: " << G4BestUnit(totalEnergy, "Energy") << G4endl;
-    G4cout << "Peak energy density: " << maxDensity / (CLHEP::eV / (CLHEP::nanometer * CLHEP::nanometer)) << " eV/nm²" << G4endl;
+    if (fDetConstruction) {
+        std::ostringstream composition;
+        for (const auto& element : fDetConstruction->GetResistElements()) {
+            if (composition.tellp() > 0) composition << ",";
+            composition << element.first << ":" << element.second;
+        }
+        result.SetResist(fDetConstruction->GetActualResistThickness(),
+                         fDetConstruction->GetResistDensity(), composition.str());
+    }
 }
 
-void RunAction::SaveBEAMERFormat(const std::string& outputDir)
+void RunAction::WriteCheckpoint(const G4String& directory, G4int batches)
 {
-    std::string actualOutputDir = fOutputDirectory.empty() ? outputDir : std::string(fOutputDirectory);
-    std::string outputPath = actualOutputDir.empty() ?
-        std::string(fBeamerFilename) :
-        actualOutputDir + "/" + std::string(fBeamerFilename);
+    RunCheckpoint checkpoint;
+    FillResult(checkpoint.GetResult());
+    checkpoint.SetScalars(GetScalars());
+    checkpoint.SetBatches(batches);
+    if (checkpoint.Write(directory)) {
+        G4cout << "### Checkpoint " << batches << " (" << fNumEvents << " events) written to "
+            << directory << G4endl;
+    }
+}
 
-    G4cout << "Saving BEAMER format to: " << outputPath << G4endl;
+void RunAction::LoadCheckpoint(const RunCheckpoint& checkpoint)
+{
+    const PSFResultFile& result = checkpoint.GetResult();
+    const G4int numPoints = GetNumberOfSweepPoints();
+    std::vector<G4double> beamEnergies;
+    for (G4int point = 0; point < numPoints; point++) {
+        beamEnergies.push_back(GetBeamEnergy(point));
+    }
 
-    std::ofstream beamerFile(outputPath);
-    if (!beamerFile.is_open()) {
-        G4cerr << "Error: Could not open BEAMER output file: " << outputPath << G4endl;
+    if (!result.IsCompatible(fBinning, beamEnergies) || checkpoint.GetScalars().size() != 4) {
+        G4Exception("RunAction::LoadCheckpoint", "CKPT004", FatalException,
+            "Checkpoint binning or beam energies differ from the current setup");
         return;
     }
+    ApplyState(result, checkpoint.GetScalars());
+}
 
-    // BEAMER format: radius(um) normalized_PSF
-    // First normalize the PSF
-    std::vector<G4double> normalizedPSF(EBL::PSF::NUM_RADIAL_BINS);
-    G4double maxValue = 0.0;
-
-    // Find maximum value for normalization
-    for (G4int i = 0; i < EBL::PSF::NUM_RADIAL_BINS; i++) {
-        G4double rInner, rOuter;
-        GetBinBoundaries(i, rInner, rOuter);
-        G4double area = CLHEP::pi * (rOuter * rOuter - rInner * rInner);
+std::vector<G4double> RunAction::GetScalars() const
+{
+    return { fTotalEnergyDeposit.GetValue(), fResistEnergyTotal.GetValue(),
+             fSubstrateEnergyTotal.GetValue(), fAboveResistEnergyTotal.GetValue() };
+}
 
-        if (fNumEvents > 0 && area > 0) {
-            normalizedPSF[i] = fRadialEnergyProfile[i] / (area * fNumEvents);
-            if (normalizedPSF[i] > maxValue) {
-                maxValue = normalizedPSF[i];
-            }
-        }
+void RunAction::SumOverRanks(PSFResultFile& total, std::vector<G4double>& scalars) const
+{
+    FillResult(total);
+    scalars = GetScalars();
+
+    DistributedRun* distributed = DistributedRun::Instance();
+    if (!distributed->IsDistributed()) return;
+
+    // One reduction for all tallies: sums, sums of squares, hits, events
+    // per point and the scalars
+    std::vector<G4double> buffer(fRadialHistogram.GetValues());
+    const std::vector<G4double>& sumSquares = fRadialHistogram.GetSumSquares();
+    const std::vector<G4double>& entries = fRadialHistogram.GetEntries();
+    buffer.insert(buffer.end(), sumSquares.begin(), sumSquares.end());
+    buffer.insert(buffer.end(), entries.begin(), entries.end());
+    const G4int numPoints = GetNumberOfSweepPoints();
+    for (G4int point = 0; point < numPoints; point++) {
+        buffer.push_back(GetEventsAtPoint(point));
+    }
+    buffer.insert(buffer.end(), scalars.begin(), scalars.end());
+
+    distributed->Sum(buffer);
+
+    auto it = buffer.begin();
+    const size_t size = fRadialHistogram.GetValues().size();
+    std::vector<G4double> sum(it, it + size);
+    std::vector<G4double> sumSq(it + size, it + 2 * size);
+    std::vector<G4double> hits(it + 2 * size, it + 3 * size);
+    total.SetTallies(sum, sumSq, hits);
+    it += 3 * size;
+    for (G4int point = 0; point < numPoints; point++) {
+        total.SetEvents(point, static_cast<G4long>(*it++ + 0.5));
     }
+    scalars.assign(it, buffer.end());
+}
 
-    // Normalize to maximum = 1.0 (BEAMER standard)
-    if (maxValue > 0) {
-        for (G4int i = 0; i < EBL::PSF::NUM_RADIAL_BINS; i++) {
-            normalizedPSF[i] /= maxValue;
+void RunAction::ApplyState(const PSFResultFile& result, const std::vector<G4double>& scalars)
+{
+    // Replace the master tallies (a checkpoint, or the sum over ranks)
+    const G4int numPoints = GetNumberOfSweepPoints();
+    const G4int numBins = fBinning.GetNumberOfBins();
+    fNumEvents = 0;
+    for (G4int point = 0; point < numPoints; point++) {
+        for (G4int i = 0; i < numBins; i++) {
+            fRadialHistogram.SetBin(point * numBins + i, result.GetSum(point, i),
+                                    result.GetSumSquares(point, i),
+                                    static_cast<G4double>(result.GetHits(point, i)));
         }
+        fPointEvents[point] = static_cast<G4int>(result.GetEvents(point));
+        fNumEvents += fPointEvents[point];
     }
 
-    // Write in BEAMER format
-    beamerFile << "# EBL PSF for BEAMER - Geant4 Simulation (Resist-Only)" << std::endl;
-    beamerFile << "# Beam energy: " << (fPrimaryGenerator ? fPrimaryGenerator->GetParticleGun()->GetParticleEnergy() / CLHEP::keV : 100.0) << " keV" << std::endl;
-    beamerFile << "# Resist: " << (fDetConstruction ? fDetConstruction->GetActualResistThickness() / CLHEP::nanometer : 30.0) << " nm ";
+    fTotalEnergyDeposit = scalars[0];
+    fResistEnergyTotal = scalars[1];
+    fSubstrateEnergyTotal = scalars[2];
+    fAboveResistEnergyTotal = scalars[3];
+}
 
-    // Try to identify resist type from composition
-    auto elements = fDetConstruction ? fDetConstruction->GetResistElements() : std::map<G4String, G4int>();
-    if (elements.count("Al") > 0) {
-        beamerFile << "Alucone";
-    }
-    else if (elements.count("Si") > 0) {
-        beamerFile << "HSQ";
+void RunAction::SumDepthOverRanks()
+{
+    // The depth tallies are not part of the PSF result (or checkpoints), so
+    // they get their own reduction; collective like SumOverRanks
+    std::vector<G4double> buffer(fDepthHistogram.GetValues());
+    const std::vector<G4double>& sumSquares = fDepthHistogram.GetSumSquares();
+    const std::vector<G4double>& entries = fDepthHistogram.GetEntries();
+    buffer.insert(buffer.end(), sumSquares.begin(), sumSquares.end());
+    buffer.insert(buffer.end(), entries.begin(), entries.end());
+    buffer.insert(buffer.end(), fDepthPointEvents.begin(), fDepthPointEvents.end());
+
+    DistributedRun::Instance()->Sum(buffer);
+
+    const G4int size = fDepthHistogram.GetSize();
+    for (G4int i = 0; i < size; i++) {
+        fDepthHistogram.SetBin(i, buffer[i], buffer[size + i], buffer[2 * size + i]);
     }
-    else {
-        beamerFile << "Organic";
+    for (size_t point = 0; point < fDepthPointEvents.size(); point++) {
+        fDepthPointEvents[point] = static_cast<G4int>(buffer[3 * size + point] + 0.5);
     }
-    beamerFile << std::endl;
+}
 
-    beamerFile << "# Format: radius(um) PSF(normalized)" << std::endl;
-    beamerFile << "# Total events: " << fNumEvents << std::endl;
-    beamerFile << "# Normalization: Peak = 1.0" << std::endl;
+void RunAction::SaveResultFile(const std::string& outputDir, const ResultSnapshot& result)
+{
+    std::string actualOutputDir = fOutputDirectory.empty() ? outputDir : std::string(fOutputDirectory);
+    std::string outputPath = actualOutputDir.empty() ?
+        std::string(fResultFilename) :
+        actualOutputDir + "/" + std::string(fResultFilename);
 
-    // Include point at origin for interpolation
-    beamerFile << std::scientific << std::setprecision(6);
+    AsyncWriter::Instance()->Submit(outputPath, [result](std::ostream& out) {
+        return result->Write(out);
+    }, true);
+    G4cout << "PSF result saved to: " << outputPath << G4endl;
+}
 
-    // Add a very small radius point to help with interpolation
-    if (normalizedPSF[0] > 0) {
-        G4double r0 = EBL::PSF::MIN_RADIUS / 2.0;
-        beamerFile << r0 / CLHEP::micrometer << " " << normalizedPSF[0] << std::endl;
+void RunAction::SaveCSVFormat(const std::string& outputDir, const ResultSnapshot& result)
+{
+    // A sweep goes into one file, indexed by the Point/BeamEnergy columns
+    G4bool sweep = !fSweepEnergies.empty();
+    std::string filename(fPSFFilename);
+    if (sweep) {
+        size_t dot = filename.find_last_of('.');
+        filename = (dot == std::string::npos) ? filename + "_sweep"
+            : filename.substr(0, dot) + "_sweep" + filename.substr(dot);
     }
 
-    for (G4int i = 0; i < EBL::PSF::NUM_RADIAL_BINS; i++) {
-        G4double rCenter = GetBinRadius(i);
+    std::string actualOutputDir = fOutputDirectory.empty() ? outputDir : std::string(fOutputDirectory);
+    std::string outputPath = actualOutputDir.empty() ?
+        filename :
+        actualOutputDir + "/" + filename;
 
-        // Only output non-zero values to keep file size reasonable
-        if (normalizedPSF[i] > 1e-12) {
-            // Convert to um for BEAMER
-            beamerFile << rCenter / CLHEP::micrometer << " "
-                << normalizedPSF[i] << std::endl;
-        }
-    }
+    G4cout << "Saving PSF data to: " << outputPath << G4endl;
+    AsyncWriter::Instance()->Submit(outputPath, [result, sweep](std::ostream& out) {
+        PSFExport::FormatCSV(*result, out, sweep);
+        return true;
+    });
+    PSFExport::PrintCSVStatistics(*result);
+}
 
-    beamerFile.close();
-    G4cout << "BEAMER format saved successfully" << G4endl;
+void RunAction::SaveBEAMERFormat(const std::string& outputDir, const ResultSnapshot& result)
+{
+    // One BEAMER file per sweep point, named after its beam energy
+    std::string actualOutputDir = fOutputDirectory.empty() ? outputDir : std::string(fOutputDirectory);
+    for (G4int point = 0; point < GetNumberOfSweepPoints(); point++) {
+        std::string filename = GetPointFilename(fBeamerFilename, point);
+        std::string outputPath = actualOutputDir.empty() ?
+            filename :
+            actualOutputDir + "/" + filename;
+        G4cout << "Saving BEAMER format to: " << outputPath << G4endl;
+        AsyncWriter::Instance()->Submit(outputPath, [result, point](std::ostream& out) {
+            PSFExport::FormatBEAMER(*result, point, out);
+            return true;
+        });
+        PSFExport::PrintBEAMERParameters(*result, point);
+    }
+}
 
-    // Calculate and report key PSF parameters
-    G4double forward_fraction = 0;
-    G4double total_integral = 0;
+void RunAction::SaveSpotSizes(const std::string& outputDir, const PSFResultFile& result)
+{
+    // The run's own beam is already in the PSF: a spot of FWHM F is the
+    // run's PSF blurred by sqrt(F^2 - F0^2). Point-source runs
+    // (/gun/beamSize 0) give every F.
+    const G4double beamSize = fPrimaryGenerator ? fPrimaryGenerator->GetBeamSize() : 0.;
+    std::string actualOutputDir = fOutputDirectory.empty() ? outputDir : std::string(fOutputDirectory);
+    G4bool sweep = !fSweepEnergies.empty();
+
+    for (G4double spotSize : fSpotSizes) {
+        if (spotSize < beamSize) {
+            G4ExceptionDescription msg;
+            msg << "Spot size " << G4BestUnit(spotSize, "Length") << " is below the simulated beam size "
+                << G4BestUnit(beamSize, "Length") << "; skipped (use /gun/beamSize 0)";
+            G4Exception("RunAction::SaveSpotSizes", "SPOT001", JustWarning, msg);
+            continue;
+        }
 
-    // Calculate forward scattering fraction (< 1 μm)
-    for (G4int i = 0; i < EBL::PSF::NUM_RADIAL_BINS; i++) {
-        if (GetBinRadius(i) < 1.0 * CLHEP::micrometer) {
-            G4double rInner, rOuter;
-            GetBinBoundaries(i, rInner, rOuter);
-            G4double area = CLHEP::pi * (rOuter * rOuter - rInner * rInner);
-            forward_fraction += normalizedPSF[i] * area;
-            total_integral += normalizedPSF[i] * area;
-        } else {
-            G4double rInner, rOuter;
-            GetBinBoundaries(i, rInner, rOuter);
-            G4double area = CLHEP::pi * (rOuter * rOuter - rInner * rInner);
-            total_integral += normalizedPSF[i] * area;
+        // The convolution itself stays on this thread; only the files are queued
+        G4cout << "\nDeriving the PSF of a " << G4BestUnit(spotSize, "Length") << " spot" << G4endl;
+        auto spot = std::make_shared<PSFResultFile>();
+        PSFConvolution::Gaussian(result, std::sqrt(spotSize * spotSize - beamSize * beamSize), *spot);
+        ResultSnapshot snapshot = spot;
+
+        std::string csvName = PSFConvolution::SpotFilename(fPSFFilename, spotSize);
+        std::string csvPath = actualOutputDir.empty() ? csvName : actualOutputDir + "/" + csvName;
+        G4cout << "Saving PSF data to: " << csvPath << G4endl;
+        AsyncWriter::Instance()->Submit(csvPath, [snapshot, sweep](std::ostream& out) {
+            PSFExport::FormatCSV(*snapshot, out, sweep);
+            return true;
+        });
+        for (G4int point = 0; point < GetNumberOfSweepPoints(); point++) {
+            std::string filename = GetPointFilename(PSFConvolution::SpotFilename(fBeamerFilename, spotSize), point);
+            std::string beamerPath = actualOutputDir.empty() ? filename : actualOutputDir + "/" + filename;
+            G4cout << "Saving BEAMER format to: " << beamerPath << G4endl;
+            AsyncWriter::Instance()->Submit(beamerPath, [snapshot, point](std::ostream& out) {
+                PSFExport::FormatBEAMER(*snapshot, point, out);
+                return true;
+            });
+            PSFExport::PrintBEAMERParameters(*snapshot, point);
         }
     }
+}
 
-    if (total_integral > 0) {
-        G4double alpha = forward_fraction / total_integral;
-        G4double beta = 1.0 - alpha;
-
-        G4cout << "\nPSF Parameters for BEAMER:" << G4endl;
-        G4cout << "  Forward scatter fraction (α): " << alpha << G4endl;
-        G4cout << "  Backscatter fraction (β): " << beta << G4endl;
+void RunAction::SaveSweepIndex(const std::string& outputDir)
+{
+    // Index of the sweep result set: one line per point with its files
+    std::string actualOutputDir = fOutputDirectory.empty() ? outputDir : std::string(fOutputDirectory);
+    std::string indexPath = actualOutputDir.empty() ?
+        std::string("sweep_index.csv") :
+        actualOutputDir + "/sweep_index.csv";
+
+    std::ostringstream indexFile;
+    indexFile << "Point,BeamEnergy(keV),Events,BeamerFile" << '\n';
+    for (G4int point = 0; point < GetNumberOfSweepPoints(); point++) {
+        indexFile << point << "," << GetBeamEnergy(point) / CLHEP::keV << ","
+            << GetEventsAtPoint(point) << ","
+            << GetPointFilename(fBeamerFilename, point) << '\n';
     }
+
+    AsyncWriter::Instance()->Submit(indexPath, indexFile.str());
+    G4cout << "Sweep index saved to: " << indexPath << G4endl;
 }
 
 void RunAction::Save2DFormat(const std::string& outputDir)
 {
-    // Skip for BEAMER-only mode
-    return;
+    // One table per sweep point: a row per depth bin (nm below the resist
+    // surface, bin centre), a column per radial bin centre (nm), values in
+    // eV/nm^3 per primary - read by the GUI's 2D tab
+    std::string actualOutputDir = fOutputDirectory.empty() ? outputDir : std::string(fOutputDirectory);
+    const G4int numBins = fBinning.GetNumberOfBins();
+    const G4int numDepthBins = fActiveDepthBins;
+    const G4double depthWidth = fDepthRange / fActiveDepthBins;
+    const PSFBinning binning = fBinning;
+
+    // The next run resets the histogram; the writer gets a copy
+    auto depth = std::make_shared<DepthResult>();
+    depth->sum = fDepthHistogram.GetValues();
+    depth->events = fDepthPointEvents;
+    depth->numDepthBins = fActiveDepthBins;
+    depth->depthRange = fDepthRange;
+    fLastDepthResult = depth;
+    DepthSnapshot snapshot = depth;
+
+    for (G4int point = 0; point < GetNumberOfSweepPoints(); point++) {
+        std::string filename = GetPointFilename(fPSF2DFilename, point);
+        std::string outputPath = actualOutputDir.empty() ?
+            filename :
+            actualOutputDir + "/" + filename;
+
+        // Tallies started with the run or, after --resume, with the first
+        // resumed batch
+        const G4double events = fDepthPointEvents[point];
+        if (events <= 0) continue;
+
+        AsyncWriter::Instance()->Submit(outputPath, [=](std::ostream& outFile) {
+            const std::vector<G4double>& values = snapshot->sum;
+            outFile << "Depth(nm)";
+            for (G4int i = 0; i < numBins; i++) {
+                outFile << "," << binning.GetCenter(i) / nm;
+            }
+            outFile << "\n";
+
+            outFile << std::scientific << std::setprecision(6);
+            for (G4int j = 0; j < numDepthBins; j++) {
+                outFile << std::defaultfloat << (j + 0.5) * depthWidth / nm << std::scientific;
+                for (G4int i = 0; i < numBins; i++) {
+                    G4double volume = binning.GetArea(i) * depthWidth;
+                    G4double energy = values[(static_cast<size_t>(point) * numBins + i) * numDepthBins + j];
+                    outFile << "," << energy / eV / (volume / (nm * nm * nm)) / events;
+                }
+                outFile << "\n";
+            }
+            return true;
+        });
+
+        G4cout << "2D depth profile saved to: " << outputPath << G4endl;
+    }
 }
 
-void RunAction::SaveSummary(const std::string& outputDir)
+void RunAction::SaveDoseMap(const std::string& outputDir)
+{
+    // Energy absorbed per resist volume over the whole exposure (eV/nm^3,
+    // averaged over the thickness), row 0 at the smallest y - the layout of
+    // ebl_expose maps of rectangle lists
+    std::string actualOutputDir = fOutputDirectory.empty() ? outputDir : std::string(fOutputDirectory);
+    std::string outputPath = actualOutputDir.empty() ?
+        std::string(fDoseMapFilename) :
+        actualOutputDir + "/" + std::string(fDoseMapFilename);
+
+    const G4double thickness = fDetConstruction->GetActualResistThickness();
+    const G4double unit = fDoseMapPixel * fDoseMapPixel * thickness * (eV / (nm * nm * nm));
+
+    DoseMapFile map;
+    if (!map.Open(outputPath, fDoseMapWidth, fDoseMapHeight)) return;
+
+    const std::vector<G4double>& values = fDoseMap.GetValues();
+    std::vector<G4double> row(fDoseMapWidth);
+    for (G4int y = 0; y < fDoseMapHeight; y++) {
+        auto first = values.begin() + static_cast<size_t>(y) * fDoseMapWidth;
+        std::copy(first, first + fDoseMapWidth, row.begin());
+        map.WriteRow(row, unit);
+    }
+    if (map.Close()) {
+        G4cout << "Dose map saved to: " << outputPath << " (" << fDoseMapWidth << " x "
+            << fDoseMapHeight << " pixels of " << fDoseMapPixel / nm << " nm from ("
+            << fDoseMapX0 / nm << ", " << fDoseMapY0 / nm << ") nm, peak "
+            << map.GetMaximum() << " eV/nm^3)" << G4endl;
+    }
+}
+
+std::string RunAction::SummaryPath(const std::string& outputDir) const
 {
     std::string actualOutputDir = fOutputDirectory.empty() ? outputDir : std::string(fOutputDirectory);
-    std::string summaryPath = actualOutputDir.empty() ?
+    return actualOutputDir.empty() ?
         std::string(fSummaryFilename) :
         actualOutputDir + "/" + std::string(fSummaryFilename);
+}
+
+void RunAction::SaveSummary(const std::string& outputDir)
+{
+    std::string summaryPath = SummaryPath(outputDir);
 
-    std::ofstream summaryFile(summaryPath);
+    std::ostringstream summaryFile;
 
     summaryFile << "BEAMER PSF Simulation Summary" << std::endl;
     summaryFile << "=============================" << std::endl;
@@ -501,7 +1106,7 @@ void RunAction::SaveSummary(const std::string& outputDir)
 
     // Simulation time
     auto endTime = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::seconds>(endTime - fStartTime);
+    std::chrono::duration<G4double> duration = endTime - fStartTime;
     summaryFile << "\nPerformance:" << std::endl;
     summaryFile << "Simulation time: " << duration.count() << " seconds" << std::endl;
     if (duration.count() > 0) {
@@ -509,10 +1114,25 @@ void RunAction::SaveSummary(const std::string& outputDir)
     }
 
     // Beam and resist info
-    if (fPrimaryGenerator) {
+    if (!fSweepEnergies.empty()) {
+        summaryFile << "\nBeam energy sweep (see sweep_index.csv):" << std::endl;
+        for (G4int point = 0; point < GetNumberOfSweepPoints(); point++) {
+            summaryFile << "Point " << point << ": " << G4BestUnit(fSweepEnergies[point], "Energy")
+                << ", " << GetEventsAtPoint(point) << " events" << std::endl;
+        }
+    }
+    else if (fPrimaryGenerator) {
         summaryFile << "\nBeam parameters:" << std::endl;
         summaryFile << "Energy: " << G4BestUnit(fPrimaryGenerator->GetParticleGun()->GetParticleEnergy(), "Energy") << std::endl;
     }
+    if (fDoseMapWidth > 0) {
+        const ShotList* shots = ShotList::Instance();
+        summaryFile << "\nShot list: " << shots->GetNumberOfShots() << " shots, "
+            << shots->GetNumberOfElectrons() << " electrons" << std::endl;
+        summaryFile << "Dose map: " << fDoseMapWidth << " x " << fDoseMapHeight << " pixels of "
+            << fDoseMapPixel / nm << " nm from (" << fDoseMapX0 / nm << ", "
+            << fDoseMapY0 / nm << ") nm" << std::endl;
+    }
 
     if (fDetConstruction) {
         summaryFile << "\nResist parameters:" << std::endl;
@@ -520,6 +1140,29 @@ void RunAction::SaveSummary(const std::string& outputDir)
         summaryFile << "Density: " << G4BestUnit(fDetConstruction->GetResistDensity(), "Volumic Mass") << std::endl;
     }
 
-    summaryFile.close();
+    summaryFile << "\nImportance biasing: "
+        << (ImportanceBiasing::Instance()->IsEnabled() ? "enabled (weighted deposits)" : "off") << std::endl;
+
+    // Phases so far; the save of this run is in the Chrome trace only
+    TraceRecorder* trace = TraceRecorder::Instance();
+    if (trace->IsEnabled()) {
+        summaryFile << "\nPhase timing (/ebl/perf/trace, whole launch):" << std::endl;
+        trace->PrintPhases(summaryFile);
+    }
+
+    AsyncWriter::Instance()->Submit(summaryPath, summaryFile.str());
     G4cout << "Summary saved to: " << summaryPath << G4endl;
+}
+
+void RunAction::SaveTrace()
+{
+    // After SaveResults, so the output of this run is in the trace as well
+    std::string summaryPath = SummaryPath(PrepareOutputDirectory());
+    std::filesystem::path tracePath =
+        std::filesystem::path(summaryPath).parent_path() / "simulation_trace.json";
+
+    std::ostringstream json;
+    TraceRecorder::Instance()->WriteChromeTrace(json);
+    AsyncWriter::Instance()->Submit(tracePath.string(), json.str());
+    G4cout << "Trace saved to: " << tracePath.string() << G4endl;
 }
\ No newline at end of file
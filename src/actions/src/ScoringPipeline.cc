@@ -0,0 +1,109 @@
+// ScoringPipeline.cc - Choice of the scoring pipeline
+#include "ScoringPipeline.hh"
+#include "EBLConstants.hh"
+#include <atomic>
+
+namespace {
+    Scoring::Mode gMode = EBL::Debug::VERBOSE_SCORING ? Scoring::Mode::kDiagnostics
+                                                      : Scoring::Mode::kRadial;
+
+    // Set by the worker threads' Build
+    std::atomic<bool> gBuilt(false);
+
+    template <class Policy>
+    const char* Missing(G4bool depth, G4bool weighted, G4bool sweep, G4bool doseMap)
+    {
+        if (depth && !Policy::kDepth) return "depth-resolved scoring (/ebl/psf/depth)";
+        if (weighted && !Policy::kWeighted) return "weighted deposits (biasing or phase-space replay)";
+        if (sweep && !Policy::kSweep) return "energy sweeps (/ebl/sweep/)";
+        if (doseMap && !Policy::kDoseMap) return "shot dose maps (/ebl/shots/)";
+        return nullptr;
+    }
+}
+
+namespace Scoring {
+
+void SetMode(Mode mode)
+{
+    gMode = mode;
+}
+
+Mode GetMode()
+{
+    return gMode;
+}
+
+G4bool ParseMode(const G4String& name, Mode& mode)
+{
+    for (Mode candidate : { Mode::kRadial, Mode::kDepth, Mode::kWeighted, Mode::kFull, Mode::kDiagnostics }) {
+        if (name == ModeName(candidate)) {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* ModeName(Mode mode)
+{
+    switch (mode) {
+    case Mode::kRadial:      return "radial";
+    case Mode::kDepth:       return "depth";
+    case Mode::kWeighted:    return "weighted";
+    case Mode::kFull:        return "full";
+    case Mode::kDiagnostics: return "diagnostics";
+    }
+    return "full";
+}
+
+G4bool IsBuilt()
+{
+    return gBuilt;
+}
+
+EventAction* CreateEventAction(Mode mode, RunAction* runAction,
+                               DetectorConstruction* detConstruction)
+{
+    gBuilt = true;
+    switch (mode) {
+    case Mode::kRadial:
+        return new ScoringPipeline<ScoringPolicy::RadialOnly>(runAction, detConstruction);
+    case Mode::kDepth:
+        return new ScoringPipeline<ScoringPolicy::RadialDepth>(runAction, detConstruction);
+    case Mode::kWeighted:
+        return new ScoringPipeline<ScoringPolicy::Weighted>(runAction, detConstruction);
+    case Mode::kDiagnostics:
+        return new ScoringPipeline<ScoringPolicy::Diagnostics>(runAction, detConstruction);
+    case Mode::kFull:
+        break;
+    }
+    return new ScoringPipeline<ScoringPolicy::Full>(runAction, detConstruction);
+}
+
+Mode ModeFor(G4bool depth, G4bool weighted, G4bool sweep, G4bool doseMap)
+{
+    if (sweep || doseMap || (depth && weighted)) return Mode::kFull;
+    if (depth) return Mode::kDepth;
+    if (weighted) return Mode::kWeighted;
+    return Mode::kRadial;
+}
+
+const char* MissingFeature(Mode mode, G4bool depth, G4bool weighted,
+                           G4bool sweep, G4bool doseMap)
+{
+    switch (mode) {
+    case Mode::kRadial:
+        return Missing<ScoringPolicy::RadialOnly>(depth, weighted, sweep, doseMap);
+    case Mode::kDepth:
+        return Missing<ScoringPolicy::RadialDepth>(depth, weighted, sweep, doseMap);
+    case Mode::kWeighted:
+        return Missing<ScoringPolicy::Weighted>(depth, weighted, sweep, doseMap);
+    case Mode::kDiagnostics:
+        return Missing<ScoringPolicy::Diagnostics>(depth, weighted, sweep, doseMap);
+    case Mode::kFull:
+        break;
+    }
+    return Missing<ScoringPolicy::Full>(depth, weighted, sweep, doseMap);
+}
+
+}
@@ -1,135 +1,202 @@
-// StackingAction.cc - Track killing for BEAMER efficiency with optimized reporting
+// StackingAction.cc - Track killing for BEAMER efficiency
 #include "StackingAction.hh"
+#include "StackingMessenger.hh"
 #include "DetectorConstruction.hh"
+#include "EventAction.hh"
+#include "ScoringPipeline.hh"
+#include "PerfMonitor.hh"
+#include "ImportanceBiasing.hh"
 #include "G4Track.hh"
-#include "G4ParticleDefinition.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Electron.hh"
+#include "G4Gamma.hh"
+#include "G4Region.hh"
+#include "Randomize.hh"
+#include "G4EmParameters.hh"
+#include "G4RunManager.hh"
+#include "G4Run.hh"
+#include "G4StateManager.hh"
+#include "G4EventManager.hh"
+#include "G4StackManager.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4UnitsTable.hh"
-#include "G4RunManager.hh"
-#include <cstdio>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    G4long ToEV(G4double energy)
+    {
+        return std::llround(energy / eV);
+    }
+}
 
 StackingAction::StackingAction(DetectorConstruction* detector)
     : G4UserStackingAction(),
       fDetector(detector),
       fResistTop(0),
       fResistBottom(0),
-      fKillEnergyThreshold(100*eV),  // Kill very low energy particles
-      fKilledTracks(0),
-      fTotalTracks(0),
-      fEventNumber(0)
+      fRangeKill(true),
+      fRangeSafetyFactor(1.2),      // margin for energy-loss straggling
+      fKillEscaping(true),
+      fGammaThreshold(10*eV),
+      fElectron(G4Electron::Definition()),
+      fGamma(G4Gamma::Definition()),
+      fRangeTableRunID(-1),
+      fBiasingEnabled(false),
+      fWaitingMode(WaitingMode::kOff),
+      fWaitingBudget(1.0 * keV),
+      fDeferDepth(1.0 * micrometer),
+      fWaitingEnergy(0.),
+      fStageEnergy(0.),
+      fStageResistStart(0.),
+      fReclassifyWeight(0.),
+      fEventAction(nullptr),
+      fEventNumber(0),
+      fPerfCounters(PerfMonitor::Instance()->GetThreadCounters()),
+      fMessenger(nullptr)
 {
     // Get resist dimensions
     if (fDetector) {
         fResistTop = fDetector->GetActualResistThickness();
         fResistBottom = 0.0;
     }
+
+    fMessenger = new StackingMessenger(this);
 }
 
 StackingAction::~StackingAction()
 {
-    // Report final statistics
-    if (fTotalTracks > 0) {
-        printf("\n=== StackingAction Final Statistics ===\n");
-        printf("Total tracks: %ld\n", fTotalTracks);
-        printf("Killed tracks: %ld\n", fKilledTracks);
-        printf("Kill rate: %.1f%%\n", (100.0 * fKilledTracks / fTotalTracks));
-        printf("======================================\n");
-        fflush(stdout);
-    }
+    delete fMessenger;
 }
 
 G4ClassificationOfNewTrack StackingAction::ClassifyNewTrack(const G4Track* track)
 {
-    fTotalTracks++;
+    // Roulette survivors of a waiting stage, already classified once
+    if (fReclassifyWeight > 0.) {
+        const_cast<G4Track*>(track)->SetWeight(track->GetWeight() * fReclassifyWeight);
+        return fUrgent;
+    }
 
-    // Get track properties
+    fPerfCounters->Add(PerfThreadCounters::kTracksPushed);
+
+    const G4ParticleDefinition* particle = track->GetDefinition();
     G4double z = track->GetPosition().z();
     G4double energy = track->GetKineticEnergy();
-    G4ParticleDefinition* particle = track->GetDefinition();
-    G4String particleName = particle->GetParticleName();
-
-    // BEAMER optimization: Kill tracks that won't contribute to resist energy
 
-    // 1. Kill very low energy electrons deep in substrate
-    if (particleName == "e-" && z < -10*micrometer && energy < 1*keV) {
-        fKilledTracks++;
+    // Very low energy photons anywhere
+    if (particle == fGamma && energy < fGammaThreshold) {
+        fPerfCounters->Add(PerfThreadCounters::kKillLowEnergyPhoton);
         return fKill;
     }
 
-    // 2. Kill low energy particles far above resist
-    if (z > fResistTop + 1*micrometer && energy < fKillEnergyThreshold) {
-        fKilledTracks++;
-        return fKill;
-    }
-
-    // 3. Kill very low energy photons anywhere (they won't reach resist)
-    if (particleName == "gamma" && energy < 10*eV) {
-        fKilledTracks++;
-        return fKill;
+    // Above the resist: the world is vacuum without fields, so anything
+    // moving away from the resist never returns
+    if (z > fResistTop) {
+        if (fKillEscaping && track->GetMomentumDirection().z() >= 0.) {
+            fPerfCounters->Add(PerfThreadCounters::kKillEscaping);
+            return fKill;
+        }
+        return fUrgent;
     }
 
-    // 4. Kill electrons moving away from resist with low energy
-    if (particleName == "e-") {
-        G4ThreeVector momentum = track->GetMomentumDirection();
-
-        // If deep in substrate and moving downward
-        if (z < -5*micrometer && momentum.z() < 0 && energy < 5*keV) {
-            fKilledTracks++;
-            return fKill;
+    // Below the resist: an electron must travel at least the distance to
+    // the resist bottom, which it cannot do if that exceeds its CSDA range
+    // in the material it starts in
+    if (particle == fElectron && z < fResistBottom) {
+        const G4VPhysicalVolume* volume = track->GetVolume();
+        if (fRangeKill && volume) {
+            G4double range = fElectronRanges.GetRange(
+                energy, volume->GetLogicalVolume()->GetMaterial());
+            if (range * fRangeSafetyFactor < fResistBottom - z) {
+                fPerfCounters->Add(PerfThreadCounters::kKillOutOfRange);
+                return fKill;
+            }
         }
 
-        // If above resist and moving upward
-        if (z > fResistTop && momentum.z() > 0 && energy < 1*keV) {
-            fKilledTracks++;
-            return fKill;
+        // Importance biasing: Russian roulette for deep electrons heading
+        // away from the resist. Survivors carry weight w/p.
+        if (fBiasingEnabled && volume && track->GetMomentumDirection().z() < 0.) {
+            const RegionBiasing* biasing = ImportanceBiasing::Instance()->Find(
+                volume->GetLogicalVolume()->GetRegion());
+            if (biasing && biasing->survivalProbability < 1. &&
+                fResistBottom - z > biasing->rouletteDepth) {
+                if (G4UniformRand() >= biasing->survivalProbability) {
+                    fPerfCounters->Add(PerfThreadCounters::kKillRoulette);
+                    return fKill;
+                }
+                const_cast<G4Track*>(track)->SetWeight(
+                    track->GetWeight() / biasing->survivalProbability);
+            }
         }
     }
 
-    // 5. Range-based killing: estimate if particle can reach resist
-    if (particleName == "e-") {
-        // Rough estimate of electron range in silicon
-        // R ≈ 0.4 * E^1.75 (R in μm, E in keV)
-        G4double energyKeV = energy / keV;
-        G4double estimatedRange = 0.4 * std::pow(energyKeV, 1.75) * micrometer;
+    // Staging: deep substrate secondaries wait for the urgent stack
+    if (fWaitingMode != WaitingMode::kOff && track->GetParentID() > 0 &&
+        z < fResistBottom - fDeferDepth) {
+        fWaitingEnergy += track->GetWeight() * energy;
+        fPerfCounters->Add(PerfThreadCounters::kTracksDeferred);
+        return fWaiting;
+    }
 
-        // If in substrate and can't reach resist
-        if (z < 0 && std::abs(z) > estimatedRange + 100*nm) {
-            fKilledTracks++;
-            return fKill;
-        }
+    // Track all others urgently
+    return fUrgent;
+}
 
-        // If above resist and can't reach back
-        if (z > fResistTop && (z - fResistTop) > estimatedRange) {
-            fKilledTracks++;
-            return fKill;
+void StackingAction::NewStage()
+{
+    // Called when the urgent stack is empty; the waiting tracks have just
+    // been moved to it
+    CloseDrainedStage();
+
+    // Geant4 also opens a stage once both stacks are empty, at the end of
+    // every event; it is not a staged decision
+    G4double energy = fWaitingEnergy;
+    fWaitingEnergy = 0.;
+    if (stackManager->GetNUrgentTrack() == 0) return;
+    if (fWaitingMode == WaitingMode::kOff) return;
+
+    G4bool drain = true;
+    if (fWaitingMode == WaitingMode::kBudget) {
+        drain = energy >= fWaitingBudget;
+    }
+    else if (fWaitingMode == WaitingMode::kRoulette && energy < fWaitingBudget) {
+        G4double probability = fWaitingBudget > 0. ? energy / fWaitingBudget : 1.;
+        drain = G4UniformRand() < probability;
+        if (drain && probability > 0.) {
+            fReclassifyWeight = 1. / probability;
+            stackManager->ReClassify();
+            fReclassifyWeight = 0.;
         }
     }
 
-    // OPTIMIZED statistics reporting - much less frequent for large simulations
-    G4long reportInterval;
-    if (fTotalTracks < 1000000) {
-        reportInterval = 100000;      // Every 100k tracks initially
-    } else if (fTotalTracks < 10000000) {
-        reportInterval = 500000;      // Every 500k tracks for medium load
-    } else {
-        reportInterval = 1000000;     // Every 1M tracks for high load
+    if (drain) {
+        fPerfCounters->Add(PerfThreadCounters::kStagesDrained);
+        fPerfCounters->Add(PerfThreadCounters::kStageEnergyDrained, ToEV(energy));
+        fStageEnergy = energy;
+        fStageResistStart = GetResistEnergy();
+        return;
     }
 
-    if (fTotalTracks % reportInterval == 0) {
-        G4double killRate = 100.0 * fKilledTracks / fTotalTracks;
-        printf("StackingAction: Processed %ld tracks, killed %.1f%%\n",
-               fTotalTracks, killRate);
-        fflush(stdout);
-    }
+    fPerfCounters->Add(PerfThreadCounters::kStagesDropped);
+    fPerfCounters->Add(PerfThreadCounters::kStageEnergyDropped, ToEV(energy));
+    fPerfCounters->Add(PerfThreadCounters::kKillWaitingStack, stackManager->GetNUrgentTrack());
+    stackManager->clear();
+}
 
-    // Track all others urgently
-    return fUrgent;
+void StackingAction::CloseDrainedStage()
+{
+    if (fStageEnergy <= 0.) return;
+    G4double deposited = GetResistEnergy() - fStageResistStart;
+    if (deposited > 0.) {
+        fPerfCounters->Add(PerfThreadCounters::kStageResistEnergy, ToEV(deposited));
+    }
+    fStageEnergy = 0.;
 }
 
-void StackingAction::NewStage()
+G4double StackingAction::GetResistEnergy() const
 {
-    // Called when urgent stack becomes empty
-    // Can be used for stage-by-stage processing
+    return fEventAction ? fEventAction->GetResistEnergy() : 0.;
 }
 
 void StackingAction::PrepareNewEvent()
@@ -137,8 +204,75 @@ void StackingAction::PrepareNewEvent()
     // Reset event-level counters if needed
     fEventNumber++;
 
+    // The last drained stage of the previous event ends with it. This runs
+    // before BeginOfEventAction, so the event action still holds the
+    // previous event's resist energy.
+    if (!fEventAction) {
+        fEventAction = dynamic_cast<EventAction*>(
+            G4EventManager::GetEventManager()->GetUserEventAction());
+    }
+    CloseDrainedStage();
+    fWaitingEnergy = 0.;
+
     // Update resist thickness in case it changed
     if (fDetector) {
         fResistTop = fDetector->GetActualResistThickness();
     }
-}
\ No newline at end of file
+
+    fBiasingEnabled = ImportanceBiasing::Instance()->IsEnabled();
+
+    // Physics tables (and materials) may change between runs
+    const G4Run* run = G4RunManager::GetRunManager()->GetCurrentRun();
+    if (run && run->GetRunID() != fRangeTableRunID) {
+        fRangeTableRunID = run->GetRunID();
+        if (fWaitingMode == WaitingMode::kRoulette &&
+            Scoring::MissingFeature(Scoring::GetMode(), false, true, false, false)) {
+            G4ExceptionDescription msg;
+            msg << "Waiting-stack roulette gives weighted tracks, which the "
+                << Scoring::ModeName(Scoring::GetMode()) << " scoring pipeline does not score";
+            G4Exception("StackingAction::PrepareNewEvent", "STACK001", FatalException, msg);
+        }
+        if (fRangeKill) {
+            BuildRangeTable();
+        }
+    }
+}
+
+void StackingAction::BuildRangeTable()
+{
+    G4EmParameters* param = G4EmParameters::Instance();
+    fElectronRanges.Build(fElectron, param->MinKinEnergy(),
+                          param->MaxEnergyForCSDARange(), param->NumberOfBinsPerDecade());
+}
+
+void StackingAction::PrintRules()
+{
+    // The master copy never processes events; build its table on demand
+    // (after /run/initialize the physics tables are available)
+    if (fRangeKill && !fElectronRanges.IsBuilt() &&
+        G4StateManager::GetStateManager()->GetCurrentState() == G4State_Idle) {
+        BuildRangeTable();
+    }
+
+    G4cout << "\n=== StackingAction kill rules ===" << G4endl;
+    G4cout << " Out of range (e- below resist): " << (fRangeKill ? "on" : "off")
+        << ", safety factor " << fRangeSafetyFactor << G4endl;
+    G4cout << " Escaping (above resist, moving away): " << (fKillEscaping ? "on" : "off") << G4endl;
+    G4cout << " Low-energy gamma: ";
+    if (fGammaThreshold > 0.) {
+        G4cout << "below " << G4BestUnit(fGammaThreshold, "Energy") << G4endl;
+    } else {
+        G4cout << "off" << G4endl;
+    }
+    static const char* const waitingModes[] = { "off", "drain", "budget", "roulette" };
+    G4cout << " Waiting stack: " << waitingModes[static_cast<G4int>(fWaitingMode)];
+    if (fWaitingMode != WaitingMode::kOff) {
+        G4cout << ", secondaries deeper than " << G4BestUnit(fDeferDepth, "Length");
+        if (fWaitingMode != WaitingMode::kDrain) {
+            G4cout << ", budget " << G4BestUnit(fWaitingBudget, "Energy");
+        }
+    }
+    G4cout << G4endl;
+    fElectronRanges.Print();
+    G4cout << "=================================" << G4endl;
+}
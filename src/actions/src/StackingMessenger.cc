@@ -0,0 +1,125 @@
+// StackingMessenger.cc
+#include "StackingMessenger.hh"
+#include "StackingAction.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+StackingMessenger::StackingMessenger(StackingAction* stackingAction)
+    : G4UImessenger(),
+    fStackingAction(stackingAction)
+{
+    fStackDir = new G4UIdirectory("/ebl/stack/");
+    fStackDir->SetGuidance("Early track-killing rules (counters in /ebl/perf/dump)");
+
+    fRangeKillCmd = new G4UIcmdWithABool("/ebl/stack/rangeKill", this);
+    fRangeKillCmd->SetGuidance("Kill electrons below the resist whose CSDA range");
+    fRangeKillCmd->SetGuidance("cannot reach it");
+    fRangeKillCmd->SetParameterName("enable", true);
+    fRangeKillCmd->SetDefaultValue(true);
+    fRangeKillCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fRangeSafetyCmd = new G4UIcmdWithADouble("/ebl/stack/rangeSafety", this);
+    fRangeSafetyCmd->SetGuidance("Multiply CSDA ranges by this factor before comparing");
+    fRangeSafetyCmd->SetGuidance("with the distance to the resist (default 1.2)");
+    fRangeSafetyCmd->SetParameterName("factor", false);
+    fRangeSafetyCmd->SetRange("factor>=1.");
+    fRangeSafetyCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fKillEscapingCmd = new G4UIcmdWithABool("/ebl/stack/killEscaping", this);
+    fKillEscapingCmd->SetGuidance("Kill tracks above the resist moving away from it");
+    fKillEscapingCmd->SetParameterName("enable", true);
+    fKillEscapingCmd->SetDefaultValue(true);
+    fKillEscapingCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fGammaThresholdCmd = new G4UIcmdWithADoubleAndUnit("/ebl/stack/gammaThreshold", this);
+    fGammaThresholdCmd->SetGuidance("Kill photons below this energy (0 disables)");
+    fGammaThresholdCmd->SetParameterName("energy", false);
+    fGammaThresholdCmd->SetRange("energy>=0.");
+    fGammaThresholdCmd->SetUnitCategory("Energy");
+    fGammaThresholdCmd->SetDefaultUnit("eV");
+    fGammaThresholdCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fWaitingCmd = new G4UIcmdWithAString("/ebl/stack/waiting", this);
+    fWaitingCmd->SetGuidance("Send substrate secondaries deeper than deferDepth to the");
+    fWaitingCmd->SetGuidance("waiting stack, and when the urgent stack is empty:");
+    fWaitingCmd->SetGuidance("  drain    - track them all");
+    fWaitingCmd->SetGuidance("  budget   - drop them if their energy is below waitingBudget");
+    fWaitingCmd->SetGuidance("  roulette - track them with probability energy/waitingBudget");
+    fWaitingCmd->SetGuidance("             and weight 1/p (needs a weighted scoring pipeline)");
+    fWaitingCmd->SetParameterName("mode", false);
+    fWaitingCmd->SetCandidates("off drain budget roulette");
+    fWaitingCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fWaitingBudgetCmd = new G4UIcmdWithADoubleAndUnit("/ebl/stack/waitingBudget", this);
+    fWaitingBudgetCmd->SetGuidance("Weighted kinetic energy of a waiting stage below which");
+    fWaitingBudgetCmd->SetGuidance("budget drops and roulette plays it (default 1 keV)");
+    fWaitingBudgetCmd->SetParameterName("energy", false);
+    fWaitingBudgetCmd->SetRange("energy>=0.");
+    fWaitingBudgetCmd->SetUnitCategory("Energy");
+    fWaitingBudgetCmd->SetDefaultUnit("keV");
+    fWaitingBudgetCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fDeferDepthCmd = new G4UIcmdWithADoubleAndUnit("/ebl/stack/deferDepth", this);
+    fDeferDepthCmd->SetGuidance("Depth below the resist beyond which secondaries wait");
+    fDeferDepthCmd->SetGuidance("(default 1 um)");
+    fDeferDepthCmd->SetParameterName("depth", false);
+    fDeferDepthCmd->SetRange("depth>=0.");
+    fDeferDepthCmd->SetUnitCategory("Length");
+    fDeferDepthCmd->SetDefaultUnit("um");
+    fDeferDepthCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    fPrintCmd = new G4UIcmdWithoutParameter("/ebl/stack/print", this);
+    fPrintCmd->SetGuidance("Print the kill rules and range tables");
+    fPrintCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fPrintCmd->SetToBeBroadcasted(false);
+}
+
+StackingMessenger::~StackingMessenger()
+{
+    delete fRangeKillCmd;
+    delete fRangeSafetyCmd;
+    delete fKillEscapingCmd;
+    delete fGammaThresholdCmd;
+    delete fWaitingCmd;
+    delete fWaitingBudgetCmd;
+    delete fDeferDepthCmd;
+    delete fPrintCmd;
+    delete fStackDir;
+}
+
+void StackingMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == fRangeKillCmd) {
+        fStackingAction->SetRangeKill(fRangeKillCmd->GetNewBoolValue(newValue));
+    }
+    else if (command == fRangeSafetyCmd) {
+        fStackingAction->SetRangeSafetyFactor(fRangeSafetyCmd->GetNewDoubleValue(newValue));
+    }
+    else if (command == fKillEscapingCmd) {
+        fStackingAction->SetKillEscaping(fKillEscapingCmd->GetNewBoolValue(newValue));
+    }
+    else if (command == fGammaThresholdCmd) {
+        fStackingAction->SetGammaThreshold(fGammaThresholdCmd->GetNewDoubleValue(newValue));
+    }
+    else if (command == fWaitingCmd) {
+        using Mode = StackingAction::WaitingMode;
+        Mode mode = Mode::kOff;
+        if (newValue == "drain") mode = Mode::kDrain;
+        else if (newValue == "budget") mode = Mode::kBudget;
+        else if (newValue == "roulette") mode = Mode::kRoulette;
+        fStackingAction->SetWaitingMode(mode);
+    }
+    else if (command == fWaitingBudgetCmd) {
+        fStackingAction->SetWaitingBudget(fWaitingBudgetCmd->GetNewDoubleValue(newValue));
+    }
+    else if (command == fDeferDepthCmd) {
+        fStackingAction->SetDeferDepth(fDeferDepthCmd->GetNewDoubleValue(newValue));
+    }
+    else if (command == fPrintCmd) {
+        fStackingAction->PrintRules();
+    }
+}
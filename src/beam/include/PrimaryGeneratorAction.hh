@@ -30,7 +30,29 @@ public:
     void SetBeamPosition(const G4ThreeVector& position);
     void SetBeamDirection(const G4ThreeVector& direction);
 
+    G4double GetBeamSize() const { return fBeamSize; }
+    const G4ThreeVector& GetBeamPosition() const { return fBeamPosition; }
+    const G4ThreeVector& GetBeamDirection() const { return fBeamDirection; }
+    G4String GetParticleName() const;
+
+    // Start height above the resist top surface (/gun/position z, or the
+    // 100 nm default); unlike the start z it does not move with the
+    // thickness
+    G4double GetStartHeight() const;
+
 private:
+    // /ebl/fastsim/calibrate: one electron below the substrate surface,
+    // cycling through the cells of the backscatter response table
+    void GenerateCalibrationPrimary(G4Event* anEvent);
+
+    // /ebl/phasespace/replay: the recorded particles of this event, moving
+    // up from the substrate surface
+    void GenerateReplayedParticles(G4Event* anEvent);
+
+    // Start height: /gun/position z, or 100 nm above the resist by default
+    G4double GetStartZ();
+    G4double ResolveStartZ() const;
+
     G4ParticleGun* fParticleGun;
     DetectorConstruction* fDetConstruction;
     G4ParticleDefinition* fElectron;
@@ -40,6 +62,7 @@ private:
     G4double fBeamSize;  // Beam diameter (FWHM)
     G4ThreeVector fBeamPosition;
     G4ThreeVector fBeamDirection;
+    G4bool fWarnedAboutPosition;
 
     // Messenger for UI commands
     PrimaryGeneratorMessenger* fMessenger;
@@ -3,6 +3,10 @@
 #include "PrimaryGeneratorMessenger.hh"
 #include "DetectorConstruction.hh"
 #include "EBLConstants.hh"
+#include "BackscatterFastSim.hh"
+#include "ParameterSweep.hh"
+#include "ShotList.hh"
+#include "PhaseSpace.hh"
 
 #include "G4LogicalVolumeStore.hh"
 #include "G4LogicalVolume.hh"
@@ -11,9 +15,14 @@
 #include "G4ParticleGun.hh"
 #include "G4ParticleTable.hh"
 #include "G4ParticleDefinition.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4Event.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4UnitsTable.hh"  // For G4BestUnit
 #include "Randomize.hh"
+#include <algorithm>
+#include <cmath>
 
 PrimaryGeneratorAction::PrimaryGeneratorAction(DetectorConstruction* detConstruction)
 : G4VUserPrimaryGeneratorAction(),
@@ -24,8 +33,14 @@ PrimaryGeneratorAction::PrimaryGeneratorAction(DetectorConstruction* detConstruc
   fBeamSize(EBL::Beam::DEFAULT_SPOT_SIZE),
   fBeamPosition(G4ThreeVector(0., 0., EBL::Beam::DEFAULT_POSITION_Z)),
   fBeamDirection(G4ThreeVector(0., 0., -1.)),  // Downward
+  fWarnedAboutPosition(false),
   fMessenger(nullptr)
 {
+    // Create messenger for UI commands before the particle gun, so that our
+    // /gun/energy, /gun/position, ... take precedence over the identically
+    // named commands registered by G4ParticleGunMessenger
+    fMessenger = new PrimaryGeneratorMessenger(this);
+
     G4int n_particle = 1;
     fParticleGun = new G4ParticleGun(n_particle);
 
@@ -38,9 +53,6 @@ PrimaryGeneratorAction::PrimaryGeneratorAction(DetectorConstruction* detConstruc
     fParticleGun->SetParticlePosition(fBeamPosition);
     fParticleGun->SetParticleMomentumDirection(fBeamDirection);
 
-    // Create messenger for UI commands
-    fMessenger = new PrimaryGeneratorMessenger(this);
-
     G4cout << "PrimaryGeneratorAction initialized with:" << G4endl;
     G4cout << "  Beam energy: " << G4BestUnit(fBeamEnergy, "Energy") << G4endl;
     G4cout << "  Beam size (FWHM): " << G4BestUnit(fBeamSize, "Length") << G4endl;
@@ -56,14 +68,102 @@ PrimaryGeneratorAction::~PrimaryGeneratorAction()
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 {
+    if (BackscatterFastSim::Instance()->IsCalibrating()) {
+        GenerateCalibrationPrimary(anEvent);
+        return;
+    }
+
     // Generate a Gaussian beam with specified diameter (FWHM)
     // FWHM = 2.355 * sigma, so sigma = FWHM / 2.355
     G4double sigma = fBeamSize / (2.0 * std::sqrt(2.0 * std::log(2.0)));
+    G4double z = GetStartZ();
+
+    // Set direction (typically straight down for EBL)
+    fParticleGun->SetParticleMomentumDirection(fBeamDirection);
+
+    // Shot list: all electrons of this event's shot, each with its own
+    // offset within the spot
+    ShotList* shots = ShotList::Instance();
+    if (shots->IsActive()) {
+        G4double shotX, shotY;
+        G4int electrons = shots->GetEvent(anEvent->GetEventID(), shotX, shotY);
+        fParticleGun->SetParticleEnergy(fBeamEnergy);
+        for (G4int i = 0; i < electrons; i++) {
+            fParticleGun->SetParticlePosition(G4ThreeVector(shotX + G4RandGauss::shoot(0., sigma),
+                                                             shotY + G4RandGauss::shoot(0., sigma),
+                                                             z));
+            fParticleGun->GeneratePrimaryVertex(anEvent);
+        }
+        return;
+    }
 
     // Sample position from 2D Gaussian distribution
     G4double x = G4RandGauss::shoot(0., sigma);
     G4double y = G4RandGauss::shoot(0., sigma);
 
+    // Set the electron position with Gaussian spread in x,y
+    fParticleGun->SetParticlePosition(G4ThreeVector(x + fBeamPosition.x(),
+                                                     y + fBeamPosition.y(),
+                                                     z));
+
+    // Set energy, from the sweep point of this event when sweeping
+    G4int eventID = anEvent->GetEventID();
+    G4double energy = fBeamEnergy;
+    ParameterSweep* sweep = ParameterSweep::Instance();
+    if (sweep->IsActive()) {
+        G4int point = sweep->GetPoint(eventID);
+        ParameterSweep::SetCurrentPoint(point);
+        energy = sweep->GetEnergy(point);
+    }
+    fParticleGun->SetParticleEnergy(energy);
+
+    // Generate the primary electron
+    fParticleGun->GeneratePrimaryVertex(anEvent);
+
+    if (PhaseSpace::Instance()->IsReplaying()) {
+        GenerateReplayedParticles(anEvent);
+    }
+}
+
+void PrimaryGeneratorAction::GenerateReplayedParticles(G4Event* anEvent)
+{
+    // What came up out of the substrate in this event of the recording,
+    // started just below the surface like the fast simulation's returns
+    size_t count = 0;
+    const PhaseSpaceFile::Particle* particles =
+        PhaseSpace::Instance()->GetReplayEvent(anEvent->GetEventID(), count);
+
+    G4ParticleTable* particleTable = G4ParticleTable::GetParticleTable();
+    for (size_t i = 0; i < count; i++) {
+        const PhaseSpaceFile::Particle& recorded = particles[i];
+        G4ParticleDefinition* definition = particleTable->FindParticle(recorded.pdg);
+        if (!definition) continue;
+
+        G4PrimaryParticle* particle = new G4PrimaryParticle(definition);
+        particle->SetKineticEnergy(recorded.energy);
+        particle->SetMomentumDirection(G4ThreeVector(recorded.ux, recorded.uy, recorded.uz).unit());
+
+        G4PrimaryVertex* vertex = new G4PrimaryVertex(
+            G4ThreeVector(recorded.x, recorded.y, -1.0e-3 * nanometer), 0.);
+        vertex->SetPrimary(particle);
+        vertex->SetWeight(recorded.weight);
+        anEvent->AddPrimaryVertex(vertex);
+    }
+}
+
+G4String PrimaryGeneratorAction::GetParticleName() const
+{
+    const G4ParticleDefinition* particle = fParticleGun->GetParticleDefinition();
+    return particle ? particle->GetParticleName() : G4String("none");
+}
+
+G4double PrimaryGeneratorAction::GetStartHeight() const
+{
+    return ResolveStartZ() - fDetConstruction->GetActualResistThickness();
+}
+
+G4double PrimaryGeneratorAction::ResolveStartZ() const
+{
     // Get the resist thickness to position beam correctly
     G4double resistThickness = fDetConstruction->GetActualResistThickness();
 
@@ -77,45 +177,59 @@ void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
         // User hasn't changed from default, use smart positioning
         z = defaultZ;
     }
+    return z;
+}
+
+G4double PrimaryGeneratorAction::GetStartZ()
+{
+    G4double resistThickness = fDetConstruction->GetActualResistThickness();
+    G4double z = ResolveStartZ();
 
-    // Warn if beam position seems wrong
-    static G4bool warnedAboutPosition = false;
-    if (!warnedAboutPosition) {
+    // Warn once per generator (thread) if the beam position seems wrong
+    if (!fWarnedAboutPosition) {
         if (z < resistThickness) {
             G4cout << "WARNING: Beam starts inside or below resist! z="
                    << G4BestUnit(z, "Length") << " < resist top="
                    << G4BestUnit(resistThickness, "Length") << G4endl;
-            warnedAboutPosition = true;
+            fWarnedAboutPosition = true;
         } else if (z > resistThickness + 10.0*micrometer) {
             G4cout << "WARNING: Beam starts very far from resist! z="
                    << G4BestUnit(z, "Length") << " >> resist top="
                    << G4BestUnit(resistThickness, "Length") << G4endl;
-            warnedAboutPosition = true;
+            fWarnedAboutPosition = true;
         }
     }
+    return z;
+}
 
-    // Set the electron position with Gaussian spread in x,y
-    fParticleGun->SetParticlePosition(G4ThreeVector(x + fBeamPosition.x(),
-                                                     y + fBeamPosition.y(),
-                                                     z));
+void PrimaryGeneratorAction::GenerateCalibrationPrimary(G4Event* anEvent)
+{
+    BackscatterResponse* table = BackscatterFastSim::GetCalibrationTable();
+    if (!table || table->IsEmpty()) {
+        G4Exception("PrimaryGeneratorAction::GenerateCalibrationPrimary", "FAST004",
+            FatalException, "No backscatter calibration table on this thread");
+        return;
+    }
 
-    // Set direction (typically straight down for EBL)
-    fParticleGun->SetParticleMomentumDirection(fBeamDirection);
+    // Cells in turn, so all of them get the same number of entries
+    G4int cell = anEvent->GetEventID() % table->GetNumberOfCells();
+    G4double eLow, eHigh, dLow, dHigh, cLow, cHigh;
+    table->GetCellRange(cell, eLow, eHigh, dLow, dHigh, cLow, cHigh);
 
-    // Set energy
-    fParticleGun->SetParticleEnergy(fBeamEnergy);
+    // Log-uniform in energy like the bins, uniform in depth and cos(theta)
+    G4double energy = eLow * std::pow(eHigh / eLow, G4UniformRand());
+    G4double depth = dLow + (dHigh - dLow) * G4UniformRand();
+    G4double cosTheta = cHigh - (cHigh - cLow) * G4UniformRand();
+    G4double sinTheta = std::sqrt(std::max(0., 1. - cosTheta * cosTheta));
 
-    // Debug output for first few events
-    G4int eventID = anEvent->GetEventID();
-    if (eventID < 5 || (eventID < 100 && eventID % 20 == 0)) {
-        G4cout << "Event " << eventID << ": e- at ("
-               << (x + fBeamPosition.x())/nm << ", "
-               << (y + fBeamPosition.y())/nm << ", "
-               << z/nm << ") nm, "
-               << "E=" << fBeamEnergy/keV << " keV" << G4endl;
-    }
+    // Entry frame of the table: at x = y = 0, azimuth 0, heading down
+    fParticleGun->SetParticlePosition(G4ThreeVector(0., 0., -depth));
+    fParticleGun->SetParticleMomentumDirection(G4ThreeVector(sinTheta, 0., -cosTheta));
+    fParticleGun->SetParticleEnergy(energy);
+
+    table->AddEntry(cell);
+    BackscatterFastSim::SetCalibrationEntry(cell, energy);
 
-    // Generate the primary electron
     fParticleGun->GeneratePrimaryVertex(anEvent);
 }
 
@@ -0,0 +1,75 @@
+// AsyncWriter.hh - Background writer of the run output files
+#ifndef AsyncWriter_h
+#define AsyncWriter_h 1
+
+#include "globals.hh"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Takes the end-of-run file writes off the master thread, so the next run
+// (sweep point, batch) starts while the previous output is still going to
+// a slow or network file system. The caller captures what a file needs in
+// its serializer - an immutable copy (std::shared_ptr<const ...>) of the
+// merged tallies, never a live histogram - and submits it; one background
+// thread runs the jobs in order. Every file is serialized through a 1 MB
+// buffer into <path>.tmp and renamed over <path>, so a reader never sees a
+// partial file.
+//
+// The writer thread is not a Geant4 thread: serializers must not use
+// G4cout or G4Exception. Failed writes are reported by the next Submit or
+// Flush on the calling thread. With /ebl/output/async false, Submit
+// writes at once on the calling thread, the same way.
+class AsyncWriter {
+public:
+    // Writes the file content; false marks the file as failed
+    using Serializer = std::function<G4bool(std::ostream&)>;
+
+    static AsyncWriter* Instance();
+    ~AsyncWriter();  // waits for the queued files
+
+    void SetEnabled(G4bool enable);
+    G4bool IsEnabled() const { return fEnabled; }
+
+    void Submit(const std::string& path, Serializer serialize, G4bool binary = false);
+    void Submit(const std::string& path, std::string content);
+
+    // Waits until every submitted file is written (end of the application,
+    // before a file is read back)
+    void Flush();
+
+private:
+    AsyncWriter();
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    struct Job {
+        std::string path;
+        Serializer serialize;
+        G4bool binary;
+    };
+
+    void WriterLoop();
+    static G4bool WriteFile(const Job& job);
+    void ReportFailures();
+
+    static AsyncWriter* fInstance;
+
+    G4bool fEnabled;
+
+    std::mutex fMutex;
+    std::condition_variable fWake;   // job queued or stop
+    std::condition_variable fIdle;   // queue drained
+    std::deque<Job> fQueue;
+    G4bool fBusy;                    // a job is being written
+    G4bool fStop;
+    std::vector<std::string> fFailed;
+    std::thread fThread;             // started by the first queued job
+};
+
+#endif
@@ -0,0 +1,96 @@
+// BackscatterFastSim.hh - Settings and shared table of the deep-substrate fast simulation
+#ifndef BackscatterFastSim_h
+#define BackscatterFastSim_h 1
+
+#include "BackscatterResponse.hh"
+#include "G4Threading.hh"
+#include "globals.hh"
+
+class FastSimMessenger;
+
+// Deep-substrate electrons deposit nothing in the resist; all that matters
+// is whether, where and how they come back up through the substrate surface.
+// With /ebl/fastsim/enable, an electron heading down deeper than a trigger
+// depth is replaced by returns drawn from a BackscatterResponse table
+// (SubstrateFastModel), which is built beforehand by a calibration run with
+// the full physics (/ebl/fastsim/calibrate).
+//
+// The settings and the loaded table are process-wide and only change between
+// runs: the master loads the table at run start and the workers read it
+// lock-free. During a calibration run every thread fills its own table
+// (owned by its RunAction), reached through the thread-local pointer below.
+class BackscatterFastSim {
+public:
+    static BackscatterFastSim* Instance();
+    ~BackscatterFastSim();
+
+    // Fast simulation (A/B switch against the full physics)
+    void SetEnabled(G4bool enable) { fEnabled = enable; }
+    G4bool IsEnabled() const { return fEnabled; }
+    void SetTriggerDepth(G4double depth) { fTriggerDepth = depth; }
+    G4double GetTriggerDepth() const { return fTriggerDepth; }
+    void SetTableFile(const G4String& fileName);
+    const G4String& GetTableFile() const { return fTableFile; }
+
+    // Load the table if needed; called by the master at run start
+    void LoadTable();
+
+    // Enabled and a table is loaded
+    G4bool IsActive() const { return fEnabled && !fCalibrating && !fTable.IsEmpty(); }
+    const BackscatterResponse& GetTable() const { return fTable; }
+
+    // Calibration run
+    void SetCalibrating(G4bool calibrate) { fCalibrating = calibrate; }
+    G4bool IsCalibrating() const { return fCalibrating; }
+    void SetCalibrationFile(const G4String& fileName) { fCalibrationFile = fileName; }
+    const G4String& GetCalibrationFile() const { return fCalibrationFile; }
+    void SetEnergyAxis(G4int nBins, G4double minEnergy, G4double maxEnergy);
+    void SetDepthAxis(G4int nBins, G4double minDepth, G4double maxDepth);
+    void SetCosThetaBins(G4int nBins) { fNumCosTheta = nBins; }
+    void SetSamplesPerCell(G4int samples) { fSamplesPerCell = samples; }
+    void ConfigureCalibration(BackscatterResponse& table) const;
+
+    // Per-thread calibration state: the table of this thread and the cell and
+    // energy of the current primary
+    static void SetCalibrationTable(BackscatterResponse* table) { fCalibrationTable = table; }
+    static BackscatterResponse* GetCalibrationTable() { return fCalibrationTable; }
+    static void SetCalibrationEntry(G4int cell, G4double energy) {
+        fCalibrationCell = cell;
+        fCalibrationEnergy = energy;
+    }
+    static G4int GetCalibrationCell() { return fCalibrationCell; }
+    static G4double GetCalibrationEnergy() { return fCalibrationEnergy; }
+
+    void Print() const;
+
+private:
+    BackscatterFastSim();
+    BackscatterFastSim(const BackscatterFastSim&) = delete;
+    BackscatterFastSim& operator=(const BackscatterFastSim&) = delete;
+
+    static BackscatterFastSim* fInstance;
+    static G4ThreadLocal BackscatterResponse* fCalibrationTable;
+    static G4ThreadLocal G4int fCalibrationCell;
+    static G4ThreadLocal G4double fCalibrationEnergy;
+
+    G4bool fEnabled;
+    G4double fTriggerDepth;      // below the substrate surface (z = 0)
+    G4String fTableFile;
+    G4String fLoadedFile;        // file fTable was read from
+    BackscatterResponse fTable;
+
+    G4bool fCalibrating;
+    G4String fCalibrationFile;
+    G4int fNumEnergy;
+    G4double fMinEnergy;
+    G4double fMaxEnergy;
+    G4int fNumDepth;
+    G4double fMinDepth;
+    G4double fMaxDepth;
+    G4int fNumCosTheta;
+    G4int fSamplesPerCell;
+
+    FastSimMessenger* fMessenger;
+};
+
+#endif
@@ -0,0 +1,98 @@
+// BackscatterResponse.hh - Tabulated return of deep-substrate electrons to the surface
+#ifndef BackscatterResponse_h
+#define BackscatterResponse_h 1
+
+#include "G4VAccumulable.hh"
+#include "G4Version.hh"
+#include "globals.hh"
+#include <vector>
+
+// Response of the substrate to an electron heading down at a given depth:
+// how many electrons come back up through the substrate surface (z = 0)
+// per entering electron, and where, with which energy and direction.
+//
+// Cells are indexed by entry energy (log bins), entry depth below the
+// surface (linear bins) and entry cos(theta) w.r.t. the -z axis (linear
+// bins in (0, 1]). Every cell keeps its entry and return counts plus a
+// random subset (reservoir) of the return samples. Samples are stored in
+// the entry frame: the entry point is at x = y = 0 and the entry direction
+// lies in the xz plane (azimuth 0), so users rotate them by the actual
+// azimuth.
+//
+// Filled per thread by a calibration run with the full physics, merged
+// through G4AccumulableManager and written to disk; read back by the fast
+// simulation model.
+class BackscatterResponse : public G4VAccumulable {
+public:
+    struct Sample {
+        G4float x, y;               // return position on the surface
+        G4float energyFraction;     // E_return / E_entry
+        G4float ux, uy, uz;         // return direction (uz > 0)
+    };
+
+    struct Cell {
+        G4long entries = 0;
+        G4long returns = 0;
+        std::vector<Sample> samples;
+    };
+
+    explicit BackscatterResponse(const G4String& name = "BackscatterResponse");
+    virtual ~BackscatterResponse() = default;
+
+    // G4VAccumulable interface
+    void Merge(const G4VAccumulable& other) override;
+    void Reset() override;
+#if G4VERSION_NUMBER >= 1120
+    void Print(G4PrintOptions options = G4PrintOptions()) const override;
+#endif
+
+    // Table layout (clears the contents)
+    void SetAxes(G4int nEnergy, G4double minEnergy, G4double maxEnergy,
+                 G4int nDepth, G4double minDepth, G4double maxDepth,
+                 G4int nCosTheta, G4int maxSamplesPerCell);
+
+    G4int GetNumberOfCells() const { return static_cast<G4int>(fCells.size()); }
+    G4int GetNumberOfEnergyBins() const { return fNumEnergy; }
+    G4int GetNumberOfDepthBins() const { return fNumDepth; }
+    G4int GetNumberOfCosThetaBins() const { return fNumCosTheta; }
+    G4double GetMinEnergy() const { return fMinEnergy; }
+    G4double GetMaxEnergy() const { return fMaxEnergy; }
+    G4double GetMinDepth() const { return fMinDepth; }
+    G4double GetMaxDepth() const { return fMaxDepth; }
+    G4bool IsEmpty() const { return fCells.empty(); }
+
+    // Cell of an entering electron; energy, depth and cos(theta) outside the
+    // table are clamped to the edge bins. cosTheta = -uz of the direction.
+    G4int FindCell(G4double energy, G4double depth, G4double cosTheta) const;
+
+    // Bin edges of a cell, for generating calibration electrons
+    void GetCellRange(G4int cell, G4double& eLow, G4double& eHigh,
+                      G4double& dLow, G4double& dHigh,
+                      G4double& cLow, G4double& cHigh) const;
+
+    const Cell& GetCell(G4int cell) const { return fCells[cell]; }
+
+    // Calibration filling
+    void AddEntry(G4int cell) { ++fCells[cell].entries; }
+    void AddReturn(G4int cell, const Sample& sample, G4double random);
+
+    // Binary I/O; return false (and leave the table empty) on failure
+    G4bool Write(const G4String& fileName) const;
+    G4bool Read(const G4String& fileName);
+
+private:
+    G4int fNumEnergy;
+    G4int fNumDepth;
+    G4int fNumCosTheta;
+    G4double fMinEnergy;
+    G4double fMaxEnergy;
+    G4double fMinDepth;
+    G4double fMaxDepth;
+    G4double fLogMinEnergy;
+    G4double fInvLogEnergyStep;
+    G4int fMaxSamples;
+
+    std::vector<Cell> fCells;
+};
+
+#endif
@@ -0,0 +1,33 @@
+// BiasingMessenger.hh - /ebl/bias/ commands
+#ifndef BiasingMessenger_h
+#define BiasingMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class ImportanceBiasing;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithABool;
+class G4UIcmdWithADouble;
+class G4UIcmdWithoutParameter;
+
+class BiasingMessenger : public G4UImessenger {
+public:
+    BiasingMessenger(ImportanceBiasing* biasing);
+    virtual ~BiasingMessenger();
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+
+private:
+    ImportanceBiasing* fBiasing;
+
+    G4UIdirectory* fBiasDir;
+    G4UIcmdWithABool* fEnableCmd;
+    G4UIcommand* fRouletteCmd;
+    G4UIcommand* fSplitCmd;
+    G4UIcmdWithADouble* fMinWeightCmd;
+    G4UIcmdWithoutParameter* fPrintCmd;
+};
+
+#endif
@@ -0,0 +1,30 @@
+// CacheMessenger.hh - /ebl/cache/ commands
+#ifndef CacheMessenger_h
+#define CacheMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class PhysicsTableCache;
+class G4UIdirectory;
+class G4UIcmdWithABool;
+class G4UIcmdWithAString;
+class G4UIcmdWithoutParameter;
+
+class CacheMessenger : public G4UImessenger {
+public:
+    CacheMessenger(PhysicsTableCache* cache);
+    virtual ~CacheMessenger();
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+
+private:
+    PhysicsTableCache* fCache;
+
+    G4UIdirectory* fCacheDir;
+    G4UIcmdWithABool* fEnableCmd;
+    G4UIcmdWithAString* fDirectoryCmd;
+    G4UIcmdWithoutParameter* fPrintCmd;
+};
+
+#endif
@@ -0,0 +1,120 @@
+// ConvergenceControl.hh - Event batches until the PSF reaches a target error
+#ifndef ConvergenceControl_h
+#define ConvergenceControl_h 1
+
+#include "globals.hh"
+#include <chrono>
+#include <memory>
+
+class RunControlMessenger;
+class RunCheckpoint;
+
+// Batched runs. /ebl/run/converge replaces guessing a /run/beamOn count:
+// it launches batches of events until every radial bin in the chosen
+// radius range has a relative statistical error (of its mean deposit per
+// event) at or below the target, or the event or time budget is used up,
+// and only then writes the output. /ebl/run/beamOn runs a fixed number of
+// events the same way.
+//
+// Each batch is an ordinary run. Workers start every batch from empty
+// tallies as usual; the master run action keeps its merged tallies across
+// the batches of one loop (IsContinuing) and evaluates the errors after
+// each merge, while the workers are idle between runs, so the check never
+// holds up event processing. It reports to EndBatch(), which decides
+// whether the result is final.
+//
+// With a checkpoint directory the run action saves a RunCheckpoint after
+// every batch. Resume() (ebl_sim --resume) makes the next batch loop start
+// from the checkpoint instead of from zero: the completed batches and
+// events count towards the budget and the master engine continues where
+// it stopped.
+class ConvergenceControl {
+public:
+    static ConvergenceControl* Instance();
+    ~ConvergenceControl();
+
+    // Target relative error per bin, e.g. 0.01; 0 disables /ebl/run/converge
+    void SetTargetError(G4double error) { fTargetError = error; }
+    G4double GetTargetError() const { return fTargetError; }
+
+    // Bins with their centre in [min, max] must converge; max = 0 means
+    // up to the end of the binning
+    void SetRadiusRange(G4double minRadius, G4double maxRadius);
+    G4double GetMinRadius() const { return fMinRadius; }
+    G4double GetMaxRadius() const { return fMaxRadius; }
+
+    // Budget of /ebl/run/converge; 0 disables a limit
+    void SetBatchSize(G4int events) { fBatchSize = events; }
+    void SetMaxEvents(G4long events) { fMaxEvents = events; }
+    void SetMaxTime(G4double time) { fMaxTime = time; }
+
+    // Master, Idle state: run batches until converged or out of budget
+    void Run();
+
+    // Master, Idle state: run a fixed number of events in batches
+    void RunEvents(G4long events);
+
+    // Save a checkpoint after every batch; empty disables
+    void SetCheckpointDirectory(const G4String& directory) { fCheckpointDirectory = directory; }
+    const G4String& GetCheckpointDirectory() const { return fCheckpointDirectory; }
+
+    // Continue the next batch loop from the checkpoint in the directory
+    // (which also becomes the checkpoint directory)
+    void Resume(const G4String& directory);
+
+    // Checkpoint the master run action has to load at the start of the
+    // first batch of a resumed loop; null otherwise
+    const RunCheckpoint* GetResumeState() const { return fResumeState.get(); }
+    void ResumeApplied() { fResumeState.reset(); }
+
+    G4int GetBatches() const { return fBatches; }
+
+    // Events of the completed batches of the current loop and its budget
+    // (0 = none)
+    G4long GetEvents() const { return fEvents; }
+    G4long GetEventBudget() const { return fLoopMaxEvents; }
+
+    // A batch loop is in progress / the current run adds to the previous batch
+    G4bool IsRunning() const { return fRunning; }
+    G4bool IsContinuing() const { return fRunning && fBatches > 0; }
+
+    // Master run action, after merging a batch: events of the batch and the
+    // largest relative error in the range (and its radius). Returns true
+    // when the loop stops and the output should be written.
+    G4bool EndBatch(G4long events, G4double worstError, G4double worstRadius);
+
+    void Print() const;
+
+private:
+    ConvergenceControl();
+    ConvergenceControl(const ConvergenceControl&) = delete;
+    ConvergenceControl& operator=(const ConvergenceControl&) = delete;
+
+    void RunBatches(G4long maxEvents, G4bool useTarget);
+
+    static ConvergenceControl* fInstance;
+
+    G4double fTargetError;
+    G4double fMinRadius;
+    G4double fMaxRadius;
+    G4int fBatchSize;
+    G4long fMaxEvents;
+    G4double fMaxTime;
+
+    G4String fCheckpointDirectory;
+    G4String fResumeDirectory;
+    std::unique_ptr<RunCheckpoint> fResumeState;
+
+    // State of the current loop
+    G4bool fRunning;
+    G4bool fUseTarget;
+    G4bool fFinished;
+    G4int fBatches;
+    G4long fEvents;
+    G4long fLoopMaxEvents;
+    std::chrono::steady_clock::time_point fStartTime;
+
+    RunControlMessenger* fMessenger;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define DataManager_h 1
 
 #include "globals.hh"
+#include "PSFBinning.hh"
 #include <vector>
 #include <memory>
 #include <fstream>
@@ -17,9 +18,12 @@ public:
     // Configuration
     void SetOutputDirectory(const G4String& dir);
     void SetRunID(G4int id);
+    void SetRunSeed(G4long seed) { fRunSeed = seed; }
 
     // PSF data management
     void InitializePSFBins(G4int nBins);
+    void SetBinning(const PSFBinning& binning);
+    const PSFBinning& GetBinning() const { return fBinning; }
     void AddPSFData(G4double radius, G4double energy);
     void AddRadialDeposit(G4double radius, G4double energy);
 
@@ -41,6 +45,7 @@ public:
     G4String GetOutputDirectory() const { return fOutputDir; }
     G4int GetCurrentRunID() const { return fRunID; }
     G4int GetProcessedEvents() const { return fProcessedEvents; }
+    G4long GetRunSeed() const { return fRunSeed; }
 
     // Real-time monitoring
     void EnableLiveMonitoring(G4bool enable) { fLiveMonitoring = enable; }
@@ -58,8 +63,8 @@ private:
     static DataManager* fInstance;
 
     // Data storage
+    PSFBinning fBinning;
     std::vector<G4double> fRadialEnergyProfile;
-    std::vector<G4double> fRadialBinCenters;
     std::vector<std::pair<G4double, G4double>> fEventDeposits;
 
     // Configuration
@@ -67,15 +72,13 @@ private:
     G4int fRunID;
     G4int fTotalEvents;
     G4int fProcessedEvents;
+    G4long fRunSeed;
     G4bool fLiveMonitoring;
 
     // File streams
     std::unique_ptr<std::ofstream> fLiveDataStream;
 
     // Helper methods
-    G4double GetBinRadius(G4int bin) const;
-    void GetBinBoundaries(G4int bin, G4double& rInner, G4double& rOuter) const;
-    G4int GetRadialBin(G4double radius) const;
     void CreateOutputDirectory();
 };
 
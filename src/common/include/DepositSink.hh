@@ -0,0 +1,20 @@
+// DepositSink.hh - Interface between scoring detectors and the event action
+#ifndef DepositSink_h
+#define DepositSink_h 1
+
+#include "globals.hh"
+
+// Implemented by the user event action. Sensitive detectors in the geometry
+// module forward energy deposits through it, which keeps ebl_geometry free
+// of any dependency on ebl_actions.
+class DepositSink {
+public:
+    virtual ~DepositSink() = default;
+
+    // Energy deposited at position (x, y, z) in the scoring volume by a
+    // track of the given statistical weight (1 unless biasing is enabled)
+    virtual void AddEnergyDeposit(G4double edep, G4double weight,
+                                  G4double x, G4double y, G4double z) = 0;
+};
+
+#endif
@@ -0,0 +1,56 @@
+// DistributedRun.hh - Reduction of run tallies across MPI ranks
+#ifndef DistributedRun_h
+#define DistributedRun_h 1
+
+#include "globals.hh"
+#include <vector>
+
+// With USE_MPI ebl_sim runs one MT event loop per MPI rank (G4MPImanager
+// broadcasts the macro commands, so every rank executes the same /det/,
+// /gun/, /ebl/ ... commands and runs). Each rank seeds its master engine from
+// its own part of the seed stream, so the ranks simulate independent events.
+//
+// The event loops never communicate. At the end of every run the master
+// thread of each rank hands its merged tallies to Sum(), which adds them
+// over all ranks; rank 0 then writes the output. The sums are computed on
+// every rank, so batched runs (/ebl/run/converge) take the same decision
+// everywhere. Calls are collective: every rank has to make the same calls
+// in the same order.
+//
+// Built without MPI, or run without mpirun, there is one rank and every
+// call is a no-op.
+class DistributedRun {
+public:
+    static DistributedRun* Instance();
+    ~DistributedRun() = default;
+
+    G4int GetRank() const { return fRank; }
+    G4int GetSize() const { return fSize; }
+    G4bool IsDistributed() const { return fSize > 1; }
+    G4bool IsMasterRank() const { return fRank == 0; }
+
+    // Element-wise sum over all ranks, result on every rank
+    void Sum(std::vector<G4double>& values) const;
+    G4long Sum(G4long value) const;
+
+    // Events of a batch of the given total size simulated by this rank; at
+    // least one, since a rank without events would skip the end-of-run sums
+    G4long GetShare(G4long events) const;
+
+    // Per-rank subdirectory (rank_<n>) for state that cannot be shared,
+    // such as checkpoints of the rank's own tallies and engine; the
+    // directory itself with one rank
+    G4String GetRankDirectory(const G4String& directory) const;
+
+private:
+    DistributedRun();
+    DistributedRun(const DistributedRun&) = delete;
+    DistributedRun& operator=(const DistributedRun&) = delete;
+
+    static DistributedRun* fInstance;
+
+    G4int fRank;
+    G4int fSize;
+};
+
+#endif
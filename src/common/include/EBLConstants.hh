@@ -14,6 +14,7 @@ namespace EBL {
     }
 
     // PSF calculation parameters - OPTIMIZED FOR BEAMER
+    // Defaults for PSFBinning; override at runtime with /ebl/psf/ commands
     namespace PSF {
         constexpr G4bool USE_LOG_BINNING = true;
         constexpr G4int NUM_RADIAL_BINS = 150;  // Reduced from 200 for efficiency
@@ -23,6 +24,7 @@ namespace EBL {
         // Additional parameters for improved calculation
         constexpr G4double OVERFLOW_RADIUS = 200.0 * micrometer;  // For tracking beyond PSF
         constexpr G4int MIN_COUNTS_FOR_STATISTICS = 10;
+        constexpr G4int NUM_DEPTH_BINS = 50;  // Depth-resolved scoring (/ebl/psf/depth)
         constexpr G4double SMOOTHING_WINDOW_FRACTION = 0.05;
     }
 
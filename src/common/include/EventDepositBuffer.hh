@@ -0,0 +1,62 @@
+// EventDepositBuffer.hh - Sparse per-event bin accumulation
+#ifndef EventDepositBuffer_h
+#define EventDepositBuffer_h 1
+
+#include "globals.hh"
+#include "HistogramAccumulable.hh"
+#include <vector>
+
+// Collects one event's deposits per bin and remembers which bins were
+// touched, so that the end-of-event flush and the reset for the next event
+// cost O(touched bins) instead of O(histogram size). The dense array is
+// only (re)allocated when the binning changes.
+class EventDepositBuffer {
+public:
+    EventDepositBuffer() : fTotal(0.0) {}
+
+    void Resize(G4int nBins) {
+        if (fValues.size() != static_cast<size_t>(nBins)) {
+            fValues.assign(nBins, 0.0);
+            fTouched.clear();
+            fTouched.reserve(64);
+            fTotal = 0.0;
+        }
+    }
+
+    void Add(G4int bin, G4double value) {
+        if (fValues[bin] == 0.0) fTouched.push_back(bin);
+        fValues[bin] += value;
+        fTotal += value;
+    }
+
+    // Move this event's per-bin sums into the histogram (sum, sum of
+    // squares, entries) and clear the buffer for the next event
+    void FlushTo(HistogramAccumulable& histogram) {
+        for (G4int bin : fTouched) {
+            if (fValues[bin] != 0.0) {
+                histogram.FillEvent(bin, fValues[bin]);
+                fValues[bin] = 0.0;
+            }
+        }
+        fTouched.clear();
+        fTotal = 0.0;
+    }
+
+    // Drop this event's deposits without scoring them
+    void Clear() {
+        for (G4int bin : fTouched) fValues[bin] = 0.0;
+        fTouched.clear();
+        fTotal = 0.0;
+    }
+
+    G4bool IsEmpty() const { return fTouched.empty(); }
+    G4double GetTotal() const { return fTotal; }
+    size_t GetNumberOfTouchedBins() const { return fTouched.size(); }
+
+private:
+    std::vector<G4double> fValues;
+    std::vector<G4int> fTouched;
+    G4double fTotal;
+};
+
+#endif
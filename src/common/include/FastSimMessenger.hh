@@ -0,0 +1,40 @@
+// FastSimMessenger.hh - /ebl/fastsim/ commands
+#ifndef FastSimMessenger_h
+#define FastSimMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class BackscatterFastSim;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithABool;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithoutParameter;
+
+class FastSimMessenger : public G4UImessenger {
+public:
+    FastSimMessenger(BackscatterFastSim* fastSim);
+    virtual ~FastSimMessenger();
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+
+private:
+    BackscatterFastSim* fFastSim;
+
+    G4UIdirectory* fFastSimDir;
+    G4UIcmdWithABool* fEnableCmd;
+    G4UIcmdWithADoubleAndUnit* fDepthCmd;
+    G4UIcmdWithAString* fTableCmd;
+    G4UIcmdWithABool* fCalibrateCmd;
+    G4UIcmdWithAString* fOutputCmd;
+    G4UIcommand* fEnergyAxisCmd;
+    G4UIcommand* fDepthAxisCmd;
+    G4UIcmdWithAnInteger* fCosThetaBinsCmd;
+    G4UIcmdWithAnInteger* fSamplesCmd;
+    G4UIcmdWithoutParameter* fPrintCmd;
+};
+
+#endif
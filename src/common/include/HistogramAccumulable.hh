@@ -0,0 +1,81 @@
+// HistogramAccumulable.hh - Flat histogram merged through G4AccumulableManager
+#ifndef HistogramAccumulable_h
+#define HistogramAccumulable_h 1
+
+#include "G4VAccumulable.hh"
+#include "G4Version.hh"
+#include "globals.hh"
+#include <vector>
+
+// Fixed-shape 1D/2D/3D histogram stored as a single contiguous row-major
+// array (index = (ix * ny + iy) * nz + iz). Each thread fills its own
+// instance; G4AccumulableManager::Merge() adds worker copies into the
+// master copy at end of run, so no user-side locking or static storage
+// is needed and consecutive runs start from a clean Reset().
+//
+// Besides the plain sum, every bin keeps the sum of squared per-event
+// contributions and the number of events that touched it (FillEvent), which
+// is what the per-bin statistical error is computed from.
+class HistogramAccumulable : public G4VAccumulable {
+public:
+    HistogramAccumulable(const G4String& name, G4int nx, G4int ny = 1, G4int nz = 1);
+    virtual ~HistogramAccumulable() = default;
+
+    // G4VAccumulable interface
+    void Merge(const G4VAccumulable& other) override;
+    void Reset() override;
+#if G4VERSION_NUMBER >= 1120
+    void Print(G4PrintOptions options = G4PrintOptions()) const override;
+#endif
+
+    // Change the shape (clears the contents). Must be applied identically
+    // on master and workers before the run starts.
+    void SetShape(G4int nx, G4int ny = 1, G4int nz = 1);
+
+    // Filling - no bounds checks, callers pass valid bins
+    void Fill(G4int bin, G4double value) { fValues[bin] += value; }
+    void FillEvent(G4int bin, G4double eventValue) {
+        fValues[bin] += eventValue;
+        fSumSquares[bin] += eventValue * eventValue;
+        fEntries[bin] += 1.0;
+    }
+    void Fill(G4int ix, G4int iy, G4double value) { fValues[ix * fNy + iy] += value; }
+    void Fill(G4int ix, G4int iy, G4int iz, G4double value) {
+        fValues[(ix * fNy + iy) * fNz + iz] += value;
+    }
+
+    // Restore a bin of a saved histogram (checkpoints)
+    void SetBin(G4int bin, G4double value, G4double sumSquares, G4double entries) {
+        fValues[bin] = value;
+        fSumSquares[bin] = sumSquares;
+        fEntries[bin] = entries;
+    }
+
+    // Access
+    G4double GetValue(G4int bin) const { return fValues[bin]; }
+    G4double GetValue(G4int ix, G4int iy) const { return fValues[ix * fNy + iy]; }
+    const std::vector<G4double>& GetValues() const { return fValues; }
+    const std::vector<G4double>& GetSumSquares() const { return fSumSquares; }
+    const std::vector<G4double>& GetEntries() const { return fEntries; }
+    G4double GetSumSquares(G4int bin) const { return fSumSquares[bin]; }
+    G4double GetEntries(G4int bin) const { return fEntries[bin]; }
+    G4int GetNx() const { return fNx; }
+    G4int GetNy() const { return fNy; }
+    G4int GetNz() const { return fNz; }
+    G4int GetSize() const { return static_cast<G4int>(fValues.size()); }
+    G4double GetSum() const;
+
+    // Relative standard error of the mean per-event deposit in a bin over
+    // nEvents events (FillEvent tallies); DBL_MAX for an empty bin
+    G4double GetRelativeError(G4int bin, G4double nEvents) const;
+
+private:
+    G4int fNx;
+    G4int fNy;
+    G4int fNz;
+    std::vector<G4double> fValues;
+    std::vector<G4double> fSumSquares;
+    std::vector<G4double> fEntries;
+};
+
+#endif
@@ -0,0 +1,73 @@
+// ImportanceBiasing.hh - Per-region Russian roulette and splitting settings
+#ifndef ImportanceBiasing_h
+#define ImportanceBiasing_h 1
+
+#include "globals.hh"
+#include <vector>
+
+class G4Region;
+class BiasingMessenger;
+
+// Weighted variance reduction for the slowly converging backscatter tail.
+// Two techniques, both configured per region with /ebl/bias/ commands:
+//  - Russian roulette: new electrons born in the region deeper than a given
+//    depth below the resist and heading away from it survive with
+//    probability p and carry weight w/p (StackingAction)
+//  - splitting: an electron crossing up into the region from below is
+//    replaced by N copies of weight w/N (ResistSensitiveDetector, so only
+//    regions made of resist volumes support it)
+// Deposits are scored with the track weight, so the PSF stays unbiased.
+//
+// The settings are process-wide and only change between runs; the master
+// resolves region names at run start and the workers read them lock-free.
+struct RegionBiasing {
+    G4String regionName;
+    const G4Region* region = nullptr;
+    G4double survivalProbability = 1.0;  // 1 = no roulette
+    G4double rouletteDepth = 0.0;        // below the resist bottom (z = 0)
+    G4int splitFactor = 1;               // 1 = no splitting
+};
+
+class ImportanceBiasing {
+public:
+    static ImportanceBiasing* Instance();
+    ~ImportanceBiasing();
+
+    void SetEnabled(G4bool enable) { fEnabled = enable; }
+    G4bool IsEnabled() const { return fEnabled; }
+
+    void SetRoulette(const G4String& regionName, G4double survivalProbability, G4double depth);
+    void SetSplitting(const G4String& regionName, G4int factor);
+    void SetMinimumWeight(G4double weight) { fMinimumWeight = weight; }
+    G4double GetMinimumWeight() const { return fMinimumWeight; }
+
+    // Look up region pointers by name; called by the master at run start
+    void ResolveRegions();
+
+    // Settings for a region, or nullptr if it is not biased
+    const RegionBiasing* Find(const G4Region* region) const {
+        for (const RegionBiasing& entry : fRegions) {
+            if (entry.region == region) return &entry;
+        }
+        return nullptr;
+    }
+
+    void Print() const;
+
+private:
+    ImportanceBiasing();
+    ImportanceBiasing(const ImportanceBiasing&) = delete;
+    ImportanceBiasing& operator=(const ImportanceBiasing&) = delete;
+
+    RegionBiasing& GetOrCreate(const G4String& regionName);
+
+    static ImportanceBiasing* fInstance;
+
+    G4bool fEnabled;
+    G4double fMinimumWeight;     // no splitting below this weight
+    std::vector<RegionBiasing> fRegions;
+
+    BiasingMessenger* fMessenger;
+};
+
+#endif
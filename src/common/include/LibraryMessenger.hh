@@ -0,0 +1,31 @@
+// LibraryMessenger.hh - /ebl/library/ commands
+#ifndef LibraryMessenger_h
+#define LibraryMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class ResultLibrary;
+class G4UIdirectory;
+class G4UIcmdWithABool;
+class G4UIcmdWithAString;
+class G4UIcmdWithoutParameter;
+
+class LibraryMessenger : public G4UImessenger {
+public:
+    LibraryMessenger(ResultLibrary* library);
+    virtual ~LibraryMessenger();
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+
+private:
+    ResultLibrary* fLibrary;
+
+    G4UIdirectory* fLibraryDir;
+    G4UIcmdWithAString* fDirectoryCmd;
+    G4UIcmdWithABool* fInterpolateCmd;
+    G4UIcmdWithAString* fToleranceCmd;
+    G4UIcmdWithoutParameter* fPrintCmd;
+};
+
+#endif
@@ -0,0 +1,19 @@
+// MasterSeed.hh - Reproducible seeding of the master random engine
+#ifndef MasterSeed_h
+#define MasterSeed_h 1
+
+#include "globals.hh"
+#include <cstdint>
+
+// Seed the master engine. In MT/tasking mode the master engine draws a
+// fresh seed pair for every event and hands it to whichever worker
+// processes that event, so every event has its own independent stream
+// and a run is reproducible regardless of thread count or scheduling.
+// MPI rank r takes the r-th seed pair of the stream, so ranks simulate
+// independent events and rank 0 matches a single-process run. Used by
+// ebl_sim and the ebl Python module.
+namespace MasterSeed {
+    void Apply(std::uint64_t userSeed, G4int rank);
+}
+
+#endif
@@ -0,0 +1,106 @@
+// PSFBinning.hh - Shared radial binning for PSF scoring and output
+#ifndef PSFBinning_h
+#define PSFBinning_h 1
+
+#include "globals.hh"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Radial bin layout used by every scorer and writer. Edges, centres and
+// annular areas are computed once at construction; FindBinSquared() maps a
+// squared radius to a bin without sqrt/log:
+//  - log mode: the IEEE-754 exponent and top mantissa bits of r^2 index a
+//    lookup table whose cells are finer than one bin, followed by at most a
+//    couple of edge comparisons
+//  - linear mode: a single multiply (plus one sqrt)
+//
+// Bin 0 always starts at r = 0, so radii below the minimum radius are
+// scored in the first bin. Radii at or beyond the maximum radius return -1.
+class PSFBinning {
+public:
+    enum class Mode { Linear, Log };
+
+    // Defaults from EBL::PSF
+    PSFBinning();
+    PSFBinning(Mode mode, G4int nBins, G4double minRadius, G4double maxRadius);
+
+    // Hot path: bin index for a squared radius, -1 if out of range
+    inline G4int FindBinSquared(G4double r2) const;
+    G4int FindBin(G4double r) const { return FindBinSquared(r * r); }
+
+    // Layout
+    Mode GetMode() const { return fMode; }
+    G4bool IsLog() const { return fMode == Mode::Log; }
+    G4int GetNumberOfBins() const { return fNumBins; }
+    G4double GetMinRadius() const { return fMinRadius; }
+    G4double GetMaxRadius() const { return fMaxRadius; }
+
+    // Cached per-bin geometry
+    G4double GetLowerEdge(G4int bin) const { return fEdges[bin]; }
+    G4double GetUpperEdge(G4int bin) const { return fEdges[bin + 1]; }
+    G4double GetCenter(G4int bin) const { return fCenters[bin]; }
+    G4double GetArea(G4int bin) const { return fAreas[bin]; }
+    const std::vector<G4double>& GetEdges() const { return fEdges; }
+    const std::vector<G4double>& GetCenters() const { return fCenters; }
+    const std::vector<G4double>& GetAreas() const { return fAreas; }
+
+    G4bool operator==(const PSFBinning& other) const {
+        return fMode == other.fMode && fNumBins == other.fNumBins &&
+            fMinRadius == other.fMinRadius && fMaxRadius == other.fMaxRadius;
+    }
+    G4bool operator!=(const PSFBinning& other) const { return !(*this == other); }
+
+    static G4String ModeName(Mode mode) { return mode == Mode::Log ? "log" : "linear"; }
+
+private:
+    void BuildEdges();
+    void BuildLookupTable();
+
+    static std::uint64_t Bits(G4double value) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    Mode fMode;
+    G4int fNumBins;
+    G4double fMinRadius;
+    G4double fMaxRadius;
+
+    std::vector<G4double> fEdges;     // fNumBins + 1 edges, fEdges[0] = 0
+    std::vector<G4double> fEdges2;    // squared edges for the lookup path
+    std::vector<G4double> fCenters;
+    std::vector<G4double> fAreas;
+
+    // Log-mode lookup: cell = (bits(r^2) >> fLookupShift) - fLookupBase
+    std::vector<G4int> fLookup;
+    G4int fLookupShift;
+    std::uint64_t fLookupBase;
+    G4double fFirstEdge2;       // below this r^2 the bin is always 0
+    G4double fMaxRadius2;
+    G4double fInvLinearWidth;
+};
+
+inline G4int PSFBinning::FindBinSquared(G4double r2) const
+{
+    if (!(r2 < fMaxRadius2)) return -1;  // also rejects NaN
+
+    if (fMode == Mode::Linear) {
+        G4int bin = static_cast<G4int>(std::sqrt(r2) * fInvLinearWidth);
+        if (bin >= fNumBins) bin = fNumBins - 1;
+        // Fix up rounding right at an edge
+        if (r2 < fEdges2[bin]) return bin - 1;
+        if (r2 >= fEdges2[bin + 1]) return bin + 1;
+        return bin;
+    }
+
+    if (r2 < fFirstEdge2) return 0;
+
+    G4int bin = fLookup[(Bits(r2) >> fLookupShift) - fLookupBase];
+    while (r2 >= fEdges2[bin + 1]) ++bin;
+    return bin;
+}
+
+#endif
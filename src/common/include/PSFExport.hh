@@ -0,0 +1,34 @@
+// PSFExport.hh - Text exports derived from a PSF result
+#ifndef PSFExport_h
+#define PSFExport_h 1
+
+#include "globals.hh"
+#include <ostream>
+
+class PSFResultFile;
+
+// The CSV table and BEAMER files are computed from the raw tallies of a
+// PSFResultFile, so a run (RunAction) and merged shards (ebl_merge) are
+// normalized by the same code: energy density per bin = sum of deposits /
+// (annular area * events at the point).
+namespace PSFExport {
+    // All points in one table; sweepColumns adds the Point and
+    // BeamEnergy(keV) columns in front
+    G4bool WriteCSV(const PSFResultFile& result, const G4String& path, G4bool sweepColumns);
+
+    // BEAMER format of one point: radius(um) PSF, normalized to peak = 1
+    G4bool WriteBEAMER(const PSFResultFile& result, G4int point, const G4String& path);
+
+    // The file contents alone, without messages, for the background writer
+    // (AsyncWriter); the Write functions above are these plus the prints below
+    void FormatCSV(const PSFResultFile& result, std::ostream& out, G4bool sweepColumns);
+    void FormatBEAMER(const PSFResultFile& result, G4int point, std::ostream& out);
+
+    // Valid bins, total energy and peak density of all points
+    void PrintCSVStatistics(const PSFResultFile& result);
+
+    // Forward and backscatter fractions of one point
+    void PrintBEAMERParameters(const PSFResultFile& result, G4int point);
+}
+
+#endif
@@ -0,0 +1,107 @@
+// PSFResultFile.hh - Versioned binary PSF result with per-bin statistics
+#ifndef PSFResultFile_h
+#define PSFResultFile_h 1
+
+#include "globals.hh"
+#include "PSFBinning.hh"
+#include <ostream>
+#include <vector>
+
+// Raw radial tallies of one run together with the run metadata, written as
+// a single binary file that numpy.memmap can map without parsing:
+//
+//   header (192 bytes, little-endian, see PSFResultFile.cc)
+//   edges      float64[nBins + 1]       bin edges (nm), edges[0] = 0
+//   energies   float64[nPoints]         beam energy of each sweep point (keV)
+//   events     int64[nPoints]           primaries simulated at each point
+//   sum        float64[nPoints, nBins]  sum of per-event deposits (eV)
+//   sumSquares float64[nPoints, nBins]  sum of squared per-event deposits (eV^2)
+//   hits       int64[nPoints, nBins]    events that deposited in the bin
+//
+// Every array starts on a 64-byte boundary at the offset recorded in the
+// header. Only sums are stored, so files of runs with the same binning and
+// beam energies merge losslessly (Merge), and densities, per-bin errors and
+// the BEAMER export are derived from them. In memory energies and lengths
+// use Geant4 internal units.
+class PSFResultFile {
+public:
+    static const G4int kVersion = 1;
+
+    PSFResultFile();
+    ~PSFResultFile() = default;
+
+    // Layout (clears the tallies)
+    void SetLayout(const PSFBinning& binning, const std::vector<G4double>& beamEnergies);
+
+    // Run metadata
+    void SetSeed(G4long seed) { fSeed = seed; }
+    void SetWeighted(G4bool weighted) { fWeighted = weighted; }
+    void SetResist(G4double thickness, G4double density, const G4String& composition);
+    void SetEvents(G4int point, G4long events) { fEvents[point] = events; }
+
+    // Tallies as laid out by HistogramAccumulable, (point, bin) row-major
+    void SetTallies(const std::vector<G4double>& sum,
+                    const std::vector<G4double>& sumSquares,
+                    const std::vector<G4double>& hits);
+
+    const PSFBinning& GetBinning() const { return fBinning; }
+    G4int GetNumberOfPoints() const { return static_cast<G4int>(fBeamEnergies.size()); }
+    G4double GetBeamEnergy(G4int point) const { return fBeamEnergies[point]; }
+    G4long GetEvents(G4int point) const { return fEvents[point]; }
+    G4long GetTotalEvents() const;
+    G4long GetSeed() const { return fSeed; }
+    G4bool IsWeighted() const { return fWeighted; }
+    G4bool IsMerged() const { return fMerged; }
+    G4double GetResistThickness() const { return fResistThickness; }
+    G4double GetResistDensity() const { return fResistDensity; }
+    const G4String& GetResistComposition() const { return fResistComposition; }
+
+    G4double GetSum(G4int point, G4int bin) const { return fSum[Index(point, bin)]; }
+    G4double GetSumSquares(G4int point, G4int bin) const { return fSumSquares[Index(point, bin)]; }
+    G4long GetHits(G4int point, G4int bin) const { return fHits[Index(point, bin)]; }
+
+    // Whole arrays, (point, bin) row-major (NumPy views of the ebl module)
+    const std::vector<G4double>& GetBeamEnergies() const { return fBeamEnergies; }
+    const std::vector<G4long>& GetEventCounts() const { return fEvents; }
+    const std::vector<G4double>& GetSums() const { return fSum; }
+    const std::vector<G4double>& GetSumSquares() const { return fSumSquares; }
+    const std::vector<G4long>& GetHitCounts() const { return fHits; }
+
+    // Relative standard error of the mean per-event deposit in a bin, as
+    // HistogramAccumulable::GetRelativeError; DBL_MAX for an empty bin
+    G4double GetRelativeError(G4int point, G4int bin) const;
+
+    // Same binning and beam energies, to within the rounding of the file
+    // units
+    G4bool IsCompatible(const PSFBinning& binning, const std::vector<G4double>& beamEnergies) const;
+
+    // Add the tallies of an independent run with the same binning and beam
+    // energies; returns false (and leaves this result untouched) otherwise
+    G4bool Merge(const PSFResultFile& other);
+
+    // Binary I/O; return false on failure
+    G4bool Write(const G4String& fileName) const;
+    G4bool Write(std::ostream& out) const;  // binary stream, no messages
+    G4bool Read(const G4String& fileName);
+
+private:
+    size_t Index(G4int point, G4int bin) const {
+        return static_cast<size_t>(point) * fBinning.GetNumberOfBins() + bin;
+    }
+
+    PSFBinning fBinning;
+    std::vector<G4double> fBeamEnergies;
+    std::vector<G4long> fEvents;
+    std::vector<G4double> fSum;
+    std::vector<G4double> fSumSquares;
+    std::vector<G4long> fHits;
+
+    G4long fSeed;
+    G4bool fWeighted;
+    G4bool fMerged;
+    G4double fResistThickness;
+    G4double fResistDensity;
+    G4String fResistComposition;
+};
+
+#endif
@@ -0,0 +1,55 @@
+// ParameterSweep.hh - Beam energy sweep within a single run
+#ifndef ParameterSweep_h
+#define ParameterSweep_h 1
+
+#include "G4Threading.hh"
+#include "globals.hh"
+#include <vector>
+
+class SweepMessenger;
+
+// Several beam energies scored in one event loop instead of one
+// /run/beamOn per energy. Event i runs at sweep point i % N, so the points
+// are interleaved over all worker threads and every point gets the same
+// number of events (to within one). Each point has its own block of the
+// radial histogram and its own output, while geometry, physics tables and
+// the thread pool are set up once.
+//
+// The point list is process-wide and only changes between runs. The
+// generator publishes the point of the current event through the
+// thread-local accessor below, which the event action uses for binning.
+class ParameterSweep {
+public:
+    static ParameterSweep* Instance();
+    ~ParameterSweep();
+
+    // Beam energies of the sweep points; an empty list disables the sweep
+    void SetEnergies(const std::vector<G4double>& energies);
+    void Clear() { fEnergies.clear(); }
+
+    G4bool IsActive() const { return !fEnergies.empty(); }
+    G4int GetNumberOfPoints() const { return static_cast<G4int>(fEnergies.size()); }
+    G4double GetEnergy(G4int point) const { return fEnergies[point]; }
+
+    G4int GetPoint(G4int eventID) const { return eventID % GetNumberOfPoints(); }
+
+    // Sweep point of the event being processed on this thread
+    static void SetCurrentPoint(G4int point) { fCurrentPoint = point; }
+    static G4int GetCurrentPoint() { return fCurrentPoint; }
+
+    void Print() const;
+
+private:
+    ParameterSweep();
+    ParameterSweep(const ParameterSweep&) = delete;
+    ParameterSweep& operator=(const ParameterSweep&) = delete;
+
+    static ParameterSweep* fInstance;
+    static G4ThreadLocal G4int fCurrentPoint;
+
+    std::vector<G4double> fEnergies;
+
+    SweepMessenger* fMessenger;
+};
+
+#endif
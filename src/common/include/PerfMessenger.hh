@@ -0,0 +1,35 @@
+// PerfMessenger.hh - /ebl/perf/ commands
+#ifndef PerfMessenger_h
+#define PerfMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class PerfMonitor;
+class G4UIdirectory;
+class G4UIcmdWithABool;
+class G4UIcmdWithAString;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithoutParameter;
+
+class PerfMessenger : public G4UImessenger {
+public:
+    PerfMessenger(PerfMonitor* monitor);
+    virtual ~PerfMessenger();
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+
+private:
+    PerfMonitor* fMonitor;
+
+    G4UIdirectory* fPerfDir;
+    G4UIcmdWithABool* fEnableCmd;
+    G4UIcmdWithADoubleAndUnit* fIntervalCmd;
+    G4UIcmdWithoutParameter* fDumpCmd;
+    G4UIcmdWithABool* fPrintCmd;
+    G4UIcmdWithAString* fStatusFileCmd;
+    G4UIcmdWithABool* fStatusPSFCmd;
+    G4UIcmdWithABool* fTraceCmd;
+};
+
+#endif
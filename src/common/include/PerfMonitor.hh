@@ -0,0 +1,166 @@
+// PerfMonitor.hh - Per-thread hot-path counters with a sampling reporter thread
+#ifndef PerfMonitor_h
+#define PerfMonitor_h 1
+
+#include "globals.hh"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class PerfMessenger;
+class PSFResultFile;
+
+// One block of counters per Geant4 thread. Every block is written only by
+// the thread that owns it, so an update is a relaxed load + store on a
+// cache line no other writer touches (no lock, no atomic read-modify-write).
+// The reporter thread only reads. The alignment keeps blocks of different
+// threads on separate cache lines.
+class alignas(64) PerfThreadCounters {
+public:
+    enum Counter {
+        kEvents = 0,
+        kSteps,                 // all steps, only with the diagnostic SteppingAction
+        kResistSteps,
+        kResistDeposits,
+        kTracksPushed,
+        kSplitTracks,           // copies created by importance splitting
+        kFastSimReplaced,       // electrons replaced by SubstrateFastModel
+        kTracksDeferred,        // StackingAction staging (/ebl/stack/waiting)
+        kStagesDrained,
+        kStagesDropped,
+        kStageEnergyDrained,    // eV of the waiting tracks of drained/dropped stages
+        kStageEnergyDropped,
+        kStageResistEnergy,     // eV deposited in the resist while drained stages ran
+        kKillOutOfRange,        // StackingAction kill rules, one counter each
+        kKillEscaping,
+        kKillLowEnergyPhoton,
+        kKillRoulette,
+        kKillWaitingStack,
+        kNumCounters,
+        kFirstKillCounter = kKillOutOfRange
+    };
+
+    explicit PerfThreadCounters(G4int threadID) : fThreadID(threadID) {}
+
+    void Add(Counter c, G4long n = 1) {
+        std::atomic<G4long>& v = fCounters[c];
+        v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    G4long Get(Counter c) const { return fCounters[c].load(std::memory_order_relaxed); }
+    G4int GetThreadID() const { return fThreadID; }
+
+    static const char* CounterName(Counter c);
+    static const char* CounterKey(Counter c);      // JSON key
+
+private:
+    std::array<std::atomic<G4long>, kNumCounters> fCounters{};
+    G4int fThreadID;
+};
+
+// Process-wide registry of the per-thread blocks. Instrumented classes
+// fetch their thread's block once (in their constructor) and only call
+// Add() afterwards; no clock is read and nothing is printed on the hot
+// path. A single reporter thread, started for the duration of each run
+// on the master, sums the blocks every interval and prints progress and
+// rates. Controlled with /ebl/perf/ commands.
+//
+// With a status file the reporter also rewrites a JSON record of the
+// progress (events, rate, ETA, per-thread and kill counters, and the PSF
+// of the last completed batch) at every sample and at the end of each
+// run. It is written to a temporary file and renamed into place, so a
+// reader polling it (the GUI) always sees a complete record; with
+// /ebl/perf/print false nothing is printed during the run at all.
+class PerfMonitor {
+public:
+    static PerfMonitor* Instance();
+    ~PerfMonitor();
+
+    // Counter block of the calling thread (registered on first use)
+    PerfThreadCounters* GetThreadCounters();
+
+    // Run boundaries, called by the master RunAction
+    void BeginRun(G4int nEventsToProcess);
+    void EndRun();
+
+    // Configuration
+    void SetEnabled(G4bool enable) { fEnabled = enable; }
+    G4bool IsEnabled() const { return fEnabled; }
+    void SetInterval(G4double seconds);
+    G4double GetInterval() const { return fInterval; }
+    void SetPrintProgress(G4bool print) { fPrintProgress = print; }
+
+    // Status file; empty disables
+    void SetStatusFile(const G4String& fileName) { fStatusFile = fileName; }
+    const G4String& GetStatusFile() const { return fStatusFile; }
+    void SetStatusPSF(G4bool enable) { fStatusPSF = enable; }
+    G4bool WantsPSFSnapshot() const { return !fStatusFile.empty() && fStatusPSF; }
+
+    // Master, before BeginRun: events the batch loop (/ebl/run/beamOn,
+    // /ebl/run/converge) completed before this run and its budget, so the
+    // record shows the progress of the loop; 0, 0 for a plain run, which
+    // also drops the PSF of an earlier loop
+    void SetLoopProgress(G4long eventsDone, G4long eventsTarget);
+
+    // Master, after a run: PSF (eV/nm^2 per event) of the tallies so far.
+    // Rewrites the status file at once, since the reporter is stopped
+    // between runs.
+    void SetPSFSnapshot(const PSFResultFile& result);
+
+    // Sum of one counter over all threads
+    G4long GetTotal(PerfThreadCounters::Counter c) const;
+
+    // Print per-thread and total counters
+    void Dump() const;
+
+private:
+    PerfMonitor();
+    PerfMonitor(const PerfMonitor&) = delete;
+    PerfMonitor& operator=(const PerfMonitor&) = delete;
+
+    using Snapshot = std::array<G4long, PerfThreadCounters::kNumCounters>;
+    Snapshot TakeSnapshot() const;
+
+    void ReporterLoop();
+    void PrintSample(const Snapshot& now, const Snapshot& previous,
+                     G4double elapsed, G4double sinceLast) const;
+    void StopReporter();
+    void WriteStatus(const Snapshot& now, const char* state);
+
+    static PerfMonitor* fInstance;
+
+    mutable std::mutex fRegistryMutex;
+    std::vector<std::unique_ptr<PerfThreadCounters>> fThreadCounters;
+
+    // Reporter thread
+    std::thread fReporter;
+    std::mutex fReporterMutex;
+    std::condition_variable fReporterWake;
+    G4bool fStopReporter;
+
+    G4bool fEnabled;
+    G4bool fPrintProgress;
+    G4double fInterval;          // seconds
+    G4int fEventsToProcess;
+    Snapshot fRunStart;          // totals at BeginRun, for per-run deltas
+    std::chrono::steady_clock::time_point fRunStartTime;
+
+    // Status file
+    G4String fStatusFile;
+    G4bool fStatusPSF;
+    std::mutex fStatusMutex;
+    G4long fLoopEventsDone;
+    G4long fLoopEventsTarget;
+    G4double fElapsed;           // seconds, at the last sample
+    G4double fEventRate;         // events/s over the last interval
+    std::string fPSFSnapshot;    // JSON object, empty if none
+
+    PerfMessenger* fMessenger;
+};
+
+#endif
@@ -0,0 +1,75 @@
+// PhaseSpace.hh - Recording and replay of the particles coming up out of the substrate
+#ifndef PhaseSpace_h
+#define PhaseSpace_h 1
+
+#include "PhaseSpaceFile.hh"
+#include "globals.hh"
+#include <mutex>
+#include <vector>
+
+class PhaseSpaceMessenger;
+
+// A thin resist barely changes what comes back out of the substrate, yet
+// every resist variation tracks the beam through the whole substrate again.
+// A recording run writes every particle that enters the resist from below
+// (ResistSensitiveDetector) to a phase-space file. A replay run with a
+// different resist stack tracks the beam through the resist as usual, but
+// whatever enters the substrate is killed (SubstrateFastModel) and the
+// recorded particles of the same event are started just below the surface
+// instead (PrimaryGeneratorAction).
+//
+// Event i of a launch (counted over all runs and batches) is event i of
+// the recording, wrapping around when the replay is longer. The mode and
+// the files only change between runs; the master opens or loads the file
+// at run start, workers append to it under a lock or read it lock-free.
+class PhaseSpace {
+public:
+    enum class Mode { kOff, kRecord, kReplay };
+
+    static PhaseSpace* Instance();
+    ~PhaseSpace();
+
+    void Record(const G4String& fileName);
+    void Replay(const G4String& fileName);
+    void Stop();
+
+    Mode GetMode() const { return fMode; }
+    G4bool IsRecording() const { return fMode == Mode::kRecord; }
+    G4bool IsReplaying() const { return fMode == Mode::kReplay; }
+    const G4String& GetFileName() const { return fFileName; }
+
+    // Master, at run start and end: open the recording or load the replay
+    // file; advance the event count of the launch
+    void BeginRun(G4double beamEnergy, G4double resistThickness);
+    void EndRun(G4long events);
+
+    // Recording: the particles of an event of the current run
+    void RecordEvent(G4long eventID, const std::vector<PhaseSpaceFile::Particle>& particles);
+
+    // Replay: the recorded particles for an event of the current run
+    const PhaseSpaceFile::Particle* GetReplayEvent(G4long eventID, size_t& count) const;
+
+    void Print() const;
+
+private:
+    PhaseSpace();
+    PhaseSpace(const PhaseSpace&) = delete;
+    PhaseSpace& operator=(const PhaseSpace&) = delete;
+
+    static PhaseSpace* fInstance;
+
+    Mode fMode;
+    G4String fFileName;
+    G4String fLoadedFile;       // replay file in fFile
+
+    PhaseSpaceFile fFile;
+    std::mutex fWriteMutex;
+
+    // Events of the earlier runs of this recording or replay
+    G4long fEventOffset;
+    G4bool fWarnedWrap;
+
+    PhaseSpaceMessenger* fMessenger;
+};
+
+#endif
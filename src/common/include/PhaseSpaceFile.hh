@@ -0,0 +1,70 @@
+// PhaseSpaceFile.hh - Particles crossing the resist/substrate plane, by event
+#ifndef PhaseSpaceFile_h
+#define PhaseSpaceFile_h 1
+
+#include "globals.hh"
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+// Binary file of the particles that come up out of the substrate through
+// z = 0, written in blocks of one event: the event ID, the particle count
+// and the particles. Blocks are in the order the events finished; the
+// header holds the number of events of the recording (including those
+// without a crossing), written when the recording is finished.
+//
+// Positions, energies and directions are in internal units (mm, MeV) as
+// 32-bit floats, 32 bytes per particle.
+class PhaseSpaceFile {
+public:
+    struct Particle {
+        G4float x, y;               // crossing point on the plane
+        G4float ux, uy, uz;         // direction (uz > 0)
+        G4float energy;             // kinetic energy
+        G4float weight;
+        std::int32_t pdg;
+    };
+
+    PhaseSpaceFile();
+    ~PhaseSpaceFile();
+
+    // Writing: the header is rewritten by every Finish, so the file is
+    // complete after each run of a recording
+    G4bool Create(const G4String& fileName, G4double beamEnergy, G4double resistThickness);
+    void Append(G4long eventID, const std::vector<Particle>& particles);
+    G4bool Finish(G4long events);
+    void Close();
+    G4bool IsOpen() const { return fOut.is_open(); }
+
+    // Reading: the whole file, indexed by event
+    G4bool Read(const G4String& fileName);
+    void Clear();
+    G4bool IsEmpty() const { return fEvents == 0; }
+
+    // Particles of an event of the recording (count 0 if none crossed)
+    const Particle* GetEvent(G4long eventID, size_t& count) const;
+
+    G4long GetEvents() const { return fEvents; }
+    size_t GetNumberOfParticles() const { return fNumParticles; }
+    G4double GetBeamEnergy() const { return fBeamEnergy; }
+    G4double GetResistThickness() const { return fResistThickness; }
+
+private:
+    void WriteHeader();
+
+    G4long fEvents;
+    size_t fNumParticles;
+    G4double fBeamEnergy;
+    G4double fResistThickness;
+
+    std::ofstream fOut;
+    G4String fFileName;
+
+    // Read file: particles sorted by event, with the first particle of
+    // every event that has any
+    std::vector<Particle> fParticles;
+    std::vector<G4long> fEventIDs;
+    std::vector<size_t> fFirst;
+};
+
+#endif
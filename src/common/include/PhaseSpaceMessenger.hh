@@ -0,0 +1,30 @@
+// PhaseSpaceMessenger.hh - /ebl/phasespace/ commands
+#ifndef PhaseSpaceMessenger_h
+#define PhaseSpaceMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class PhaseSpace;
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithoutParameter;
+
+class PhaseSpaceMessenger : public G4UImessenger {
+public:
+    PhaseSpaceMessenger(PhaseSpace* phaseSpace);
+    virtual ~PhaseSpaceMessenger();
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+
+private:
+    PhaseSpace* fPhaseSpace;
+
+    G4UIdirectory* fPhaseSpaceDir;
+    G4UIcmdWithAString* fRecordCmd;
+    G4UIcmdWithAString* fReplayCmd;
+    G4UIcmdWithoutParameter* fStopCmd;
+    G4UIcmdWithoutParameter* fPrintCmd;
+};
+
+#endif
@@ -0,0 +1,77 @@
+// PhysicsTableCache.hh - On-disk cache of the built physics tables
+#ifndef PhysicsTableCache_h
+#define PhysicsTableCache_h 1
+
+#include "globals.hh"
+
+class G4VUserPhysicsList;
+class CacheMessenger;
+
+// Building the Livermore tables for the ultra-fine resist cuts dominates
+// the start-up of short runs, and rebuilding them on every launch gives
+// the same tables again. The master stores them after the first build in
+// <directory>/<key>/ and later launches retrieve them through
+// G4VUserPhysicsList::SetPhysicsTableRetrieved(); workers share the
+// master's tables as usual, so they never touch the cache.
+//
+// The key is a hash of everything the tables depend on: the materials
+// (the resist composition and density end up in its G4Material), the
+// region production cuts and their materials, the G4EmParameters, the
+// physics configuration passed by the physics list and the Geant4
+// version. Changing any of them selects a different directory, so stale
+// tables are never read. Entries are written to a temporary directory
+// and renamed into place, so concurrent launches never see partial ones.
+// Off by default (/ebl/cache/enable).
+class PhysicsTableCache {
+public:
+    static PhysicsTableCache* Instance();
+    ~PhysicsTableCache();
+
+    void SetEnabled(G4bool enable) { fEnabled = enable; }
+    G4bool IsEnabled() const { return fEnabled; }
+    void SetDirectory(const G4String& directory) { fDirectory = directory; }
+    const G4String& GetDirectory() const { return fDirectory; }
+
+    // Master, after the cuts are set (/run/initialize): retrieve the tables
+    // if an entry for the current setup exists
+    void Prepare(G4VUserPhysicsList* physicsList, const G4String& configuration);
+
+    // Master, after the tables are built (run start): store them if the
+    // current setup has no entry yet
+    void StoreIfNeeded();
+
+    // The setup may change before the next table build (geometry update):
+    // build instead of retrieving, StoreIfNeeded() then files the result
+    void Invalidate();
+
+    void Print() const;
+
+    // Canonical description of the setup and its hash; the result library
+    // keys its entries on them as well
+    G4String DescribeSetup() const;
+    static G4String HashToString(const G4String& text);
+
+private:
+    PhysicsTableCache();
+    PhysicsTableCache(const PhysicsTableCache&) = delete;
+    PhysicsTableCache& operator=(const PhysicsTableCache&) = delete;
+
+    G4String EntryDirectory(const G4String& key) const;
+    G4bool HasEntry(const G4String& key) const;
+    void UpdateRegionMaterials() const;
+
+    static PhysicsTableCache* fInstance;
+
+    G4bool fEnabled;
+    G4String fDirectory;
+
+    G4VUserPhysicsList* fPhysicsList;
+    G4String fConfiguration;
+    G4String fSetup;            // DescribeSetup() the key is the hash of
+    G4String fKey;              // setup the current tables belong to
+    G4bool fStored;             // fKey has a complete entry
+
+    CacheMessenger* fMessenger;
+};
+
+#endif
@@ -0,0 +1,102 @@
+// ResultLibrary.hh - On-disk library of finished PSF results
+#ifndef ResultLibrary_h
+#define ResultLibrary_h 1
+
+#include "globals.hh"
+#include <set>
+#include <vector>
+
+class PSFResultFile;
+class LibraryMessenger;
+
+// What a PSF result depends on. Beam energy and resist thickness are the
+// axes results are interpolated along; everything else (physics setup,
+// resist density and composition, beam, binning, biasing) is the setup text,
+// and only results with the same setup are ever combined.
+struct ResultKey {
+    G4double beamEnergy;
+    G4double resistThickness;
+    G4String setup;
+};
+
+// Finished single-energy runs are filed under <directory>/<setup hash>/,
+// one PSF result file per (energy, thickness) with a text record of the
+// key, the events and the seeds that went into it. The record is renamed
+// into place after the result, so readers only see complete entries.
+//
+// An entry grows with every run of the same key: runs are added to it
+// unless they may repeat its events (same seed from an earlier launch),
+// in which case the larger of the two is kept. Event counts are therefore
+// not part of the key; a lookup asks for a minimum.
+class ResultLibrary {
+public:
+    static ResultLibrary* Instance();
+    ~ResultLibrary();
+
+    // Empty directory = library off
+    void SetDirectory(const G4String& directory) { fDirectory = directory; }
+    const G4String& GetDirectory() const { return fDirectory; }
+    G4bool IsEnabled() const { return !fDirectory.empty(); }
+
+    // Interpolate between neighbouring entries when there is no exact one,
+    // if their PSFs differ by at most the tolerance (relative L1 distance)
+    void SetInterpolation(G4bool enable) { fInterpolation = enable; }
+    G4bool IsInterpolating() const { return fInterpolation; }
+    void SetTolerance(G4double tolerance) { fTolerance = tolerance; }
+
+    // The entry of a key; false if there is none
+    G4bool Find(const ResultKey& key, PSFResultFile& result) const;
+
+    // Linear interpolation between the entries bracketing the beam energy
+    // (same thickness) or the thickness (same energy), each with at least
+    // minEvents. The interpolated sums are scaled to the smaller event
+    // count; difference is the distance of the two neighbours.
+    G4bool Interpolate(const ResultKey& key, G4long minEvents,
+                       PSFResultFile& result, G4double& difference) const;
+
+    // A run of this launch with the given seed adds new events to the entry
+    G4bool CanExtend(const ResultKey& key, G4long seed) const;
+
+    // File a run: added to the entry when CanExtend(), otherwise it
+    // replaces the entry if it has more events
+    void AddRun(const ResultKey& key, const PSFResultFile& result);
+
+    // File a result that already contains the entry
+    void Replace(const ResultKey& key, const PSFResultFile& result);
+
+    void Print() const;
+
+private:
+    ResultLibrary();
+    ResultLibrary(const ResultLibrary&) = delete;
+    ResultLibrary& operator=(const ResultLibrary&) = delete;
+
+    // Record of an entry (the .txt next to the .bin)
+    struct Entry {
+        G4double beamEnergy;
+        G4double resistThickness;
+        G4long events;
+        std::vector<G4long> seeds;
+        G4String path;          // result file
+    };
+
+    G4String FamilyDirectory(const ResultKey& key) const;
+    G4String EntryPath(const ResultKey& key) const;
+    std::vector<Entry> ListEntries(const ResultKey& key) const;
+    G4bool FindEntry(const ResultKey& key, Entry& entry) const;
+    void Write(const ResultKey& key, const PSFResultFile& result, const std::vector<G4long>& seeds);
+
+    static ResultLibrary* fInstance;
+
+    G4String fDirectory;
+    G4bool fInterpolation;
+    G4double fTolerance;
+
+    // Entries written by this launch: later runs continue the random
+    // sequence, so they add new events even with the same seed
+    std::set<G4String> fWritten;
+
+    LibraryMessenger* fMessenger;
+};
+
+#endif
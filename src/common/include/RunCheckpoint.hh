@@ -0,0 +1,47 @@
+// RunCheckpoint.hh - Resumable state of a batched run
+#ifndef RunCheckpoint_h
+#define RunCheckpoint_h 1
+
+#include "globals.hh"
+#include "PSFResultFile.hh"
+#include <vector>
+
+// Everything needed to continue a batched run (/ebl/run/beamOn,
+// /ebl/run/converge) after the process died: the merged radial tallies
+// with their events per sweep point, the scalar energy totals, the number
+// of completed batches and the state of the master random engine, which
+// seeds all worker events, so a resumed run draws the same events as an
+// uninterrupted one.
+//
+// A checkpoint directory holds one generation of files at a time:
+//   tallies_<n>.bin   PSFResultFile (n = completed batches)
+//   engine_<n>.rndm   CLHEP engine status
+//   state.txt         batches and scalars; written last and
+//                     renamed into place, so it always names a complete set
+class RunCheckpoint {
+public:
+    RunCheckpoint();
+    ~RunCheckpoint() = default;
+
+    PSFResultFile& GetResult() { return fResult; }
+    const PSFResultFile& GetResult() const { return fResult; }
+
+    // Scalar accumulables, in the order the run action registers them
+    void SetScalars(const std::vector<G4double>& scalars) { fScalars = scalars; }
+    const std::vector<G4double>& GetScalars() const { return fScalars; }
+
+    void SetBatches(G4int batches) { fBatches = batches; }
+    G4int GetBatches() const { return fBatches; }
+
+    // Master thread only: Write also saves the engine status, Read restores
+    // it. Both return false on failure.
+    G4bool Write(const G4String& directory);
+    G4bool Read(const G4String& directory);
+
+private:
+    PSFResultFile fResult;
+    std::vector<G4double> fScalars;
+    G4int fBatches;             // also the generation of the files
+};
+
+#endif
@@ -0,0 +1,38 @@
+// RunControlMessenger.hh - /ebl/run/ commands
+#ifndef RunControlMessenger_h
+#define RunControlMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class ConvergenceControl;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithoutParameter;
+
+class RunControlMessenger : public G4UImessenger {
+public:
+    RunControlMessenger(ConvergenceControl* control);
+    virtual ~RunControlMessenger();
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+
+private:
+    ConvergenceControl* fControl;
+
+    G4UIdirectory* fRunDir;
+    G4UIcmdWithAString* fTargetErrorCmd;
+    G4UIcommand* fRangeCmd;
+    G4UIcmdWithAnInteger* fBatchSizeCmd;
+    G4UIcmdWithAnInteger* fMaxEventsCmd;
+    G4UIcmdWithADoubleAndUnit* fMaxTimeCmd;
+    G4UIcmdWithoutParameter* fConvergeCmd;
+    G4UIcmdWithAnInteger* fBeamOnCmd;
+    G4UIcmdWithAString* fCheckpointCmd;
+    G4UIcmdWithoutParameter* fPrintCmd;
+};
+
+#endif
@@ -0,0 +1,95 @@
+// ShotList.hh - Exposure shots as the source of primaries
+#ifndef ShotList_h
+#define ShotList_h 1
+
+#include "globals.hh"
+#include <vector>
+
+class ShotMessenger;
+
+// A pattern exposure simulated directly: the beam visits the shots of a
+// list, each delivering a number of electrons at its position. Events are
+// indexed into the list by event ID - event e carries up to
+// maxPerEvent electrons of one shot, larger shots span several consecutive
+// events - so every worker thread finds its shots without a shared file
+// cursor, and the result does not depend on which thread ran which event.
+// Event IDs past the end of the list wrap around; /ebl/shots/beamOn runs
+// exactly one pass.
+//
+// Deposits are scored in a lateral dose map over the shot bounding box
+// (grown by a margin) instead of the radial PSF histogram. The list is
+// read once, on the master, and only changes between runs.
+class ShotList {
+public:
+    // Largest dose map; every thread holds a few arrays of this size
+    static const G4int kMaxMapBins = 1 << 22;
+
+    static ShotList* Instance();
+    ~ShotList();
+
+    // "x y [electrons]" per line, positions in nm, '#' starts a comment;
+    // returns false (list unchanged) on a read error
+    G4bool Load(const G4String& fileName);
+    void Clear();
+
+    // Electrons of shots without a count, applied by the next Load
+    void SetDefaultElectrons(G4int electrons) { fDefaultElectrons = electrons; }
+    void SetMaxPrimariesPerEvent(G4int primaries);
+    void SetPixelSize(G4double size);
+    void SetMargin(G4double margin);
+
+    G4bool IsActive() const { return !fShots.empty(); }
+    size_t GetNumberOfShots() const { return fShots.size(); }
+    G4long GetNumberOfEvents() const { return fNumEvents; }
+    G4long GetNumberOfElectrons() const { return fNumElectrons; }
+
+    // Position and electron count of an event
+    G4int GetEvent(G4long eventID, G4double& x, G4double& y) const;
+
+    // Dose map layout; width 0 if the map would exceed kMaxMapBins
+    G4int GetMapWidth() const { return fMapWidth; }
+    G4int GetMapHeight() const { return fMapHeight; }
+    G4double GetMapX0() const { return fMapX0; }
+    G4double GetMapY0() const { return fMapY0; }
+    G4double GetPixelSize() const { return fPixelSize; }
+
+    // One pass over the list
+    void BeamOn();
+
+    void Print() const;
+
+private:
+    ShotList();
+    ShotList(const ShotList&) = delete;
+    ShotList& operator=(const ShotList&) = delete;
+
+    void UpdateEvents();
+    void UpdateMap();
+
+    static ShotList* fInstance;
+
+    struct Shot {
+        G4double x;
+        G4double y;
+        G4int electrons;
+    };
+    std::vector<Shot> fShots;
+    std::vector<G4long> fFirstEvent;    // first event of each shot
+    G4long fNumEvents;
+    G4long fNumElectrons;
+    G4String fFileName;
+
+    G4int fDefaultElectrons;
+    G4int fMaxPrimariesPerEvent;
+    G4double fPixelSize;
+    G4double fMargin;
+
+    G4int fMapWidth;
+    G4int fMapHeight;
+    G4double fMapX0;
+    G4double fMapY0;
+
+    ShotMessenger* fMessenger;
+};
+
+#endif
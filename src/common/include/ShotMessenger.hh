@@ -0,0 +1,36 @@
+// ShotMessenger.hh - /ebl/shots/ commands
+#ifndef ShotMessenger_h
+#define ShotMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class ShotList;
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithoutParameter;
+
+class ShotMessenger : public G4UImessenger {
+public:
+    ShotMessenger(ShotList* shots);
+    virtual ~ShotMessenger();
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+
+private:
+    ShotList* fShots;
+
+    G4UIdirectory* fShotsDir;
+    G4UIcmdWithAString* fLoadCmd;
+    G4UIcmdWithoutParameter* fClearCmd;
+    G4UIcmdWithAnInteger* fElectronsCmd;
+    G4UIcmdWithAnInteger* fMaxPerEventCmd;
+    G4UIcmdWithADoubleAndUnit* fPixelCmd;
+    G4UIcmdWithADoubleAndUnit* fMarginCmd;
+    G4UIcmdWithoutParameter* fBeamOnCmd;
+    G4UIcmdWithoutParameter* fPrintCmd;
+};
+
+#endif
@@ -0,0 +1,29 @@
+// SweepMessenger.hh - /ebl/sweep/ commands
+#ifndef SweepMessenger_h
+#define SweepMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class ParameterSweep;
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithoutParameter;
+
+class SweepMessenger : public G4UImessenger {
+public:
+    SweepMessenger(ParameterSweep* sweep);
+    virtual ~SweepMessenger();
+
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+
+private:
+    ParameterSweep* fSweep;
+
+    G4UIdirectory* fSweepDir;
+    G4UIcmdWithAString* fEnergiesCmd;
+    G4UIcmdWithoutParameter* fClearCmd;
+    G4UIcmdWithoutParameter* fPrintCmd;
+};
+
+#endif
@@ -0,0 +1,95 @@
+// TraceRecorder.hh - Phase timers and Chrome-trace export
+#ifndef TraceRecorder_h
+#define TraceRecorder_h 1
+
+#include "globals.hh"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+class G4VStateDependent;
+
+// Timeline of the coarse phases of a launch: /run/initialize (geometry,
+// resist material, physics construction), the run initialization that
+// builds the physics tables, the event loop of every thread, the
+// end-of-run merge, the MPI reduction and the output. Spans are only
+// recorded with /ebl/perf/trace true; when off a TraceScope reads one
+// atomic flag and never the clock. There are a few spans per thread and
+// run, so they are collected under a lock.
+//
+// The master RunAction appends the per-phase totals to the run summary and
+// writes the spans as a Chrome trace (chrome://tracing, ui.perfetto.dev)
+// next to it. Times are relative to the creation of the recorder in main.
+class TraceRecorder {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static TraceRecorder* Instance();
+    ~TraceRecorder();
+
+    void SetEnabled(G4bool enable) { fEnabled = enable; }
+    G4bool IsEnabled() const { return fEnabled.load(std::memory_order_relaxed); }
+
+    // A finished span of the calling thread; events >= 0 is shown with it
+    void AddSpan(const char* name, Clock::time_point start, Clock::time_point end,
+                 G4long events = -1);
+
+    // Calls, total and longest duration per phase, master and workers apart
+    void PrintPhases(std::ostream& out) const;
+
+    // Chrome trace event format
+    void WriteChromeTrace(std::ostream& json) const;
+
+private:
+    TraceRecorder();
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    struct Span {
+        const char* name;       // string literal
+        G4int thread;           // 0 = master, worker i = i + 1
+        G4double start;         // s since fOrigin
+        G4double duration;      // s
+        G4long events;
+    };
+
+    static TraceRecorder* fInstance;
+
+    Clock::time_point fOrigin;
+    std::atomic<G4bool> fEnabled;
+
+    mutable std::mutex fMutex;
+    std::vector<Span> fSpans;
+
+    // Times the master's G4State_Init phases (initialization, table build)
+    G4VStateDependent* fStateObserver;
+};
+
+// Records the enclosing scope as a span of the calling thread
+class TraceScope {
+public:
+    explicit TraceScope(const char* name)
+        : fName(name), fActive(TraceRecorder::Instance()->IsEnabled())
+    {
+        if (fActive) fStart = TraceRecorder::Clock::now();
+    }
+
+    ~TraceScope()
+    {
+        if (fActive) {
+            TraceRecorder::Instance()->AddSpan(fName, fStart, TraceRecorder::Clock::now());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* fName;
+    G4bool fActive;
+    TraceRecorder::Clock::time_point fStart;
+};
+
+#endif
@@ -0,0 +1,153 @@
+// AsyncWriter.cc - Background writer of the run output files
+#include "AsyncWriter.hh"
+#include "G4ios.hh"
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    // Few large writes rather than one per line: a network file system
+    // pays a round trip per write call
+    const std::size_t kBufferSize = 1 << 20;
+}
+
+AsyncWriter* AsyncWriter::fInstance = nullptr;
+
+AsyncWriter* AsyncWriter::Instance()
+{
+    if (!fInstance) {
+        fInstance = new AsyncWriter();
+    }
+    return fInstance;
+}
+
+AsyncWriter::AsyncWriter()
+    : fEnabled(true),
+    fBusy(false),
+    fStop(false)
+{
+}
+
+AsyncWriter::~AsyncWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fStop = true;
+    }
+    fWake.notify_all();
+    if (fThread.joinable()) fThread.join();
+}
+
+void AsyncWriter::SetEnabled(G4bool enable)
+{
+    // Files queued so far still go out before any written in place
+    if (!enable) Flush();
+    fEnabled = enable;
+}
+
+void AsyncWriter::Submit(const std::string& path, Serializer serialize, G4bool binary)
+{
+    Job job{ path, std::move(serialize), binary };
+    if (!fEnabled) {
+        if (!WriteFile(job)) {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fFailed.push_back(path);
+        }
+        ReportFailures();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fQueue.push_back(std::move(job));
+        if (!fThread.joinable()) {
+            fThread = std::thread(&AsyncWriter::WriterLoop, this);
+        }
+    }
+    fWake.notify_one();
+    ReportFailures();
+}
+
+void AsyncWriter::Submit(const std::string& path, std::string content)
+{
+    Submit(path, [text = std::move(content)](std::ostream& out) {
+        out << text;
+        return true;
+    });
+}
+
+void AsyncWriter::Flush()
+{
+    {
+        std::unique_lock<std::mutex> lock(fMutex);
+        fIdle.wait(lock, [this]() { return fQueue.empty() && !fBusy; });
+    }
+    ReportFailures();
+}
+
+void AsyncWriter::WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(fMutex);
+    while (true) {
+        fWake.wait(lock, [this]() { return fStop || !fQueue.empty(); });
+        if (fQueue.empty()) break;
+
+        Job job = std::move(fQueue.front());
+        fQueue.pop_front();
+        fBusy = true;
+        lock.unlock();
+
+        G4bool ok = WriteFile(job);
+        job.serialize = nullptr;  // releases the snapshot outside the lock
+
+        lock.lock();
+        fBusy = false;
+        if (!ok) fFailed.push_back(job.path);
+        if (fQueue.empty()) fIdle.notify_all();
+    }
+}
+
+G4bool AsyncWriter::WriteFile(const Job& job)
+{
+    const std::string temporary = job.path + ".tmp";
+    G4bool ok = false;
+    {
+        // The buffer must be set before the file is opened
+        std::vector<char> buffer(kBufferSize);
+        std::ofstream out;
+        out.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        out.open(temporary, job.binary ? std::ios::trunc | std::ios::binary : std::ios::trunc);
+        if (!out) return false;
+        try {
+            ok = job.serialize(out);
+        }
+        catch (const std::exception&) {
+            ok = false;
+        }
+        out.close();
+        ok = ok && !out.fail();
+    }
+
+    std::error_code ec;
+    if (ok) std::filesystem::rename(temporary, job.path, ec);
+    if (!ok || ec) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+void AsyncWriter::ReportFailures()
+{
+    std::vector<std::string> failed;
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        failed.swap(fFailed);
+    }
+    for (const std::string& path : failed) {
+        G4ExceptionDescription msg;
+        msg << "Could not write " << path;
+        G4Exception("AsyncWriter::Submit", "ASYNC001", JustWarning, msg);
+    }
+}
@@ -0,0 +1,122 @@
+// BackscatterFastSim.cc - Settings and shared table of the deep-substrate fast simulation
+#include "BackscatterFastSim.hh"
+#include "FastSimMessenger.hh"
+#include "G4UnitsTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+
+BackscatterFastSim* BackscatterFastSim::fInstance = nullptr;
+G4ThreadLocal BackscatterResponse* BackscatterFastSim::fCalibrationTable = nullptr;
+G4ThreadLocal G4int BackscatterFastSim::fCalibrationCell = -1;
+G4ThreadLocal G4double BackscatterFastSim::fCalibrationEnergy = 0.;
+
+BackscatterFastSim* BackscatterFastSim::Instance()
+{
+    if (!fInstance) {
+        fInstance = new BackscatterFastSim();
+    }
+    return fInstance;
+}
+
+BackscatterFastSim::BackscatterFastSim()
+    : fEnabled(false),
+    fTriggerDepth(2.0 * micrometer),
+    fTableFile("backscatter_response.bin"),
+    fTable("BackscatterTable"),
+    fCalibrating(false),
+    fCalibrationFile("backscatter_response.bin"),
+    fNumEnergy(20),
+    fMinEnergy(1.0 * keV),
+    fMaxEnergy(100.0 * keV),
+    fNumDepth(12),
+    fMinDepth(2.0 * micrometer),
+    fMaxDepth(50.0 * micrometer),
+    fNumCosTheta(5),
+    fSamplesPerCell(1000),
+    fMessenger(nullptr)
+{
+    fMessenger = new FastSimMessenger(this);
+}
+
+BackscatterFastSim::~BackscatterFastSim()
+{
+    delete fMessenger;
+}
+
+void BackscatterFastSim::SetTableFile(const G4String& fileName)
+{
+    fTableFile = fileName;
+    fLoadedFile = "";
+}
+
+void BackscatterFastSim::SetEnergyAxis(G4int nBins, G4double minEnergy, G4double maxEnergy)
+{
+    if (nBins < 1 || minEnergy <= 0. || maxEnergy <= minEnergy) {
+        G4Exception("BackscatterFastSim::SetEnergyAxis", "FAST001", JustWarning,
+            "Invalid energy axis, command ignored");
+        return;
+    }
+    fNumEnergy = nBins;
+    fMinEnergy = minEnergy;
+    fMaxEnergy = maxEnergy;
+}
+
+void BackscatterFastSim::SetDepthAxis(G4int nBins, G4double minDepth, G4double maxDepth)
+{
+    if (nBins < 1 || minDepth < 0. || maxDepth <= minDepth) {
+        G4Exception("BackscatterFastSim::SetDepthAxis", "FAST001", JustWarning,
+            "Invalid depth axis, command ignored");
+        return;
+    }
+    fNumDepth = nBins;
+    fMinDepth = minDepth;
+    fMaxDepth = maxDepth;
+}
+
+void BackscatterFastSim::ConfigureCalibration(BackscatterResponse& table) const
+{
+    table.SetAxes(fNumEnergy, fMinEnergy, fMaxEnergy,
+                  fNumDepth, fMinDepth, fMaxDepth,
+                  fNumCosTheta, fSamplesPerCell);
+}
+
+void BackscatterFastSim::LoadTable()
+{
+    if (!fEnabled || fCalibrating || fLoadedFile == fTableFile) return;
+
+    if (!fTable.Read(fTableFile)) {
+        fLoadedFile = "";
+        G4ExceptionDescription msg;
+        msg << "No usable backscatter response table in " << fTableFile
+            << ", fast simulation disabled for this run.\n"
+            << "Build one with /ebl/fastsim/calibrate true.";
+        G4Exception("BackscatterFastSim::LoadTable", "FAST002", JustWarning, msg);
+        return;
+    }
+    fLoadedFile = fTableFile;
+
+    if (fTriggerDepth < fTable.GetMinDepth()) {
+        G4ExceptionDescription msg;
+        msg << "Trigger depth " << G4BestUnit(fTriggerDepth, "Length")
+            << " is shallower than the table (" << G4BestUnit(fTable.GetMinDepth(), "Length")
+            << "), the first depth bin is used above it";
+        G4Exception("BackscatterFastSim::LoadTable", "FAST003", JustWarning, msg);
+    }
+
+    G4cout << "Loaded backscatter response table " << fTableFile << ": "
+        << fTable.GetNumberOfCells() << " cells" << G4endl;
+}
+
+void BackscatterFastSim::Print() const
+{
+    G4cout << "\n=== Deep-substrate fast simulation: "
+        << (fCalibrating ? "CALIBRATING" : (fEnabled ? "ON" : "off")) << " ===" << G4endl;
+    G4cout << " Trigger depth: " << G4BestUnit(fTriggerDepth, "Length") << G4endl;
+    G4cout << " Table: " << fTableFile
+        << (fTable.IsEmpty() ? " (not loaded)" : " (loaded)") << G4endl;
+    G4cout << " Calibration: " << fNumEnergy << " energy bins ("
+        << G4BestUnit(fMinEnergy, "Energy") << " - " << G4BestUnit(fMaxEnergy, "Energy") << "), "
+        << fNumDepth << " depth bins (" << G4BestUnit(fMinDepth, "Length") << " - "
+        << G4BestUnit(fMaxDepth, "Length") << "), " << fNumCosTheta << " cos(theta) bins, "
+        << fSamplesPerCell << " samples/cell -> " << fCalibrationFile << G4endl;
+}
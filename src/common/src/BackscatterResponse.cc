@@ -0,0 +1,263 @@
+// BackscatterResponse.cc - Tabulated return of deep-substrate electrons to the surface
+#include "BackscatterResponse.hh"
+#include "G4ios.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+namespace {
+    const char kMagic[8] = { 'E', 'B', 'L', 'B', 'S', 'R', '1', '\0' };
+
+    template <typename T>
+    void WriteValue(std::ofstream& out, const T& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    G4bool ReadValue(std::ifstream& in, T& value)
+    {
+        in.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return static_cast<G4bool>(in);
+    }
+}
+
+BackscatterResponse::BackscatterResponse(const G4String& name)
+    : G4VAccumulable(name),
+    fNumEnergy(0),
+    fNumDepth(0),
+    fNumCosTheta(0),
+    fMinEnergy(0.),
+    fMaxEnergy(0.),
+    fMinDepth(0.),
+    fMaxDepth(0.),
+    fLogMinEnergy(0.),
+    fInvLogEnergyStep(0.),
+    fMaxSamples(0)
+{
+}
+
+void BackscatterResponse::SetAxes(G4int nEnergy, G4double minEnergy, G4double maxEnergy,
+                                  G4int nDepth, G4double minDepth, G4double maxDepth,
+                                  G4int nCosTheta, G4int maxSamplesPerCell)
+{
+    if (nEnergy < 1 || nDepth < 1 || nCosTheta < 1 || maxSamplesPerCell < 1 ||
+        minEnergy <= 0. || maxEnergy <= minEnergy || minDepth < 0. || maxDepth <= minDepth) {
+        G4Exception("BackscatterResponse::SetAxes", "BSR001", FatalErrorInArgument,
+            "Invalid backscatter response table layout");
+        return;
+    }
+
+    fNumEnergy = nEnergy;
+    fNumDepth = nDepth;
+    fNumCosTheta = nCosTheta;
+    fMinEnergy = minEnergy;
+    fMaxEnergy = maxEnergy;
+    fMinDepth = minDepth;
+    fMaxDepth = maxDepth;
+    fLogMinEnergy = std::log(minEnergy);
+    fInvLogEnergyStep = nEnergy / (std::log(maxEnergy) - fLogMinEnergy);
+    fMaxSamples = maxSamplesPerCell;
+
+    fCells.assign(static_cast<size_t>(nEnergy) * nDepth * nCosTheta, Cell());
+}
+
+G4int BackscatterResponse::FindCell(G4double energy, G4double depth, G4double cosTheta) const
+{
+    G4int iE = 0;
+    if (energy > fMinEnergy) {
+        iE = std::min(fNumEnergy - 1,
+            static_cast<G4int>((std::log(energy) - fLogMinEnergy) * fInvLogEnergyStep));
+    }
+
+    G4double d = (depth - fMinDepth) / (fMaxDepth - fMinDepth) * fNumDepth;
+    G4int iD = std::max(0, std::min(fNumDepth - 1, static_cast<G4int>(d)));
+
+    G4int iC = std::max(0, std::min(fNumCosTheta - 1, static_cast<G4int>(cosTheta * fNumCosTheta)));
+
+    return (iE * fNumDepth + iD) * fNumCosTheta + iC;
+}
+
+void BackscatterResponse::GetCellRange(G4int cell, G4double& eLow, G4double& eHigh,
+                                       G4double& dLow, G4double& dHigh,
+                                       G4double& cLow, G4double& cHigh) const
+{
+    G4int iC = cell % fNumCosTheta;
+    G4int iD = (cell / fNumCosTheta) % fNumDepth;
+    G4int iE = cell / (fNumCosTheta * fNumDepth);
+
+    eLow = std::exp(fLogMinEnergy + iE / fInvLogEnergyStep);
+    eHigh = std::exp(fLogMinEnergy + (iE + 1) / fInvLogEnergyStep);
+
+    G4double depthStep = (fMaxDepth - fMinDepth) / fNumDepth;
+    dLow = fMinDepth + iD * depthStep;
+    dHigh = dLow + depthStep;
+
+    cLow = static_cast<G4double>(iC) / fNumCosTheta;
+    cHigh = static_cast<G4double>(iC + 1) / fNumCosTheta;
+}
+
+void BackscatterResponse::AddReturn(G4int cell, const Sample& sample, G4double random)
+{
+    // Reservoir sampling keeps a uniform subset of all returns of the cell
+    Cell& c = fCells[cell];
+    ++c.returns;
+    if (static_cast<G4int>(c.samples.size()) < fMaxSamples) {
+        c.samples.push_back(sample);
+    }
+    else {
+        G4long j = static_cast<G4long>(random * c.returns);
+        if (j < fMaxSamples) {
+            c.samples[j] = sample;
+        }
+    }
+}
+
+void BackscatterResponse::Merge(const G4VAccumulable& other)
+{
+    const auto& otherResponse = static_cast<const BackscatterResponse&>(other);
+    if (otherResponse.fCells.size() != fCells.size()) {
+        G4Exception("BackscatterResponse::Merge", "BSR002", FatalException,
+            "Cannot merge backscatter tables with different layouts");
+        return;
+    }
+
+    for (size_t i = 0; i < fCells.size(); ++i) {
+        Cell& mine = fCells[i];
+        const Cell& theirs = otherResponse.fCells[i];
+
+        // Combine the two reservoirs so every return of the merged cell is
+        // equally likely to be kept. A local generator keeps the Geant4
+        // engine untouched.
+        if (mine.samples.size() + theirs.samples.size() <= static_cast<size_t>(fMaxSamples)) {
+            mine.samples.insert(mine.samples.end(), theirs.samples.begin(), theirs.samples.end());
+        }
+        else {
+            std::mt19937_64 rng(0x9E3779B97F4A7C15ULL ^ (i * 0x100000001B3ULL)
+                                ^ static_cast<std::uint64_t>(mine.returns + theirs.returns));
+            std::vector<Sample> a = mine.samples;
+            std::vector<Sample> b = theirs.samples;
+            std::shuffle(a.begin(), a.end(), rng);
+            std::shuffle(b.begin(), b.end(), rng);
+
+            G4double pA = static_cast<G4double>(mine.returns) / (mine.returns + theirs.returns);
+            std::uniform_real_distribution<G4double> uniform(0., 1.);
+            mine.samples.clear();
+            size_t ia = 0, ib = 0;
+            while (mine.samples.size() < static_cast<size_t>(fMaxSamples) &&
+                   (ia < a.size() || ib < b.size())) {
+                G4bool fromA = (ib >= b.size()) || (ia < a.size() && uniform(rng) < pA);
+                mine.samples.push_back(fromA ? a[ia++] : b[ib++]);
+            }
+        }
+
+        mine.entries += theirs.entries;
+        mine.returns += theirs.returns;
+    }
+}
+
+void BackscatterResponse::Reset()
+{
+    for (Cell& cell : fCells) {
+        cell.entries = 0;
+        cell.returns = 0;
+        cell.samples.clear();
+    }
+}
+
+#if G4VERSION_NUMBER >= 1120
+void BackscatterResponse::Print(G4PrintOptions) const
+{
+    G4long entries = 0, returns = 0;
+    for (const Cell& cell : fCells) {
+        entries += cell.entries;
+        returns += cell.returns;
+    }
+    G4cout << GetName() << ": " << fNumEnergy << "x" << fNumDepth << "x" << fNumCosTheta
+        << " cells, " << entries << " entries, " << returns << " returns" << G4endl;
+}
+#endif
+
+G4bool BackscatterResponse::Write(const G4String& fileName) const
+{
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out) {
+        G4ExceptionDescription msg;
+        msg << "Cannot write backscatter response to " << fileName;
+        G4Exception("BackscatterResponse::Write", "BSR003", JustWarning, msg);
+        return false;
+    }
+
+    out.write(kMagic, sizeof(kMagic));
+    WriteValue(out, static_cast<std::int32_t>(fNumEnergy));
+    WriteValue(out, static_cast<std::int32_t>(fNumDepth));
+    WriteValue(out, static_cast<std::int32_t>(fNumCosTheta));
+    WriteValue(out, static_cast<std::int32_t>(fMaxSamples));
+    // Internal units (MeV, mm)
+    WriteValue(out, fMinEnergy);
+    WriteValue(out, fMaxEnergy);
+    WriteValue(out, fMinDepth);
+    WriteValue(out, fMaxDepth);
+
+    for (const Cell& cell : fCells) {
+        WriteValue(out, static_cast<std::int64_t>(cell.entries));
+        WriteValue(out, static_cast<std::int64_t>(cell.returns));
+        WriteValue(out, static_cast<std::int32_t>(cell.samples.size()));
+        if (!cell.samples.empty()) {
+            out.write(reinterpret_cast<const char*>(cell.samples.data()),
+                      cell.samples.size() * sizeof(Sample));
+        }
+    }
+
+    return static_cast<G4bool>(out);
+}
+
+G4bool BackscatterResponse::Read(const G4String& fileName)
+{
+    fCells.clear();
+
+    std::ifstream in(fileName, std::ios::binary);
+    char magic[sizeof(kMagic)];
+    if (!in || !in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+        G4ExceptionDescription msg;
+        msg << fileName << " is not a backscatter response table";
+        G4Exception("BackscatterResponse::Read", "BSR004", JustWarning, msg);
+        return false;
+    }
+
+    std::int32_t nE = 0, nD = 0, nC = 0, maxSamples = 0;
+    G4double eMin = 0., eMax = 0., dMin = 0., dMax = 0.;
+    G4bool ok = ReadValue(in, nE) && ReadValue(in, nD) && ReadValue(in, nC) &&
+                ReadValue(in, maxSamples) && ReadValue(in, eMin) && ReadValue(in, eMax) &&
+                ReadValue(in, dMin) && ReadValue(in, dMax);
+    if (ok) {
+        SetAxes(nE, eMin, eMax, nD, dMin, dMax, nC, maxSamples);
+        for (Cell& cell : fCells) {
+            std::int64_t entries = 0, returns = 0;
+            std::int32_t nSamples = 0;
+            ok = ReadValue(in, entries) && ReadValue(in, returns) && ReadValue(in, nSamples) &&
+                 nSamples >= 0 && nSamples <= maxSamples;
+            if (!ok) break;
+            cell.entries = entries;
+            cell.returns = returns;
+            cell.samples.resize(nSamples);
+            if (nSamples > 0) {
+                ok = static_cast<G4bool>(in.read(reinterpret_cast<char*>(cell.samples.data()),
+                                                 nSamples * sizeof(Sample)));
+                if (!ok) break;
+            }
+        }
+    }
+
+    if (!ok) {
+        fCells.clear();
+        G4ExceptionDescription msg;
+        msg << "Backscatter response table " << fileName << " is truncated or corrupt";
+        G4Exception("BackscatterResponse::Read", "BSR005", JustWarning, msg);
+        return false;
+    }
+    return true;
+}
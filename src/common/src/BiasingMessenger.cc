@@ -0,0 +1,107 @@
+// BiasingMessenger.cc
+#include "BiasingMessenger.hh"
+#include "ImportanceBiasing.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4Tokenizer.hh"
+
+BiasingMessenger::BiasingMessenger(ImportanceBiasing* biasing)
+    : G4UImessenger(),
+    fBiasing(biasing)
+{
+    // Settings are shared by all threads, so nothing is broadcast
+    fBiasDir = new G4UIdirectory("/ebl/bias/");
+    fBiasDir->SetGuidance("Weighted variance reduction (Russian roulette and splitting)");
+
+    fEnableCmd = new G4UIcmdWithABool("/ebl/bias/enable", this);
+    fEnableCmd->SetGuidance("Enable importance biasing");
+    fEnableCmd->SetParameterName("enable", true);
+    fEnableCmd->SetDefaultValue(true);
+    fEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fEnableCmd->SetToBeBroadcasted(false);
+
+    fRouletteCmd = new G4UIcommand("/ebl/bias/roulette", this);
+    fRouletteCmd->SetGuidance("Russian roulette for new electrons in a region that are deeper");
+    fRouletteCmd->SetGuidance("than <depth> below the resist and moving away from it.");
+    fRouletteCmd->SetGuidance("Survivors carry weight w/p.");
+    fRouletteCmd->SetGuidance("  e.g. /ebl/bias/roulette SubstrateRegion 0.25 2 um");
+    G4UIparameter* regionParam = new G4UIparameter("region", 's', false);
+    fRouletteCmd->SetParameter(regionParam);
+    G4UIparameter* probParam = new G4UIparameter("p", 'd', false);
+    probParam->SetParameterRange("p>0. && p<=1.");
+    fRouletteCmd->SetParameter(probParam);
+    G4UIparameter* depthParam = new G4UIparameter("depth", 'd', false);
+    depthParam->SetParameterRange("depth>=0.");
+    fRouletteCmd->SetParameter(depthParam);
+    G4UIparameter* unitParam = new G4UIparameter("unit", 's', true);
+    unitParam->SetDefaultUnit("um");
+    fRouletteCmd->SetParameter(unitParam);
+    fRouletteCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fRouletteCmd->SetToBeBroadcasted(false);
+
+    fSplitCmd = new G4UIcommand("/ebl/bias/split", this);
+    fSplitCmd->SetGuidance("Split electrons crossing up into a region into N copies of weight w/N.");
+    fSplitCmd->SetGuidance("Supported for regions made of resist volumes.");
+    fSplitCmd->SetGuidance("  e.g. /ebl/bias/split ResistRegion 4");
+    G4UIparameter* splitRegionParam = new G4UIparameter("region", 's', false);
+    fSplitCmd->SetParameter(splitRegionParam);
+    G4UIparameter* factorParam = new G4UIparameter("N", 'i', false);
+    factorParam->SetParameterRange("N>=1");
+    fSplitCmd->SetParameter(factorParam);
+    fSplitCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fSplitCmd->SetToBeBroadcasted(false);
+
+    fMinWeightCmd = new G4UIcmdWithADouble("/ebl/bias/minWeight", this);
+    fMinWeightCmd->SetGuidance("Do not split tracks whose weight would drop below this value");
+    fMinWeightCmd->SetParameterName("weight", false);
+    fMinWeightCmd->SetRange("weight>0.");
+    fMinWeightCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fMinWeightCmd->SetToBeBroadcasted(false);
+
+    fPrintCmd = new G4UIcmdWithoutParameter("/ebl/bias/print", this);
+    fPrintCmd->SetGuidance("Print the biasing settings");
+    fPrintCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fPrintCmd->SetToBeBroadcasted(false);
+}
+
+BiasingMessenger::~BiasingMessenger()
+{
+    delete fEnableCmd;
+    delete fRouletteCmd;
+    delete fSplitCmd;
+    delete fMinWeightCmd;
+    delete fPrintCmd;
+    delete fBiasDir;
+}
+
+void BiasingMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == fEnableCmd) {
+        fBiasing->SetEnabled(fEnableCmd->GetNewBoolValue(newValue));
+    }
+    else if (command == fRouletteCmd) {
+        G4Tokenizer next(newValue);
+        G4String region = next();
+        G4double probability = StoD(next());
+        G4double depth = StoD(next());
+        G4String unit = next();
+        depth *= G4UIcommand::ValueOf(unit);
+        fBiasing->SetRoulette(region, probability, depth);
+    }
+    else if (command == fSplitCmd) {
+        G4Tokenizer next(newValue);
+        G4String region = next();
+        G4int factor = StoI(next());
+        fBiasing->SetSplitting(region, factor);
+    }
+    else if (command == fMinWeightCmd) {
+        fBiasing->SetMinimumWeight(fMinWeightCmd->GetNewDoubleValue(newValue));
+    }
+    else if (command == fPrintCmd) {
+        fBiasing->Print();
+    }
+}
@@ -0,0 +1,55 @@
+// CacheMessenger.cc
+#include "CacheMessenger.hh"
+#include "PhysicsTableCache.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+CacheMessenger::CacheMessenger(PhysicsTableCache* cache)
+    : G4UImessenger(),
+    fCache(cache)
+{
+    // Only the master reads and writes the cache, so nothing is broadcast
+    fCacheDir = new G4UIdirectory("/ebl/cache/");
+    fCacheDir->SetGuidance("On-disk physics table cache");
+
+    fEnableCmd = new G4UIcmdWithABool("/ebl/cache/enable", this);
+    fEnableCmd->SetGuidance("Store built physics tables and retrieve them on later launches (default off)");
+    fEnableCmd->SetParameterName("enable", true);
+    fEnableCmd->SetDefaultValue(true);
+    fEnableCmd->AvailableForStates(G4State_PreInit);
+    fEnableCmd->SetToBeBroadcasted(false);
+
+    fDirectoryCmd = new G4UIcmdWithAString("/ebl/cache/directory", this);
+    fDirectoryCmd->SetGuidance("Cache directory; one subdirectory per physics setup");
+    fDirectoryCmd->SetParameterName("directory", false);
+    fDirectoryCmd->AvailableForStates(G4State_PreInit);
+    fDirectoryCmd->SetToBeBroadcasted(false);
+
+    fPrintCmd = new G4UIcmdWithoutParameter("/ebl/cache/print", this);
+    fPrintCmd->SetGuidance("Print the cache settings and the entry in use");
+    fPrintCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fPrintCmd->SetToBeBroadcasted(false);
+}
+
+CacheMessenger::~CacheMessenger()
+{
+    delete fEnableCmd;
+    delete fDirectoryCmd;
+    delete fPrintCmd;
+    delete fCacheDir;
+}
+
+void CacheMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == fEnableCmd) {
+        fCache->SetEnabled(fEnableCmd->GetNewBoolValue(newValue));
+    }
+    else if (command == fDirectoryCmd) {
+        fCache->SetDirectory(newValue);
+    }
+    else if (command == fPrintCmd) {
+        fCache->Print();
+    }
+}
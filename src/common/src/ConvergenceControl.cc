@@ -0,0 +1,202 @@
+// ConvergenceControl.cc - Event batches until the PSF reaches a target error
+#include "ConvergenceControl.hh"
+#include "RunControlMessenger.hh"
+#include "RunCheckpoint.hh"
+#include "DataManager.hh"
+#include "DistributedRun.hh"
+#include "G4RunManager.hh"
+#include "G4UnitsTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+#include <algorithm>
+#include <cfloat>
+
+ConvergenceControl* ConvergenceControl::fInstance = nullptr;
+
+ConvergenceControl* ConvergenceControl::Instance()
+{
+    if (!fInstance) {
+        fInstance = new ConvergenceControl();
+    }
+    return fInstance;
+}
+
+ConvergenceControl::ConvergenceControl()
+    : fTargetError(0.),
+    fMinRadius(0.),
+    fMaxRadius(0.),
+    fBatchSize(10000),
+    fMaxEvents(10000000),
+    fMaxTime(0.),
+    fRunning(false),
+    fUseTarget(false),
+    fFinished(false),
+    fBatches(0),
+    fEvents(0),
+    fLoopMaxEvents(0),
+    fMessenger(nullptr)
+{
+    fMessenger = new RunControlMessenger(this);
+}
+
+ConvergenceControl::~ConvergenceControl()
+{
+    delete fMessenger;
+}
+
+void ConvergenceControl::SetRadiusRange(G4double minRadius, G4double maxRadius)
+{
+    if (maxRadius > 0. && maxRadius <= minRadius) {
+        G4Exception("ConvergenceControl::SetRadiusRange", "CONV001", JustWarning,
+            "Convergence range must have max > min (or max = 0); ignored");
+        return;
+    }
+    fMinRadius = minRadius;
+    fMaxRadius = maxRadius;
+}
+
+void ConvergenceControl::Resume(const G4String& directory)
+{
+    fResumeDirectory = directory;
+    fCheckpointDirectory = directory;
+}
+
+void ConvergenceControl::Run()
+{
+    if (fTargetError <= 0.) {
+        G4Exception("ConvergenceControl::Run", "CONV001", JustWarning,
+            "No target error set, use /ebl/run/targetError first");
+        return;
+    }
+
+    Print();
+    RunBatches(fMaxEvents, true);
+}
+
+void ConvergenceControl::RunEvents(G4long events)
+{
+    RunBatches(events, false);
+}
+
+void ConvergenceControl::RunBatches(G4long maxEvents, G4bool useTarget)
+{
+    fRunning = true;
+    fUseTarget = useTarget;
+    fFinished = false;
+    fBatches = 0;
+    fEvents = 0;
+    fStartTime = std::chrono::steady_clock::now();
+
+    // Only the first loop after --resume continues from the checkpoint.
+    // Under MPI every rank resumes its own tallies; the event count is
+    // that of all ranks.
+    DistributedRun* distributed = DistributedRun::Instance();
+    if (!fResumeDirectory.empty()) {
+        fResumeState = std::make_unique<RunCheckpoint>();
+        G4bool resumed = fResumeState->Read(distributed->GetRankDirectory(fResumeDirectory));
+        fEvents = distributed->Sum(resumed ? fResumeState->GetResult().GetTotalEvents() : 0);
+        if (resumed) {
+            fBatches = fResumeState->GetBatches();
+            DataManager::Instance()->SetRunSeed(fResumeState->GetResult().GetSeed());
+            G4cout << "### Resuming from " << fResumeDirectory << ": " << fBatches
+                << " batches, " << fEvents << " events done" << G4endl;
+        }
+        else {
+            fResumeState.reset();
+            G4cout << "### Nothing to resume in " << fResumeDirectory << ", starting from zero" << G4endl;
+        }
+        fResumeDirectory.clear();
+    }
+
+    fLoopMaxEvents = maxEvents;
+    if (maxEvents > 0 && fEvents >= maxEvents) {
+        G4cout << "### All " << maxEvents << " events already done" << G4endl;
+        fResumeState.reset();
+        fRunning = false;
+        return;
+    }
+
+    G4RunManager* runManager = G4RunManager::GetRunManager();
+    while (!fFinished) {
+        G4long batch = fBatchSize;
+        if (maxEvents > 0) batch = std::min(batch, maxEvents - fEvents);
+
+        // The run action reports every completed batch; a run that did not
+        // (aborted, or no events) ends the loop. Ranks split each batch.
+        G4int batches = fBatches;
+        runManager->BeamOn(static_cast<G4int>(distributed->GetShare(batch)));
+        if (fBatches == batches) break;
+    }
+
+    fResumeState.reset();
+    fRunning = false;
+}
+
+G4bool ConvergenceControl::EndBatch(G4long events, G4double worstError, G4double worstRadius)
+{
+    ++fBatches;
+    fEvents += events;
+
+    G4double elapsed = std::chrono::duration<G4double>(
+        std::chrono::steady_clock::now() - fStartTime).count() * s;
+
+    G4bool outOfEvents = fLoopMaxEvents > 0 && fEvents >= fLoopMaxEvents;
+    if (!fUseTarget) {
+        G4cout << "### Batch " << fBatches << ": " << fEvents << " / " << fLoopMaxEvents
+            << " events" << G4endl;
+        fFinished = outOfEvents;
+        return fFinished;
+    }
+
+    G4bool converged = worstError <= fTargetError;
+    G4bool outOfTime = fMaxTime > 0. && elapsed >= fMaxTime;
+
+    G4cout << "### Batch " << fBatches << ": " << fEvents << " events, worst relative error ";
+    if (worstError < DBL_MAX) {
+        G4cout << worstError * 100 << "% at r = " << G4BestUnit(worstRadius, "Length");
+    }
+    else {
+        G4cout << "undefined (too few hits) at r = " << G4BestUnit(worstRadius, "Length");
+    }
+    G4cout << " (target " << fTargetError * 100 << "%)" << G4endl;
+
+    if (converged) {
+        G4cout << "### Converged after " << fEvents << " events in "
+            << G4BestUnit(elapsed, "Time") << G4endl;
+    }
+    else if (outOfEvents || outOfTime) {
+        G4ExceptionDescription msg;
+        msg << (outOfEvents ? "Event" : "Time") << " budget used up after " << fEvents
+            << " events before reaching the target error; writing the output as is";
+        G4Exception("ConvergenceControl::EndBatch", "CONV002", JustWarning, msg);
+    }
+
+    fFinished = converged || outOfEvents || outOfTime;
+    return fFinished;
+}
+
+void ConvergenceControl::Print() const
+{
+    G4cout << "\n=== Batched runs ===" << G4endl;
+    G4cout << " Batch size: " << fBatchSize << " events" << G4endl;
+    G4cout << " Checkpoints: "
+        << (fCheckpointDirectory.empty() ? G4String("off") : fCheckpointDirectory) << G4endl;
+    if (fTargetError <= 0.) {
+        G4cout << " Target error: off" << G4endl;
+        return;
+    }
+    G4cout << " Target relative error: " << fTargetError * 100 << "% per bin" << G4endl;
+    G4cout << " Radius range: " << G4BestUnit(fMinRadius, "Length") << " - ";
+    if (fMaxRadius > 0.) {
+        G4cout << G4BestUnit(fMaxRadius, "Length") << G4endl;
+    }
+    else {
+        G4cout << "end of binning" << G4endl;
+    }
+    G4cout << " Event budget: ";
+    if (fMaxEvents > 0) G4cout << fMaxEvents << G4endl;
+    else G4cout << "unlimited" << G4endl;
+    G4cout << " Time budget: ";
+    if (fMaxTime > 0.) G4cout << G4BestUnit(fMaxTime, "Time") << G4endl;
+    else G4cout << "unlimited" << G4endl;
+}
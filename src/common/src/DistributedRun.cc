@@ -0,0 +1,69 @@
+// DistributedRun.cc - Reduction of run tallies across MPI ranks
+#include "DistributedRun.hh"
+#include <algorithm>
+
+#ifdef EBL_USE_MPI
+#include <mpi.h>
+#endif
+
+DistributedRun* DistributedRun::fInstance = nullptr;
+
+DistributedRun* DistributedRun::Instance()
+{
+    if (!fInstance) {
+        fInstance = new DistributedRun();
+    }
+    return fInstance;
+}
+
+DistributedRun::DistributedRun()
+    : fRank(0),
+    fSize(1)
+{
+#ifdef EBL_USE_MPI
+    // MPI is initialized by G4MPImanager in main(); without it (plain
+    // launch of an MPI build) this is a single rank
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    if (initialized) {
+        MPI_Comm_rank(MPI_COMM_WORLD, &fRank);
+        MPI_Comm_size(MPI_COMM_WORLD, &fSize);
+    }
+#endif
+}
+
+void DistributedRun::Sum(std::vector<G4double>& values) const
+{
+#ifdef EBL_USE_MPI
+    if (fSize > 1 && !values.empty()) {
+        MPI_Allreduce(MPI_IN_PLACE, values.data(), static_cast<int>(values.size()),
+                      MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    }
+#else
+    (void)values;
+#endif
+}
+
+G4long DistributedRun::Sum(G4long value) const
+{
+#ifdef EBL_USE_MPI
+    if (fSize > 1) {
+        long long total = value;
+        MPI_Allreduce(MPI_IN_PLACE, &total, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+        return static_cast<G4long>(total);
+    }
+#endif
+    return value;
+}
+
+G4long DistributedRun::GetShare(G4long events) const
+{
+    G4long share = events / fSize + (fRank < events % fSize ? 1 : 0);
+    return std::max<G4long>(share, 1);
+}
+
+G4String DistributedRun::GetRankDirectory(const G4String& directory) const
+{
+    if (fSize == 1) return directory;
+    return directory + "/rank_" + std::to_string(fRank);
+}
@@ -0,0 +1,163 @@
+// FastSimMessenger.cc
+#include "FastSimMessenger.hh"
+#include "BackscatterFastSim.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4Tokenizer.hh"
+
+namespace {
+    // <n> <min> <max> [unit]
+    G4UIcommand* CreateAxisCommand(const G4String& path, G4UImessenger* messenger,
+                                   const G4String& unitName)
+    {
+        G4UIcommand* command = new G4UIcommand(path, messenger);
+        G4UIparameter* binsParam = new G4UIparameter("n", 'i', false);
+        binsParam->SetParameterRange("n>=1");
+        command->SetParameter(binsParam);
+        command->SetParameter(new G4UIparameter("min", 'd', false));
+        command->SetParameter(new G4UIparameter("max", 'd', false));
+        G4UIparameter* unitParam = new G4UIparameter("unit", 's', true);
+        unitParam->SetDefaultUnit(unitName);
+        command->SetParameter(unitParam);
+        command->AvailableForStates(G4State_PreInit, G4State_Idle);
+        command->SetToBeBroadcasted(false);
+        return command;
+    }
+}
+
+FastSimMessenger::FastSimMessenger(BackscatterFastSim* fastSim)
+    : G4UImessenger(),
+    fFastSim(fastSim)
+{
+    // Settings are shared by all threads, so nothing is broadcast
+    fFastSimDir = new G4UIdirectory("/ebl/fastsim/");
+    fFastSimDir->SetGuidance("Fast simulation of deep-substrate electron transport");
+
+    fEnableCmd = new G4UIcmdWithABool("/ebl/fastsim/enable", this);
+    fEnableCmd->SetGuidance("Replace electrons heading down below the trigger depth by");
+    fEnableCmd->SetGuidance("returns sampled from the backscatter response table");
+    fEnableCmd->SetParameterName("enable", true);
+    fEnableCmd->SetDefaultValue(true);
+    fEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fEnableCmd->SetToBeBroadcasted(false);
+
+    fDepthCmd = new G4UIcmdWithADoubleAndUnit("/ebl/fastsim/depth", this);
+    fDepthCmd->SetGuidance("Trigger depth below the substrate surface");
+    fDepthCmd->SetParameterName("depth", false);
+    fDepthCmd->SetRange("depth>0.");
+    fDepthCmd->SetUnitCategory("Length");
+    fDepthCmd->SetDefaultUnit("um");
+    fDepthCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fDepthCmd->SetToBeBroadcasted(false);
+
+    fTableCmd = new G4UIcmdWithAString("/ebl/fastsim/table", this);
+    fTableCmd->SetGuidance("Backscatter response table to use (read at the next run start)");
+    fTableCmd->SetParameterName("file", false);
+    fTableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fTableCmd->SetToBeBroadcasted(false);
+
+    fCalibrateCmd = new G4UIcmdWithABool("/ebl/fastsim/calibrate", this);
+    fCalibrateCmd->SetGuidance("Calibration run: primaries are generated below the surface,");
+    fCalibrateCmd->SetGuidance("one response cell per event, tracked with the full physics and");
+    fCalibrateCmd->SetGuidance("recorded when they come back up. The table is written at the end");
+    fCalibrateCmd->SetGuidance("of the run instead of the PSF.");
+    fCalibrateCmd->SetParameterName("calibrate", true);
+    fCalibrateCmd->SetDefaultValue(true);
+    fCalibrateCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fCalibrateCmd->SetToBeBroadcasted(false);
+
+    fOutputCmd = new G4UIcmdWithAString("/ebl/fastsim/output", this);
+    fOutputCmd->SetGuidance("File the calibration run writes the table to");
+    fOutputCmd->SetParameterName("file", false);
+    fOutputCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fOutputCmd->SetToBeBroadcasted(false);
+
+    fEnergyAxisCmd = CreateAxisCommand("/ebl/fastsim/energyAxis", this, "keV");
+    fEnergyAxisCmd->SetGuidance("Calibration entry energy bins (logarithmic)");
+    fEnergyAxisCmd->SetGuidance("  e.g. /ebl/fastsim/energyAxis 20 1 100 keV");
+
+    fDepthAxisCmd = CreateAxisCommand("/ebl/fastsim/depthAxis", this, "um");
+    fDepthAxisCmd->SetGuidance("Calibration entry depth bins below the substrate surface");
+    fDepthAxisCmd->SetGuidance("  e.g. /ebl/fastsim/depthAxis 12 2 50 um");
+
+    fCosThetaBinsCmd = new G4UIcmdWithAnInteger("/ebl/fastsim/cosThetaBins", this);
+    fCosThetaBinsCmd->SetGuidance("Calibration entry direction bins in cos(theta) (0, 1]");
+    fCosThetaBinsCmd->SetParameterName("n", false);
+    fCosThetaBinsCmd->SetRange("n>=1");
+    fCosThetaBinsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fCosThetaBinsCmd->SetToBeBroadcasted(false);
+
+    fSamplesCmd = new G4UIcmdWithAnInteger("/ebl/fastsim/samplesPerCell", this);
+    fSamplesCmd->SetGuidance("Return samples kept per calibration cell");
+    fSamplesCmd->SetParameterName("n", false);
+    fSamplesCmd->SetRange("n>=1");
+    fSamplesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fSamplesCmd->SetToBeBroadcasted(false);
+
+    fPrintCmd = new G4UIcmdWithoutParameter("/ebl/fastsim/print", this);
+    fPrintCmd->SetGuidance("Print the fast simulation settings");
+    fPrintCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fPrintCmd->SetToBeBroadcasted(false);
+}
+
+FastSimMessenger::~FastSimMessenger()
+{
+    delete fEnableCmd;
+    delete fDepthCmd;
+    delete fTableCmd;
+    delete fCalibrateCmd;
+    delete fOutputCmd;
+    delete fEnergyAxisCmd;
+    delete fDepthAxisCmd;
+    delete fCosThetaBinsCmd;
+    delete fSamplesCmd;
+    delete fPrintCmd;
+    delete fFastSimDir;
+}
+
+void FastSimMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == fEnableCmd) {
+        fFastSim->SetEnabled(fEnableCmd->GetNewBoolValue(newValue));
+    }
+    else if (command == fDepthCmd) {
+        fFastSim->SetTriggerDepth(fDepthCmd->GetNewDoubleValue(newValue));
+    }
+    else if (command == fTableCmd) {
+        fFastSim->SetTableFile(newValue);
+    }
+    else if (command == fCalibrateCmd) {
+        fFastSim->SetCalibrating(fCalibrateCmd->GetNewBoolValue(newValue));
+    }
+    else if (command == fOutputCmd) {
+        fFastSim->SetCalibrationFile(newValue);
+    }
+    else if (command == fEnergyAxisCmd || command == fDepthAxisCmd) {
+        G4Tokenizer next(newValue);
+        G4int bins = StoI(next());
+        G4double minValue = StoD(next());
+        G4double maxValue = StoD(next());
+        G4double unit = G4UIcommand::ValueOf(next());
+        if (command == fEnergyAxisCmd) {
+            fFastSim->SetEnergyAxis(bins, minValue * unit, maxValue * unit);
+        }
+        else {
+            fFastSim->SetDepthAxis(bins, minValue * unit, maxValue * unit);
+        }
+    }
+    else if (command == fCosThetaBinsCmd) {
+        fFastSim->SetCosThetaBins(fCosThetaBinsCmd->GetNewIntValue(newValue));
+    }
+    else if (command == fSamplesCmd) {
+        fFastSim->SetSamplesPerCell(fSamplesCmd->GetNewIntValue(newValue));
+    }
+    else if (command == fPrintCmd) {
+        fFastSim->Print();
+    }
+}
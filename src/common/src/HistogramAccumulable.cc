@@ -0,0 +1,73 @@
+// HistogramAccumulable.cc - Flat histogram merged through G4AccumulableManager
+#include "HistogramAccumulable.hh"
+#include "G4ios.hh"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+HistogramAccumulable::HistogramAccumulable(const G4String& name, G4int nx, G4int ny, G4int nz)
+    : G4VAccumulable(name),
+    fNx(0),
+    fNy(0),
+    fNz(0)
+{
+    SetShape(nx, ny, nz);
+}
+
+void HistogramAccumulable::SetShape(G4int nx, G4int ny, G4int nz)
+{
+    fNx = std::max(nx, 1);
+    fNy = std::max(ny, 1);
+    fNz = std::max(nz, 1);
+    const size_t size = static_cast<size_t>(fNx) * fNy * fNz;
+    fValues.assign(size, 0.0);
+    fSumSquares.assign(size, 0.0);
+    fEntries.assign(size, 0.0);
+}
+
+void HistogramAccumulable::Merge(const G4VAccumulable& other)
+{
+    const auto& otherHist = static_cast<const HistogramAccumulable&>(other);
+
+    if (otherHist.fValues.size() != fValues.size()) {
+        G4Exception("HistogramAccumulable::Merge", "HA001", FatalException,
+            ("Shape mismatch while merging histogram " + GetName()).c_str());
+        return;
+    }
+
+    for (size_t i = 0; i < fValues.size(); ++i) {
+        fValues[i] += otherHist.fValues[i];
+        fSumSquares[i] += otherHist.fSumSquares[i];
+        fEntries[i] += otherHist.fEntries[i];
+    }
+}
+
+void HistogramAccumulable::Reset()
+{
+    std::fill(fValues.begin(), fValues.end(), 0.0);
+    std::fill(fSumSquares.begin(), fSumSquares.end(), 0.0);
+    std::fill(fEntries.begin(), fEntries.end(), 0.0);
+}
+
+#if G4VERSION_NUMBER >= 1120
+void HistogramAccumulable::Print(G4PrintOptions) const
+{
+    G4cout << GetName() << ": " << fNx << " x " << fNy << " x " << fNz
+        << " bins, sum = " << GetSum() << G4endl;
+}
+#endif
+
+G4double HistogramAccumulable::GetSum() const
+{
+    return std::accumulate(fValues.begin(), fValues.end(), 0.0);
+}
+
+G4double HistogramAccumulable::GetRelativeError(G4int bin, G4double nEvents) const
+{
+    if (nEvents < 2. || fValues[bin] <= 0.) return DBL_MAX;
+
+    G4double mean = fValues[bin] / nEvents;
+    G4double variance = std::max(0., fSumSquares[bin] / nEvents - mean * mean);
+    return std::sqrt(variance / (nEvents - 1.)) / mean;
+}
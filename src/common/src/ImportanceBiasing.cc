@@ -0,0 +1,93 @@
+// ImportanceBiasing.cc - Per-region Russian roulette and splitting settings
+#include "ImportanceBiasing.hh"
+#include "BiasingMessenger.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4UnitsTable.hh"
+#include "G4ios.hh"
+
+ImportanceBiasing* ImportanceBiasing::fInstance = nullptr;
+
+ImportanceBiasing* ImportanceBiasing::Instance()
+{
+    if (!fInstance) {
+        fInstance = new ImportanceBiasing();
+    }
+    return fInstance;
+}
+
+ImportanceBiasing::ImportanceBiasing()
+    : fEnabled(false),
+    fMinimumWeight(1.0e-3),
+    fMessenger(nullptr)
+{
+    fMessenger = new BiasingMessenger(this);
+}
+
+ImportanceBiasing::~ImportanceBiasing()
+{
+    delete fMessenger;
+}
+
+RegionBiasing& ImportanceBiasing::GetOrCreate(const G4String& regionName)
+{
+    for (RegionBiasing& entry : fRegions) {
+        if (entry.regionName == regionName) return entry;
+    }
+    fRegions.emplace_back();
+    fRegions.back().regionName = regionName;
+    return fRegions.back();
+}
+
+void ImportanceBiasing::SetRoulette(const G4String& regionName,
+                                    G4double survivalProbability, G4double depth)
+{
+    if (survivalProbability <= 0. || survivalProbability > 1.) {
+        G4Exception("ImportanceBiasing::SetRoulette", "BIAS001", JustWarning,
+            "Survival probability must be in (0, 1], command ignored");
+        return;
+    }
+    RegionBiasing& entry = GetOrCreate(regionName);
+    entry.survivalProbability = survivalProbability;
+    entry.rouletteDepth = depth;
+}
+
+void ImportanceBiasing::SetSplitting(const G4String& regionName, G4int factor)
+{
+    if (factor < 1) {
+        G4Exception("ImportanceBiasing::SetSplitting", "BIAS002", JustWarning,
+            "Splitting factor must be at least 1, command ignored");
+        return;
+    }
+    GetOrCreate(regionName).splitFactor = factor;
+}
+
+void ImportanceBiasing::ResolveRegions()
+{
+    G4RegionStore* regionStore = G4RegionStore::GetInstance();
+    for (RegionBiasing& entry : fRegions) {
+        entry.region = regionStore->GetRegion(entry.regionName, false);
+        if (fEnabled && !entry.region) {
+            G4ExceptionDescription msg;
+            msg << "Region " << entry.regionName << " not found, its biasing is ignored";
+            G4Exception("ImportanceBiasing::ResolveRegions", "BIAS003", JustWarning, msg);
+        }
+    }
+}
+
+void ImportanceBiasing::Print() const
+{
+    G4cout << "\n=== Importance biasing: " << (fEnabled ? "ON" : "off") << " ===" << G4endl;
+    for (const RegionBiasing& entry : fRegions) {
+        G4cout << " " << entry.regionName << ":";
+        if (entry.survivalProbability < 1.) {
+            G4cout << " roulette p=" << entry.survivalProbability
+                << " below " << G4BestUnit(entry.rouletteDepth, "Length");
+        }
+        if (entry.splitFactor > 1) {
+            G4cout << " split x" << entry.splitFactor << " on upward entry";
+        }
+        G4cout << G4endl;
+    }
+    G4cout << " Minimum weight for splitting: " << fMinimumWeight << G4endl;
+}
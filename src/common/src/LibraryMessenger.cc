@@ -0,0 +1,78 @@
+// LibraryMessenger.cc
+#include "LibraryMessenger.hh"
+#include "ResultLibrary.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+LibraryMessenger::LibraryMessenger(ResultLibrary* library)
+    : G4UImessenger(),
+    fLibrary(library)
+{
+    // Only the master reads and writes the library, so nothing is broadcast
+    fLibraryDir = new G4UIdirectory("/ebl/library/");
+    fLibraryDir->SetGuidance("Library of finished PSF results, reused by /ebl/library/beamOn");
+
+    fDirectoryCmd = new G4UIcmdWithAString("/ebl/library/directory", this);
+    fDirectoryCmd->SetGuidance("Library directory; every finished single-energy run is filed in it.");
+    fDirectoryCmd->SetGuidance("\"none\" turns the library off (the default).");
+    fDirectoryCmd->SetParameterName("directory", false);
+    fDirectoryCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fDirectoryCmd->SetToBeBroadcasted(false);
+
+    fInterpolateCmd = new G4UIcmdWithABool("/ebl/library/interpolate", this);
+    fInterpolateCmd->SetGuidance("Without an exact entry, interpolate between the neighbouring");
+    fInterpolateCmd->SetGuidance("beam energies or resist thicknesses instead of running");
+    fInterpolateCmd->SetParameterName("enable", true);
+    fInterpolateCmd->SetDefaultValue(true);
+    fInterpolateCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fInterpolateCmd->SetToBeBroadcasted(false);
+
+    fToleranceCmd = new G4UIcmdWithAString("/ebl/library/tolerance", this);
+    fToleranceCmd->SetGuidance("Largest difference of the neighbouring PSFs (relative L1 distance)");
+    fToleranceCmd->SetGuidance("for interpolation, as a fraction or a percentage (0.02 or 2%).");
+    fToleranceCmd->SetParameterName("tolerance", false);
+    fToleranceCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fToleranceCmd->SetToBeBroadcasted(false);
+
+    fPrintCmd = new G4UIcmdWithoutParameter("/ebl/library/print", this);
+    fPrintCmd->SetGuidance("Print the library settings and contents");
+    fPrintCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fPrintCmd->SetToBeBroadcasted(false);
+}
+
+LibraryMessenger::~LibraryMessenger()
+{
+    delete fDirectoryCmd;
+    delete fInterpolateCmd;
+    delete fToleranceCmd;
+    delete fPrintCmd;
+    delete fLibraryDir;
+}
+
+void LibraryMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == fDirectoryCmd) {
+        fLibrary->SetDirectory(newValue == "none" ? G4String() : newValue);
+    }
+    else if (command == fInterpolateCmd) {
+        fLibrary->SetInterpolation(fInterpolateCmd->GetNewBoolValue(newValue));
+    }
+    else if (command == fToleranceCmd) {
+        G4String value = newValue;
+        G4bool percent = !value.empty() && value.back() == '%';
+        if (percent) value.pop_back();
+        G4double tolerance = G4UIcommand::ConvertToDouble(value);
+        if (percent) tolerance /= 100.;
+        if (tolerance < 0.) {
+            G4Exception("LibraryMessenger::SetNewValue", "LIB002", JustWarning,
+                "Tolerance must not be negative, e.g. 0.02 or 2%");
+            return;
+        }
+        fLibrary->SetTolerance(tolerance);
+    }
+    else if (command == fPrintCmd) {
+        fLibrary->Print();
+    }
+}
@@ -0,0 +1,31 @@
+// MasterSeed.cc - Reproducible seeding of the master random engine
+#include "MasterSeed.hh"
+#include "Randomize.hh"
+
+namespace {
+    // SplitMix64 - expands one user seed into well-separated engine seeds
+    std::uint64_t SplitMix64(std::uint64_t& state)
+    {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+}
+
+namespace MasterSeed {
+
+void Apply(std::uint64_t userSeed, G4int rank)
+{
+    std::uint64_t state = userSeed;
+    for (G4int i = 0; i < 2 * rank; i++) {
+        SplitMix64(state);
+    }
+    long seeds[3];
+    seeds[0] = static_cast<long>(SplitMix64(state) & 0x7FFFFFFFULL);
+    seeds[1] = static_cast<long>(SplitMix64(state) & 0x7FFFFFFFULL);
+    seeds[2] = 0;
+    CLHEP::HepRandom::setTheSeeds(seeds);
+}
+
+}
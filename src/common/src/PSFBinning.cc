@@ -0,0 +1,106 @@
+// PSFBinning.cc - Shared radial binning for PSF scoring and output
+#include "PSFBinning.hh"
+#include "EBLConstants.hh"
+#include "G4PhysicalConstants.hh"
+#include <algorithm>
+#include <cmath>
+
+PSFBinning::PSFBinning()
+    : PSFBinning(EBL::PSF::USE_LOG_BINNING ? Mode::Log : Mode::Linear,
+        EBL::PSF::NUM_RADIAL_BINS, EBL::PSF::MIN_RADIUS, EBL::PSF::MAX_RADIUS)
+{
+}
+
+PSFBinning::PSFBinning(Mode mode, G4int nBins, G4double minRadius, G4double maxRadius)
+    : fMode(mode),
+    fNumBins(nBins),
+    fMinRadius(minRadius),
+    fMaxRadius(maxRadius),
+    fLookupShift(52),
+    fLookupBase(0),
+    fFirstEdge2(0.0),
+    fMaxRadius2(maxRadius * maxRadius),
+    fInvLinearWidth(0.0)
+{
+    if (fNumBins < 1 || fMaxRadius <= 0.0 ||
+        (fMode == Mode::Log && (fMinRadius <= 0.0 || fMinRadius >= fMaxRadius))) {
+        G4Exception("PSFBinning::PSFBinning", "PSF001", FatalErrorInArgument,
+            "Invalid PSF binning: need nBins >= 1 and 0 < minRadius < maxRadius");
+    }
+
+    BuildEdges();
+    if (fMode == Mode::Log) {
+        BuildLookupTable();
+    }
+}
+
+void PSFBinning::BuildEdges()
+{
+    fEdges.resize(fNumBins + 1);
+    fCenters.resize(fNumBins);
+    fAreas.resize(fNumBins);
+
+    if (fMode == Mode::Linear) {
+        const G4double binWidth = fMaxRadius / fNumBins;
+        fInvLinearWidth = 1.0 / binWidth;
+        for (G4int i = 0; i <= fNumBins; ++i) {
+            fEdges[i] = i * binWidth;
+        }
+        for (G4int i = 0; i < fNumBins; ++i) {
+            fCenters[i] = (i + 0.5) * binWidth;
+        }
+    }
+    else {
+        // Edge i sits at minRadius * q^i with q = (max/min)^(1/n); the first
+        // bin is extended down to r = 0 so small radii are not lost
+        const G4double logMin = std::log(fMinRadius);
+        const G4double logStep = (std::log(fMaxRadius) - logMin) / fNumBins;
+        fEdges[0] = 0.0;
+        for (G4int i = 1; i < fNumBins; ++i) {
+            fEdges[i] = std::exp(logMin + i * logStep);
+        }
+        fEdges[fNumBins] = fMaxRadius;
+        for (G4int i = 0; i < fNumBins; ++i) {
+            fCenters[i] = std::exp(logMin + (i + 0.5) * logStep);
+        }
+    }
+
+    fEdges2.resize(fNumBins + 2);
+    for (G4int i = 0; i <= fNumBins; ++i) {
+        fEdges2[i] = fEdges[i] * fEdges[i];
+    }
+    // Sentinel so the lookup loop never walks past the last bin
+    fEdges2[fNumBins + 1] = fEdges2[fNumBins];
+
+    for (G4int i = 0; i < fNumBins; ++i) {
+        fAreas[i] = CLHEP::pi * (fEdges2[i + 1] - fEdges2[i]);
+    }
+}
+
+void PSFBinning::BuildLookupTable()
+{
+    // Bins per octave of r^2; pick enough mantissa bits that one lookup
+    // cell is at most a quarter of a bin wide
+    const G4double octaves = 2.0 * std::log2(fMaxRadius / fMinRadius);
+    const G4double binsPerOctave = fNumBins / octaves;
+    G4int mantissaBits = static_cast<G4int>(std::ceil(std::log2(binsPerOctave))) + 2;
+    mantissaBits = std::max(0, std::min(mantissaBits, 20));
+    fLookupShift = 52 - mantissaBits;
+
+    fFirstEdge2 = (fNumBins > 1) ? fEdges2[1] : fMaxRadius2;
+    fLookupBase = Bits(fFirstEdge2) >> fLookupShift;
+    const std::uint64_t lastKey = Bits(fMaxRadius2) >> fLookupShift;
+
+    fLookup.resize(static_cast<size_t>(lastKey - fLookupBase + 1));
+    for (std::uint64_t key = fLookupBase; key <= lastKey; ++key) {
+        // Smallest r^2 that maps to this cell
+        const std::uint64_t cellBits = key << fLookupShift;
+        G4double cellStart;
+        std::memcpy(&cellStart, &cellBits, sizeof(cellStart));
+
+        // Last bin whose lower edge is <= cellStart
+        auto it = std::upper_bound(fEdges2.begin(), fEdges2.begin() + fNumBins, cellStart);
+        G4int bin = static_cast<G4int>(it - fEdges2.begin()) - 1;
+        fLookup[key - fLookupBase] = std::max(bin, 0);
+    }
+}
@@ -0,0 +1,234 @@
+// PSFExport.cc - Text exports derived from a PSF result
+#include "PSFExport.hh"
+#include "PSFResultFile.hh"
+#include "G4UnitsTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+namespace {
+    // Energy density per bin of one point, normalized to peak = 1 (BEAMER
+    // standard)
+    std::vector<G4double> NormalizedPSF(const PSFResultFile& result, G4int point)
+    {
+        const PSFBinning& binning = result.GetBinning();
+        const G4int numBins = binning.GetNumberOfBins();
+        const G4long pointEvents = result.GetEvents(point);
+        std::vector<G4double> normalizedPSF(numBins, 0.0);
+        G4double maxValue = 0.0;
+
+        // Find maximum value for normalization
+        for (G4int i = 0; i < numBins; i++) {
+            G4double area = binning.GetArea(i);
+
+            if (pointEvents > 0 && area > 0) {
+                normalizedPSF[i] = result.GetSum(point, i) / (area * pointEvents);
+                if (normalizedPSF[i] > maxValue) {
+                    maxValue = normalizedPSF[i];
+                }
+            }
+        }
+
+        if (maxValue > 0) {
+            for (G4int i = 0; i < numBins; i++) {
+                normalizedPSF[i] /= maxValue;
+            }
+        }
+        return normalizedPSF;
+    }
+}
+
+namespace PSFExport {
+
+G4bool WriteCSV(const PSFResultFile& result, const G4String& path, G4bool sweepColumns)
+{
+    G4cout << "Saving PSF data to: " << path << G4endl;
+
+    std::ofstream psfFile(path);
+    if (!psfFile.is_open()) {
+        G4cerr << "Error: Could not open output file: " << path << G4endl;
+        return false;
+    }
+    FormatCSV(result, psfFile, sweepColumns);
+    psfFile.close();
+
+    G4cout << "PSF data saved successfully" << G4endl;
+    PrintCSVStatistics(result);
+    return true;
+}
+
+void FormatCSV(const PSFResultFile& result, std::ostream& psfFile, G4bool sweepColumns)
+{
+    // Write header
+    if (sweepColumns) {
+        psfFile << "Point,BeamEnergy(keV),";
+    }
+    psfFile << "Radius(nm),EnergyDeposition(eV/nm^2),BinLower(nm),BinUpper(nm),Events" << '\n';
+
+    const PSFBinning& binning = result.GetBinning();
+    const G4int numBins = binning.GetNumberOfBins();
+    const G4int numPoints = result.GetNumberOfPoints();
+    for (G4int point = 0; point < numPoints; point++) {
+        G4long pointEvents = result.GetEvents(point);
+        G4double beamEnergy = result.GetBeamEnergy(point);
+
+        for (G4int i = 0; i < numBins; i++) {
+            G4double rCenter = binning.GetCenter(i);
+            G4double rInner = binning.GetLowerEdge(i);
+            G4double rOuter = binning.GetUpperEdge(i);
+            G4double binEnergy = result.GetSum(point, i);
+
+            // Annular area for this bin (cached by the binning)
+            G4double area = binning.GetArea(i);
+
+            // Calculate energy density per unit area per event
+            G4double energyDensity = (area > 0 && pointEvents > 0) ?
+                binEnergy / (area * pointEvents) : 0.0;
+
+            // Output with full precision for analysis
+            if (sweepColumns) {
+                psfFile << point << "," << std::defaultfloat << beamEnergy / keV << ",";
+            }
+            psfFile << std::fixed << std::setprecision(3) << rCenter / nanometer << ","
+                << std::scientific << std::setprecision(6) << energyDensity / (eV / (nanometer * nanometer)) << ","
+                << std::fixed << std::setprecision(3) << rInner / nanometer << ","
+                << rOuter / nanometer << ","
+                << pointEvents
+                << '\n';
+        }
+    }
+}
+
+void PrintCSVStatistics(const PSFResultFile& result)
+{
+    G4int validBins = 0;
+    G4double totalEnergy = 0.0;
+    G4double maxDensity = 0.0;
+
+    const PSFBinning& binning = result.GetBinning();
+    const G4int numBins = binning.GetNumberOfBins();
+    const G4int numPoints = result.GetNumberOfPoints();
+    for (G4int point = 0; point < numPoints; point++) {
+        G4long pointEvents = result.GetEvents(point);
+        for (G4int i = 0; i < numBins; i++) {
+            G4double binEnergy = result.GetSum(point, i);
+            G4double area = binning.GetArea(i);
+            G4double energyDensity = (area > 0 && pointEvents > 0) ?
+                binEnergy / (area * pointEvents) : 0.0;
+
+            if (energyDensity > maxDensity) {
+                maxDensity = energyDensity;
+            }
+
+            if (binEnergy > 0) {
+                validBins++;
+                totalEnergy += binEnergy;
+            }
+        }
+    }
+
+    G4cout << "Valid bins with energy: " << validBins << " / " << numBins * numPoints << G4endl;
+    G4cout << "Total energy in radial profile: " << G4BestUnit(totalEnergy, "Energy") << G4endl;
+    G4cout << "Peak energy density: " << maxDensity / (eV / (nanometer * nanometer)) << " eV/nm²" << G4endl;
+}
+
+G4bool WriteBEAMER(const PSFResultFile& result, G4int point, const G4String& path)
+{
+    G4cout << "Saving BEAMER format to: " << path << G4endl;
+
+    std::ofstream beamerFile(path);
+    if (!beamerFile.is_open()) {
+        G4cerr << "Error: Could not open BEAMER output file: " << path << G4endl;
+        return false;
+    }
+    FormatBEAMER(result, point, beamerFile);
+    beamerFile.close();
+
+    G4cout << "BEAMER format saved successfully" << G4endl;
+    PrintBEAMERParameters(result, point);
+    return true;
+}
+
+void FormatBEAMER(const PSFResultFile& result, G4int point, std::ostream& beamerFile)
+{
+    // BEAMER format: radius(um) normalized_PSF
+    const PSFBinning& binning = result.GetBinning();
+    const G4int numBins = binning.GetNumberOfBins();
+    const G4long pointEvents = result.GetEvents(point);
+    const std::vector<G4double> normalizedPSF = NormalizedPSF(result, point);
+
+    // Write in BEAMER format
+    beamerFile << "# EBL PSF for BEAMER - Geant4 Simulation (Resist-Only)" << '\n';
+    beamerFile << "# Beam energy: " << result.GetBeamEnergy(point) / keV << " keV" << '\n';
+    beamerFile << "# Resist: " << (result.GetResistThickness() > 0 ? result.GetResistThickness() / nanometer : 30.0) << " nm ";
+
+    // Try to identify resist type from composition ("Al:1,C:5,...")
+    const G4String& composition = result.GetResistComposition();
+    if (composition.rfind("Al:", 0) == 0 || composition.find(",Al:") != std::string::npos) {
+        beamerFile << "Alucone";
+    }
+    else if (composition.rfind("Si:", 0) == 0 || composition.find(",Si:") != std::string::npos) {
+        beamerFile << "HSQ";
+    }
+    else {
+        beamerFile << "Organic";
+    }
+    beamerFile << '\n';
+
+    beamerFile << "# Format: radius(um) PSF(normalized)" << '\n';
+    beamerFile << "# Total events: " << pointEvents << '\n';
+    beamerFile << "# Normalization: Peak = 1.0" << '\n';
+
+    // Include point at origin for interpolation
+    beamerFile << std::scientific << std::setprecision(6);
+
+    // Add a very small radius point to help with interpolation
+    if (normalizedPSF[0] > 0) {
+        G4double r0 = binning.GetMinRadius() / 2.0;
+        beamerFile << r0 / micrometer << " " << normalizedPSF[0] << '\n';
+    }
+
+    for (G4int i = 0; i < numBins; i++) {
+        G4double rCenter = binning.GetCenter(i);
+
+        // Only output non-zero values to keep file size reasonable
+        if (normalizedPSF[i] > 1e-12) {
+            // Convert to um for BEAMER
+            beamerFile << rCenter / micrometer << " "
+                << normalizedPSF[i] << '\n';
+        }
+    }
+}
+
+void PrintBEAMERParameters(const PSFResultFile& result, G4int point)
+{
+    const PSFBinning& binning = result.GetBinning();
+    const G4int numBins = binning.GetNumberOfBins();
+    const std::vector<G4double> normalizedPSF = NormalizedPSF(result, point);
+
+    // Calculate and report key PSF parameters
+    G4double forward_fraction = 0;
+    G4double total_integral = 0;
+
+    // Calculate forward scattering fraction (< 1 μm)
+    for (G4int i = 0; i < numBins; i++) {
+        G4double weighted = normalizedPSF[i] * binning.GetArea(i);
+        if (binning.GetCenter(i) < 1.0 * micrometer) {
+            forward_fraction += weighted;
+        }
+        total_integral += weighted;
+    }
+
+    if (total_integral > 0) {
+        G4double alpha = forward_fraction / total_integral;
+        G4double beta = 1.0 - alpha;
+
+        G4cout << "\nPSF Parameters for BEAMER:" << G4endl;
+        G4cout << "  Forward scatter fraction (α): " << alpha << G4endl;
+        G4cout << "  Backscatter fraction (β): " << beta << G4endl;
+    }
+}
+
+}
@@ -0,0 +1,308 @@
+// PSFResultFile.cc - Versioned binary PSF result with per-bin statistics
+#include "PSFResultFile.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace {
+    const char kMagic[8] = { 'E', 'B', 'L', 'P', 'S', 'F', '\0', '\0' };
+    const std::uint64_t kAlignment = 64;
+
+    const std::uint32_t kFlagWeighted = 1u << 0;
+    const std::uint32_t kFlagMerged = 1u << 1;
+
+    // On-disk header. Every field sits at its natural alignment, so the
+    // struct has no padding and matches the numpy dtype of the reader
+    // (scripts/gui/psf_result.py) byte for byte.
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t headerSize;
+        std::uint32_t binningMode;      // 0 linear, 1 log
+        std::uint32_t numBins;
+        std::uint32_t numPoints;
+        std::uint32_t flags;
+        std::int64_t totalEvents;
+        std::int64_t seed;
+        double minRadius;               // nm
+        double maxRadius;               // nm
+        double resistThickness;         // nm
+        double resistDensity;           // g/cm3
+        char composition[64];           // "Al:1,C:5,...", NUL terminated
+        std::uint64_t edgesOffset;
+        std::uint64_t energiesOffset;
+        std::uint64_t eventsOffset;
+        std::uint64_t sumOffset;
+        std::uint64_t sumSquaresOffset;
+        std::uint64_t hitsOffset;
+    };
+    static_assert(sizeof(Header) == 192, "PSF result header layout changed");
+
+    std::uint64_t Align(std::uint64_t offset)
+    {
+        return (offset + kAlignment - 1) / kAlignment * kAlignment;
+    }
+
+    // Zero padding up to the aligned offset rather than a seek, so the
+    // stream need not be seekable
+    template <typename T>
+    void WriteArray(std::ostream& out, std::uint64_t& position, std::uint64_t offset,
+                    const std::vector<T>& values)
+    {
+        static const char kZeros[kAlignment] = {};
+        out.write(kZeros, static_cast<std::streamsize>(offset - position));
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+        position = offset + values.size() * sizeof(T);
+    }
+
+    template <typename T>
+    G4bool ReadArray(std::ifstream& in, std::uint64_t offset, std::vector<T>& values)
+    {
+        in.seekg(static_cast<std::streamoff>(offset));
+        in.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(T));
+        return static_cast<G4bool>(in);
+    }
+}
+
+PSFResultFile::PSFResultFile()
+    : fSeed(-1),
+    fWeighted(false),
+    fMerged(false),
+    fResistThickness(0.),
+    fResistDensity(0.)
+{
+}
+
+void PSFResultFile::SetLayout(const PSFBinning& binning, const std::vector<G4double>& beamEnergies)
+{
+    fBinning = binning;
+    fBeamEnergies = beamEnergies;
+
+    size_t nPoints = beamEnergies.size();
+    size_t size = nPoints * binning.GetNumberOfBins();
+    fEvents.assign(nPoints, 0);
+    fSum.assign(size, 0.);
+    fSumSquares.assign(size, 0.);
+    fHits.assign(size, 0);
+    fMerged = false;
+}
+
+void PSFResultFile::SetResist(G4double thickness, G4double density, const G4String& composition)
+{
+    fResistThickness = thickness;
+    fResistDensity = density;
+    fResistComposition = composition;
+}
+
+void PSFResultFile::SetTallies(const std::vector<G4double>& sum,
+                               const std::vector<G4double>& sumSquares,
+                               const std::vector<G4double>& hits)
+{
+    if (sum.size() != fSum.size() || sumSquares.size() != fSum.size() || hits.size() != fSum.size()) {
+        G4Exception("PSFResultFile::SetTallies", "PSFR001", FatalException,
+            "Tallies do not match the result layout");
+        return;
+    }
+
+    fSum = sum;
+    fSumSquares = sumSquares;
+    // Entries are counted in doubles by the histogram but are whole numbers
+    std::transform(hits.begin(), hits.end(), fHits.begin(),
+        [](G4double n) { return static_cast<G4long>(n + 0.5); });
+}
+
+G4long PSFResultFile::GetTotalEvents() const
+{
+    G4long total = 0;
+    for (G4long events : fEvents) total += events;
+    return total;
+}
+
+G4double PSFResultFile::GetRelativeError(G4int point, G4int bin) const
+{
+    const G4double nEvents = static_cast<G4double>(fEvents[point]);
+    const G4double sum = fSum[Index(point, bin)];
+    if (nEvents < 2. || sum <= 0.) return DBL_MAX;
+
+    G4double mean = sum / nEvents;
+    G4double variance = std::max(0., fSumSquares[Index(point, bin)] / nEvents - mean * mean);
+    return std::sqrt(variance / (nEvents - 1.)) / mean;
+}
+
+G4bool PSFResultFile::IsCompatible(const PSFBinning& binning,
+                                   const std::vector<G4double>& beamEnergies) const
+{
+    auto close = [](G4double a, G4double b) {
+        return std::abs(a - b) <= 1e-9 * std::max(std::abs(a), std::abs(b));
+    };
+
+    if (binning.GetMode() != fBinning.GetMode() ||
+        binning.GetNumberOfBins() != fBinning.GetNumberOfBins() ||
+        !close(binning.GetMinRadius(), fBinning.GetMinRadius()) ||
+        !close(binning.GetMaxRadius(), fBinning.GetMaxRadius()) ||
+        beamEnergies.size() != fBeamEnergies.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < beamEnergies.size(); ++i) {
+        if (!close(beamEnergies[i], fBeamEnergies[i])) return false;
+    }
+    return true;
+}
+
+G4bool PSFResultFile::Merge(const PSFResultFile& other)
+{
+    if (!IsCompatible(other.fBinning, other.fBeamEnergies)) {
+        G4Exception("PSFResultFile::Merge", "PSFR002", JustWarning,
+            "Cannot merge PSF results with different binning or beam energies");
+        return false;
+    }
+    if (other.fWeighted != fWeighted) {
+        G4Exception("PSFResultFile::Merge", "PSFR002", JustWarning,
+            "Cannot merge weighted (biased) and unweighted PSF results");
+        return false;
+    }
+
+    for (size_t i = 0; i < fEvents.size(); ++i) {
+        fEvents[i] += other.fEvents[i];
+    }
+    for (size_t i = 0; i < fSum.size(); ++i) {
+        fSum[i] += other.fSum[i];
+        fSumSquares[i] += other.fSumSquares[i];
+        fHits[i] += other.fHits[i];
+    }
+
+    // The seed of the first run is kept; the flag marks it as not
+    // reproducing the merged tallies on its own
+    fMerged = true;
+    return true;
+}
+
+G4bool PSFResultFile::Write(const G4String& fileName) const
+{
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out || !Write(out)) {
+        G4ExceptionDescription msg;
+        msg << "Cannot write PSF result to " << fileName;
+        G4Exception("PSFResultFile::Write", "PSFR003", JustWarning, msg);
+        return false;
+    }
+    return true;
+}
+
+G4bool PSFResultFile::Write(std::ostream& out) const
+{
+    const G4int nBins = fBinning.GetNumberOfBins();
+    const G4int nPoints = GetNumberOfPoints();
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.headerSize = sizeof(Header);
+    header.binningMode = fBinning.IsLog() ? 1 : 0;
+    header.numBins = nBins;
+    header.numPoints = nPoints;
+    header.flags = (fWeighted ? kFlagWeighted : 0u) | (fMerged ? kFlagMerged : 0u);
+    header.totalEvents = GetTotalEvents();
+    header.seed = fSeed;
+    header.minRadius = fBinning.GetMinRadius() / nm;
+    header.maxRadius = fBinning.GetMaxRadius() / nm;
+    header.resistThickness = fResistThickness / nm;
+    header.resistDensity = fResistDensity / (g / cm3);
+    std::strncpy(header.composition, fResistComposition.c_str(), sizeof(header.composition) - 1);
+
+    header.edgesOffset = Align(sizeof(Header));
+    header.energiesOffset = Align(header.edgesOffset + (nBins + 1) * sizeof(double));
+    header.eventsOffset = Align(header.energiesOffset + nPoints * sizeof(double));
+    header.sumOffset = Align(header.eventsOffset + nPoints * sizeof(std::int64_t));
+    header.sumSquaresOffset = Align(header.sumOffset + fSum.size() * sizeof(double));
+    header.hitsOffset = Align(header.sumSquaresOffset + fSum.size() * sizeof(double));
+
+    // File units: nm, keV, eV
+    std::vector<double> edges(fBinning.GetEdges());
+    for (double& edge : edges) edge /= nm;
+    std::vector<double> energies(fBeamEnergies);
+    for (double& energy : energies) energy /= keV;
+    std::vector<double> sum(fSum);
+    for (double& value : sum) value /= eV;
+    std::vector<double> sumSquares(fSumSquares);
+    for (double& value : sumSquares) value /= (eV * eV);
+    std::vector<std::int64_t> events(fEvents.begin(), fEvents.end());
+    std::vector<std::int64_t> hits(fHits.begin(), fHits.end());
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    std::uint64_t position = sizeof(header);
+    WriteArray(out, position, header.edgesOffset, edges);
+    WriteArray(out, position, header.energiesOffset, energies);
+    WriteArray(out, position, header.eventsOffset, events);
+    WriteArray(out, position, header.sumOffset, sum);
+    WriteArray(out, position, header.sumSquaresOffset, sumSquares);
+    WriteArray(out, position, header.hitsOffset, hits);
+
+    return static_cast<G4bool>(out);
+}
+
+G4bool PSFResultFile::Read(const G4String& fileName)
+{
+    std::ifstream in(fileName, std::ios::binary);
+    Header header;
+    if (!in || !in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        G4ExceptionDescription msg;
+        msg << fileName << " is not a PSF result file";
+        G4Exception("PSFResultFile::Read", "PSFR004", JustWarning, msg);
+        return false;
+    }
+    if (header.version != static_cast<std::uint32_t>(kVersion) || header.headerSize != sizeof(Header)) {
+        G4ExceptionDescription msg;
+        msg << fileName << " has PSF result format version " << header.version
+            << ", this build reads version " << kVersion;
+        G4Exception("PSFResultFile::Read", "PSFR004", JustWarning, msg);
+        return false;
+    }
+
+    PSFBinning binning(header.binningMode == 1 ? PSFBinning::Mode::Log : PSFBinning::Mode::Linear,
+                       static_cast<G4int>(header.numBins),
+                       header.minRadius * nm, header.maxRadius * nm);
+
+    std::vector<double> energies(header.numPoints);
+    std::vector<std::int64_t> events(header.numPoints);
+    const size_t size = static_cast<size_t>(header.numPoints) * header.numBins;
+    std::vector<double> sum(size), sumSquares(size);
+    std::vector<std::int64_t> hits(size);
+
+    G4bool ok = ReadArray(in, header.energiesOffset, energies) &&
+                ReadArray(in, header.eventsOffset, events) &&
+                ReadArray(in, header.sumOffset, sum) &&
+                ReadArray(in, header.sumSquaresOffset, sumSquares) &&
+                ReadArray(in, header.hitsOffset, hits);
+    if (!ok) {
+        G4ExceptionDescription msg;
+        msg << "PSF result file " << fileName << " is truncated";
+        G4Exception("PSFResultFile::Read", "PSFR005", JustWarning, msg);
+        return false;
+    }
+
+    for (double& energy : energies) energy *= keV;
+    SetLayout(binning, energies);
+    std::copy(events.begin(), events.end(), fEvents.begin());
+    for (size_t i = 0; i < size; ++i) {
+        fSum[i] = sum[i] * eV;
+        fSumSquares[i] = sumSquares[i] * (eV * eV);
+        fHits[i] = hits[i];
+    }
+
+    header.composition[sizeof(header.composition) - 1] = '\0';
+    fSeed = header.seed;
+    fWeighted = (header.flags & kFlagWeighted) != 0;
+    fMerged = (header.flags & kFlagMerged) != 0;
+    fResistThickness = header.resistThickness * nm;
+    fResistDensity = header.resistDensity * (g / cm3);
+    fResistComposition = header.composition;
+    return true;
+}
@@ -0,0 +1,61 @@
+// ParameterSweep.cc - Beam energy sweep within a single run
+#include "ParameterSweep.hh"
+#include "SweepMessenger.hh"
+#include "G4UnitsTable.hh"
+#include "G4ios.hh"
+#include <algorithm>
+
+ParameterSweep* ParameterSweep::fInstance = nullptr;
+G4ThreadLocal G4int ParameterSweep::fCurrentPoint = 0;
+
+ParameterSweep* ParameterSweep::Instance()
+{
+    if (!fInstance) {
+        fInstance = new ParameterSweep();
+    }
+    return fInstance;
+}
+
+ParameterSweep::ParameterSweep()
+    : fMessenger(nullptr)
+{
+    fMessenger = new SweepMessenger(this);
+}
+
+ParameterSweep::~ParameterSweep()
+{
+    delete fMessenger;
+}
+
+void ParameterSweep::SetEnergies(const std::vector<G4double>& energies)
+{
+    // Points name their output files, so every energy may appear only once
+    fEnergies.clear();
+    for (G4double energy : energies) {
+        if (energy <= 0.) {
+            G4Exception("ParameterSweep::SetEnergies", "SWEEP001", JustWarning,
+                "Non-positive sweep energy ignored");
+            continue;
+        }
+        if (std::find(fEnergies.begin(), fEnergies.end(), energy) != fEnergies.end()) {
+            G4ExceptionDescription msg;
+            msg << "Duplicate sweep energy " << G4BestUnit(energy, "Energy") << " ignored";
+            G4Exception("ParameterSweep::SetEnergies", "SWEEP002", JustWarning, msg);
+            continue;
+        }
+        fEnergies.push_back(energy);
+    }
+}
+
+void ParameterSweep::Print() const
+{
+    if (!IsActive()) {
+        G4cout << "Parameter sweep: off" << G4endl;
+        return;
+    }
+    G4cout << "Parameter sweep: " << fEnergies.size() << " beam energies:";
+    for (G4double energy : fEnergies) {
+        G4cout << " " << G4BestUnit(energy, "Energy");
+    }
+    G4cout << G4endl;
+}
@@ -0,0 +1,111 @@
+// PerfMessenger.cc
+#include "PerfMessenger.hh"
+#include "PerfMonitor.hh"
+#include "TraceRecorder.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4SystemOfUnits.hh"
+
+PerfMessenger::PerfMessenger(PerfMonitor* monitor)
+    : G4UImessenger(),
+    fMonitor(monitor)
+{
+    // The monitor is process-wide and lives on the master, so none of
+    // these commands are broadcast to worker threads
+    fPerfDir = new G4UIdirectory("/ebl/perf/");
+    fPerfDir->SetGuidance("Performance counters and progress reporting");
+
+    fEnableCmd = new G4UIcmdWithABool("/ebl/perf/enable", this);
+    fEnableCmd->SetGuidance("Enable the periodic progress/rate reporter during runs");
+    fEnableCmd->SetGuidance("Counters are always collected; this only controls the reporter thread");
+    fEnableCmd->SetParameterName("enable", true);
+    fEnableCmd->SetDefaultValue(true);
+    fEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fEnableCmd->SetToBeBroadcasted(false);
+
+    fIntervalCmd = new G4UIcmdWithADoubleAndUnit("/ebl/perf/interval", this);
+    fIntervalCmd->SetGuidance("Set the reporter sampling interval");
+    fIntervalCmd->SetParameterName("interval", false);
+    fIntervalCmd->SetUnitCategory("Time");
+    fIntervalCmd->SetDefaultUnit("s");
+    fIntervalCmd->SetRange("interval>0.");
+    fIntervalCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fIntervalCmd->SetToBeBroadcasted(false);
+
+    fDumpCmd = new G4UIcmdWithoutParameter("/ebl/perf/dump", this);
+    fDumpCmd->SetGuidance("Print per-thread and total counters, including kills per stacking rule");
+    fDumpCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fDumpCmd->SetToBeBroadcasted(false);
+
+    fPrintCmd = new G4UIcmdWithABool("/ebl/perf/print", this);
+    fPrintCmd->SetGuidance("Print the progress/rate lines of the reporter to stdout");
+    fPrintCmd->SetGuidance("Turn off when a reader polls /ebl/perf/statusFile instead");
+    fPrintCmd->SetParameterName("print", true);
+    fPrintCmd->SetDefaultValue(true);
+    fPrintCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fPrintCmd->SetToBeBroadcasted(false);
+
+    fStatusFileCmd = new G4UIcmdWithAString("/ebl/perf/statusFile", this);
+    fStatusFileCmd->SetGuidance("JSON status record rewritten atomically at every reporter sample");
+    fStatusFileCmd->SetGuidance("and at the end of each run; no argument disables it");
+    fStatusFileCmd->SetParameterName("file", true);
+    fStatusFileCmd->SetDefaultValue("");
+    fStatusFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fStatusFileCmd->SetToBeBroadcasted(false);
+
+    fStatusPSFCmd = new G4UIcmdWithABool("/ebl/perf/statusPSF", this);
+    fStatusPSFCmd->SetGuidance("Include the PSF of the last completed run or batch in the status record");
+    fStatusPSFCmd->SetParameterName("enable", true);
+    fStatusPSFCmd->SetDefaultValue(true);
+    fStatusPSFCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fStatusPSFCmd->SetToBeBroadcasted(false);
+
+    fTraceCmd = new G4UIcmdWithABool("/ebl/perf/trace", this);
+    fTraceCmd->SetGuidance("Time the initialization, physics tables, event loop of every thread,");
+    fTraceCmd->SetGuidance("merge and output; the phase table is added to the run summary and");
+    fTraceCmd->SetGuidance("simulation_trace.json (chrome://tracing, Perfetto) written next to it");
+    fTraceCmd->SetParameterName("enable", true);
+    fTraceCmd->SetDefaultValue(true);
+    fTraceCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fTraceCmd->SetToBeBroadcasted(false);
+}
+
+PerfMessenger::~PerfMessenger()
+{
+    delete fEnableCmd;
+    delete fIntervalCmd;
+    delete fDumpCmd;
+    delete fPrintCmd;
+    delete fStatusFileCmd;
+    delete fStatusPSFCmd;
+    delete fTraceCmd;
+    delete fPerfDir;
+}
+
+void PerfMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == fEnableCmd) {
+        fMonitor->SetEnabled(fEnableCmd->GetNewBoolValue(newValue));
+    }
+    else if (command == fIntervalCmd) {
+        fMonitor->SetInterval(fIntervalCmd->GetNewDoubleValue(newValue) / s);
+    }
+    else if (command == fDumpCmd) {
+        fMonitor->Dump();
+    }
+    else if (command == fPrintCmd) {
+        fMonitor->SetPrintProgress(fPrintCmd->GetNewBoolValue(newValue));
+    }
+    else if (command == fStatusFileCmd) {
+        fMonitor->SetStatusFile(newValue);
+    }
+    else if (command == fStatusPSFCmd) {
+        fMonitor->SetStatusPSF(fStatusPSFCmd->GetNewBoolValue(newValue));
+    }
+    else if (command == fTraceCmd) {
+        TraceRecorder::Instance()->SetEnabled(fTraceCmd->GetNewBoolValue(newValue));
+    }
+}
@@ -0,0 +1,396 @@
+// PerfMonitor.cc - Per-thread hot-path counters with a sampling reporter thread
+#include "PerfMonitor.hh"
+#include "PerfMessenger.hh"
+#include "PSFResultFile.hh"
+#include "G4Threading.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+PerfMonitor* PerfMonitor::fInstance = nullptr;
+
+const char* PerfThreadCounters::CounterName(Counter c)
+{
+    switch (c) {
+    case kEvents:             return "events";
+    case kSteps:              return "steps";
+    case kResistSteps:        return "resist steps";
+    case kResistDeposits:     return "resist deposits";
+    case kTracksPushed:       return "tracks pushed";
+    case kSplitTracks:        return "split copies";
+    case kFastSimReplaced:    return "fast-simulated";
+    case kTracksDeferred:     return "deferred to waiting";
+    case kStagesDrained:      return "waiting stages drained";
+    case kStagesDropped:      return "waiting stages dropped";
+    case kStageEnergyDrained: return "waiting energy drained (eV)";
+    case kStageEnergyDropped: return "waiting energy dropped (eV)";
+    case kStageResistEnergy:  return "resist energy of drained stages (eV)";
+    case kKillOutOfRange:     return "killed: out of range";
+    case kKillEscaping:       return "killed: escaping";
+    case kKillLowEnergyPhoton:return "killed: low-energy gamma";
+    case kKillRoulette:       return "killed: roulette";
+    case kKillWaitingStack:   return "killed: waiting stack dropped";
+    default:                  return "unknown";
+    }
+}
+
+const char* PerfThreadCounters::CounterKey(Counter c)
+{
+    switch (c) {
+    case kEvents:             return "events";
+    case kSteps:              return "steps";
+    case kResistSteps:        return "resist_steps";
+    case kResistDeposits:     return "resist_deposits";
+    case kTracksPushed:       return "tracks_pushed";
+    case kSplitTracks:        return "split_tracks";
+    case kFastSimReplaced:    return "fastsim_replaced";
+    case kTracksDeferred:     return "tracks_deferred";
+    case kStagesDrained:      return "stages_drained";
+    case kStagesDropped:      return "stages_dropped";
+    case kStageEnergyDrained: return "stage_energy_drained_eV";
+    case kStageEnergyDropped: return "stage_energy_dropped_eV";
+    case kStageResistEnergy:  return "stage_resist_energy_eV";
+    case kKillOutOfRange:     return "kill_out_of_range";
+    case kKillEscaping:       return "kill_escaping";
+    case kKillLowEnergyPhoton:return "kill_low_energy_gamma";
+    case kKillRoulette:       return "kill_roulette";
+    case kKillWaitingStack:   return "kill_waiting_stack";
+    default:                  return "unknown";
+    }
+}
+
+PerfMonitor* PerfMonitor::Instance()
+{
+    if (!fInstance) {
+        fInstance = new PerfMonitor();
+    }
+    return fInstance;
+}
+
+PerfMonitor::PerfMonitor()
+    : fStopReporter(false),
+    fEnabled(true),
+    fPrintProgress(true),
+    fInterval(10.0),
+    fEventsToProcess(0),
+    fRunStart{},
+    fStatusPSF(true),
+    fLoopEventsDone(0),
+    fLoopEventsTarget(0),
+    fElapsed(0.),
+    fEventRate(0.),
+    fMessenger(nullptr)
+{
+    fMessenger = new PerfMessenger(this);
+}
+
+PerfMonitor::~PerfMonitor()
+{
+    StopReporter();
+    delete fMessenger;
+}
+
+PerfThreadCounters* PerfMonitor::GetThreadCounters()
+{
+    // Cached per thread, so the registry lock is taken once per thread
+    static G4ThreadLocal PerfThreadCounters* counters = nullptr;
+    if (!counters) {
+        std::lock_guard<std::mutex> lock(fRegistryMutex);
+        fThreadCounters.push_back(
+            std::make_unique<PerfThreadCounters>(G4Threading::G4GetThreadId()));
+        counters = fThreadCounters.back().get();
+    }
+    return counters;
+}
+
+void PerfMonitor::SetInterval(G4double seconds)
+{
+    if (seconds <= 0.) {
+        G4cerr << "PerfMonitor: interval must be positive, keeping "
+            << fInterval << " s" << G4endl;
+        return;
+    }
+    fInterval = seconds;
+}
+
+PerfMonitor::Snapshot PerfMonitor::TakeSnapshot() const
+{
+    Snapshot totals{};
+    std::lock_guard<std::mutex> lock(fRegistryMutex);
+    for (const auto& counters : fThreadCounters) {
+        for (G4int c = 0; c < PerfThreadCounters::kNumCounters; ++c) {
+            totals[c] += counters->Get(static_cast<PerfThreadCounters::Counter>(c));
+        }
+    }
+    return totals;
+}
+
+G4long PerfMonitor::GetTotal(PerfThreadCounters::Counter c) const
+{
+    return TakeSnapshot()[c];
+}
+
+void PerfMonitor::BeginRun(G4int nEventsToProcess)
+{
+    StopReporter();
+
+    fEventsToProcess = nEventsToProcess;
+    fRunStart = TakeSnapshot();
+    fRunStartTime = std::chrono::steady_clock::now();
+    fElapsed = 0.;
+    fEventRate = 0.;
+
+    if (!fStatusFile.empty()) {
+        WriteStatus(fRunStart, "running");
+    }
+
+    if (!fEnabled) return;
+
+    fStopReporter = false;
+    fReporter = std::thread(&PerfMonitor::ReporterLoop, this);
+}
+
+void PerfMonitor::EndRun()
+{
+    G4bool wasRunning = fReporter.joinable();
+    StopReporter();
+
+    if (!fStatusFile.empty()) {
+        fElapsed = std::chrono::duration<G4double>(
+            std::chrono::steady_clock::now() - fRunStartTime).count();
+        WriteStatus(TakeSnapshot(), "idle");
+    }
+
+    if (wasRunning) {
+        Snapshot now = TakeSnapshot();
+        Snapshot run{};
+        for (G4int c = 0; c < PerfThreadCounters::kNumCounters; ++c) {
+            run[c] = now[c] - fRunStart[c];
+        }
+        G4long killed = 0;
+        for (G4int c = PerfThreadCounters::kFirstKillCounter; c < PerfThreadCounters::kNumCounters; ++c) {
+            killed += run[c];
+        }
+        printf("Perf: run totals - %ld events, %ld tracks (killed %ld), %ld resist deposits in %ld steps\n",
+               run[PerfThreadCounters::kEvents], run[PerfThreadCounters::kTracksPushed], killed,
+               run[PerfThreadCounters::kResistDeposits], run[PerfThreadCounters::kResistSteps]);
+
+        // Dropped waiting stacks: bias estimate from the resist energy per
+        // unit of energy of the stages that were tracked
+        G4long dropped = run[PerfThreadCounters::kStagesDropped];
+        if (dropped + run[PerfThreadCounters::kStagesDrained] > 0) {
+            G4long drainedEnergy = run[PerfThreadCounters::kStageEnergyDrained];
+            G4double yield = drainedEnergy > 0
+                ? static_cast<G4double>(run[PerfThreadCounters::kStageResistEnergy]) / drainedEnergy : 0.;
+            printf("Perf: waiting stack - %ld stages drained, %ld dropped (%ld tracks, %.4g keV); "
+                   "estimated resist energy lost %.4g keV\n",
+                   run[PerfThreadCounters::kStagesDrained], dropped,
+                   run[PerfThreadCounters::kKillWaitingStack],
+                   1e-3 * run[PerfThreadCounters::kStageEnergyDropped],
+                   1e-3 * yield * run[PerfThreadCounters::kStageEnergyDropped]);
+        }
+        fflush(stdout);
+    }
+}
+
+void PerfMonitor::StopReporter()
+{
+    if (!fReporter.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(fReporterMutex);
+        fStopReporter = true;
+    }
+    fReporterWake.notify_all();
+    fReporter.join();
+}
+
+void PerfMonitor::ReporterLoop()
+{
+    using Clock = std::chrono::steady_clock;
+    auto last = fRunStartTime;
+    Snapshot previous = fRunStart;
+
+    std::unique_lock<std::mutex> lock(fReporterMutex);
+    const auto interval = std::chrono::duration<G4double>(fInterval);
+    while (!fReporterWake.wait_for(lock, interval, [this] { return fStopReporter; })) {
+        const auto now = Clock::now();
+        Snapshot current = TakeSnapshot();
+        G4double elapsed = std::chrono::duration<G4double>(now - fRunStartTime).count();
+        G4double sinceLast = std::chrono::duration<G4double>(now - last).count();
+        if (fPrintProgress) {
+            PrintSample(current, previous, elapsed, sinceLast);
+        }
+        if (!fStatusFile.empty()) {
+            fElapsed = elapsed;
+            fEventRate = (sinceLast > 0.)
+                ? (current[PerfThreadCounters::kEvents] - previous[PerfThreadCounters::kEvents]) / sinceLast
+                : 0.;
+            WriteStatus(current, "running");
+        }
+        previous = current;
+        last = now;
+    }
+}
+
+void PerfMonitor::SetLoopProgress(G4long eventsDone, G4long eventsTarget)
+{
+    std::lock_guard<std::mutex> lock(fStatusMutex);
+    fLoopEventsDone = eventsDone;
+    fLoopEventsTarget = eventsTarget;
+    if (eventsDone == 0) {
+        fPSFSnapshot.clear();
+    }
+}
+
+void PerfMonitor::SetPSFSnapshot(const PSFResultFile& result)
+{
+    const PSFBinning& binning = result.GetBinning();
+    const G4int numBins = binning.GetNumberOfBins();
+    const G4double densityUnit = eV / (nm * nm);
+
+    std::ostringstream psf;
+    psf << "{\"events\": " << result.GetTotalEvents() << ", \"radius_nm\": [";
+    for (G4int i = 0; i < numBins; i++) {
+        psf << (i > 0 ? ", " : "") << binning.GetCenter(i) / nm;
+    }
+    psf << "], \"points\": [";
+    for (G4int point = 0; point < result.GetNumberOfPoints(); point++) {
+        const G4long events = result.GetEvents(point);
+        psf << (point > 0 ? ", " : "") << "{\"energy_keV\": " << result.GetBeamEnergy(point) / keV
+            << ", \"events\": " << events << ", \"density\": [";
+        for (G4int i = 0; i < numBins; i++) {
+            G4double area = binning.GetArea(i);
+            G4double density = (area > 0 && events > 0) ?
+                result.GetSum(point, i) / (area * events) / densityUnit : 0.;
+            psf << (i > 0 ? ", " : "") << density;
+        }
+        psf << "]}";
+    }
+    psf << "]}";
+
+    {
+        std::lock_guard<std::mutex> lock(fStatusMutex);
+        fPSFSnapshot = psf.str();
+    }
+    if (!fStatusFile.empty()) {
+        WriteStatus(TakeSnapshot(), "idle");
+    }
+}
+
+void PerfMonitor::WriteStatus(const Snapshot& now, const char* state)
+{
+    // Called by the reporter during a run and by the master between runs
+    std::lock_guard<std::mutex> lock(fStatusMutex);
+
+    G4long events = now[PerfThreadCounters::kEvents] - fRunStart[PerfThreadCounters::kEvents];
+    G4long remaining = (fLoopEventsTarget > 0)
+        ? fLoopEventsTarget - fLoopEventsDone - events
+        : fEventsToProcess - events;
+    G4double averageRate = (fElapsed > 0.) ? events / fElapsed : 0.;
+
+    std::ostringstream json;
+    json << "{\"state\": \"" << state << "\", \"elapsed_s\": " << fElapsed
+        << ", \"events\": " << events << ", \"events_to_process\": " << fEventsToProcess
+        << ", \"loop_events_done\": " << fLoopEventsDone
+        << ", \"loop_events_target\": " << fLoopEventsTarget
+        << ", \"rate\": " << fEventRate << ", \"eta_s\": ";
+    if (averageRate > 0. && remaining >= 0) json << remaining / averageRate;
+    else json << "null";
+
+    // Counters of this run, in total and per thread
+    json << ", \"counters\": {";
+    for (G4int c = 0; c < PerfThreadCounters::kNumCounters; ++c) {
+        json << (c > 0 ? ", " : "") << "\""
+            << PerfThreadCounters::CounterKey(static_cast<PerfThreadCounters::Counter>(c))
+            << "\": " << now[c] - fRunStart[c];
+    }
+    json << "}, \"threads\": [";
+    {
+        std::lock_guard<std::mutex> registryLock(fRegistryMutex);
+        for (size_t t = 0; t < fThreadCounters.size(); ++t) {
+            const PerfThreadCounters& counters = *fThreadCounters[t];
+            json << (t > 0 ? ", " : "") << "{\"thread\": " << counters.GetThreadID()
+                << ", \"events\": " << counters.Get(PerfThreadCounters::kEvents)
+                << ", \"tracks_pushed\": " << counters.Get(PerfThreadCounters::kTracksPushed) << "}";
+        }
+    }
+    json << "]";
+    if (fStatusPSF && !fPSFSnapshot.empty()) {
+        json << ", \"psf\": " << fPSFSnapshot;
+    }
+    json << "}\n";
+
+    // Replace the file in one step; a failed rename (reader holding the
+    // file on Windows) is retried at the next sample
+    const std::string fileName(fStatusFile);
+    const std::string temporary = fileName + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        if (!out) return;
+        out << json.str();
+    }
+    std::error_code ec;
+    std::filesystem::rename(temporary, fileName, ec);
+}
+
+void PerfMonitor::PrintSample(const Snapshot& now, const Snapshot& previous,
+                              G4double elapsed, G4double sinceLast) const
+{
+    // printf rather than G4cout: this is not a Geant4 thread, so it has no
+    // G4cout destination of its own
+    G4long events = now[PerfThreadCounters::kEvents] - fRunStart[PerfThreadCounters::kEvents];
+    G4long tracks = now[PerfThreadCounters::kTracksPushed] - fRunStart[PerfThreadCounters::kTracksPushed];
+    G4long killed = 0;
+    for (G4int c = PerfThreadCounters::kFirstKillCounter; c < PerfThreadCounters::kNumCounters; ++c) {
+        killed += now[c] - fRunStart[c];
+    }
+    G4long deposits = now[PerfThreadCounters::kResistDeposits] - fRunStart[PerfThreadCounters::kResistDeposits];
+
+    G4double eventRate = (sinceLast > 0.)
+        ? (now[PerfThreadCounters::kEvents] - previous[PerfThreadCounters::kEvents]) / sinceLast
+        : 0.;
+
+    // Same progress line format as before, the GUI parses it
+    if (fEventsToProcess > 0) {
+        printf("Processing event %ld - %.1f%% complete\n",
+               events, 100.0 * events / fEventsToProcess);
+    }
+    printf("Perf: %.0f s, %.1f events/s, tracks %ld (killed %.1f%%), resist deposits %ld\n",
+           elapsed, eventRate, tracks, tracks > 0 ? 100.0 * killed / tracks : 0.0, deposits);
+    fflush(stdout);
+}
+
+void PerfMonitor::Dump() const
+{
+    std::lock_guard<std::mutex> lock(fRegistryMutex);
+
+    G4cout << "\n=== Performance counters (cumulative) ===" << G4endl;
+    Snapshot totals{};
+    for (const auto& counters : fThreadCounters) {
+        G4cout << "Thread " << counters->GetThreadID() << ":";
+        for (G4int c = 0; c < PerfThreadCounters::kNumCounters; ++c) {
+            auto counter = static_cast<PerfThreadCounters::Counter>(c);
+            G4long value = counters->Get(counter);
+            totals[c] += value;
+            if (value != 0) {
+                G4cout << " " << PerfThreadCounters::CounterName(counter) << "=" << value;
+            }
+        }
+        G4cout << G4endl;
+    }
+
+    G4cout << "Totals:" << G4endl;
+    for (G4int c = 0; c < PerfThreadCounters::kNumCounters; ++c) {
+        auto counter = static_cast<PerfThreadCounters::Counter>(c);
+        G4cout << "  " << PerfThreadCounters::CounterName(counter) << ": " << totals[c];
+        if (c >= PerfThreadCounters::kFirstKillCounter && totals[PerfThreadCounters::kTracksPushed] > 0) {
+            G4cout << " (" << 100.0 * totals[c] / totals[PerfThreadCounters::kTracksPushed] << "%)";
+        }
+        G4cout << G4endl;
+    }
+    G4cout << "=========================================" << G4endl;
+}
@@ -0,0 +1,161 @@
+// PhaseSpace.cc - Recording and replay of the particles coming up out of the substrate
+#include "PhaseSpace.hh"
+#include "PhaseSpaceMessenger.hh"
+#include "G4UnitsTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+#include <cmath>
+
+PhaseSpace* PhaseSpace::fInstance = nullptr;
+
+PhaseSpace* PhaseSpace::Instance()
+{
+    if (!fInstance) {
+        fInstance = new PhaseSpace();
+    }
+    return fInstance;
+}
+
+PhaseSpace::PhaseSpace()
+    : fMode(Mode::kOff),
+    fEventOffset(0),
+    fWarnedWrap(false),
+    fMessenger(nullptr)
+{
+    fMessenger = new PhaseSpaceMessenger(this);
+}
+
+PhaseSpace::~PhaseSpace()
+{
+    fFile.Close();
+    delete fMessenger;
+}
+
+void PhaseSpace::Record(const G4String& fileName)
+{
+    Stop();
+    fMode = Mode::kRecord;
+    fFileName = fileName;
+}
+
+void PhaseSpace::Replay(const G4String& fileName)
+{
+    Stop();
+    fMode = Mode::kReplay;
+    fFileName = fileName;
+}
+
+void PhaseSpace::Stop()
+{
+    if (IsRecording() && fFile.IsOpen()) {
+        fFile.Close();
+        G4cout << "Phase space: recorded " << fFile.GetNumberOfParticles() << " particles of "
+            << fFile.GetEvents() << " events in " << fFileName << G4endl;
+    }
+    fMode = Mode::kOff;
+    fFileName = "";
+    fLoadedFile = "";
+    fFile.Clear();
+    fEventOffset = 0;
+    fWarnedWrap = false;
+}
+
+void PhaseSpace::BeginRun(G4double beamEnergy, G4double resistThickness)
+{
+    if (IsRecording()) {
+        // Later runs append to the open recording
+        if (!fFile.IsOpen()) {
+            if (!fFile.Create(fFileName, beamEnergy, resistThickness)) {
+                Stop();
+                return;
+            }
+            G4cout << "### Recording the phase space at the substrate surface to " << fFileName << G4endl;
+        }
+        else if (std::abs(beamEnergy - fFile.GetBeamEnergy()) > 1e-9 * beamEnergy) {
+            G4ExceptionDescription msg;
+            msg << "Beam energy changed to " << G4BestUnit(beamEnergy, "Energy")
+                << " during the recording at " << G4BestUnit(fFile.GetBeamEnergy(), "Energy")
+                << "; use a new /ebl/phasespace/record file per energy";
+            G4Exception("PhaseSpace::BeginRun", "PHSP005", JustWarning, msg);
+        }
+        return;
+    }
+
+    if (!IsReplaying()) return;
+
+    if (fLoadedFile != fFileName) {
+        if (!fFile.Read(fFileName) || fFile.IsEmpty()) {
+            G4ExceptionDescription msg;
+            msg << "Cannot replay the phase space of " << fFileName;
+            G4Exception("PhaseSpace::BeginRun", "PHSP006", FatalException, msg);
+            return;
+        }
+        fLoadedFile = fFileName;
+        Print();
+    }
+
+    // The recorded particles belong to the recorded beam
+    if (std::abs(beamEnergy - fFile.GetBeamEnergy()) > 1e-9 * beamEnergy) {
+        G4ExceptionDescription msg;
+        msg << "Replaying a phase space recorded at " << G4BestUnit(fFile.GetBeamEnergy(), "Energy")
+            << " with a " << G4BestUnit(beamEnergy, "Energy") << " beam";
+        G4Exception("PhaseSpace::BeginRun", "PHSP007", JustWarning, msg);
+    }
+    G4cout << "### Replaying " << fFileName << ": recorded under "
+        << G4BestUnit(fFile.GetResistThickness(), "Length") << " of resist, replayed under "
+        << G4BestUnit(resistThickness, "Length") << G4endl;
+}
+
+void PhaseSpace::EndRun(G4long events)
+{
+    if (fMode == Mode::kOff) return;
+
+    fEventOffset += events;
+    if (IsRecording()) {
+        fFile.Finish(fEventOffset);
+    }
+    else if (!fWarnedWrap && fEventOffset > fFile.GetEvents()) {
+        G4ExceptionDescription msg;
+        msg << "The replay has run " << fEventOffset << " events of a recording of "
+            << fFile.GetEvents() << "; recorded events are being reused";
+        G4Exception("PhaseSpace::EndRun", "PHSP008", JustWarning, msg);
+        fWarnedWrap = true;
+    }
+}
+
+void PhaseSpace::RecordEvent(G4long eventID, const std::vector<PhaseSpaceFile::Particle>& particles)
+{
+    std::lock_guard<std::mutex> lock(fWriteMutex);
+    fFile.Append(eventID + fEventOffset, particles);
+}
+
+const PhaseSpaceFile::Particle* PhaseSpace::GetReplayEvent(G4long eventID, size_t& count) const
+{
+    count = 0;
+    G4long events = fFile.GetEvents();
+    if (!IsReplaying() || events <= 0) return nullptr;
+    return fFile.GetEvent((eventID + fEventOffset) % events, count);
+}
+
+void PhaseSpace::Print() const
+{
+    G4cout << "\n=== Phase space: ";
+    if (fMode == Mode::kOff) {
+        G4cout << "off ===" << G4endl;
+        return;
+    }
+    G4cout << (IsRecording() ? "recording to " : "replaying ") << fFileName << " ===" << G4endl;
+    if (IsReplaying() && fLoadedFile.empty()) return;
+
+    G4cout << " " << fFile.GetNumberOfParticles() << " particles of " << fFile.GetEvents()
+        << " events";
+    if (fFile.GetEvents() > 0) {
+        G4cout << " (" << static_cast<G4double>(fFile.GetNumberOfParticles()) / fFile.GetEvents()
+            << " per event)";
+    }
+    G4cout << G4endl;
+    if (fFile.GetBeamEnergy() > 0.) {
+        G4cout << " Recorded with a " << G4BestUnit(fFile.GetBeamEnergy(), "Energy") << " beam under "
+            << G4BestUnit(fFile.GetResistThickness(), "Length") << " of resist" << G4endl;
+    }
+}
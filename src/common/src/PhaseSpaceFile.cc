@@ -0,0 +1,194 @@
+// PhaseSpaceFile.cc - Particles crossing the resist/substrate plane, by event
+#include "PhaseSpaceFile.hh"
+#include "G4ios.hh"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace {
+    const char kMagic[8] = { 'E', 'B', 'L', 'P', 'H', 'S', '1', '\0' };
+
+    template <typename T>
+    void WriteValue(std::ofstream& out, const T& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    G4bool ReadValue(std::ifstream& in, T& value)
+    {
+        in.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return static_cast<G4bool>(in);
+    }
+
+    static_assert(sizeof(PhaseSpaceFile::Particle) == 32, "phase-space records are 32 bytes");
+}
+
+PhaseSpaceFile::PhaseSpaceFile()
+    : fEvents(0),
+    fNumParticles(0),
+    fBeamEnergy(0.),
+    fResistThickness(0.)
+{
+}
+
+PhaseSpaceFile::~PhaseSpaceFile()
+{
+    Close();
+}
+
+G4bool PhaseSpaceFile::Create(const G4String& fileName, G4double beamEnergy, G4double resistThickness)
+{
+    Close();
+    Clear();
+
+    fOut.open(fileName, std::ios::binary | std::ios::trunc);
+    if (!fOut) {
+        G4ExceptionDescription msg;
+        msg << "Cannot write the phase space to " << fileName;
+        G4Exception("PhaseSpaceFile::Create", "PHSP001", JustWarning, msg);
+        return false;
+    }
+    fFileName = fileName;
+    fBeamEnergy = beamEnergy;
+    fResistThickness = resistThickness;
+    WriteHeader();
+    return static_cast<G4bool>(fOut);
+}
+
+void PhaseSpaceFile::WriteHeader()
+{
+    // Internal units (MeV, mm)
+    fOut.write(kMagic, sizeof(kMagic));
+    WriteValue(fOut, static_cast<std::int32_t>(sizeof(Particle)));
+    WriteValue(fOut, static_cast<std::int32_t>(0));
+    WriteValue(fOut, static_cast<std::int64_t>(fEvents));
+    WriteValue(fOut, static_cast<std::int64_t>(fNumParticles));
+    WriteValue(fOut, fBeamEnergy);
+    WriteValue(fOut, fResistThickness);
+}
+
+void PhaseSpaceFile::Append(G4long eventID, const std::vector<Particle>& particles)
+{
+    if (!fOut.is_open() || particles.empty()) return;
+
+    WriteValue(fOut, static_cast<std::int64_t>(eventID));
+    WriteValue(fOut, static_cast<std::int64_t>(particles.size()));
+    fOut.write(reinterpret_cast<const char*>(particles.data()), particles.size() * sizeof(Particle));
+    fNumParticles += particles.size();
+}
+
+G4bool PhaseSpaceFile::Finish(G4long events)
+{
+    if (!fOut.is_open()) return false;
+
+    fEvents = events;
+    std::streampos end = fOut.tellp();
+    fOut.seekp(0);
+    WriteHeader();
+    fOut.seekp(end);
+    fOut.flush();
+
+    if (!fOut) {
+        G4ExceptionDescription msg;
+        msg << "Writing the phase space to " << fFileName << " failed";
+        G4Exception("PhaseSpaceFile::Finish", "PHSP002", JustWarning, msg);
+        return false;
+    }
+    return true;
+}
+
+void PhaseSpaceFile::Close()
+{
+    if (fOut.is_open()) fOut.close();
+}
+
+void PhaseSpaceFile::Clear()
+{
+    fEvents = 0;
+    fNumParticles = 0;
+    fBeamEnergy = 0.;
+    fResistThickness = 0.;
+    fParticles.clear();
+    fEventIDs.clear();
+    fFirst.clear();
+}
+
+G4bool PhaseSpaceFile::Read(const G4String& fileName)
+{
+    Close();
+    Clear();
+
+    std::ifstream in(fileName, std::ios::binary);
+    char magic[sizeof(kMagic)];
+    if (!in || !in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+        G4ExceptionDescription msg;
+        msg << fileName << " is not a phase-space file";
+        G4Exception("PhaseSpaceFile::Read", "PHSP003", JustWarning, msg);
+        return false;
+    }
+
+    std::int32_t particleSize = 0, reserved = 0;
+    std::int64_t events = 0, numParticles = 0;
+    G4double beamEnergy = 0., resistThickness = 0.;
+    G4bool ok = ReadValue(in, particleSize) && ReadValue(in, reserved) &&
+                ReadValue(in, events) && ReadValue(in, numParticles) &&
+                ReadValue(in, beamEnergy) && ReadValue(in, resistThickness) &&
+                particleSize == static_cast<std::int32_t>(sizeof(Particle)) &&
+                events >= 0 && numParticles >= 0;
+
+    // Blocks as written, then sorted by event
+    std::vector<Particle> particles;
+    std::vector<G4long> blockEvents;
+    std::vector<size_t> blockFirst;
+    if (ok) particles.reserve(static_cast<size_t>(numParticles));
+    while (ok && particles.size() < static_cast<size_t>(numParticles)) {
+        std::int64_t eventID = 0, count = 0;
+        ok = ReadValue(in, eventID) && ReadValue(in, count) && count > 0 &&
+             particles.size() + count <= static_cast<size_t>(numParticles);
+        if (!ok) break;
+        blockEvents.push_back(eventID);
+        blockFirst.push_back(particles.size());
+        particles.resize(particles.size() + count);
+        ok = static_cast<G4bool>(in.read(reinterpret_cast<char*>(&particles[blockFirst.back()]),
+                                         count * sizeof(Particle)));
+    }
+
+    if (!ok) {
+        G4ExceptionDescription msg;
+        msg << "Phase-space file " << fileName << " is truncated or corrupt";
+        G4Exception("PhaseSpaceFile::Read", "PHSP004", JustWarning, msg);
+        return false;
+    }
+
+    std::vector<size_t> order(blockEvents.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&blockEvents](size_t a, size_t b) { return blockEvents[a] < blockEvents[b]; });
+
+    fParticles.reserve(particles.size());
+    for (size_t block : order) {
+        size_t end = block + 1 < blockFirst.size() ? blockFirst[block + 1] : particles.size();
+        fEventIDs.push_back(blockEvents[block]);
+        fFirst.push_back(fParticles.size());
+        fParticles.insert(fParticles.end(), particles.begin() + blockFirst[block], particles.begin() + end);
+    }
+    fFirst.push_back(fParticles.size());
+
+    fEvents = events;
+    fNumParticles = fParticles.size();
+    fBeamEnergy = beamEnergy;
+    fResistThickness = resistThickness;
+    return true;
+}
+
+const PhaseSpaceFile::Particle* PhaseSpaceFile::GetEvent(G4long eventID, size_t& count) const
+{
+    count = 0;
+    auto it = std::lower_bound(fEventIDs.begin(), fEventIDs.end(), eventID);
+    if (it == fEventIDs.end() || *it != eventID) return nullptr;
+
+    size_t index = it - fEventIDs.begin();
+    count = fFirst[index + 1] - fFirst[index];
+    return &fParticles[fFirst[index]];
+}
@@ -0,0 +1,66 @@
+// PhaseSpaceMessenger.cc
+#include "PhaseSpaceMessenger.hh"
+#include "PhaseSpace.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+PhaseSpaceMessenger::PhaseSpaceMessenger(PhaseSpace* phaseSpace)
+    : G4UImessenger(),
+    fPhaseSpace(phaseSpace)
+{
+    // The phase-space file is shared by all threads, so nothing is broadcast
+    fPhaseSpaceDir = new G4UIdirectory("/ebl/phasespace/");
+    fPhaseSpaceDir->SetGuidance("Record the particles coming up out of the substrate and replay them");
+    fPhaseSpaceDir->SetGuidance("under a different resist, without tracking the substrate again");
+
+    fRecordCmd = new G4UIcmdWithAString("/ebl/phasespace/record", this);
+    fRecordCmd->SetGuidance("Write every particle entering the resist from the substrate to a file.");
+    fRecordCmd->SetGuidance("Following runs append to it until /ebl/phasespace/stop.");
+    fRecordCmd->SetParameterName("file", false);
+    fRecordCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fRecordCmd->SetToBeBroadcasted(false);
+
+    fReplayCmd = new G4UIcmdWithAString("/ebl/phasespace/replay", this);
+    fReplayCmd->SetGuidance("Replay a recorded phase space: particles entering the substrate are");
+    fReplayCmd->SetGuidance("killed and the recorded ones of the same event start below the surface.");
+    fReplayCmd->SetGuidance("Only valid for the beam energy and substrate of the recording.");
+    fReplayCmd->SetParameterName("file", false);
+    fReplayCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fReplayCmd->SetToBeBroadcasted(false);
+
+    fStopCmd = new G4UIcmdWithoutParameter("/ebl/phasespace/stop", this);
+    fStopCmd->SetGuidance("Close the recording or end the replay (back to full transport)");
+    fStopCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fStopCmd->SetToBeBroadcasted(false);
+
+    fPrintCmd = new G4UIcmdWithoutParameter("/ebl/phasespace/print", this);
+    fPrintCmd->SetGuidance("Print the phase-space mode and file summary");
+    fPrintCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fPrintCmd->SetToBeBroadcasted(false);
+}
+
+PhaseSpaceMessenger::~PhaseSpaceMessenger()
+{
+    delete fRecordCmd;
+    delete fReplayCmd;
+    delete fStopCmd;
+    delete fPrintCmd;
+    delete fPhaseSpaceDir;
+}
+
+void PhaseSpaceMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == fRecordCmd) {
+        fPhaseSpace->Record(newValue);
+    }
+    else if (command == fReplayCmd) {
+        fPhaseSpace->Replay(newValue);
+    }
+    else if (command == fStopCmd) {
+        fPhaseSpace->Stop();
+    }
+    else if (command == fPrintCmd) {
+        fPhaseSpace->Print();
+    }
+}
@@ -0,0 +1,219 @@
+// PhysicsTableCache.cc - On-disk cache of the built physics tables
+#include "PhysicsTableCache.hh"
+#include "CacheMessenger.hh"
+#include "G4VUserPhysicsList.hh"
+#include "G4Material.hh"
+#include "G4Element.hh"
+#include "G4IonisParamMat.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4ProductionCuts.hh"
+#include "G4EmParameters.hh"
+#include "G4TransportationManager.hh"
+#include "G4Navigator.hh"
+#include "G4Version.hh"
+#include "G4ios.hh"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+#include <random>
+
+PhysicsTableCache* PhysicsTableCache::fInstance = nullptr;
+
+PhysicsTableCache* PhysicsTableCache::Instance()
+{
+    if (!fInstance) {
+        fInstance = new PhysicsTableCache();
+    }
+    return fInstance;
+}
+
+PhysicsTableCache::PhysicsTableCache()
+    : fEnabled(false),
+    fDirectory("physics_cache"),
+    fPhysicsList(nullptr),
+    fStored(false),
+    fMessenger(nullptr)
+{
+    fMessenger = new CacheMessenger(this);
+}
+
+PhysicsTableCache::~PhysicsTableCache()
+{
+    delete fMessenger;
+}
+
+G4String PhysicsTableCache::DescribeSetup() const
+{
+    std::ostringstream os;
+    os << std::setprecision(17);
+    os << "Geant4 " << G4VERSION_NUMBER << "\n";
+    os << "Configuration " << fConfiguration << "\n";
+
+    for (const G4Material* material : *G4Material::GetMaterialTable()) {
+        os << "Material " << material->GetName()
+            << " density=" << material->GetDensity()
+            << " state=" << material->GetState()
+            << " T=" << material->GetTemperature()
+            << " P=" << material->GetPressure()
+            << " I=" << material->GetIonisation()->GetMeanExcitationEnergy() << "\n";
+        const G4double* fractions = material->GetFractionVector();
+        for (size_t i = 0; i < material->GetNumberOfElements(); ++i) {
+            const G4Element* element = material->GetElement(static_cast<G4int>(i));
+            os << "  " << element->GetName() << " Z=" << element->GetZ()
+                << " A=" << element->GetA() << " w=" << fractions[i] << "\n";
+        }
+    }
+
+    for (const G4Region* region : *G4RegionStore::GetInstance()) {
+        os << "Region " << region->GetName();
+        G4ProductionCuts* cuts = region->GetProductionCuts();
+        if (cuts) {
+            for (G4int index = 0; index < NumberOfG4CutIndex; ++index) {
+                os << " " << cuts->GetProductionCut(index);
+            }
+        }
+        auto materialIt = region->GetMaterialIterator();
+        for (size_t i = 0; i < region->GetNumberOfMaterials(); ++i, ++materialIt) {
+            os << " " << (*materialIt)->GetName();
+        }
+        os << "\n";
+    }
+
+    os << *G4EmParameters::Instance();
+    return os.str();
+}
+
+void PhysicsTableCache::UpdateRegionMaterials() const
+{
+    // The region material lists are only filled at run initialization,
+    // after the cuts are set; fill them now so the setup reads the same
+    // in Prepare() and at run start
+    G4VPhysicalVolume* world =
+        G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume();
+    if (world) {
+        G4RegionStore::GetInstance()->UpdateMaterialList(world);
+    }
+}
+
+G4String PhysicsTableCache::HashToString(const G4String& text)
+{
+    // 64-bit FNV-1a; collisions only matter within one cache directory
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    std::ostringstream os;
+    os << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return os.str();
+}
+
+G4String PhysicsTableCache::EntryDirectory(const G4String& key) const
+{
+    return (std::filesystem::path(std::string(fDirectory)) / std::string(key)).string();
+}
+
+G4bool PhysicsTableCache::HasEntry(const G4String& key) const
+{
+    // The setup file is written before the rename, so it marks complete entries
+    std::error_code error;
+    return std::filesystem::exists(
+        std::filesystem::path(std::string(EntryDirectory(key))) / "setup.txt", error);
+}
+
+void PhysicsTableCache::Prepare(G4VUserPhysicsList* physicsList, const G4String& configuration)
+{
+    fPhysicsList = physicsList;
+    fConfiguration = configuration;
+    fKey = "";
+    fSetup = "";
+    fStored = false;
+    if (!fEnabled) {
+        physicsList->ResetPhysicsTableRetrieved();
+        return;
+    }
+
+    UpdateRegionMaterials();
+    fSetup = DescribeSetup();
+    fKey = HashToString(fSetup);
+    fStored = HasEntry(fKey);
+    if (fStored) {
+        physicsList->SetPhysicsTableRetrieved(EntryDirectory(fKey));
+        G4cout << "Physics tables: retrieving cached entry " << EntryDirectory(fKey) << G4endl;
+    }
+    else {
+        physicsList->ResetPhysicsTableRetrieved();
+        G4cout << "Physics tables: no cached entry for this setup, building" << G4endl;
+    }
+}
+
+void PhysicsTableCache::Invalidate()
+{
+    if (fPhysicsList) {
+        fPhysicsList->ResetPhysicsTableRetrieved();
+    }
+    fKey = "";
+    fSetup = "";
+    fStored = false;
+}
+
+void PhysicsTableCache::StoreIfNeeded()
+{
+    if (!fEnabled || !fPhysicsList) return;
+
+    // Filed under the key Prepare() looked up; after Invalidate() the setup
+    // is described again from the rebuilt geometry
+    if (fKey.empty()) {
+        UpdateRegionMaterials();
+        fSetup = DescribeSetup();
+        fKey = HashToString(fSetup);
+        fStored = HasEntry(fKey);
+    }
+    if (fStored) return;
+
+    namespace fs = std::filesystem;
+    fs::path entry(std::string(EntryDirectory(fKey)));
+    fs::path staging = entry;
+    staging += ".tmp" + std::to_string(std::random_device{}());
+
+    std::error_code error;
+    fs::remove_all(staging, error);
+    fs::create_directories(staging, error);
+    if (error || !fPhysicsList->StorePhysicsTable(staging.string())) {
+        G4ExceptionDescription msg;
+        msg << "Could not store physics tables in " << staging.string()
+            << ", the next launch builds them again";
+        G4Exception("PhysicsTableCache::StoreIfNeeded", "CACHE001", JustWarning, msg);
+        fs::remove_all(staging, error);
+        fStored = true;     // do not retry every run
+        return;
+    }
+
+    {
+        std::ofstream setup(staging / "setup.txt");
+        setup << fSetup;
+    }
+
+    // Another launch may have filed the same entry meanwhile; keep theirs
+    fs::rename(staging, entry, error);
+    if (error) {
+        fs::remove_all(staging, error);
+    }
+    else {
+        G4cout << "Physics tables: stored cache entry " << entry.string() << G4endl;
+    }
+    fStored = true;
+}
+
+void PhysicsTableCache::Print() const
+{
+    G4cout << "\n=== Physics table cache: " << (fEnabled ? "ON" : "off") << " ===" << G4endl;
+    G4cout << " Directory: " << fDirectory << G4endl;
+    if (!fKey.empty()) {
+        G4cout << " Current setup: " << fKey << (fStored ? " (cached)" : " (not cached)") << G4endl;
+    }
+}
@@ -0,0 +1,304 @@
+// ResultLibrary.cc - On-disk library of finished PSF results
+#include "ResultLibrary.hh"
+#include "LibraryMessenger.hh"
+#include "PSFResultFile.hh"
+#include "PhysicsTableCache.hh"
+#include "G4UnitsTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+namespace {
+    G4bool SameValue(G4double a, G4double b)
+    {
+        return std::abs(a - b) <= 1e-9 * std::max(std::abs(a), std::abs(b));
+    }
+}
+
+ResultLibrary* ResultLibrary::fInstance = nullptr;
+
+ResultLibrary* ResultLibrary::Instance()
+{
+    if (!fInstance) {
+        fInstance = new ResultLibrary();
+    }
+    return fInstance;
+}
+
+ResultLibrary::ResultLibrary()
+    : fInterpolation(false),
+    fTolerance(0.02),
+    fMessenger(nullptr)
+{
+    fMessenger = new LibraryMessenger(this);
+}
+
+ResultLibrary::~ResultLibrary()
+{
+    delete fMessenger;
+}
+
+G4String ResultLibrary::FamilyDirectory(const ResultKey& key) const
+{
+    return (std::filesystem::path(std::string(fDirectory)) /
+        std::string(PhysicsTableCache::HashToString(key.setup))).string();
+}
+
+G4String ResultLibrary::EntryPath(const ResultKey& key) const
+{
+    // Readable names; the record holds the exact values
+    std::ostringstream name;
+    name << std::setprecision(10) << key.beamEnergy / keV << "keV_"
+        << key.resistThickness / nm << "nm.bin";
+    return (std::filesystem::path(std::string(FamilyDirectory(key))) / name.str()).string();
+}
+
+std::vector<ResultLibrary::Entry> ResultLibrary::ListEntries(const ResultKey& key) const
+{
+    namespace fs = std::filesystem;
+    std::vector<Entry> entries;
+    if (!IsEnabled()) return entries;
+
+    std::error_code error;
+    for (const fs::directory_entry& file : fs::directory_iterator(std::string(FamilyDirectory(key)), error)) {
+        if (file.path().extension() != ".txt") continue;
+
+        std::ifstream record(file.path());
+        Entry entry;
+        std::string field, seeds;
+        record >> field >> entry.beamEnergy >> field >> entry.resistThickness
+            >> field >> entry.events >> field;
+        std::getline(record, seeds);
+        if (!record) continue;
+
+        std::istringstream seedList(seeds);
+        for (G4long seed; seedList >> seed;) entry.seeds.push_back(seed);
+        entry.beamEnergy *= keV;
+        entry.resistThickness *= nm;
+        entry.path = fs::path(file.path()).replace_extension(".bin").string();
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+G4bool ResultLibrary::FindEntry(const ResultKey& key, Entry& entry) const
+{
+    for (const Entry& candidate : ListEntries(key)) {
+        if (SameValue(candidate.beamEnergy, key.beamEnergy) &&
+            SameValue(candidate.resistThickness, key.resistThickness)) {
+            entry = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+G4bool ResultLibrary::Find(const ResultKey& key, PSFResultFile& result) const
+{
+    Entry entry;
+    return FindEntry(key, entry) && result.Read(entry.path);
+}
+
+G4bool ResultLibrary::Interpolate(const ResultKey& key, G4long minEvents,
+                                  PSFResultFile& result, G4double& difference) const
+{
+    std::vector<Entry> entries = ListEntries(key);
+
+    // Energy axis first (same thickness), then thickness (same energy)
+    for (G4int axis = 0; axis < 2; axis++) {
+        auto position = [axis](const Entry& e) { return axis == 0 ? e.beamEnergy : e.resistThickness; };
+        auto other = [axis](const Entry& e) { return axis == 0 ? e.resistThickness : e.beamEnergy; };
+        const G4double target = axis == 0 ? key.beamEnergy : key.resistThickness;
+        const G4double fixed = axis == 0 ? key.resistThickness : key.beamEnergy;
+
+        const Entry* below = nullptr;
+        const Entry* above = nullptr;
+        for (const Entry& entry : entries) {
+            if (entry.events < minEvents || !SameValue(other(entry), fixed)) continue;
+            G4double x = position(entry);
+            if (x < target && (!below || x > position(*below))) below = &entry;
+            if (x > target && (!above || x < position(*above))) above = &entry;
+        }
+        if (!below || !above) continue;
+
+        PSFResultFile lower, upper;
+        if (!lower.Read(below->path) || !upper.Read(above->path) ||
+            lower.GetBinning() != upper.GetBinning()) {
+            continue;
+        }
+
+        // Per-event tallies of the neighbours and their relative L1 distance
+        const PSFBinning& binning = lower.GetBinning();
+        const G4int numBins = binning.GetNumberOfBins();
+        const G4double lowerEvents = static_cast<G4double>(lower.GetEvents(0));
+        const G4double upperEvents = static_cast<G4double>(upper.GetEvents(0));
+        if (lowerEvents <= 0. || upperEvents <= 0.) continue;
+
+        G4double distance = 0.;
+        G4double norm = 0.;
+        for (G4int bin = 0; bin < numBins; bin++) {
+            G4double a = lower.GetSum(0, bin) / lowerEvents;
+            G4double b = upper.GetSum(0, bin) / upperEvents;
+            distance += std::abs(a - b);
+            norm += 0.5 * (a + b);
+        }
+        difference = norm > 0. ? distance / norm : 0.;
+        if (difference > fTolerance) {
+            G4cout << "Result library: neighbours at " << G4BestUnit(position(*below), axis == 0 ? "Energy" : "Length")
+                << " and " << G4BestUnit(position(*above), axis == 0 ? "Energy" : "Length") << " differ by "
+                << difference * 100. << "%, above the " << fTolerance * 100. << "% tolerance" << G4endl;
+            continue;
+        }
+
+        // Linear in the axis; moments per event, scaled back to the smaller
+        // event count so that the errors stay those of the weaker neighbour
+        const G4double w = (target - position(*below)) / (position(*above) - position(*below));
+        const G4long events = std::min(lower.GetEvents(0), upper.GetEvents(0));
+        std::vector<G4double> sum(numBins), sumSquares(numBins), hits(numBins);
+        for (G4int bin = 0; bin < numBins; bin++) {
+            sum[bin] = events * ((1. - w) * lower.GetSum(0, bin) / lowerEvents +
+                                 w * upper.GetSum(0, bin) / upperEvents);
+            sumSquares[bin] = events * ((1. - w) * lower.GetSumSquares(0, bin) / lowerEvents +
+                                        w * upper.GetSumSquares(0, bin) / upperEvents);
+            hits[bin] = events * ((1. - w) * lower.GetHits(0, bin) / lowerEvents +
+                                  w * upper.GetHits(0, bin) / upperEvents);
+        }
+
+        result.SetLayout(binning, { key.beamEnergy });
+        result.SetEvents(0, events);
+        result.SetTallies(sum, sumSquares, hits);
+        result.SetSeed(-1);
+        result.SetWeighted(lower.IsWeighted());
+        result.SetResist(key.resistThickness, lower.GetResistDensity(), lower.GetResistComposition());
+
+        G4cout << "Result library: interpolated between " << below->path << " and " << above->path
+            << " (neighbours differ by " << difference * 100. << "%)" << G4endl;
+        return true;
+    }
+    return false;
+}
+
+G4bool ResultLibrary::CanExtend(const ResultKey& key, G4long seed) const
+{
+    Entry entry;
+    if (!FindEntry(key, entry) || fWritten.count(entry.path) > 0) return true;
+    return seed != -1 && std::find(entry.seeds.begin(), entry.seeds.end(), seed) == entry.seeds.end();
+}
+
+void ResultLibrary::AddRun(const ResultKey& key, const PSFResultFile& result)
+{
+    if (!IsEnabled()) return;
+
+    Entry entry;
+    if (!FindEntry(key, entry)) {
+        Write(key, result, { result.GetSeed() });
+        return;
+    }
+
+    PSFResultFile combined;
+    if (CanExtend(key, result.GetSeed()) && combined.Read(entry.path) && combined.Merge(result)) {
+        std::vector<G4long> seeds = entry.seeds;
+        if (std::find(seeds.begin(), seeds.end(), result.GetSeed()) == seeds.end()) {
+            seeds.push_back(result.GetSeed());
+        }
+        Write(key, combined, seeds);
+    }
+    else if (result.GetTotalEvents() > entry.events) {
+        G4cout << "Result library: replacing " << entry.path << " (" << entry.events
+            << " events, may share this run's events)" << G4endl;
+        Write(key, result, { result.GetSeed() });
+    }
+    else {
+        G4cout << "Result library: keeping " << entry.path << " (" << entry.events
+            << " events, may share this run's events)" << G4endl;
+    }
+}
+
+void ResultLibrary::Replace(const ResultKey& key, const PSFResultFile& result)
+{
+    if (!IsEnabled()) return;
+
+    std::vector<G4long> seeds;
+    Entry entry;
+    if (FindEntry(key, entry)) seeds = entry.seeds;
+    if (std::find(seeds.begin(), seeds.end(), result.GetSeed()) == seeds.end()) {
+        seeds.push_back(result.GetSeed());
+    }
+    Write(key, result, seeds);
+}
+
+void ResultLibrary::Write(const ResultKey& key, const PSFResultFile& result,
+                          const std::vector<G4long>& seeds)
+{
+    namespace fs = std::filesystem;
+    fs::path path(std::string(EntryPath(key)));
+    fs::path record = fs::path(path).replace_extension(".txt");
+    std::string staging = ".tmp" + std::to_string(std::random_device{}());
+
+    std::error_code error;
+    fs::create_directories(path.parent_path(), error);
+
+    // Result first, then the record that marks the entry complete
+    G4bool ok = result.Write(path.string() + staging);
+    if (ok) {
+        fs::rename(path.string() + staging, path, error);
+        ok = !error;
+    }
+    if (ok) {
+        std::ofstream out(record.string() + staging);
+        out << std::setprecision(17)
+            << "energy_keV " << key.beamEnergy / keV << "\n"
+            << "thickness_nm " << key.resistThickness / nm << "\n"
+            << "events " << result.GetTotalEvents() << "\n"
+            << "seeds";
+        for (G4long seed : seeds) out << " " << seed;
+        out << "\n" << key.setup;
+        out.close();
+        ok = static_cast<G4bool>(out);
+    }
+    if (ok) {
+        fs::rename(record.string() + staging, record, error);
+        ok = !error;
+    }
+    if (!ok) {
+        G4ExceptionDescription msg;
+        msg << "Could not file the result in " << path.string();
+        G4Exception("ResultLibrary::Write", "LIB001", JustWarning, msg);
+        fs::remove(path.string() + staging, error);
+        fs::remove(record.string() + staging, error);
+        return;
+    }
+
+    fWritten.insert(path.string());
+    G4cout << "Result library: filed " << result.GetTotalEvents() << " events as " << path.string() << G4endl;
+}
+
+void ResultLibrary::Print() const
+{
+    G4cout << "\n=== Result library: " << (IsEnabled() ? "ON" : "off") << " ===" << G4endl;
+    if (!IsEnabled()) return;
+    G4cout << " Directory: " << fDirectory << G4endl;
+    G4cout << " Interpolation: " << (fInterpolation ? "on" : "off")
+        << ", tolerance " << fTolerance * 100. << "%" << G4endl;
+
+    namespace fs = std::filesystem;
+    std::error_code error;
+    G4int setups = 0;
+    G4int results = 0;
+    for (const fs::directory_entry& family : fs::directory_iterator(std::string(fDirectory), error)) {
+        if (!family.is_directory()) continue;
+        setups++;
+        for (const fs::directory_entry& file : fs::directory_iterator(family.path(), error)) {
+            if (file.path().extension() == ".txt") results++;
+        }
+    }
+    G4cout << " " << results << " results of " << setups << " setups" << G4endl;
+}
@@ -0,0 +1,123 @@
+// RunCheckpoint.cc - Resumable state of a batched run
+#include "RunCheckpoint.hh"
+#include "Randomize.hh"
+#include "G4ios.hh"
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+    const char* kStateFile = "state.txt";
+
+    std::string GenerationFile(const fs::path& directory, const char* stem,
+                               G4int generation, const char* extension)
+    {
+        std::ostringstream name;
+        name << stem << "_" << generation << extension;
+        return (directory / name.str()).string();
+    }
+}
+
+RunCheckpoint::RunCheckpoint()
+    : fBatches(0)
+{
+}
+
+G4bool RunCheckpoint::Write(const G4String& directory)
+{
+    const fs::path dir = std::string(directory);
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+
+    // Data files first, under names of their own generation
+    const std::string talliesPath = GenerationFile(dir, "tallies", fBatches, ".bin");
+    const std::string enginePath = GenerationFile(dir, "engine", fBatches, ".rndm");
+    if (!fResult.Write(talliesPath)) return false;
+    CLHEP::HepRandom::saveEngineStatus(enginePath.c_str());
+
+    // Then switch state.txt over to them in one rename
+    const fs::path statePath = dir / kStateFile;
+    fs::path tmpPath = statePath;
+    tmpPath += ".tmp";
+    {
+        std::ofstream state(tmpPath);
+        state << "# EBL run checkpoint" << '\n';
+        state << "batches " << fBatches << '\n';
+        state << "scalars";
+        state << std::setprecision(17);
+        for (G4double value : fScalars) {
+            state << " " << value;
+        }
+        state << '\n';
+        if (!state) {
+            G4ExceptionDescription msg;
+            msg << "Cannot write checkpoint state to " << tmpPath.string();
+            G4Exception("RunCheckpoint::Write", "CKPT001", JustWarning, msg);
+            return false;
+        }
+    }
+    fs::rename(tmpPath, statePath, ec);
+    if (ec) {
+        G4ExceptionDescription msg;
+        msg << "Cannot update checkpoint " << statePath.string() << ": " << ec.message();
+        G4Exception("RunCheckpoint::Write", "CKPT001", JustWarning, msg);
+        return false;
+    }
+
+    // Drop the files of older generations
+    for (const fs::directory_entry& entry : fs::directory_iterator(dir, ec)) {
+        const std::string path = entry.path().string();
+        const std::string name = entry.path().filename().string();
+        G4bool generationFile = name.rfind("tallies_", 0) == 0 || name.rfind("engine_", 0) == 0;
+        if (generationFile && path != talliesPath && path != enginePath) {
+            fs::remove(entry.path(), ec);
+        }
+    }
+    return true;
+}
+
+G4bool RunCheckpoint::Read(const G4String& directory)
+{
+    const fs::path dir = std::string(directory);
+    std::ifstream state(dir / kStateFile);
+    if (!state) {
+        G4ExceptionDescription msg;
+        msg << "No checkpoint in " << directory;
+        G4Exception("RunCheckpoint::Read", "CKPT002", JustWarning, msg);
+        return false;
+    }
+
+    G4int batches = -1;
+    std::vector<G4double> scalars;
+    std::string line;
+    while (std::getline(state, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        fields >> key;
+        if (key == "batches") {
+            fields >> batches;
+        }
+        else if (key == "scalars") {
+            for (G4double value; fields >> value;) {
+                scalars.push_back(value);
+            }
+        }
+    }
+
+    const std::string talliesPath = GenerationFile(dir, "tallies", batches, ".bin");
+    const std::string enginePath = GenerationFile(dir, "engine", batches, ".rndm");
+    if (batches < 0 || !fs::exists(enginePath) || !fResult.Read(talliesPath)) {
+        G4ExceptionDescription msg;
+        msg << "Checkpoint in " << directory << " is incomplete";
+        G4Exception("RunCheckpoint::Read", "CKPT003", JustWarning, msg);
+        return false;
+    }
+
+    CLHEP::HepRandom::restoreEngineStatus(enginePath.c_str());
+    fBatches = batches;
+    fScalars = scalars;
+    return true;
+}
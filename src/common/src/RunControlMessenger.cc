@@ -0,0 +1,154 @@
+// RunControlMessenger.cc
+#include "RunControlMessenger.hh"
+#include "ConvergenceControl.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4Tokenizer.hh"
+
+RunControlMessenger::RunControlMessenger(ConvergenceControl* control)
+    : G4UImessenger(),
+    fControl(control)
+{
+    // The batch loop runs on the master, so nothing is broadcast
+    fRunDir = new G4UIdirectory("/ebl/run/");
+    fRunDir->SetGuidance("Batched runs: convergence-driven and checkpointed");
+
+    fTargetErrorCmd = new G4UIcmdWithAString("/ebl/run/targetError", this);
+    fTargetErrorCmd->SetGuidance("Target relative error of every bin in the /ebl/run/range,");
+    fTargetErrorCmd->SetGuidance("as a fraction or a percentage (0.01 or 1%). 0 disables.");
+    fTargetErrorCmd->SetParameterName("error", false);
+    fTargetErrorCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fTargetErrorCmd->SetToBeBroadcasted(false);
+
+    fRangeCmd = new G4UIcommand("/ebl/run/range", this);
+    fRangeCmd->SetGuidance("Radius range whose bins must reach the target error");
+    fRangeCmd->SetGuidance("(max 0 = up to the end of the binning)");
+    fRangeCmd->SetGuidance("  e.g. /ebl/run/range 10 50000 nm");
+    G4UIparameter* minParam = new G4UIparameter("min", 'd', false);
+    minParam->SetParameterRange("min>=0.");
+    fRangeCmd->SetParameter(minParam);
+    G4UIparameter* maxParam = new G4UIparameter("max", 'd', false);
+    maxParam->SetParameterRange("max>=0.");
+    fRangeCmd->SetParameter(maxParam);
+    G4UIparameter* unitParam = new G4UIparameter("unit", 's', true);
+    unitParam->SetDefaultUnit("nm");
+    fRangeCmd->SetParameter(unitParam);
+    fRangeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fRangeCmd->SetToBeBroadcasted(false);
+
+    fBatchSizeCmd = new G4UIcmdWithAnInteger("/ebl/run/batchSize", this);
+    fBatchSizeCmd->SetGuidance("Events per batch; the error is checked after every batch");
+    fBatchSizeCmd->SetParameterName("events", false);
+    fBatchSizeCmd->SetRange("events>0");
+    fBatchSizeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fBatchSizeCmd->SetToBeBroadcasted(false);
+
+    fMaxEventsCmd = new G4UIcmdWithAnInteger("/ebl/run/maxEvents", this);
+    fMaxEventsCmd->SetGuidance("Event budget of /ebl/run/converge (0 = unlimited)");
+    fMaxEventsCmd->SetParameterName("events", false);
+    fMaxEventsCmd->SetRange("events>=0");
+    fMaxEventsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fMaxEventsCmd->SetToBeBroadcasted(false);
+
+    fMaxTimeCmd = new G4UIcmdWithADoubleAndUnit("/ebl/run/maxTime", this);
+    fMaxTimeCmd->SetGuidance("Wall-time budget of /ebl/run/converge (0 = unlimited);");
+    fMaxTimeCmd->SetGuidance("checked after each batch");
+    fMaxTimeCmd->SetParameterName("time", false);
+    fMaxTimeCmd->SetRange("time>=0.");
+    fMaxTimeCmd->SetUnitCategory("Time");
+    fMaxTimeCmd->SetDefaultUnit("s");
+    fMaxTimeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fMaxTimeCmd->SetToBeBroadcasted(false);
+
+    fConvergeCmd = new G4UIcmdWithoutParameter("/ebl/run/converge", this);
+    fConvergeCmd->SetGuidance("Run batches until the target error or a budget is reached,");
+    fConvergeCmd->SetGuidance("then write the output of all batches together");
+    fConvergeCmd->AvailableForStates(G4State_Idle);
+    fConvergeCmd->SetToBeBroadcasted(false);
+
+    fBeamOnCmd = new G4UIcmdWithAnInteger("/ebl/run/beamOn", this);
+    fBeamOnCmd->SetGuidance("Run the events in batches of /ebl/run/batchSize, with a");
+    fBeamOnCmd->SetGuidance("checkpoint after every batch (/ebl/run/checkpoint); after");
+    fBeamOnCmd->SetGuidance("ebl_sim --resume only the remaining events are run");
+    fBeamOnCmd->SetParameterName("events", false);
+    fBeamOnCmd->SetRange("events>0");
+    fBeamOnCmd->AvailableForStates(G4State_Idle);
+    fBeamOnCmd->SetToBeBroadcasted(false);
+
+    fCheckpointCmd = new G4UIcmdWithAString("/ebl/run/checkpoint", this);
+    fCheckpointCmd->SetGuidance("Directory for a checkpoint after every batch of");
+    fCheckpointCmd->SetGuidance("/ebl/run/beamOn and /ebl/run/converge; no argument disables");
+    fCheckpointCmd->SetParameterName("directory", true);
+    fCheckpointCmd->SetDefaultValue("");
+    fCheckpointCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fCheckpointCmd->SetToBeBroadcasted(false);
+
+    fPrintCmd = new G4UIcmdWithoutParameter("/ebl/run/print", this);
+    fPrintCmd->SetGuidance("Print the convergence settings");
+    fPrintCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fPrintCmd->SetToBeBroadcasted(false);
+}
+
+RunControlMessenger::~RunControlMessenger()
+{
+    delete fTargetErrorCmd;
+    delete fRangeCmd;
+    delete fBatchSizeCmd;
+    delete fMaxEventsCmd;
+    delete fMaxTimeCmd;
+    delete fConvergeCmd;
+    delete fBeamOnCmd;
+    delete fCheckpointCmd;
+    delete fPrintCmd;
+    delete fRunDir;
+}
+
+void RunControlMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == fTargetErrorCmd) {
+        G4String value = newValue;
+        G4bool percent = !value.empty() && value.back() == '%';
+        if (percent) value.pop_back();
+        G4double error = G4UIcommand::ConvertToDouble(value);
+        if (percent) error /= 100.;
+        if (error < 0. || error >= 1.) {
+            G4Exception("RunControlMessenger::SetNewValue", "CONV003", JustWarning,
+                "Target error must be a fraction in [0, 1), e.g. 0.01 or 1%");
+            return;
+        }
+        fControl->SetTargetError(error);
+    }
+    else if (command == fRangeCmd) {
+        G4Tokenizer next(newValue);
+        G4double minRadius = StoD(next());
+        G4double maxRadius = StoD(next());
+        G4double unit = G4UIcommand::ValueOf(next());
+        fControl->SetRadiusRange(minRadius * unit, maxRadius * unit);
+    }
+    else if (command == fBatchSizeCmd) {
+        fControl->SetBatchSize(fBatchSizeCmd->GetNewIntValue(newValue));
+    }
+    else if (command == fMaxEventsCmd) {
+        fControl->SetMaxEvents(fMaxEventsCmd->GetNewIntValue(newValue));
+    }
+    else if (command == fMaxTimeCmd) {
+        fControl->SetMaxTime(fMaxTimeCmd->GetNewDoubleValue(newValue));
+    }
+    else if (command == fConvergeCmd) {
+        fControl->Run();
+    }
+    else if (command == fBeamOnCmd) {
+        fControl->RunEvents(fBeamOnCmd->GetNewIntValue(newValue));
+    }
+    else if (command == fCheckpointCmd) {
+        fControl->SetCheckpointDirectory(newValue);
+    }
+    else if (command == fPrintCmd) {
+        fControl->Print();
+    }
+}
@@ -0,0 +1,210 @@
+// ShotList.cc - Exposure shots as the source of primaries
+#include "ShotList.hh"
+#include "ShotMessenger.hh"
+#include "G4RunManager.hh"
+#include "G4UnitsTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+ShotList* ShotList::fInstance = nullptr;
+
+ShotList* ShotList::Instance()
+{
+    if (!fInstance) {
+        fInstance = new ShotList();
+    }
+    return fInstance;
+}
+
+ShotList::ShotList()
+    : fNumEvents(0),
+    fNumElectrons(0),
+    fDefaultElectrons(1),
+    fMaxPrimariesPerEvent(100),
+    fPixelSize(5. * nm),
+    fMargin(500. * nm),
+    fMapWidth(0),
+    fMapHeight(0),
+    fMapX0(0.),
+    fMapY0(0.),
+    fMessenger(nullptr)
+{
+    fMessenger = new ShotMessenger(this);
+}
+
+ShotList::~ShotList()
+{
+    delete fMessenger;
+}
+
+G4bool ShotList::Load(const G4String& fileName)
+{
+    std::ifstream in(fileName);
+    if (!in) {
+        G4ExceptionDescription msg;
+        msg << "Cannot read shot list " << fileName;
+        G4Exception("ShotList::Load", "SHOT001", JustWarning, msg);
+        return false;
+    }
+
+    // Streamed line by line into the compact in-memory list
+    std::vector<Shot> shots;
+    std::string line;
+    G4long lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+        std::istringstream fields(line);
+        Shot shot;
+        shot.electrons = fDefaultElectrons;
+        if (!(fields >> shot.x >> shot.y)) {
+            G4ExceptionDescription msg;
+            msg << fileName << ":" << lineNumber << ": expected x y [electrons]";
+            G4Exception("ShotList::Load", "SHOT001", JustWarning, msg);
+            return false;
+        }
+        fields >> shot.electrons;
+        if (shot.electrons <= 0) continue;
+
+        shot.x *= nm;
+        shot.y *= nm;
+        shots.push_back(shot);
+    }
+    if (shots.empty()) {
+        G4ExceptionDescription msg;
+        msg << fileName << " holds no shots";
+        G4Exception("ShotList::Load", "SHOT001", JustWarning, msg);
+        return false;
+    }
+
+    fShots.swap(shots);
+    fFileName = fileName;
+    UpdateEvents();
+    UpdateMap();
+    return true;
+}
+
+void ShotList::Clear()
+{
+    fShots.clear();
+    fFirstEvent.clear();
+    fNumEvents = 0;
+    fNumElectrons = 0;
+    fMapWidth = 0;
+    fMapHeight = 0;
+}
+
+void ShotList::SetMaxPrimariesPerEvent(G4int primaries)
+{
+    fMaxPrimariesPerEvent = primaries;
+    UpdateEvents();
+}
+
+void ShotList::SetPixelSize(G4double size)
+{
+    fPixelSize = size;
+    UpdateMap();
+}
+
+void ShotList::SetMargin(G4double margin)
+{
+    fMargin = margin;
+    UpdateMap();
+}
+
+void ShotList::UpdateEvents()
+{
+    fFirstEvent.resize(fShots.size());
+    fNumEvents = 0;
+    fNumElectrons = 0;
+    for (size_t i = 0; i < fShots.size(); i++) {
+        fFirstEvent[i] = fNumEvents;
+        fNumEvents += (fShots[i].electrons + fMaxPrimariesPerEvent - 1) / fMaxPrimariesPerEvent;
+        fNumElectrons += fShots[i].electrons;
+    }
+}
+
+void ShotList::UpdateMap()
+{
+    fMapWidth = 0;
+    fMapHeight = 0;
+    if (fShots.empty()) return;
+
+    auto xRange = std::minmax_element(fShots.begin(), fShots.end(),
+        [](const Shot& a, const Shot& b) { return a.x < b.x; });
+    auto yRange = std::minmax_element(fShots.begin(), fShots.end(),
+        [](const Shot& a, const Shot& b) { return a.y < b.y; });
+
+    fMapX0 = xRange.first->x - fMargin;
+    fMapY0 = yRange.first->y - fMargin;
+    G4double width = std::ceil((xRange.second->x + fMargin - fMapX0) / fPixelSize);
+    G4double height = std::ceil((yRange.second->y + fMargin - fMapY0) / fPixelSize);
+    width = std::max(width, 1.);
+    height = std::max(height, 1.);
+
+    if (width * height > kMaxMapBins) {
+        G4ExceptionDescription msg;
+        msg << "Dose map of " << width << " x " << height << " pixels exceeds "
+            << kMaxMapBins << "; use a larger /ebl/shots/pixel or a smaller margin";
+        G4Exception("ShotList::UpdateMap", "SHOT002", JustWarning, msg);
+        return;
+    }
+    fMapWidth = static_cast<G4int>(width);
+    fMapHeight = static_cast<G4int>(height);
+}
+
+G4int ShotList::GetEvent(G4long eventID, G4double& x, G4double& y) const
+{
+    G4long event = eventID % fNumEvents;
+    size_t shot = std::upper_bound(fFirstEvent.begin(), fFirstEvent.end(), event) - fFirstEvent.begin() - 1;
+    const Shot& entry = fShots[shot];
+    x = entry.x;
+    y = entry.y;
+
+    G4long done = (event - fFirstEvent[shot]) * fMaxPrimariesPerEvent;
+    return static_cast<G4int>(std::min<G4long>(fMaxPrimariesPerEvent, entry.electrons - done));
+}
+
+void ShotList::BeamOn()
+{
+    if (!IsActive()) {
+        G4Exception("ShotList::BeamOn", "SHOT003", JustWarning,
+            "No shot list loaded, use /ebl/shots/load first");
+        return;
+    }
+    if (fNumEvents > INT_MAX) {
+        G4Exception("ShotList::BeamOn", "SHOT003", JustWarning,
+            "Shot list needs more events than one run can hold; raise /ebl/shots/maxPerEvent");
+        return;
+    }
+
+    Print();
+    G4RunManager::GetRunManager()->BeamOn(static_cast<G4int>(fNumEvents));
+}
+
+void ShotList::Print() const
+{
+    if (!IsActive()) {
+        G4cout << "Shot list: off" << G4endl;
+        return;
+    }
+    G4cout << "Shot list " << fFileName << ": " << fShots.size() << " shots, "
+        << fNumElectrons << " electrons in " << fNumEvents << " events (up to "
+        << fMaxPrimariesPerEvent << " per event)" << G4endl;
+    G4cout << " Dose map: ";
+    if (fMapWidth == 0) {
+        G4cout << "too large" << G4endl;
+        return;
+    }
+    G4cout << fMapWidth << " x " << fMapHeight << " pixels of " << G4BestUnit(fPixelSize, "Length")
+        << " from (" << fMapX0 / nm << ", " << fMapY0 / nm << ") nm" << G4endl;
+}
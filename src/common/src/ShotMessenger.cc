@@ -0,0 +1,113 @@
+// ShotMessenger.cc
+#include "ShotMessenger.hh"
+#include "ShotList.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+ShotMessenger::ShotMessenger(ShotList* shots)
+    : G4UImessenger(),
+    fShots(shots)
+{
+    // The shot list is shared by all threads, so nothing is broadcast
+    fShotsDir = new G4UIdirectory("/ebl/shots/");
+    fShotsDir->SetGuidance("Pattern exposure from a shot list, scored in a lateral dose map");
+
+    fLoadCmd = new G4UIcmdWithAString("/ebl/shots/load", this);
+    fLoadCmd->SetGuidance("Read a shot list: one \"x y [electrons]\" line per shot, in nm.");
+    fLoadCmd->SetGuidance("Replaces the beam spot position and the radial PSF scoring");
+    fLoadCmd->SetGuidance("until /ebl/shots/clear.");
+    fLoadCmd->SetParameterName("file", false);
+    fLoadCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fLoadCmd->SetToBeBroadcasted(false);
+
+    fClearCmd = new G4UIcmdWithoutParameter("/ebl/shots/clear", this);
+    fClearCmd->SetGuidance("Drop the shot list (back to single-spot PSF runs)");
+    fClearCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fClearCmd->SetToBeBroadcasted(false);
+
+    fElectronsCmd = new G4UIcmdWithAnInteger("/ebl/shots/electrons", this);
+    fElectronsCmd->SetGuidance("Electrons of shots listed without a count (before /ebl/shots/load)");
+    fElectronsCmd->SetParameterName("electrons", false);
+    fElectronsCmd->SetRange("electrons>0");
+    fElectronsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fElectronsCmd->SetToBeBroadcasted(false);
+
+    fMaxPerEventCmd = new G4UIcmdWithAnInteger("/ebl/shots/maxPerEvent", this);
+    fMaxPerEventCmd->SetGuidance("Most primaries per event; larger shots span several events");
+    fMaxPerEventCmd->SetParameterName("primaries", false);
+    fMaxPerEventCmd->SetRange("primaries>0");
+    fMaxPerEventCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fMaxPerEventCmd->SetToBeBroadcasted(false);
+
+    fPixelCmd = new G4UIcmdWithADoubleAndUnit("/ebl/shots/pixel", this);
+    fPixelCmd->SetGuidance("Pixel size of the dose map");
+    fPixelCmd->SetParameterName("size", false);
+    fPixelCmd->SetRange("size>0.");
+    fPixelCmd->SetUnitCategory("Length");
+    fPixelCmd->SetDefaultUnit("nm");
+    fPixelCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fPixelCmd->SetToBeBroadcasted(false);
+
+    fMarginCmd = new G4UIcmdWithADoubleAndUnit("/ebl/shots/margin", this);
+    fMarginCmd->SetGuidance("Dose map margin around the shot bounding box");
+    fMarginCmd->SetParameterName("margin", false);
+    fMarginCmd->SetRange("margin>=0.");
+    fMarginCmd->SetUnitCategory("Length");
+    fMarginCmd->SetDefaultUnit("nm");
+    fMarginCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fMarginCmd->SetToBeBroadcasted(false);
+
+    fBeamOnCmd = new G4UIcmdWithoutParameter("/ebl/shots/beamOn", this);
+    fBeamOnCmd->SetGuidance("Run one pass over the shot list");
+    fBeamOnCmd->AvailableForStates(G4State_Idle);
+    fBeamOnCmd->SetToBeBroadcasted(false);
+
+    fPrintCmd = new G4UIcmdWithoutParameter("/ebl/shots/print", this);
+    fPrintCmd->SetGuidance("Print the shot list summary and dose map layout");
+    fPrintCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fPrintCmd->SetToBeBroadcasted(false);
+}
+
+ShotMessenger::~ShotMessenger()
+{
+    delete fLoadCmd;
+    delete fClearCmd;
+    delete fElectronsCmd;
+    delete fMaxPerEventCmd;
+    delete fPixelCmd;
+    delete fMarginCmd;
+    delete fBeamOnCmd;
+    delete fPrintCmd;
+    delete fShotsDir;
+}
+
+void ShotMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == fLoadCmd) {
+        if (fShots->Load(newValue)) fShots->Print();
+    }
+    else if (command == fClearCmd) {
+        fShots->Clear();
+    }
+    else if (command == fElectronsCmd) {
+        fShots->SetDefaultElectrons(fElectronsCmd->GetNewIntValue(newValue));
+    }
+    else if (command == fMaxPerEventCmd) {
+        fShots->SetMaxPrimariesPerEvent(fMaxPerEventCmd->GetNewIntValue(newValue));
+    }
+    else if (command == fPixelCmd) {
+        fShots->SetPixelSize(fPixelCmd->GetNewDoubleValue(newValue));
+    }
+    else if (command == fMarginCmd) {
+        fShots->SetMargin(fMarginCmd->GetNewDoubleValue(newValue));
+    }
+    else if (command == fBeamOnCmd) {
+        fShots->BeamOn();
+    }
+    else if (command == fPrintCmd) {
+        fShots->Print();
+    }
+}
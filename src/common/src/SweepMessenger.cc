@@ -0,0 +1,77 @@
+// SweepMessenger.cc
+#include "SweepMessenger.hh"
+#include "ParameterSweep.hh"
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4Tokenizer.hh"
+#include "G4UnitsTable.hh"
+#include <vector>
+
+SweepMessenger::SweepMessenger(ParameterSweep* sweep)
+    : G4UImessenger(),
+    fSweep(sweep)
+{
+    // The point list is shared by all threads, so nothing is broadcast
+    fSweepDir = new G4UIdirectory("/ebl/sweep/");
+    fSweepDir->SetGuidance("Parameter sweeps scored in a single run");
+
+    fEnergiesCmd = new G4UIcmdWithAString("/ebl/sweep/energies", this);
+    fEnergiesCmd->SetGuidance("Beam energies of the sweep points, followed by a unit.");
+    fEnergiesCmd->SetGuidance("Event i runs at point i % N; each point is scored and");
+    fEnergiesCmd->SetGuidance("written separately. Overrides /gun/energy until cleared.");
+    fEnergiesCmd->SetGuidance("  e.g. /ebl/sweep/energies 10 30 50 100 keV");
+    fEnergiesCmd->SetParameterName("energies", false);
+    fEnergiesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fEnergiesCmd->SetToBeBroadcasted(false);
+
+    fClearCmd = new G4UIcmdWithoutParameter("/ebl/sweep/clear", this);
+    fClearCmd->SetGuidance("Remove all sweep points (back to single-energy runs)");
+    fClearCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fClearCmd->SetToBeBroadcasted(false);
+
+    fPrintCmd = new G4UIcmdWithoutParameter("/ebl/sweep/print", this);
+    fPrintCmd->SetGuidance("Print the sweep points");
+    fPrintCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+    fPrintCmd->SetToBeBroadcasted(false);
+}
+
+SweepMessenger::~SweepMessenger()
+{
+    delete fEnergiesCmd;
+    delete fClearCmd;
+    delete fPrintCmd;
+    delete fSweepDir;
+}
+
+void SweepMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == fEnergiesCmd) {
+        // Values first, the unit last
+        std::vector<G4String> tokens;
+        G4Tokenizer next(newValue);
+        for (G4String token = next(); !token.empty(); token = next()) {
+            tokens.push_back(token);
+        }
+        if (tokens.size() < 2 || !G4UnitDefinition::IsUnitDefined(tokens.back()) ||
+            G4UnitDefinition::GetCategory(tokens.back()) != "Energy") {
+            G4Exception("SweepMessenger::SetNewValue", "SWEEP003", JustWarning,
+                "Usage: /ebl/sweep/energies <E1> <E2> ... <unit>");
+            return;
+        }
+        G4double unit = G4UIcommand::ValueOf(tokens.back());
+        std::vector<G4double> energies;
+        for (size_t i = 0; i + 1 < tokens.size(); ++i) {
+            energies.push_back(G4UIcommand::ConvertToDouble(tokens[i]) * unit);
+        }
+        fSweep->SetEnergies(energies);
+        fSweep->Print();
+    }
+    else if (command == fClearCmd) {
+        fSweep->Clear();
+    }
+    else if (command == fPrintCmd) {
+        fSweep->Print();
+    }
+}
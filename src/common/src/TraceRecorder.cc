@@ -0,0 +1,156 @@
+// TraceRecorder.cc - Phase timers and Chrome-trace export
+#include "TraceRecorder.hh"
+#include "G4VStateDependent.hh"
+#include "G4StateManager.hh"
+#include "G4Threading.hh"
+#include "G4ios.hh"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <set>
+
+namespace {
+    // /run/initialize enters G4State_Init from PreInit; the initialization
+    // of every run (region update, physics tables) enters it from Idle
+    class InitStateObserver : public G4VStateDependent {
+    public:
+        explicit InitStateObserver(TraceRecorder* recorder)
+            : fRecorder(recorder), fFromIdle(false) {}
+
+        G4bool Notify(G4ApplicationState requestedState) override
+        {
+            G4ApplicationState current = G4StateManager::GetStateManager()->GetCurrentState();
+            if (requestedState == G4State_Init && current != G4State_Init) {
+                fFromIdle = current == G4State_Idle;
+                fStart = TraceRecorder::Clock::now();
+            }
+            else if (current == G4State_Init && requestedState != G4State_Init &&
+                     fRecorder->IsEnabled()) {
+                fRecorder->AddSpan(fFromIdle ? "run initialization" : "initialize",
+                                   fStart, TraceRecorder::Clock::now());
+            }
+            return true;
+        }
+
+    private:
+        TraceRecorder* fRecorder;
+        G4bool fFromIdle;
+        TraceRecorder::Clock::time_point fStart;
+    };
+
+    // Chrome trace timestamps and durations
+    G4double Microseconds(G4double seconds)
+    {
+        return 1e6 * seconds;
+    }
+}
+
+TraceRecorder* TraceRecorder::fInstance = nullptr;
+
+TraceRecorder* TraceRecorder::Instance()
+{
+    if (!fInstance) {
+        fInstance = new TraceRecorder();
+    }
+    return fInstance;
+}
+
+TraceRecorder::TraceRecorder()
+    : fOrigin(Clock::now()),
+    fEnabled(false),
+    fStateObserver(nullptr)
+{
+    fStateObserver = new InitStateObserver(this);
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    delete fStateObserver;
+}
+
+void TraceRecorder::AddSpan(const char* name, Clock::time_point start, Clock::time_point end,
+                            G4long events)
+{
+    Span span;
+    span.name = name;
+    span.thread = G4Threading::G4GetThreadId() + 1;
+    span.start = std::chrono::duration<G4double>(start - fOrigin).count();
+    span.duration = std::chrono::duration<G4double>(end - start).count();
+    span.events = events;
+
+    std::lock_guard<std::mutex> lock(fMutex);
+    fSpans.push_back(span);
+}
+
+void TraceRecorder::PrintPhases(std::ostream& out) const
+{
+    struct Phase {
+        const char* name;
+        G4bool workers;
+        G4int calls;
+        G4double total;
+        G4double longest;
+    };
+
+    // In order of first occurrence
+    std::vector<Phase> phases;
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        for (const Span& span : fSpans) {
+            G4bool workers = span.thread > 0;
+            auto it = std::find_if(phases.begin(), phases.end(), [&](const Phase& phase) {
+                return phase.workers == workers && std::strcmp(phase.name, span.name) == 0;
+            });
+            if (it == phases.end()) {
+                phases.push_back({ span.name, workers, 0, 0., 0. });
+                it = phases.end() - 1;
+            }
+            it->calls++;
+            it->total += span.duration;
+            it->longest = std::max(it->longest, span.duration);
+        }
+    }
+
+    out << std::left << std::setw(22) << "Phase" << std::setw(9) << "Thread"
+        << std::right << std::setw(7) << "Calls" << std::setw(12) << "Total (s)"
+        << std::setw(12) << "Max (s)" << std::endl;
+    for (const Phase& phase : phases) {
+        out << std::left << std::setw(22) << phase.name
+            << std::setw(9) << (phase.workers ? "workers" : "master")
+            << std::right << std::setw(7) << phase.calls
+            << std::fixed << std::setprecision(3)
+            << std::setw(12) << phase.total << std::setw(12) << phase.longest
+            << std::defaultfloat << std::endl;
+    }
+}
+
+void TraceRecorder::WriteChromeTrace(std::ostream& json) const
+{
+    std::lock_guard<std::mutex> lock(fMutex);
+
+    json << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    std::set<G4int> threads;
+    G4bool first = true;
+    for (const Span& span : fSpans) {
+        threads.insert(span.thread);
+        json << (first ? "\n" : ",\n") << "{\"name\": \"" << span.name
+            << "\", \"cat\": \"ebl\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << span.thread
+            << ", \"ts\": " << std::fixed << std::setprecision(1) << Microseconds(span.start)
+            << ", \"dur\": " << Microseconds(span.duration) << std::defaultfloat;
+        if (span.events >= 0) json << ", \"args\": {\"events\": " << span.events << "}";
+        json << "}";
+        first = false;
+    }
+
+    // Thread names, master first
+    for (G4int thread : threads) {
+        json << (first ? "\n" : ",\n")
+            << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread
+            << ", \"args\": {\"name\": \"";
+        if (thread == 0) json << "master";
+        else json << "worker " << thread - 1;
+        json << "\"}}";
+        first = false;
+    }
+    json << "\n]}\n";
+}
@@ -0,0 +1,35 @@
+// DoseMapFile.hh - Dose map output as a NumPy .npy array
+#ifndef DoseMapFile_h
+#define DoseMapFile_h 1
+
+#include "globals.hh"
+#include <fstream>
+#include <vector>
+
+// float32 array of shape (height, width), written row by row as the
+// exposure engine produces them, so numpy.load (or numpy.memmap with the
+// header offset) reads it directly.
+class DoseMapFile {
+public:
+    DoseMapFile();
+    ~DoseMapFile() = default;
+
+    G4bool Open(const G4String& fileName, G4int width, G4int height);
+    // values are divided by unit before conversion to float
+    G4bool WriteRow(const std::vector<G4double>& row, G4double unit);
+    // false if fewer rows than the declared height were written
+    G4bool Close();
+
+    G4double GetMaximum() const { return fMaximum; }
+
+private:
+    std::ofstream fOut;
+    G4String fFileName;
+    G4int fWidth;
+    G4int fHeight;
+    G4int fRows;
+    G4double fMaximum;
+    std::vector<float> fBuffer;
+};
+
+#endif
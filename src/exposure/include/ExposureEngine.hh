@@ -0,0 +1,62 @@
+// ExposureEngine.hh - Dose maps by FFT convolution of a pattern with the PSF
+#ifndef ExposureEngine_h
+#define ExposureEngine_h 1
+
+#include "globals.hh"
+#include "FFT2D.hh"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class ExposureKernel;
+class PatternSource;
+
+// Convolves a pattern with an ExposureKernel by overlap-add: the pattern is
+// cut into T x T tiles, each zero-padded to the FFT size N = T + 2h
+// (h = kernel half width) so the circular convolution does not wrap, and
+// the N x N results are added into a band of T + 2h rows. Once a strip of
+// tiles is done, the first T rows of the band are final and go to the
+// sink; memory is O(N^2 per thread + field width x N), independent of the
+// field height. Tiles of a strip are shared out to the worker threads;
+// tiles without exposed pixels are skipped.
+class ExposureEngine {
+public:
+    // Called with each dose map row, top to bottom; return false to abort
+    using RowSink = std::function<G4bool(const std::vector<G4double>& row)>;
+
+    // fftSize 0 picks a power of two of at least twice the kernel width;
+    // numThreads 0 uses one thread per hardware thread
+    ExposureEngine(const ExposureKernel& kernel, G4int fftSize = 0, G4int numThreads = 0);
+    ~ExposureEngine();
+
+    // FFT size the engine uses: fftSize if valid for the kernel, otherwise
+    // (0, or invalid with a warning) the default of the constructor
+    static G4int ChooseFFTSize(const ExposureKernel& kernel, G4int fftSize);
+
+    // Bytes a Run needs: the kernel spectrum, the strip and the band of a
+    // field of the given width, plus one tile buffer per thread
+    static std::size_t GetSharedMemory(G4int fftSize, G4int halfWidth, G4int fieldWidth);
+    static std::size_t GetThreadMemory(G4int fftSize);
+
+    G4int GetFFTSize() const { return fFFT->GetSize(); }
+    G4int GetTileSize() const { return fTileSize; }
+    G4int GetNumberOfThreads() const { return fNumThreads; }
+
+    // Map value = sum over pattern pixels of relative dose * scale * kernel;
+    // with scale = primaries per pixel at the nominal dose this is the
+    // energy deposited per map pixel. Returns false if the sink aborted.
+    G4bool Run(PatternSource& pattern, G4double scale, const RowSink& sink);
+
+private:
+    void ConvolveTile(const std::vector<G4double>& strip, G4int width, G4int x0,
+                      G4double scale, std::vector<FFT2D::Complex>& buffer) const;
+
+    G4int fHalfWidth;
+    G4int fTileSize;
+    G4int fNumThreads;
+    std::unique_ptr<FFT2D> fFFT;
+    std::vector<FFT2D::Complex> fKernelSpectrum;    // transposed, see FFT2D
+};
+
+#endif
@@ -0,0 +1,45 @@
+// ExposureKernel.hh - Pixelated 2D kernel of a radial PSF
+#ifndef ExposureKernel_h
+#define ExposureKernel_h 1
+
+#include "globals.hh"
+#include <vector>
+
+class PSFResultFile;
+
+// The PSF of one sweep point of a PSFResultFile laid out on a square pixel
+// grid centred on the beam: each pixel holds the energy deposited in it
+// per primary electron (internal energy units). The radial density is
+// constant within a PSF bin, so pixels are integrated by subsampling them
+// finely enough to resolve the (log) bins they cross; the kernel is then
+// rescaled to the exact PSF energy inside its radius.
+class ExposureKernel {
+public:
+    ExposureKernel();
+    ~ExposureKernel() = default;
+
+    // radius <= 0 (or beyond the PSF) takes the outer PSF edge; returns
+    // false if the point has no events or the pixel size is not positive
+    G4bool Build(const PSFResultFile& result, G4int point, G4double pixelSize, G4double radius);
+
+    // Kernel pixels run from -halfWidth to +halfWidth in x and y
+    G4int GetHalfWidth() const { return fHalfWidth; }
+    G4int GetWidth() const { return 2 * fHalfWidth + 1; }
+    G4double GetPixelSize() const { return fPixelSize; }
+    G4double GetRadius() const { return fRadius; }
+    G4double At(G4int i, G4int j) const {
+        return fValues[static_cast<size_t>(j + fHalfWidth) * GetWidth() + (i + fHalfWidth)];
+    }
+
+    // Energy per primary inside the kernel radius
+    G4double GetTotal() const { return fTotal; }
+
+private:
+    G4int fHalfWidth;
+    G4double fPixelSize;
+    G4double fRadius;
+    G4double fTotal;
+    std::vector<G4double> fValues;
+};
+
+#endif
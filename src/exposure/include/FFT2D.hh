@@ -0,0 +1,44 @@
+// FFT2D.hh - Square 2D FFT for the exposure convolution
+#ifndef FFT2D_h
+#define FFT2D_h 1
+
+#include "globals.hh"
+#include <complex>
+#include <vector>
+
+// Radix-2 complex FFT of an N x N array (N a power of two), row-major.
+// Both passes run over contiguous rows with a transpose in between, so a
+// forward transform leaves the spectrum transposed. Inverse() takes that
+// layout back to the original one; spectra that are only multiplied
+// element-wise (the convolution) never need the extra transposes.
+//
+// The tables are built once; Forward/Inverse are const and can be called
+// from several threads on separate arrays.
+class FFT2D {
+public:
+    using Complex = std::complex<G4double>;
+
+    explicit FFT2D(G4int n);
+    ~FFT2D() = default;
+
+    G4int GetSize() const { return fN; }
+
+    // data: N*N values; Forward leaves the spectrum transposed
+    void Forward(std::vector<Complex>& data) const;
+    // Inverse of Forward, including the 1/N^2 normalization
+    void Inverse(std::vector<Complex>& data) const;
+
+    static G4bool IsPowerOfTwo(G4int n) { return n > 1 && (n & (n - 1)) == 0; }
+    static G4int NextPowerOfTwo(G4int n);
+
+private:
+    void TransformRows(std::vector<Complex>& data, G4bool inverse) const;
+    void TransformRow(Complex* row, G4bool inverse) const;
+    void Transpose(std::vector<Complex>& data) const;
+
+    G4int fN;
+    std::vector<G4int> fBitReverse;
+    std::vector<Complex> fTwiddles;     // exp(-2 pi i k / N), k < N/2
+};
+
+#endif
@@ -0,0 +1,80 @@
+// PatternSource.hh - Rasterised exposure patterns, read strip by strip
+#ifndef PatternSource_h
+#define PatternSource_h 1
+
+#include "globals.hh"
+#include <fstream>
+#include <vector>
+
+// A pattern is a grid of pixels holding the relative dose (1 = the nominal
+// dose, 0 = unexposed). Sources hand out consecutive rows, so a field only
+// has to fit in memory one strip at a time. Row 0 of the dose map is row 0
+// of the pattern.
+class PatternSource {
+public:
+    virtual ~PatternSource() = default;
+
+    virtual G4int GetWidth() const = 0;
+    virtual G4int GetHeight() const = 0;
+
+    // The next nRows rows, row-major; rows past the end are zero
+    virtual void ReadRows(G4int nRows, std::vector<G4double>& rows) = 0;
+};
+
+// Netpbm bitmap: PBM (P1/P4, 1 = exposed) or PGM (P2/P5, grey level /
+// maxval = relative dose), one pixel per pattern pixel, top row first
+class BitmapPattern : public PatternSource {
+public:
+    BitmapPattern();
+
+    G4bool Open(const G4String& fileName);
+
+    G4int GetWidth() const override { return fWidth; }
+    G4int GetHeight() const override { return fHeight; }
+    void ReadRows(G4int nRows, std::vector<G4double>& rows) override;
+
+private:
+    G4bool ReadHeaderValue(G4int& value);
+    G4bool ReadRow(G4double* row);
+
+    std::ifstream fIn;
+    G4int fFormat;          // 1, 2, 4 or 5 as in the magic number
+    G4int fWidth;
+    G4int fHeight;
+    G4int fMaxValue;
+    G4int fNextRow;
+    std::vector<unsigned char> fRowBytes;
+};
+
+// Rectangle list, one "x0 y0 x1 y1 [relative dose]" line per shape in nm
+// ('#' starts a comment). The field is the bounding box grown by a margin;
+// pixels are weighted by the area the rectangles cover, and overlapping
+// rectangles add up. Row 0 is at the smallest y.
+class RectanglePattern : public PatternSource {
+public:
+    RectanglePattern();
+
+    G4bool Open(const G4String& fileName, G4double pixelSize, G4double margin);
+
+    G4int GetWidth() const override { return fWidth; }
+    G4int GetHeight() const override { return fHeight; }
+    void ReadRows(G4int nRows, std::vector<G4double>& rows) override;
+
+    size_t GetNumberOfRectangles() const { return fRectangles.size(); }
+
+private:
+    // Corners in pixel units relative to the field origin
+    struct Rectangle {
+        G4double x0, y0, x1, y1;
+        G4double dose;
+    };
+
+    std::vector<Rectangle> fRectangles;     // sorted by y0
+    std::vector<size_t> fActive;            // overlapping the rows read last
+    size_t fNextRectangle;
+    G4int fWidth;
+    G4int fHeight;
+    G4int fNextRow;
+};
+
+#endif
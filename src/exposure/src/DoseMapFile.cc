@@ -0,0 +1,72 @@
+// DoseMapFile.cc - Dose map output as a NumPy .npy array
+#include "DoseMapFile.hh"
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+DoseMapFile::DoseMapFile()
+    : fWidth(0),
+    fHeight(0),
+    fRows(0),
+    fMaximum(0.)
+{
+}
+
+G4bool DoseMapFile::Open(const G4String& fileName, G4int width, G4int height)
+{
+    fOut.open(fileName, std::ios::binary);
+    if (!fOut) {
+        G4ExceptionDescription msg;
+        msg << "Cannot write dose map to " << fileName;
+        G4Exception("DoseMapFile::Open", "EXPO007", JustWarning, msg);
+        return false;
+    }
+    fFileName = fileName;
+    fWidth = width;
+    fHeight = height;
+    fRows = 0;
+    fMaximum = 0.;
+    fBuffer.resize(width);
+
+    // .npy version 1.0: magic, header length, Python dict literal padded
+    // with spaces to a 64-byte boundary and ended by a newline
+    std::ostringstream dict;
+    dict << "{'descr': '<f4', 'fortran_order': False, 'shape': (" << height << ", " << width << "), }";
+    std::string header = dict.str();
+    const size_t prefix = 10;
+    size_t padded = (prefix + header.size() + 1 + 63) / 64 * 64;
+    header.append(padded - prefix - header.size() - 1, ' ');
+    header.push_back('\n');
+
+    const unsigned short length = static_cast<unsigned short>(header.size());
+    const char magic[8] = { '\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0 };
+    const char lengthBytes[2] = { static_cast<char>(length & 0xff), static_cast<char>(length >> 8) };
+    fOut.write(magic, sizeof(magic));
+    fOut.write(lengthBytes, sizeof(lengthBytes));
+    fOut.write(header.data(), header.size());
+    return static_cast<G4bool>(fOut);
+}
+
+G4bool DoseMapFile::WriteRow(const std::vector<G4double>& row, G4double unit)
+{
+    for (G4int x = 0; x < fWidth; x++) {
+        G4double value = row[x] / unit;
+        fMaximum = std::max(fMaximum, value);
+        fBuffer[x] = static_cast<float>(value);
+    }
+    fOut.write(reinterpret_cast<const char*>(fBuffer.data()), fBuffer.size() * sizeof(float));
+    fRows++;
+    return static_cast<G4bool>(fOut);
+}
+
+G4bool DoseMapFile::Close()
+{
+    fOut.close();
+    if (fRows != fHeight || !fOut) {
+        G4ExceptionDescription msg;
+        msg << "Dose map " << fFileName << " is incomplete (" << fRows << " of " << fHeight << " rows)";
+        G4Exception("DoseMapFile::Close", "EXPO007", JustWarning, msg);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,167 @@
+// ExposureEngine.cc - Dose maps by FFT convolution of a pattern with the PSF
+#include "ExposureEngine.hh"
+#include "ExposureKernel.hh"
+#include "PatternSource.hh"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+ExposureEngine::ExposureEngine(const ExposureKernel& kernel, G4int fftSize, G4int numThreads)
+    : fHalfWidth(kernel.GetHalfWidth()),
+    fTileSize(0),
+    fNumThreads(numThreads)
+{
+    fftSize = ChooseFFTSize(kernel, fftSize);
+    fFFT = std::make_unique<FFT2D>(fftSize);
+    fTileSize = fftSize - 2 * fHalfWidth;
+
+    if (fNumThreads <= 0) {
+        fNumThreads = std::max(1, static_cast<G4int>(std::thread::hardware_concurrency()));
+    }
+
+    // Kernel centred on (0, 0) with negative offsets wrapped around
+    const G4int n = fftSize;
+    fKernelSpectrum.assign(static_cast<size_t>(n) * n, FFT2D::Complex(0., 0.));
+    for (G4int j = -fHalfWidth; j <= fHalfWidth; j++) {
+        for (G4int i = -fHalfWidth; i <= fHalfWidth; i++) {
+            fKernelSpectrum[static_cast<size_t>((j + n) % n) * n + (i + n) % n] = kernel.At(i, j);
+        }
+    }
+    fFFT->Forward(fKernelSpectrum);
+}
+
+ExposureEngine::~ExposureEngine()
+{
+}
+
+G4int ExposureEngine::ChooseFFTSize(const ExposureKernel& kernel, G4int fftSize)
+{
+    const G4int halfWidth = kernel.GetHalfWidth();
+    const G4int minSize = std::max(FFT2D::NextPowerOfTwo(2 * kernel.GetWidth()), 256);
+    if (fftSize != 0 && (!FFT2D::IsPowerOfTwo(fftSize) || fftSize <= 2 * halfWidth)) {
+        G4ExceptionDescription msg;
+        msg << "FFT size " << fftSize << " is not a power of two above twice the kernel half width ("
+            << 2 * halfWidth << "); using " << minSize;
+        G4Exception("ExposureEngine::ChooseFFTSize", "EXPO006", JustWarning, msg);
+        fftSize = 0;
+    }
+    return fftSize == 0 ? minSize : fftSize;
+}
+
+std::size_t ExposureEngine::GetSharedMemory(G4int fftSize, G4int halfWidth, G4int fieldWidth)
+{
+    const std::size_t n = fftSize;
+    const std::size_t tile = fftSize - 2 * halfWidth;
+    const std::size_t width = fieldWidth;
+    const std::size_t spectrum = n * n * sizeof(FFT2D::Complex);
+    const std::size_t band = (width + 2 * halfWidth) * (tile + 2 * halfWidth) * sizeof(G4double);
+    const std::size_t strip = (width * tile + width) * sizeof(G4double);
+    return spectrum + band + strip;
+}
+
+std::size_t ExposureEngine::GetThreadMemory(G4int fftSize)
+{
+    return static_cast<std::size_t>(fftSize) * fftSize * sizeof(FFT2D::Complex);
+}
+
+void ExposureEngine::ConvolveTile(const std::vector<G4double>& strip, G4int width, G4int x0,
+                                  G4double scale, std::vector<FFT2D::Complex>& buffer) const
+{
+    const G4int n = fFFT->GetSize();
+    const G4int columns = std::min(fTileSize, width - x0);
+    std::fill(buffer.begin(), buffer.end(), FFT2D::Complex(0., 0.));
+    for (G4int y = 0; y < fTileSize; y++) {
+        const G4double* row = &strip[static_cast<size_t>(y) * width + x0];
+        for (G4int x = 0; x < columns; x++) {
+            buffer[static_cast<size_t>(y) * n + x] = row[x] * scale;
+        }
+    }
+
+    fFFT->Forward(buffer);
+    for (size_t i = 0; i < buffer.size(); i++) {
+        buffer[i] *= fKernelSpectrum[i];
+    }
+    fFFT->Inverse(buffer);
+}
+
+G4bool ExposureEngine::Run(PatternSource& pattern, G4double scale, const RowSink& sink)
+{
+    const G4int width = pattern.GetWidth();
+    const G4int height = pattern.GetHeight();
+    const G4int n = fFFT->GetSize();
+    const G4int h = fHalfWidth;
+    const G4int tile = fTileSize;
+    const G4int tilesPerStrip = (width + tile - 1) / tile;
+
+    // Band row r is map row (stripY - h + r), band column c map column c - h
+    const G4int bandWidth = width + 2 * h;
+    const G4int bandHeight = tile + 2 * h;
+    std::vector<G4double> band(static_cast<size_t>(bandWidth) * bandHeight, 0.);
+    std::vector<G4double> strip;
+    std::vector<G4double> row(width);
+    std::mutex bandMutex;
+
+    auto emitRows = [&](G4int bandRows, G4int stripY) {
+        for (G4int r = 0; r < bandRows; r++) {
+            G4int y = stripY - h + r;
+            if (y < 0 || y >= height) continue;
+            const G4double* source = &band[static_cast<size_t>(r) * bandWidth + h];
+            std::copy(source, source + width, row.begin());
+            if (!sink(row)) return false;
+        }
+        return true;
+    };
+
+    G4int stripY = 0;
+    for (; stripY < height; stripY += tile) {
+        pattern.ReadRows(tile, strip);
+
+        std::atomic<G4int> nextTile(0);
+        auto worker = [&]() {
+            std::vector<FFT2D::Complex> buffer(static_cast<size_t>(n) * n);
+            for (G4int t = nextTile++; t < tilesPerStrip; t = nextTile++) {
+                const G4int x0 = t * tile;
+                const G4int columns = std::min(tile, width - x0);
+                G4bool exposed = false;
+                for (G4int y = 0; y < tile && !exposed; y++) {
+                    const G4double* source = &strip[static_cast<size_t>(y) * width + x0];
+                    exposed = std::any_of(source, source + columns, [](G4double v) { return v != 0.; });
+                }
+                if (!exposed) continue;
+
+                ConvolveTile(strip, width, x0, scale, buffer);
+
+                // Output pixels of this tile reach h beyond it on every side
+                std::lock_guard<std::mutex> lock(bandMutex);
+                const G4int cEnd = std::min(tile + h, width + h - x0);
+                for (G4int r = -h; r < tile + h; r++) {
+                    const FFT2D::Complex* source = &buffer[static_cast<size_t>((r + n) % n) * n];
+                    G4double* target = &band[static_cast<size_t>(r + h) * bandWidth + x0 + h];
+                    for (G4int c = -h; c < cEnd; c++) {
+                        target[c] += source[(c + n) % n].real();
+                    }
+                }
+            }
+        };
+
+        const G4int threads = std::min(fNumThreads, tilesPerStrip);
+        if (threads <= 1) {
+            worker();
+        }
+        else {
+            std::vector<std::thread> pool;
+            for (G4int i = 0; i < threads; i++) pool.emplace_back(worker);
+            for (std::thread& thread : pool) thread.join();
+        }
+
+        // Map rows up to stripY + tile - h have all their contributions
+        if (!emitRows(tile, stripY)) return false;
+
+        // The last 2h rows carry over to the next strip
+        std::copy(band.begin() + static_cast<size_t>(tile) * bandWidth, band.end(), band.begin());
+        std::fill(band.begin() + static_cast<size_t>(2 * h) * bandWidth, band.end(), 0.);
+    }
+
+    return emitRows(2 * h, stripY);
+}
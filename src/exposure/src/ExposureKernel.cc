@@ -0,0 +1,101 @@
+// ExposureKernel.cc - Pixelated 2D kernel of a radial PSF
+#include "ExposureKernel.hh"
+#include "PSFResultFile.hh"
+#include "G4PhysicalConstants.hh"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Subsamples per pixel side are chosen to give about two per radial bin
+    // width, up to this limit
+    const G4int kMaxSubsamples = 32;
+}
+
+ExposureKernel::ExposureKernel()
+    : fHalfWidth(0),
+    fPixelSize(0.),
+    fRadius(0.),
+    fTotal(0.)
+{
+}
+
+G4bool ExposureKernel::Build(const PSFResultFile& result, G4int point, G4double pixelSize, G4double radius)
+{
+    const PSFBinning& binning = result.GetBinning();
+    const G4long events = result.GetEvents(point);
+    if (events <= 0 || pixelSize <= 0.) {
+        G4Exception("ExposureKernel::Build", "EXPO002", JustWarning,
+            "PSF point without events or non-positive pixel size");
+        return false;
+    }
+
+    fPixelSize = pixelSize;
+    fRadius = (radius > 0. && radius < binning.GetMaxRadius()) ? radius : binning.GetMaxRadius();
+    fHalfWidth = static_cast<G4int>(std::ceil(fRadius / pixelSize));
+    const G4int width = GetWidth();
+    fValues.assign(static_cast<size_t>(width) * width, 0.);
+
+    // Density per primary of every bin, and the exact energy inside the
+    // kernel radius (the bin holding the radius only partly)
+    const G4int nBins = binning.GetNumberOfBins();
+    std::vector<G4double> density(nBins);
+    fTotal = 0.;
+    for (G4int b = 0; b < nBins; b++) {
+        G4double energy = result.GetSum(point, b) / events;
+        density[b] = energy / binning.GetArea(b);
+        if (binning.GetUpperEdge(b) <= fRadius) {
+            fTotal += energy;
+        }
+        else if (binning.GetLowerEdge(b) < fRadius) {
+            G4double lower = binning.GetLowerEdge(b);
+            fTotal += density[b] * pi * (fRadius * fRadius - lower * lower);
+        }
+    }
+
+    // One quadrant, mirrored; the radial PSF is symmetric
+    const G4double radius2 = fRadius * fRadius;
+    G4double sum = 0.;
+    for (G4int j = 0; j <= fHalfWidth; j++) {
+        for (G4int i = 0; i <= fHalfWidth; i++) {
+            G4double dx = std::max(0., (i - 0.5) * pixelSize);
+            G4double dy = std::max(0., (j - 0.5) * pixelSize);
+            G4double nearest2 = dx * dx + dy * dy;
+            if (nearest2 >= radius2) continue;
+
+            G4int bin = binning.FindBinSquared(nearest2);
+            if (bin < 0) continue;
+            G4double binWidth = binning.GetUpperEdge(bin) - binning.GetLowerEdge(bin);
+            G4int samples = static_cast<G4int>(std::ceil(2. * pixelSize / binWidth));
+            samples = std::min(std::max(samples, 1), kMaxSubsamples);
+
+            const G4double step = pixelSize / samples;
+            G4double energy = 0.;
+            for (G4int sy = 0; sy < samples; sy++) {
+                G4double y = (j - 0.5) * pixelSize + (sy + 0.5) * step;
+                for (G4int sx = 0; sx < samples; sx++) {
+                    G4double x = (i - 0.5) * pixelSize + (sx + 0.5) * step;
+                    G4double r2 = x * x + y * y;
+                    if (r2 >= radius2) continue;
+                    G4int b = binning.FindBinSquared(r2);
+                    if (b >= 0) energy += density[b];
+                }
+            }
+            energy *= step * step;
+
+            // Axis pixels are shared by two (the centre by four) quadrants
+            G4int copies = (i == 0 ? 1 : 2) * (j == 0 ? 1 : 2);
+            sum += copies * energy;
+            for (G4int mx : { i, -i }) {
+                for (G4int my : { j, -j }) {
+                    fValues[static_cast<size_t>(my + fHalfWidth) * width + (mx + fHalfWidth)] = energy;
+                }
+            }
+        }
+    }
+
+    if (sum > 0.) {
+        const G4double scale = fTotal / sum;
+        for (G4double& value : fValues) value *= scale;
+    }
+    return true;
+}
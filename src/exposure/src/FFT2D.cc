@@ -0,0 +1,104 @@
+// FFT2D.cc - Square 2D FFT for the exposure convolution
+#include "FFT2D.hh"
+#include "G4PhysicalConstants.hh"
+#include <algorithm>
+#include <cmath>
+
+FFT2D::FFT2D(G4int n)
+    : fN(n)
+{
+    if (!IsPowerOfTwo(n)) {
+        G4ExceptionDescription msg;
+        msg << "FFT size " << n << " is not a power of two";
+        G4Exception("FFT2D::FFT2D", "EXPO001", FatalErrorInArgument, msg);
+        return;
+    }
+
+    G4int bits = 0;
+    while ((1 << bits) < n) ++bits;
+    fBitReverse.resize(n);
+    for (G4int i = 0; i < n; i++) {
+        G4int reversed = 0;
+        for (G4int b = 0; b < bits; b++) {
+            if (i & (1 << b)) reversed |= 1 << (bits - 1 - b);
+        }
+        fBitReverse[i] = reversed;
+    }
+
+    fTwiddles.resize(n / 2);
+    for (G4int k = 0; k < n / 2; k++) {
+        G4double phase = -twopi * k / n;
+        fTwiddles[k] = Complex(std::cos(phase), std::sin(phase));
+    }
+}
+
+G4int FFT2D::NextPowerOfTwo(G4int n)
+{
+    G4int size = 2;
+    while (size < n) size <<= 1;
+    return size;
+}
+
+void FFT2D::Forward(std::vector<Complex>& data) const
+{
+    TransformRows(data, false);
+    Transpose(data);
+    TransformRows(data, false);
+}
+
+void FFT2D::Inverse(std::vector<Complex>& data) const
+{
+    TransformRows(data, true);
+    Transpose(data);
+    TransformRows(data, true);
+
+    const G4double scale = 1. / (static_cast<G4double>(fN) * fN);
+    for (Complex& value : data) value *= scale;
+}
+
+void FFT2D::TransformRows(std::vector<Complex>& data, G4bool inverse) const
+{
+    for (G4int row = 0; row < fN; row++) {
+        TransformRow(&data[static_cast<size_t>(row) * fN], inverse);
+    }
+}
+
+void FFT2D::TransformRow(Complex* row, G4bool inverse) const
+{
+    for (G4int i = 0; i < fN; i++) {
+        G4int j = fBitReverse[i];
+        if (i < j) std::swap(row[i], row[j]);
+    }
+
+    for (G4int length = 2; length <= fN; length <<= 1) {
+        const G4int half = length / 2;
+        const G4int step = fN / length;
+        for (G4int start = 0; start < fN; start += length) {
+            for (G4int k = 0; k < half; k++) {
+                Complex w = inverse ? std::conj(fTwiddles[k * step]) : fTwiddles[k * step];
+                Complex u = row[start + k];
+                Complex v = row[start + k + half] * w;
+                row[start + k] = u + v;
+                row[start + k + half] = u - v;
+            }
+        }
+    }
+}
+
+void FFT2D::Transpose(std::vector<Complex>& data) const
+{
+    // Blocked in-place swap across the diagonal
+    const G4int block = 32;
+    for (G4int i0 = 0; i0 < fN; i0 += block) {
+        for (G4int j0 = i0; j0 < fN; j0 += block) {
+            const G4int iEnd = std::min(i0 + block, fN);
+            const G4int jEnd = std::min(j0 + block, fN);
+            for (G4int i = i0; i < iEnd; i++) {
+                for (G4int j = (i0 == j0 ? i + 1 : j0); j < jEnd; j++) {
+                    std::swap(data[static_cast<size_t>(i) * fN + j],
+                              data[static_cast<size_t>(j) * fN + i]);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,242 @@
+// PatternSource.cc - Rasterised exposure patterns, read strip by strip
+#include "PatternSource.hh"
+#include "G4SystemOfUnits.hh"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <sstream>
+#include <string>
+
+BitmapPattern::BitmapPattern()
+    : fFormat(0),
+    fWidth(0),
+    fHeight(0),
+    fMaxValue(1),
+    fNextRow(0)
+{
+}
+
+G4bool BitmapPattern::Open(const G4String& fileName)
+{
+    fIn.open(fileName, std::ios::binary);
+    char magic[2] = { 0, 0 };
+    if (!fIn || !fIn.read(magic, 2) || magic[0] != 'P' ||
+        (magic[1] != '1' && magic[1] != '2' && magic[1] != '4' && magic[1] != '5')) {
+        G4ExceptionDescription msg;
+        msg << fileName << " is not a PBM or PGM bitmap";
+        G4Exception("BitmapPattern::Open", "EXPO003", JustWarning, msg);
+        return false;
+    }
+    fFormat = magic[1] - '0';
+
+    G4bool grey = (fFormat == 2 || fFormat == 5);
+    if (!ReadHeaderValue(fWidth) || !ReadHeaderValue(fHeight) ||
+        (grey && !ReadHeaderValue(fMaxValue)) ||
+        fWidth <= 0 || fHeight <= 0 || fMaxValue <= 0 || fMaxValue > 65535) {
+        G4ExceptionDescription msg;
+        msg << "Bad bitmap header in " << fileName;
+        G4Exception("BitmapPattern::Open", "EXPO003", JustWarning, msg);
+        return false;
+    }
+
+    // A single whitespace character separates the header from binary data
+    if (fFormat == 4 || fFormat == 5) fIn.get();
+
+    if (fFormat == 4) fRowBytes.resize((fWidth + 7) / 8);
+    if (fFormat == 5) fRowBytes.resize(static_cast<size_t>(fWidth) * (fMaxValue > 255 ? 2 : 1));
+    fNextRow = 0;
+    return true;
+}
+
+G4bool BitmapPattern::ReadHeaderValue(G4int& value)
+{
+    // Whitespace and '#' comments may appear between header fields
+    G4int c = fIn.get();
+    while (c != EOF && (std::isspace(c) || c == '#')) {
+        if (c == '#') {
+            while (c != EOF && c != '\n') c = fIn.get();
+        }
+        c = fIn.get();
+    }
+    if (c == EOF || !std::isdigit(c)) return false;
+
+    value = 0;
+    while (c != EOF && std::isdigit(c)) {
+        value = value * 10 + (c - '0');
+        c = fIn.get();
+    }
+    if (c != EOF) fIn.unget();
+    return true;
+}
+
+G4bool BitmapPattern::ReadRow(G4double* row)
+{
+    switch (fFormat) {
+    case 4:
+        if (!fIn.read(reinterpret_cast<char*>(fRowBytes.data()), fRowBytes.size())) return false;
+        for (G4int x = 0; x < fWidth; x++) {
+            row[x] = (fRowBytes[x / 8] >> (7 - x % 8)) & 1 ? 1. : 0.;
+        }
+        return true;
+    case 5:
+        if (!fIn.read(reinterpret_cast<char*>(fRowBytes.data()), fRowBytes.size())) return false;
+        for (G4int x = 0; x < fWidth; x++) {
+            G4int value = fMaxValue > 255 ?
+                (fRowBytes[2 * x] << 8) | fRowBytes[2 * x + 1] : fRowBytes[x];
+            row[x] = static_cast<G4double>(value) / fMaxValue;
+        }
+        return true;
+    case 1:
+        for (G4int x = 0; x < fWidth; x++) {
+            // Plain PBM digits need no separators
+            G4int c = fIn.get();
+            while (c != EOF && (std::isspace(c) || c == '#')) {
+                if (c == '#') {
+                    while (c != EOF && c != '\n') c = fIn.get();
+                }
+                c = fIn.get();
+            }
+            if (c != '0' && c != '1') return false;
+            row[x] = (c == '1') ? 1. : 0.;
+        }
+        return true;
+    default:
+        for (G4int x = 0; x < fWidth; x++) {
+            G4int value = 0;
+            if (!ReadHeaderValue(value)) return false;
+            row[x] = static_cast<G4double>(value) / fMaxValue;
+        }
+        return true;
+    }
+}
+
+void BitmapPattern::ReadRows(G4int nRows, std::vector<G4double>& rows)
+{
+    rows.assign(static_cast<size_t>(nRows) * fWidth, 0.);
+    for (G4int r = 0; r < nRows && fNextRow < fHeight; r++, fNextRow++) {
+        if (!ReadRow(&rows[static_cast<size_t>(r) * fWidth])) {
+            G4ExceptionDescription msg;
+            msg << "Bitmap ends at row " << fNextRow << " of " << fHeight
+                << "; the remaining rows are unexposed";
+            G4Exception("BitmapPattern::ReadRows", "EXPO004", JustWarning, msg);
+            std::fill(rows.begin() + static_cast<size_t>(r) * fWidth, rows.end(), 0.);
+            fNextRow = fHeight;
+            return;
+        }
+    }
+}
+
+RectanglePattern::RectanglePattern()
+    : fNextRectangle(0),
+    fWidth(0),
+    fHeight(0),
+    fNextRow(0)
+{
+}
+
+G4bool RectanglePattern::Open(const G4String& fileName, G4double pixelSize, G4double margin)
+{
+    std::ifstream in(fileName);
+    if (!in) {
+        G4ExceptionDescription msg;
+        msg << "Cannot read rectangle list " << fileName;
+        G4Exception("RectanglePattern::Open", "EXPO005", JustWarning, msg);
+        return false;
+    }
+
+    // Read in nm, converted to pixels once the field is known
+    fRectangles.clear();
+    std::string line;
+    G4int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+        std::istringstream fields(line);
+        Rectangle rect;
+        rect.dose = 1.;
+        if (!(fields >> rect.x0 >> rect.y0 >> rect.x1 >> rect.y1)) {
+            G4ExceptionDescription msg;
+            msg << fileName << ":" << lineNumber << ": expected x0 y0 x1 y1 [dose]";
+            G4Exception("RectanglePattern::Open", "EXPO005", JustWarning, msg);
+            return false;
+        }
+        fields >> rect.dose;
+
+        if (rect.x1 < rect.x0) std::swap(rect.x0, rect.x1);
+        if (rect.y1 < rect.y0) std::swap(rect.y0, rect.y1);
+        if (rect.x1 > rect.x0 && rect.y1 > rect.y0 && rect.dose != 0.) {
+            fRectangles.push_back(rect);
+        }
+    }
+    if (fRectangles.empty()) {
+        G4ExceptionDescription msg;
+        msg << fileName << " holds no rectangles";
+        G4Exception("RectanglePattern::Open", "EXPO005", JustWarning, msg);
+        return false;
+    }
+
+    G4double xMin = fRectangles[0].x0, xMax = fRectangles[0].x1;
+    G4double yMin = fRectangles[0].y0, yMax = fRectangles[0].y1;
+    for (const Rectangle& rect : fRectangles) {
+        xMin = std::min(xMin, rect.x0);
+        xMax = std::max(xMax, rect.x1);
+        yMin = std::min(yMin, rect.y0);
+        yMax = std::max(yMax, rect.y1);
+    }
+
+    const G4double pixel = pixelSize / nm;
+    const G4double border = margin / nm;
+    const G4double x0 = xMin - border;
+    const G4double y0 = yMin - border;
+    fWidth = static_cast<G4int>(std::ceil((xMax + border - x0) / pixel));
+    fHeight = static_cast<G4int>(std::ceil((yMax + border - y0) / pixel));
+    for (Rectangle& rect : fRectangles) {
+        rect.x0 = (rect.x0 - x0) / pixel;
+        rect.x1 = (rect.x1 - x0) / pixel;
+        rect.y0 = (rect.y0 - y0) / pixel;
+        rect.y1 = (rect.y1 - y0) / pixel;
+    }
+    std::sort(fRectangles.begin(), fRectangles.end(),
+        [](const Rectangle& a, const Rectangle& b) { return a.y0 < b.y0; });
+
+    fActive.clear();
+    fNextRectangle = 0;
+    fNextRow = 0;
+    return true;
+}
+
+void RectanglePattern::ReadRows(G4int nRows, std::vector<G4double>& rows)
+{
+    rows.assign(static_cast<size_t>(nRows) * fWidth, 0.);
+    const G4int rowBegin = fNextRow;
+    const G4int rowEnd = fNextRow + nRows;
+    fNextRow = rowEnd;
+
+    // Rectangles starting above the strip join, those ending before it leave
+    while (fNextRectangle < fRectangles.size() && fRectangles[fNextRectangle].y0 < rowEnd) {
+        fActive.push_back(fNextRectangle++);
+    }
+    fActive.erase(std::remove_if(fActive.begin(), fActive.end(),
+        [&](size_t index) { return fRectangles[index].y1 <= rowBegin; }), fActive.end());
+
+    for (size_t index : fActive) {
+        const Rectangle& rect = fRectangles[index];
+        G4int yFirst = std::max(static_cast<G4int>(std::floor(rect.y0)), rowBegin);
+        G4int yLast = std::min(static_cast<G4int>(std::ceil(rect.y1)), rowEnd);
+        G4int xFirst = std::max(static_cast<G4int>(std::floor(rect.x0)), 0);
+        G4int xLast = std::min(static_cast<G4int>(std::ceil(rect.x1)), fWidth);
+
+        for (G4int y = yFirst; y < yLast; y++) {
+            G4double fy = std::min(rect.y1, y + 1.) - std::max(rect.y0, static_cast<G4double>(y));
+            if (fy <= 0.) continue;
+            G4double* row = &rows[static_cast<size_t>(y - rowBegin) * fWidth];
+            for (G4int x = xFirst; x < xLast; x++) {
+                G4double fx = std::min(rect.x1, x + 1.) - std::max(rect.x0, static_cast<G4double>(x));
+                if (fx > 0.) row[x] += rect.dose * fx * fy;
+            }
+        }
+    }
+}
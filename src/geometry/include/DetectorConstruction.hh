@@ -11,6 +11,8 @@ class G4VPhysicalVolume;
 class G4LogicalVolume;
 class G4Region;
 class G4Material;
+class G4Box;
+class G4VisAttributes;
 class DetectorMessenger;
 
 class DetectorConstruction : public G4VUserDetectorConstruction {
@@ -35,6 +37,13 @@ public:
     void ClearResistElements();
     void SetResistComposition(G4String composition);  // Format: "Al:1,C:5,H:4,O:2"
 
+    // /det/update: apply parameter changes to the built geometry in place.
+    // A thickness change resizes the resist box and moves its placement; a
+    // composition or density change swaps the resist material. Solids,
+    // volumes, regions and the substrate are kept, so only the navigator
+    // voxels (and, for a new material, the physics tables) are rebuilt.
+    void UpdateGeometry();
+
     // Return current parameters
     G4double GetResistDensity() const { return fResistDensity; }
     std::map<G4String, G4int> GetResistElements() const { return fResistElements; }
@@ -45,11 +54,21 @@ protected:
     G4Region* fResistRegion;
     G4double fActualResistThickness;
 
+    // Built resist, kept for in-place updates
+    G4Box* fSolidResist;
+    G4VPhysicalVolume* fPhysResist;
+    G4Material* fResistMaterial;
+    G4bool fGeometryBuilt;      // overlap checks only on the first build
+
     // Parameter storage
     G4double fResistDensity;
     G4double fResistVisualizationThickness;
     std::map<G4String, G4int> fResistElements;
     G4bool fParametersChanged;
+    G4bool fMaterialChanged;    // composition or density changed since the last build
+
+    G4VisAttributes* fSubstrateVis;
+    G4VisAttributes* fResistVis;
 
     // Messenger for UI commands
     DetectorMessenger* fMessenger;
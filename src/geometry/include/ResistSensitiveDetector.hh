@@ -0,0 +1,55 @@
+// ResistSensitiveDetector.hh - Thread-local scorer attached to the resist volume
+#ifndef ResistSensitiveDetector_h
+#define ResistSensitiveDetector_h 1
+
+#include "G4VSensitiveDetector.hh"
+#include "PhaseSpaceFile.hh"
+#include "globals.hh"
+#include <vector>
+
+class DepositSink;
+class PerfThreadCounters;
+class BackscatterResponse;
+class G4Step;
+class G4HCofThisEvent;
+class G4TouchableHistory;
+
+// Geant4 only calls ProcessHits for steps inside the resist logical volume,
+// so no coordinate test is needed and steps in the substrate and world never
+// reach user scoring code. Deposits are forwarded to the current
+// DepositSink (the EventAction), looked up once per event. With importance
+// biasing enabled, deposits carry the track weight and electrons entering
+// the volume from below can be split (see ImportanceBiasing). In a
+// backscatter calibration run nothing is scored; electrons entering from
+// below are recorded as returns instead (see BackscatterFastSim). While
+// recording a phase space, every particle entering from below is written
+// out at the end of the event (see PhaseSpace).
+class ResistSensitiveDetector : public G4VSensitiveDetector {
+public:
+    ResistSensitiveDetector(const G4String& name);
+    virtual ~ResistSensitiveDetector();
+
+    virtual void Initialize(G4HCofThisEvent* hce);
+    virtual G4bool ProcessHits(G4Step* step, G4TouchableHistory* history);
+    virtual void EndOfEvent(G4HCofThisEvent* hce);
+
+private:
+    void Split(G4Step* step, G4int factor);
+    void RecordCalibrationReturn(G4Step* step);
+    void RecordCrossing(const G4Step* step);
+
+    DepositSink* fSink;
+
+    // Steps seen in the resist this event, published at EndOfEvent
+    G4long fNumSteps;
+    G4long fNumClones;
+    G4bool fBiasingEnabled;
+    BackscatterResponse* fCalibrationTable;   // non-null in calibration runs
+    PerfThreadCounters* fPerfCounters;
+
+    // Phase-space recording: the crossings of this event
+    G4bool fRecordPhaseSpace;
+    std::vector<PhaseSpaceFile::Particle> fCrossings;
+};
+
+#endif
@@ -0,0 +1,61 @@
+// SubstrateFastModel.hh - Fast simulation of deep-substrate electron transport
+#ifndef SubstrateFastModel_h
+#define SubstrateFastModel_h 1
+
+#include "G4VFastSimulationModel.hh"
+#include "globals.hh"
+
+class BackscatterFastSim;
+class PhaseSpace;
+class PerfThreadCounters;
+class G4ParticleDefinition;
+
+// Envelope model for the substrate region. An electron heading down deeper
+// than the trigger depth is killed and its energy deposited locally;
+// instead, the returns of its BackscatterResponse cell are sampled and
+// created as new electrons just below the surface (z = 0), moving up, with
+// the weight of the replaced electron. The number of returns is the cell's
+// mean return count, rounded up or down at random so the mean is kept.
+//
+// Without a loaded table, or for an empty cell, the model does not trigger
+// and the full physics tracks the electron.
+//
+// In a phase-space replay every electron or photon heading down in the
+// substrate is killed with its energy deposited locally: what comes back
+// up is the recorded phase space, started by the primary generator.
+// Photons only reach the model in a replay.
+// One instance per thread
+// (created in DetectorConstruction::ConstructSDandField).
+//
+// The fast-simulation process that reaches the model is switched per run
+// and per thread (SetFastSimulation, from RunAction::BeginOfRunAction): an
+// inactive process is dropped from the stepping loop, so runs with neither
+// the fast simulation nor a replay pay nothing per substrate step.
+class SubstrateFastModel : public G4VFastSimulationModel {
+public:
+    SubstrateFastModel(const G4String& name, G4Region* envelope);
+    virtual ~SubstrateFastModel();
+
+    // Switch the fast-simulation process of a particle on this thread
+    static void SetFastSimulation(const G4ParticleDefinition* particle, G4bool active);
+
+    G4bool IsApplicable(const G4ParticleDefinition& particle) override;
+    G4bool ModelTrigger(const G4FastTrack& fastTrack) override;
+    void DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep) override;
+
+private:
+    BackscatterFastSim* fFastSim;
+    PhaseSpace* fPhaseSpace;
+    const G4ParticleDefinition* fElectron;
+    const G4ParticleDefinition* fGamma;
+
+    // Surface offset of the created returns, so they start in the substrate
+    G4double fSurfaceOffset;
+
+    // Cell found by ModelTrigger, used by the following DoIt (-1: replay)
+    G4int fCell;
+
+    PerfThreadCounters* fPerfCounters;
+};
+
+#endif
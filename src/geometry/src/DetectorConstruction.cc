@@ -1,7 +1,11 @@
 // DetectorConstruction.cc - Complete file with material validation
 #include "DetectorConstruction.hh"
 #include "DetectorMessenger.hh"
+#include "ResistSensitiveDetector.hh"
+#include "SubstrateFastModel.hh"
 #include "EBLConstants.hh"
+#include "PhysicsTableCache.hh"
+#include "TraceRecorder.hh"
 
 #include "G4Material.hh"
 #include "G4NistManager.hh"
@@ -15,6 +19,7 @@
 #include "G4UnitsTable.hh"
 #include "G4RunManager.hh"
 #include "G4SDManager.hh"
+#include "G4FastSimulationManager.hh"
 
 #include <sstream>
 #include <algorithm>
@@ -59,9 +64,16 @@ DetectorConstruction::DetectorConstruction()
     fWorldVolume(nullptr),
     fResistRegion(nullptr),
     fActualResistThickness(EBL::Resist::DEFAULT_THICKNESS),
+    fSolidResist(nullptr),
+    fPhysResist(nullptr),
+    fResistMaterial(nullptr),
+    fGeometryBuilt(false),
     fResistDensity(EBL::Resist::DEFAULT_DENSITY),
     fResistVisualizationThickness(30.0 * nm),
     fParametersChanged(false),
+    fMaterialChanged(false),
+    fSubstrateVis(nullptr),
+    fResistVis(nullptr),
     fMessenger(nullptr)
 {
     // Default resist composition - Alucone from XPS
@@ -77,10 +89,18 @@ DetectorConstruction::DetectorConstruction()
 DetectorConstruction::~DetectorConstruction()
 {
     delete fMessenger;
+    delete fSubstrateVis;
+    delete fResistVis;
 }
 
 G4VPhysicalVolume* DetectorConstruction::Construct()
 {
+    TraceScope scope("geometry");
+
+    // Overlaps cannot appear through later /det/update changes (the resist
+    // only grows along z on top of the substrate), so check them once
+    G4bool checkOverlaps = !fGeometryBuilt;
+
     // Get nist material manager
     G4NistManager* nist = G4NistManager::Instance();
 
@@ -103,7 +123,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
         0,                     // mother volume
         false,                 // no boolean operation
         0,                     // copy number
-        true);                 // overlaps checking
+        checkOverlaps);        // overlaps checking
 
     // Substrate - Silicon
     G4Material* substrate_mat = nist->FindOrBuildMaterial("G4_Si");
@@ -125,54 +145,65 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
         fWorldVolume,
         false,
         0,
-        true);
-
-    // CREATE SUBSTRATE REGION for region-specific cuts
-    G4Region* substrateRegion = new G4Region("SubstrateRegion");
+        checkOverlaps);
+
+    // CREATE SUBSTRATE REGION for region-specific cuts (reused if the
+    // geometry is constructed again, e.g. /run/reinitializeGeometry)
+    G4RegionStore* regionStore = G4RegionStore::GetInstance();
+    G4Region* substrateRegion = regionStore->GetRegion("SubstrateRegion", false);
+    if (!substrateRegion) {
+        substrateRegion = new G4Region("SubstrateRegion");
+    }
     logicSubstrate->SetRegion(substrateRegion);
     substrateRegion->AddRootLogicalVolume(logicSubstrate);
 
     // Resist layer - create custom material
     G4Material* resist_mat = CreateResistMaterial();
+    fResistMaterial = resist_mat;
+    fMaterialChanged = false;
 
     // Use actual thickness for physics, but could visualize differently
     G4double resist_thickness = fActualResistThickness;
     G4double resist_xy = substrate_xy;  // Same lateral size as substrate
 
-    G4Box* solidResist = new G4Box("Resist",
+    fSolidResist = new G4Box("Resist",
         0.5 * resist_xy, 0.5 * resist_xy, 0.5 * resist_thickness);
 
     G4LogicalVolume* logicResist = new G4LogicalVolume(
-        solidResist, resist_mat, "Resist");
+        fSolidResist, resist_mat, "Resist");
 
     // Position resist on top of substrate (bottom at z=0)
-    new G4PVPlacement(0,
+    fPhysResist = new G4PVPlacement(0,
         G4ThreeVector(0, 0, 0.5 * resist_thickness),
         logicResist,
         "Resist",
         fWorldVolume,
         false,
         0,
-        true);
+        checkOverlaps);
 
     // Set resist as the scoring volume
     fScoringVolume = logicResist;
 
     // Create a region for the resist with special production cuts
-    fResistRegion = new G4Region("ResistRegion");
+    fResistRegion = regionStore->GetRegion("ResistRegion", false);
+    if (!fResistRegion) {
+        fResistRegion = new G4Region("ResistRegion");
+    }
     logicResist->SetRegion(fResistRegion);
     fResistRegion->AddRootLogicalVolume(logicResist);
 
     // Visualization attributes
     fWorldVolume->SetVisAttributes(G4VisAttributes::GetInvisible());
 
-    G4VisAttributes* substrateVis = new G4VisAttributes(G4Colour(0.5, 0.5, 0.5, 0.8));
-    substrateVis->SetForceSolid(true);
-    logicSubstrate->SetVisAttributes(substrateVis);
-
-    G4VisAttributes* resistVis = new G4VisAttributes(G4Colour(1.0, 0.8, 0.0, 0.5));
-    resistVis->SetForceSolid(true);
-    logicResist->SetVisAttributes(resistVis);
+    if (!fSubstrateVis) {
+        fSubstrateVis = new G4VisAttributes(G4Colour(0.5, 0.5, 0.5, 0.8));
+        fSubstrateVis->SetForceSolid(true);
+        fResistVis = new G4VisAttributes(G4Colour(1.0, 0.8, 0.0, 0.5));
+        fResistVis->SetForceSolid(true);
+    }
+    logicSubstrate->SetVisAttributes(fSubstrateVis);
+    logicResist->SetVisAttributes(fResistVis);
 
     // Print geometry info
     G4cout << "\n=== Detector Construction ===" << G4endl;
@@ -182,16 +213,80 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
     G4cout << "Resist density: " << G4BestUnit(resist_mat->GetDensity(), "Volumic Mass") << G4endl;
     G4cout << "===========================\n" << G4endl;
 
+    fGeometryBuilt = true;
+    fParametersChanged = false;
+
     return physWorld;
 }
 
+void DetectorConstruction::UpdateGeometry()
+{
+    // Before the first build Construct() picks the parameters up itself
+    if (!fGeometryBuilt || !fParametersChanged) return;
+
+    G4RunManager* runManager = G4RunManager::GetRunManager();
+    G4bool geometryChanged = false;
+
+    // New composition or density: swap the material of the resist volume.
+    // The material-cuts couple changes, so the physics tables are rebuilt.
+    if (fMaterialChanged) {
+        G4Material* material = CreateResistMaterial();
+        fMaterialChanged = false;
+        if (material != fResistMaterial) {
+            fResistMaterial = material;
+            fScoringVolume->SetMaterial(material);
+            runManager->PhysicsHasBeenModified();
+            PhysicsTableCache::Instance()->Invalidate();
+            geometryChanged = true;
+            G4cout << "Resist material changed to " << material->GetName() << G4endl;
+        }
+    }
+
+    // New thickness: resize the box and keep its bottom at z=0. Solids are
+    // shared by all threads; this runs between runs only.
+    G4double halfThickness = 0.5 * fActualResistThickness;
+    if (fSolidResist->GetZHalfLength() != halfThickness) {
+        fSolidResist->SetZHalfLength(halfThickness);
+        fPhysResist->SetTranslation(G4ThreeVector(0, 0, halfThickness));
+        geometryChanged = true;
+        G4cout << "Resist resized to " << G4BestUnit(fActualResistThickness, "Length") << G4endl;
+    }
+
+    // Re-optimise the navigator for the moved volume at the next run start
+    // (propagated to the workers); nothing else is rebuilt
+    if (geometryChanged) {
+        runManager->GeometryHasBeenModified();
+    }
+    fParametersChanged = false;
+}
+
 void DetectorConstruction::ConstructSDandField()
 {
-    // Add sensitive detectors or fields if needed
+    // Thread-local resist scorer: radial (and depth) scoring only ever runs
+    // for steps inside the resist logical volume
+    if (!fScoringVolume) return;
+
+    TraceScope scope("sensitive detectors");
+    G4SDManager* sdManager = G4SDManager::GetSDMpointer();
+    G4VSensitiveDetector* resistSD = sdManager->FindSensitiveDetector("ResistSD", false);
+    if (!resistSD) {
+        resistSD = new ResistSensitiveDetector("ResistSD");
+        sdManager->AddNewDetector(resistSD);
+    }
+    SetSensitiveDetector(fScoringVolume, resistSD);
+
+    // Thread-local deep-substrate model; it only triggers with
+    // /ebl/fastsim/enable and a loaded response table. Its process is
+    // inactive in other runs (SubstrateFastModel::SetFastSimulation).
+    G4Region* substrateRegion = G4RegionStore::GetInstance()->GetRegion("SubstrateRegion", false);
+    if (substrateRegion && !substrateRegion->GetFastSimulationManager()) {
+        new SubstrateFastModel("SubstrateFastModel", substrateRegion);
+    }
 }
 
 G4Material* DetectorConstruction::CreateResistMaterial()
 {
+    TraceScope scope("resist material");
     G4NistManager* nist = G4NistManager::Instance();
 
     // Create unique name based on composition
@@ -200,6 +295,7 @@ G4Material* DetectorConstruction::CreateResistMaterial()
     for (const auto& elem : fResistElements) {
         ss << elem.first << elem.second << "_";
     }
+    ss << fResistDensity / (g / cm3) << "gcm3";
     G4String materialName = ss.str();
 
     // Check if material already exists
@@ -287,6 +383,7 @@ void DetectorConstruction::SetResistDensity(G4double density)
 {
     fResistDensity = density;
     fParametersChanged = true;
+    fMaterialChanged = true;
 
     G4cout << "Resist density set to " << G4BestUnit(density, "Volumic Mass") << G4endl;
 }
@@ -302,12 +399,14 @@ void DetectorConstruction::AddResistElement(G4String element, G4int count)
 {
     fResistElements[element] = count;
     fParametersChanged = true;
+    fMaterialChanged = true;
 }
 
 void DetectorConstruction::ClearResistElements()
 {
     fResistElements.clear();
     fParametersChanged = true;
+    fMaterialChanged = true;
 }
 
 void DetectorConstruction::SetResistComposition(G4String composition)
@@ -315,6 +414,7 @@ void DetectorConstruction::SetResistComposition(G4String composition)
     // Use the parseComposition helper function
     parseComposition(composition, fResistElements);
     fParametersChanged = true;
+    fMaterialChanged = true;
 
     G4cout << "Resist composition updated: ";
     for (const auto& elem : fResistElements) {
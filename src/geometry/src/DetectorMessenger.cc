@@ -90,8 +90,8 @@ void DetectorMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
         fDetector->SetResistComposition(composition);
     }
     else if (command == fUpdateCmd) {
-        // Force geometry update
-        G4RunManager::GetRunManager()->GeometryHasBeenModified();
+        // Apply the changed parameters to the built geometry in place
+        fDetector->UpdateGeometry();
         G4cout << "Detector geometry updated." << G4endl;
     }
 }
\ No newline at end of file
@@ -0,0 +1,174 @@
+// ResistSensitiveDetector.cc - Thread-local scorer attached to the resist volume
+#include "ResistSensitiveDetector.hh"
+#include "DepositSink.hh"
+#include "PerfMonitor.hh"
+#include "ImportanceBiasing.hh"
+#include "BackscatterFastSim.hh"
+#include "PhaseSpace.hh"
+
+#include "G4Step.hh"
+#include "G4StepPoint.hh"
+#include "G4Track.hh"
+#include "G4DynamicParticle.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4EventManager.hh"
+#include "G4Event.hh"
+#include "G4UserEventAction.hh"
+#include "G4Electron.hh"
+#include "Randomize.hh"
+
+ResistSensitiveDetector::ResistSensitiveDetector(const G4String& name)
+    : G4VSensitiveDetector(name),
+    fSink(nullptr),
+    fNumSteps(0),
+    fNumClones(0),
+    fBiasingEnabled(false),
+    fCalibrationTable(nullptr),
+    fPerfCounters(PerfMonitor::Instance()->GetThreadCounters()),
+    fRecordPhaseSpace(false)
+{
+}
+
+ResistSensitiveDetector::~ResistSensitiveDetector()
+{
+}
+
+void ResistSensitiveDetector::Initialize(G4HCofThisEvent*)
+{
+    // Called at the start of every event on this thread
+    G4UserEventAction* eventAction =
+        G4EventManager::GetEventManager()->GetUserEventAction();
+    fSink = dynamic_cast<DepositSink*>(eventAction);
+    fNumSteps = 0;
+    fNumClones = 0;
+    fBiasingEnabled = ImportanceBiasing::Instance()->IsEnabled();
+    fCalibrationTable = BackscatterFastSim::Instance()->IsCalibrating()
+        ? BackscatterFastSim::GetCalibrationTable() : nullptr;
+    fRecordPhaseSpace = PhaseSpace::Instance()->IsRecording();
+    fCrossings.clear();
+}
+
+void ResistSensitiveDetector::EndOfEvent(G4HCofThisEvent*)
+{
+    fPerfCounters->Add(PerfThreadCounters::kResistSteps, fNumSteps);
+    fPerfCounters->Add(PerfThreadCounters::kSplitTracks, fNumClones);
+
+    if (!fCrossings.empty()) {
+        const G4Event* event = G4EventManager::GetEventManager()->GetConstCurrentEvent();
+        PhaseSpace::Instance()->RecordEvent(event->GetEventID(), fCrossings);
+    }
+}
+
+G4bool ResistSensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory*)
+{
+    fNumSteps++;
+
+    G4StepPoint* preStepPoint = step->GetPreStepPoint();
+
+    if (fCalibrationTable) {
+        RecordCalibrationReturn(step);
+        return false;
+    }
+
+    G4double edep = step->GetTotalEnergyDeposit();
+    G4bool scored = false;
+
+    // For BEAMER PSF, we don't filter any energy deposits in resist
+    // Every bit of energy matters for accurate proximity correction
+    if (edep > 0 && fSink) {
+        const G4ThreeVector& pos = preStepPoint->GetPosition();
+        fSink->AddEnergyDeposit(edep, preStepPoint->GetWeight(), pos.x(), pos.y(), pos.z());
+        scored = true;
+    }
+
+    // Upward entry through the bottom face: the first step in the volume
+    // starts on a boundary with the direction pointing up
+    G4bool enteredFromBelow = preStepPoint->GetStepStatus() == fGeomBoundary &&
+        preStepPoint->GetMomentumDirection().z() > 0.;
+    if (fRecordPhaseSpace && enteredFromBelow) {
+        RecordCrossing(step);
+    }
+    // Only electrons are split: the biasing targets the backscattered
+    // electrons, and copies of gammas or positrons would only add tracks
+    if (fBiasingEnabled && enteredFromBelow &&
+        step->GetTrack()->GetDefinition() == G4Electron::Definition()) {
+        const RegionBiasing* biasing = ImportanceBiasing::Instance()->Find(
+            preStepPoint->GetPhysicalVolume()->GetLogicalVolume()->GetRegion());
+        if (biasing && biasing->splitFactor > 1) {
+            Split(step, biasing->splitFactor);
+        }
+    }
+
+    return scored;
+}
+
+void ResistSensitiveDetector::Split(G4Step* step, G4int factor)
+{
+    // The deposit of this step was already scored with the full weight;
+    // from the post-step point on the track continues as N tracks of
+    // weight w/N, the copies being handed to the stack as secondaries
+    G4Track* track = step->GetTrack();
+    if (track->GetTrackStatus() != fAlive) return;
+
+    G4double weight = track->GetWeight() / factor;
+    if (weight < ImportanceBiasing::Instance()->GetMinimumWeight()) return;
+
+    track->SetWeight(weight);
+    G4TrackVector* secondaries = step->GetfSecondary();
+    for (G4int i = 1; i < factor; ++i) {
+        G4Track* clone = new G4Track(new G4DynamicParticle(*track->GetDynamicParticle()),
+                                     track->GetGlobalTime(), track->GetPosition());
+        clone->SetWeight(weight);
+        clone->SetParentID(track->GetTrackID());
+        clone->SetTouchableHandle(track->GetTouchableHandle());
+        clone->SetCreatorProcess(track->GetCreatorProcess());
+        secondaries->push_back(clone);
+    }
+    fNumClones += factor - 1;
+}
+
+void ResistSensitiveDetector::RecordCalibrationReturn(G4Step* step)
+{
+    // Backscatter calibration: an electron coming up out of the substrate is
+    // a return of the current cell; it is recorded on the surface and not
+    // tracked further (nothing is scored in a calibration run)
+    G4StepPoint* preStepPoint = step->GetPreStepPoint();
+    const G4ThreeVector& direction = preStepPoint->GetMomentumDirection();
+    if (preStepPoint->GetStepStatus() != fGeomBoundary || direction.z() <= 0.) return;
+
+    G4Track* track = step->GetTrack();
+    if (track->GetDefinition() == G4Electron::Definition()) {
+        const G4ThreeVector& pos = preStepPoint->GetPosition();
+        BackscatterResponse::Sample sample;
+        sample.x = static_cast<G4float>(pos.x());
+        sample.y = static_cast<G4float>(pos.y());
+        sample.energyFraction = static_cast<G4float>(
+            preStepPoint->GetKineticEnergy() / BackscatterFastSim::GetCalibrationEnergy());
+        sample.ux = static_cast<G4float>(direction.x());
+        sample.uy = static_cast<G4float>(direction.y());
+        sample.uz = static_cast<G4float>(direction.z());
+        fCalibrationTable->AddReturn(BackscatterFastSim::GetCalibrationCell(), sample, G4UniformRand());
+    }
+    track->SetTrackStatus(fStopAndKill);
+}
+
+void ResistSensitiveDetector::RecordCrossing(const G4Step* step)
+{
+    // Recorded before any splitting, with the weight the track came up with
+    const G4StepPoint* preStepPoint = step->GetPreStepPoint();
+    const G4ThreeVector& pos = preStepPoint->GetPosition();
+    const G4ThreeVector& direction = preStepPoint->GetMomentumDirection();
+
+    PhaseSpaceFile::Particle particle;
+    particle.x = static_cast<G4float>(pos.x());
+    particle.y = static_cast<G4float>(pos.y());
+    particle.ux = static_cast<G4float>(direction.x());
+    particle.uy = static_cast<G4float>(direction.y());
+    particle.uz = static_cast<G4float>(direction.z());
+    particle.energy = static_cast<G4float>(preStepPoint->GetKineticEnergy());
+    particle.weight = static_cast<G4float>(preStepPoint->GetWeight());
+    particle.pdg = step->GetTrack()->GetDefinition()->GetPDGEncoding();
+    fCrossings.push_back(particle);
+}
@@ -0,0 +1,135 @@
+// SubstrateFastModel.cc - Fast simulation of deep-substrate electron transport
+#include "SubstrateFastModel.hh"
+#include "BackscatterFastSim.hh"
+#include "PhaseSpace.hh"
+#include "PerfMonitor.hh"
+
+#include "G4FastTrack.hh"
+#include "G4FastStep.hh"
+#include "G4FastSimulationManagerProcess.hh"
+#include "G4ProcessManager.hh"
+#include "G4ProcessVector.hh"
+#include "G4Track.hh"
+#include "G4DynamicParticle.hh"
+#include "G4Electron.hh"
+#include "G4Gamma.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+#include <cmath>
+
+SubstrateFastModel::SubstrateFastModel(const G4String& name, G4Region* envelope)
+    : G4VFastSimulationModel(name, envelope),
+    fFastSim(BackscatterFastSim::Instance()),
+    fPhaseSpace(PhaseSpace::Instance()),
+    fElectron(G4Electron::Definition()),
+    fGamma(G4Gamma::Definition()),
+    fSurfaceOffset(1.0e-3 * nanometer),
+    fCell(-1),
+    fPerfCounters(PerfMonitor::Instance()->GetThreadCounters())
+{
+}
+
+SubstrateFastModel::~SubstrateFastModel()
+{
+}
+
+void SubstrateFastModel::SetFastSimulation(const G4ParticleDefinition* particle, G4bool active)
+{
+    // Process managers are per thread; the process sits in the stepping
+    // vectors only while active
+    G4ProcessManager* manager = particle->GetProcessManager();
+    if (!manager) return;
+    G4ProcessVector* processes = manager->GetProcessList();
+    for (size_t i = 0; i < processes->size(); ++i) {
+        G4VProcess* process = (*processes)[i];
+        if (dynamic_cast<G4FastSimulationManagerProcess*>(process) &&
+            manager->GetProcessActivation(process) != active) {
+            manager->SetProcessActivation(process, active);
+        }
+    }
+}
+
+G4bool SubstrateFastModel::IsApplicable(const G4ParticleDefinition& particle)
+{
+    return &particle == fElectron || &particle == fGamma;
+}
+
+G4bool SubstrateFastModel::ModelTrigger(const G4FastTrack& fastTrack)
+{
+    const G4Track* track = fastTrack.GetPrimaryTrack();
+    const G4ThreeVector& direction = track->GetMomentumDirection();
+
+    // Replay: nothing heading down is tracked, the recording comes back up
+    if (fPhaseSpace->IsReplaying()) {
+        fCell = -1;
+        return direction.z() < 0.;
+    }
+
+    if (!fFastSim->IsActive() || track->GetDefinition() != fElectron) return false;
+
+    G4double depth = -track->GetPosition().z();
+    if (direction.z() >= 0. || depth < fFastSim->GetTriggerDepth()) return false;
+
+    const BackscatterResponse& table = fFastSim->GetTable();
+    fCell = table.FindCell(track->GetKineticEnergy(), depth, -direction.z());
+    return table.GetCell(fCell).entries > 0;
+}
+
+void SubstrateFastModel::DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep)
+{
+    const G4Track* track = fastTrack.GetPrimaryTrack();
+    G4double energy = track->GetKineticEnergy();
+
+    if (fCell < 0) {
+        fastStep.KillPrimaryTrack();
+        fastStep.ProposeTotalEnergyDeposited(energy);
+        return;
+    }
+
+    const BackscatterResponse::Cell& cell = fFastSim->GetTable().GetCell(fCell);
+    const G4ThreeVector& position = track->GetPosition();
+    const G4ThreeVector& direction = track->GetMomentumDirection();
+
+    // Number of returns: keep the mean return count of the cell
+    G4int nReturns = 0;
+    if (!cell.samples.empty()) {
+        G4double mean = static_cast<G4double>(cell.returns) / cell.entries;
+        nReturns = static_cast<G4int>(mean);
+        if (G4UniformRand() < mean - nReturns) ++nReturns;
+    }
+
+    // Samples are stored for an entry at azimuth 0; rotate to the actual one
+    G4double phi = std::atan2(direction.y(), direction.x());
+    G4double cosPhi = std::cos(phi);
+    G4double sinPhi = std::sin(phi);
+
+    fastStep.KillPrimaryTrack();
+    fastStep.SetNumberOfSecondaryTracks(nReturns);
+
+    G4double returnedEnergy = 0.;
+    for (G4int i = 0; i < nReturns; ++i) {
+        size_t index = static_cast<size_t>(G4UniformRand() * cell.samples.size());
+        if (index >= cell.samples.size()) index = cell.samples.size() - 1;
+        const BackscatterResponse::Sample& sample = cell.samples[index];
+
+        G4double returnEnergy = sample.energyFraction * energy;
+        if (returnedEnergy + returnEnergy > energy) break;
+        returnedEnergy += returnEnergy;
+
+        G4ThreeVector returnPosition(position.x() + cosPhi * sample.x - sinPhi * sample.y,
+                                     position.y() + sinPhi * sample.x + cosPhi * sample.y,
+                                     -fSurfaceOffset);
+        G4ThreeVector returnDirection(cosPhi * sample.ux - sinPhi * sample.uy,
+                                      sinPhi * sample.ux + cosPhi * sample.uy,
+                                      sample.uz);
+
+        G4DynamicParticle particle(fElectron, returnDirection.unit(), returnEnergy);
+        G4Track* secondary = fastStep.CreateSecondaryTrack(particle, returnPosition,
+                                                           track->GetGlobalTime(), false);
+        secondary->SetWeight(track->GetWeight());
+    }
+
+    // Whatever does not come back stays in the substrate
+    fastStep.ProposeTotalEnergyDeposited(energy - returnedEnergy);
+    fPerfCounters->Add(PerfThreadCounters::kFastSimReplaced);
+}
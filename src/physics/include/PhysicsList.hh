@@ -6,6 +6,7 @@
 #include "globals.hh"
 
 class G4VPhysicsConstructor;
+class G4UserLimits;
 class PhysicsMessenger;
 
 class PhysicsList : public G4VModularPhysicsList
@@ -19,8 +20,16 @@ public:
     virtual void ConstructProcess();
     virtual void SetCuts();
 
-    // Optional: Add methods to change physics on the fly
+    // Named EM presets (/process/em/preset), PreInit only:
+    //  livermore - G4EmLivermorePhysics everywhere (reference, default)
+    //  hybrid    - Option4, with Livermore models and de-excitation only in
+    //              ResistRegion, coarser step function, 100 eV tracking
+    //              cutoff in SubstrateRegion
+    //  fast      - Standard, Livermore and de-excitation (no PIXE) only in
+    //              ResistRegion, coarse step function, 1 keV substrate cutoff
+    // Both coarse presets limit the step in ResistRegion to 1 nm.
     void SetEmPhysics(const G4String& name);
+    const G4String& GetEmPhysicsName() const { return fEmPreset; }
 
     // Setters for cuts
     void SetGammaCut(G4double val) { fCutForGamma = val; }
@@ -29,10 +38,20 @@ public:
 
 private:
     void SetupEmParameters();
+    void SetupPresetParameters();
+    void SetupTrackingCuts();
 
 private:
     G4VPhysicsConstructor* fEmPhysics;
     G4VPhysicsConstructor* fDecayPhysics;
+    G4VPhysicsConstructor* fStepLimiterPhysics;
+    G4VPhysicsConstructor* fFastSimPhysics;
+
+    G4String fEmPreset;
+    G4double fSubstrateTrackingCut;     // 0 = no cutoff beyond the EM one
+    G4UserLimits* fSubstrateLimits;
+    G4double fResistMaxStep;            // 0 = step function only
+    G4UserLimits* fResistLimits;
 
     G4double fCutForGamma;
     G4double fCutForElectron;
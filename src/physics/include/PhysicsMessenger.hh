@@ -9,6 +9,7 @@ class PhysicsList;
 class G4UIdirectory;
 class G4UIcmdWithAnInteger;
 class G4UIcmdWithABool;
+class G4UIcmdWithAString;
 
 class PhysicsMessenger : public G4UImessenger {
 public:
@@ -26,6 +27,7 @@ private:
     G4UIcmdWithAnInteger* fAugerCmd;
     G4UIcmdWithABool* fDeexcitationCmd;
     G4UIcmdWithABool* fPixeCmd;
+    G4UIcmdWithAString* fPresetCmd;
 };
 
 #endif
\ No newline at end of file
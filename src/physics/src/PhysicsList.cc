@@ -1,6 +1,8 @@
 // PhysicsList.cc - Optimized for BEAMER with region-specific cuts
 #include "PhysicsList.hh"
 #include "PhysicsMessenger.hh"
+#include "PhysicsTableCache.hh"
+#include "TraceRecorder.hh"
 
 #include "G4DecayPhysics.hh"
 #include "G4EmStandardPhysics.hh"
@@ -8,6 +10,8 @@
 #include "G4EmLivermorePhysics.hh"
 #include "G4EmPenelopePhysics.hh"
 #include "G4EmExtraPhysics.hh"
+#include "G4StepLimiterPhysics.hh"
+#include "G4FastSimulationPhysics.hh"
 
 #include "G4SystemOfUnits.hh"
 #include "G4ParticleDefinition.hh"
@@ -18,11 +22,21 @@
 #include "G4Region.hh"
 #include "G4RegionStore.hh"
 #include "G4ProductionCuts.hh"
+#include "G4UserLimits.hh"
+#include "G4Threading.hh"
+#include <sstream>
 
 PhysicsList::PhysicsList()
     : G4VModularPhysicsList(),
     fEmPhysics(nullptr),
     fDecayPhysics(nullptr),
+    fStepLimiterPhysics(nullptr),
+    fFastSimPhysics(nullptr),
+    fEmPreset("livermore"),
+    fSubstrateTrackingCut(0.),
+    fSubstrateLimits(nullptr),
+    fResistMaxStep(0.),
+    fResistLimits(nullptr),
     fCutForGamma(0.1 * nanometer),      // Ultra-fine for accuracy
     fCutForElectron(0.1 * nanometer),   // Ultra-fine for accuracy
     fCutForPositron(0.1 * nanometer),   // Ultra-fine for accuracy
@@ -36,6 +50,16 @@ PhysicsList::PhysicsList()
     // Default physics
     fDecayPhysics = new G4DecayPhysics();
 
+    // Fast simulation hook for electrons and photons (SubstrateFastModel).
+    // The processes have to exist from /run/initialize on, since the
+    // commands that need them work in Idle state; RunAction switches them
+    // off where the model cannot trigger (photons: outside a phase-space
+    // replay; electrons: also without /ebl/fastsim/enable).
+    G4FastSimulationPhysics* fastSimPhysics = new G4FastSimulationPhysics();
+    fastSimPhysics->ActivateFastSimulation("e-");
+    fastSimPhysics->ActivateFastSimulation("gamma");
+    fFastSimPhysics = fastSimPhysics;
+
     // EM physics - Use Livermore for better low-energy accuracy (down to 10 eV)
     fEmPhysics = new G4EmLivermorePhysics();
 
@@ -50,9 +74,83 @@ PhysicsList::~PhysicsList()
 {
     delete fDecayPhysics;
     delete fEmPhysics;
+    delete fStepLimiterPhysics;
+    delete fFastSimPhysics;
+    delete fSubstrateLimits;
+    delete fResistLimits;
     delete fMessenger;
 }
 
+void PhysicsList::SetEmPhysics(const G4String& name)
+{
+    if (name == fEmPreset) return;
+
+    G4VPhysicsConstructor* emPhysics = nullptr;
+    if (name == "livermore") {
+        emPhysics = new G4EmLivermorePhysics();
+    }
+    else if (name == "hybrid") {
+        emPhysics = new G4EmStandardPhysics_option4();
+    }
+    else if (name == "fast") {
+        emPhysics = new G4EmStandardPhysics();
+    }
+    else {
+        G4ExceptionDescription msg;
+        msg << "Unknown EM physics preset '" << name << "', keeping " << fEmPreset;
+        G4Exception("PhysicsList::SetEmPhysics", "PHYS001", JustWarning, msg);
+        return;
+    }
+
+    delete fEmPhysics;
+    fEmPhysics = emPhysics;
+    fEmPreset = name;
+
+    // EM constructors reset G4EmParameters to their own defaults, so our
+    // settings (and the preset's region overrides) are applied again
+    SetupEmParameters();
+    SetupPresetParameters();
+
+    // The substrate tracking cutoff is applied by G4UserSpecialCuts, the
+    // resist step limit by G4StepLimiter
+    if ((fSubstrateTrackingCut > 0. || fResistMaxStep > 0.) && !fStepLimiterPhysics) {
+        fStepLimiterPhysics = new G4StepLimiterPhysics();
+    }
+
+    G4cout << "EM physics preset: " << fEmPreset << G4endl;
+}
+
+void PhysicsList::SetupPresetParameters()
+{
+    G4EmParameters* param = G4EmParameters::Instance();
+    fSubstrateTrackingCut = 0.;
+    fResistMaxStep = 0.;
+
+    if (fEmPreset == "livermore") return;
+
+    // Resist-only fidelity: Livermore models (through G4EmModelActivator,
+    // which drives G4EmConfigurator) and atomic de-excitation in the resist,
+    // base-list models everywhere else
+    G4bool pixe = (fEmPreset == "hybrid");
+    param->AddPhysics("ResistRegion", "G4EmLivermore");
+    param->SetDeexActiveRegion("ResistRegion", true, true, pixe);
+    param->SetDeexActiveRegion("SubstrateRegion", false, false, false);
+    param->SetDeexActiveRegion("DefaultRegionForTheWorld", false, false, false);
+
+    // The step function is global, so the coarse one would apply in the
+    // resist too; a region step limit keeps resist steps at 1 nm or less
+    // (a few tens across the layer), the substrate and world stay coarse
+    fResistMaxStep = 1 * nanometer;
+    if (fEmPreset == "hybrid") {
+        param->SetStepFunction(0.2, 1 * nanometer);
+        fSubstrateTrackingCut = 100 * eV;
+    }
+    else {
+        param->SetStepFunction(0.2, 10 * nanometer);
+        fSubstrateTrackingCut = 1 * keV;
+    }
+}
+
 void PhysicsList::SetupEmParameters()
 {
     // Get EM parameters instance
@@ -129,6 +227,8 @@ void PhysicsList::ConstructParticle()
 
 void PhysicsList::ConstructProcess()
 {
+    TraceScope scope("physics processes");
+
     // Transportation
     AddTransportation();
 
@@ -137,10 +237,20 @@ void PhysicsList::ConstructProcess()
 
     // Decay physics
     fDecayPhysics->ConstructProcess();
+
+    // G4UserSpecialCuts for the substrate tracking cutoff of the fast presets
+    if (fStepLimiterPhysics) {
+        fStepLimiterPhysics->ConstructProcess();
+    }
+
+    // Fast simulation, must come after the physics it shortcuts
+    fFastSimPhysics->ConstructProcess();
 }
 
 void PhysicsList::SetCuts()
 {
+    TraceScope scope("production cuts");
+
     // BEAMER OPTIMIZATION: Use region-specific cuts
 
     // Default global cuts (moderate)
@@ -206,6 +316,17 @@ void PhysicsList::SetCuts()
             << G4BestUnit(100.0 * nanometer, "Length") << G4endl;
     }
 
+    SetupTrackingCuts();
+
+    // Reuse the tables of an earlier launch with the same materials, cuts
+    // and EM parameters; workers share the master's tables anyway
+    if (G4Threading::IsMasterThread()) {
+        std::ostringstream configuration;
+        configuration << fEmPreset << " substrateCut=" << fSubstrateTrackingCut
+            << " resistMaxStep=" << fResistMaxStep;
+        PhysicsTableCache::Instance()->Prepare(this, configuration.str());
+    }
+
     // Dump the full particle/process list for verification
     if (GetVerboseLevel() > 0) {
         DumpCutValuesTable();
@@ -216,8 +337,52 @@ void PhysicsList::SetCuts()
     G4double lowestE = param->LowestElectronEnergy();
 
     G4cout << "\nBEAMER PSF Optimization Summary:" << G4endl;
+    G4cout << "  EM preset: " << fEmPreset << G4endl;
     G4cout << "  Resist: Ultra-fine cuts (0.05 nm) for accuracy" << G4endl;
     G4cout << "  Substrate: Coarse cuts (10 nm) for efficiency" << G4endl;
     G4cout << "  Tracking threshold: " << lowestE/eV << " eV" << G4endl;
     G4cout << "  This configuration optimizes for resist-only PSF calculation\n" << G4endl;
+}
+
+void PhysicsList::SetupTrackingCuts()
+{
+    G4RegionStore* regionStore = G4RegionStore::GetInstance();
+
+    // Resist step limit of the presets with a coarse step function
+    G4Region* resistRegion = regionStore->GetRegion("ResistRegion", false);
+    if (resistRegion) {
+        if (fResistMaxStep > 0.) {
+            if (!fResistLimits) {
+                fResistLimits = new G4UserLimits();
+            }
+            fResistLimits->SetMaxAllowedStep(fResistMaxStep);
+            resistRegion->SetUserLimits(fResistLimits);
+
+            G4cout << "  Resist maximum step: "
+                << G4BestUnit(fResistMaxStep, "Length") << G4endl;
+        }
+        else {
+            resistRegion->SetUserLimits(nullptr);
+        }
+    }
+
+    // Electrons below the cutoff stop in the substrate and deposit their
+    // energy locally. The world stays uncut: it is vacuum, and anything
+    // there heading down still reaches the resist.
+    G4Region* substrateRegion = regionStore->GetRegion("SubstrateRegion", false);
+    if (!substrateRegion) return;
+
+    if (fSubstrateTrackingCut > 0.) {
+        if (!fSubstrateLimits) {
+            fSubstrateLimits = new G4UserLimits();
+        }
+        fSubstrateLimits->SetUserMinEkine(fSubstrateTrackingCut);
+        substrateRegion->SetUserLimits(fSubstrateLimits);
+
+        G4cout << "  Substrate tracking cutoff: "
+            << G4BestUnit(fSubstrateTrackingCut, "Energy") << G4endl;
+    }
+    else {
+        substrateRegion->SetUserLimits(nullptr);
+    }
 }
\ No newline at end of file
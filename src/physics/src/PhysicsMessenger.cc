@@ -5,6 +5,7 @@
 #include "G4UIdirectory.hh"
 #include "G4UIcmdWithAnInteger.hh"
 #include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAString.hh"
 #include "G4UIcommand.hh"
 #include "G4EmParameters.hh"
 
@@ -43,11 +44,25 @@ PhysicsMessenger::PhysicsMessenger(PhysicsList* physics)
     fPixeCmd->SetParameterName("PIXEBool", true);
     fPixeCmd->SetDefaultValue(true);
     fPixeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Region-specific EM model presets
+    fPresetCmd = new G4UIcmdWithAString("/process/em/preset", this);
+    fPresetCmd->SetGuidance("Select the EM physics preset (before /run/initialize).");
+    fPresetCmd->SetGuidance("  livermore : Livermore everywhere (reference)");
+    fPresetCmd->SetGuidance("  hybrid    : Option4, Livermore + de-excitation in ResistRegion only");
+    fPresetCmd->SetGuidance("  fast      : Standard, Livermore in ResistRegion, 1 keV substrate cutoff");
+    fPresetCmd->SetGuidance("hybrid and fast coarsen the step function, limited to 1 nm in the resist.");
+    fPresetCmd->SetGuidance("Issue it first: it resets the other /process/em/ settings.");
+    fPresetCmd->SetParameterName("preset", false);
+    fPresetCmd->SetCandidates("livermore hybrid fast");
+    fPresetCmd->AvailableForStates(G4State_PreInit);
+    fPresetCmd->SetToBeBroadcasted(false);
 }
 
 PhysicsMessenger::~PhysicsMessenger()
 {
     delete fPixeCmd;
+    delete fPresetCmd;
     delete fDeexcitationCmd;
     delete fFluoCmd;
     delete fAugerCmd;
@@ -80,4 +95,7 @@ void PhysicsMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
         param->SetPixe(flag);
         G4cout << "PIXE " << (flag ? "enabled" : "disabled") << G4endl;
     }
+    else if (command == fPresetCmd) {
+        fPhysicsList->SetEmPhysics(newValue);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+// Simulation.hh - In-process ebl_sim set-up for the Python module
+#ifndef Simulation_h
+#define Simulation_h 1
+
+#include "globals.hh"
+#include "RunAction.hh"
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+class G4RunManager;
+
+// What ebl_sim's main sets up before it executes a macro - run manager,
+// seeding, the process-wide helpers, geometry, physics and actions - kept
+// alive between runs. The ebl Python module drives it, so the GUI and
+// notebooks pay process startup and physics initialization once for many
+// short runs and read the tallies without going through the output files.
+//
+// Geant4 allows one run manager per process, so there is one Simulation
+// (Create, then Instance). Configuration goes through the UI commands,
+// exactly as in a macro, so broadcast commands also reach the workers'
+// copies of the actions. All calls must come from the thread that created
+// it, which is the Geant4 master thread.
+class Simulation {
+public:
+    struct Options {
+        G4int threads = 0;                  // 0 = all cores
+        G4bool seedGiven = false;
+        std::uint64_t seed = 0;             // time-based unless given
+        G4String runManager = "tasking";    // tasking, mt or serial
+        G4String scoring = "radial";        // see /ebl/psf/scoring
+    };
+
+    // Null, with the reason in error, if a Simulation exists already or
+    // an option is invalid
+    static Simulation* Create(const Options& options, G4String& error);
+    static Simulation* Instance() { return fInstance; }
+
+    // Never deleted: the Geant4 state lives until the process exits
+    ~Simulation() = default;
+
+    // G4UImanager::ApplyCommand status, 0 on success
+    G4int ApplyCommand(const G4String& command);
+
+    // /run/initialize has been done (by the first run or a command)
+    G4bool IsInitialized() const;
+    G4bool IsMasterThread() const { return std::this_thread::get_id() == fThread; }
+
+    // Worker threads; the count can change until the first run starts
+    // them, false afterwards for a different one
+    G4bool SetThreads(G4int threads);
+    G4int GetThreads() const;
+    std::uint64_t GetSeed() const { return fSeed; }
+
+    // One /run/beamOn, /ebl/sweep/ energies for one run (then cleared) or
+    // an /ebl/run/converge loop with the ConvergenceControl settings.
+    // Each returns the PSF the run wrote, null if it wrote none
+    // (backscatter calibration, shot runs, no target error).
+    RunAction::ResultSnapshot Run(G4int events);
+    RunAction::ResultSnapshot Sweep(const std::vector<G4double>& energies, G4int events);
+    RunAction::ResultSnapshot Converge();
+
+    // (r, z) tallies of the last run, null without depth scoring
+    RunAction::DepthSnapshot GetDepthResult() const;
+
+private:
+    explicit Simulation(const Options& options);
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    void Initialize();
+    const RunAction* GetMasterRunAction() const;
+
+    static Simulation* fInstance;
+
+    G4RunManager* fRunManager;
+    std::uint64_t fSeed;
+    std::thread::id fThread;
+};
+
+#endif
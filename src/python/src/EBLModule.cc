@@ -0,0 +1,344 @@
+// EBLModule.cc - The ebl Python module (USE_PYTHON)
+#include "Simulation.hh"
+#include "PSFResultFile.hh"
+#include "ConvergenceControl.hh"
+#include "AsyncWriter.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <cfloat>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+namespace py = pybind11;
+
+namespace {
+    // Result of one run: the snapshots written by the master run action
+    struct Result {
+        RunAction::ResultSnapshot psf;
+        RunAction::DepthSnapshot depth;
+    };
+
+    // Read-only NumPy view of a snapshot buffer; the array holds a
+    // reference to the snapshot, so it stays valid after later runs
+    template <typename T>
+    py::array View(const std::vector<T>& data, std::vector<py::ssize_t> shape,
+                   std::shared_ptr<const void> owner)
+    {
+        auto* holder = new std::shared_ptr<const void>(std::move(owner));
+        py::capsule base(holder, [](void* pointer) {
+            delete static_cast<std::shared_ptr<const void>*>(pointer);
+        });
+        py::array array(py::dtype::of<T>(), std::move(shape), {}, data.data(), base);
+        array.attr("setflags")(py::arg("write") = false);
+        return array;
+    }
+
+    std::string Number(G4double value)
+    {
+        std::ostringstream text;
+        text.precision(17);
+        text << value;
+        return text.str();
+    }
+
+    void CheckThread(const Simulation& simulation)
+    {
+        if (!simulation.IsMasterThread()) {
+            throw std::runtime_error("ebl.Simulation must be used from the thread that created it");
+        }
+    }
+
+    // Any macro command; the GIL is released while Geant4 works on it
+    void Apply(Simulation& simulation, const std::string& command)
+    {
+        CheckThread(simulation);
+        G4int status;
+        {
+            py::gil_scoped_release release;
+            status = simulation.ApplyCommand(command);
+        }
+        if (status != 0) {
+            throw std::runtime_error("command failed (G4UImanager status " +
+                                     std::to_string(status) + "): " + command);
+        }
+    }
+
+    void SetThreads(Simulation& simulation, std::optional<G4int> threads)
+    {
+        if (threads && !simulation.SetThreads(*threads)) {
+            throw std::runtime_error("the worker threads are started (" +
+                                     std::to_string(simulation.GetThreads()) +
+                                     "); the count is fixed from the first run on");
+        }
+    }
+
+    template <typename Function>
+    std::optional<Result> RunWithoutGIL(Simulation& simulation, Function run)
+    {
+        CheckThread(simulation);
+        Result result;
+        {
+            py::gil_scoped_release release;
+            result.psf = run();
+            result.depth = simulation.GetDepthResult();
+        }
+        if (!result.psf) return std::nullopt;
+        return result;
+    }
+
+    // Energy density per event, as the CSV export (eV/nm^2)
+    py::array_t<G4double> EnergyDensity(const PSFResultFile& psf)
+    {
+        const PSFBinning& binning = psf.GetBinning();
+        const G4int numBins = binning.GetNumberOfBins();
+        const G4int numPoints = psf.GetNumberOfPoints();
+        py::array_t<G4double> density({ numPoints, numBins });
+        auto out = density.mutable_unchecked<2>();
+        for (G4int point = 0; point < numPoints; point++) {
+            const G4long events = psf.GetEvents(point);
+            for (G4int i = 0; i < numBins; i++) {
+                G4double area = binning.GetArea(i);
+                out(point, i) = (area > 0 && events > 0) ?
+                    psf.GetSum(point, i) / (area * events) / (eV / (nm * nm)) : 0.;
+            }
+        }
+        return density;
+    }
+
+    // Relative standard error of the mean deposit per event, inf if empty
+    py::array_t<G4double> RelativeError(const PSFResultFile& psf)
+    {
+        const G4int numBins = psf.GetBinning().GetNumberOfBins();
+        const G4int numPoints = psf.GetNumberOfPoints();
+        py::array_t<G4double> error({ numPoints, numBins });
+        auto out = error.mutable_unchecked<2>();
+        for (G4int point = 0; point < numPoints; point++) {
+            for (G4int i = 0; i < numBins; i++) {
+                G4double value = psf.GetRelativeError(point, i);
+                out(point, i) = value == DBL_MAX ? std::numeric_limits<G4double>::infinity() : value;
+            }
+        }
+        return error;
+    }
+
+    // Energy density per event of the (r, z) table, as the 2D export
+    // (eV/nm^3); None without depth scoring
+    py::object DepthDensity(const Result& result)
+    {
+        if (!result.depth) return py::none();
+        const RunAction::DepthResult& depth = *result.depth;
+        const PSFBinning& binning = result.psf->GetBinning();
+        const G4int numBins = binning.GetNumberOfBins();
+        const G4int numPoints = result.psf->GetNumberOfPoints();
+        const G4int numDepthBins = depth.numDepthBins;
+        const G4double depthWidth = depth.depthRange / numDepthBins;
+
+        py::array_t<G4double> density({ numPoints, numBins, numDepthBins });
+        auto out = density.mutable_unchecked<3>();
+        for (G4int point = 0; point < numPoints; point++) {
+            const G4double events = depth.events[point];
+            for (G4int i = 0; i < numBins; i++) {
+                G4double volume = binning.GetArea(i) * depthWidth / (nm * nm * nm);
+                for (G4int j = 0; j < numDepthBins; j++) {
+                    G4double energy = depth.sum[(static_cast<size_t>(point) * numBins + i) * numDepthBins + j];
+                    out(point, i, j) = events > 0 ? energy / eV / volume / events : 0.;
+                }
+            }
+        }
+        return std::move(density);
+    }
+}
+
+PYBIND11_MODULE(ebl, m)
+{
+    m.doc() =
+        "In-process EBL PSF simulations: the ebl_sim set-up kept alive between runs.\n\n"
+        "Raw tallies are returned as read-only NumPy views of the C++ buffers, in\n"
+        "Geant4 internal units (mm, MeV); divide by ebl.nm, ebl.eV, ... to convert.";
+
+    m.attr("nm") = nm;
+    m.attr("um") = micrometer;
+    m.attr("mm") = mm;
+    m.attr("eV") = eV;
+    m.attr("keV") = keV;
+    m.attr("MeV") = MeV;
+
+    m.def("flush", []() {
+        py::gil_scoped_release release;
+        AsyncWriter::Instance()->Flush();
+    }, "Wait until the queued output files are written (done at exit as well)");
+
+    py::class_<Result>(m, "Result", "PSF tallies of one run (all sweep points)")
+        .def_property_readonly("n_points", [](const Result& r) { return r.psf->GetNumberOfPoints(); })
+        .def_property_readonly("n_bins", [](const Result& r) { return r.psf->GetBinning().GetNumberOfBins(); })
+        .def_property_readonly("binning", [](const Result& r) {
+            return PSFBinning::ModeName(r.psf->GetBinning().GetMode());
+        })
+        .def_property_readonly("edges", [](const Result& r) {
+            const std::vector<G4double>& edges = r.psf->GetBinning().GetEdges();
+            return View(edges, { static_cast<py::ssize_t>(edges.size()) }, r.psf);
+        }, "Radial bin edges (mm), shape (n_bins + 1,)")
+        .def_property_readonly("radius_nm", [](const Result& r) {
+            const PSFBinning& binning = r.psf->GetBinning();
+            py::array_t<G4double> centers(binning.GetNumberOfBins());
+            auto out = centers.mutable_unchecked<1>();
+            for (G4int i = 0; i < binning.GetNumberOfBins(); i++) out(i) = binning.GetCenter(i) / nm;
+            return centers;
+        }, "Bin centres (nm), a copy")
+        .def_property_readonly("beam_energies", [](const Result& r) {
+            const std::vector<G4double>& energies = r.psf->GetBeamEnergies();
+            return View(energies, { static_cast<py::ssize_t>(energies.size()) }, r.psf);
+        }, "Beam energy of each sweep point (MeV)")
+        .def_property_readonly("events", [](const Result& r) {
+            const std::vector<G4long>& events = r.psf->GetEventCounts();
+            return View(events, { static_cast<py::ssize_t>(events.size()) }, r.psf);
+        }, "Primaries per sweep point")
+        .def_property_readonly("sum", [](const Result& r) {
+            return View(r.psf->GetSums(), { r.psf->GetNumberOfPoints(), r.psf->GetBinning().GetNumberOfBins() }, r.psf);
+        }, "Sum of the per-event deposits (MeV), shape (n_points, n_bins)")
+        .def_property_readonly("sum_squares", [](const Result& r) {
+            return View(r.psf->GetSumSquares(), { r.psf->GetNumberOfPoints(), r.psf->GetBinning().GetNumberOfBins() }, r.psf);
+        }, "Sum of the squared per-event deposits (MeV^2)")
+        .def_property_readonly("hits", [](const Result& r) {
+            return View(r.psf->GetHitCounts(), { r.psf->GetNumberOfPoints(), r.psf->GetBinning().GetNumberOfBins() }, r.psf);
+        }, "Events that deposited in each bin")
+        .def_property_readonly("depth_sum", [](const Result& r) -> py::object {
+            if (!r.depth) return py::none();
+            return View(r.depth->sum, { r.psf->GetNumberOfPoints(), r.psf->GetBinning().GetNumberOfBins(),
+                                        r.depth->numDepthBins }, r.depth);
+        }, "Sum of the deposits (MeV) per (point, radial bin, depth bin); None without /ebl/psf/depth")
+        .def_property_readonly("depth_events", [](const Result& r) -> py::object {
+            if (!r.depth) return py::none();
+            return py::cast(r.depth->events);
+        }, "Primaries in the depth tallies per sweep point")
+        .def_property_readonly("depth_range", [](const Result& r) -> py::object {
+            if (!r.depth) return py::none();
+            return py::float_(r.depth->depthRange);
+        }, "Thickness spanned by the depth bins (mm)")
+        .def_property_readonly("seed", [](const Result& r) { return r.psf->GetSeed(); })
+        .def_property_readonly("weighted", [](const Result& r) { return r.psf->IsWeighted(); })
+        .def("energy_density", [](const Result& r) { return EnergyDensity(*r.psf); },
+             "Energy density per event (eV/nm^2) of each (point, bin), as the CSV export")
+        .def("relative_error", [](const Result& r) { return RelativeError(*r.psf); },
+             "Relative standard error of the mean deposit per event (inf for empty bins)")
+        .def("depth_density", &DepthDensity,
+             "Energy density per event (eV/nm^3) of each (point, radial bin, depth bin), as the 2D export")
+        .def("write", [](const Result& r, const std::string& path) {
+            if (!r.psf->Write(path)) throw std::runtime_error("cannot write " + path);
+        }, py::arg("path"), "Write the binary PSF result file (scripts/gui/psf_result.py reads it)");
+
+    py::class_<Simulation, std::unique_ptr<Simulation, py::nodelete>>(m, "Simulation",
+        "The ebl_sim geometry, physics and actions on one Geant4 run manager (one per process).\n"
+        "Configure it with the macro commands (command) or the set_ helpers; the first run\n"
+        "initializes it.")
+        .def(py::init([](G4int threads, std::optional<std::uint64_t> seed,
+                         const std::string& runManager, const std::string& scoring) {
+            Simulation::Options options;
+            options.threads = threads;
+            options.seedGiven = seed.has_value();
+            options.seed = seed.value_or(0);
+            options.runManager = runManager;
+            options.scoring = scoring;
+            G4String error;
+            Simulation* simulation = Simulation::Create(options, error);
+            if (!simulation) throw std::runtime_error(error);
+            return std::unique_ptr<Simulation, py::nodelete>(simulation);
+        }), py::arg("threads") = 0, py::arg("seed") = py::none(),
+            py::arg("run_manager") = "tasking", py::arg("scoring") = "radial")
+        .def_static("instance", []() { return Simulation::Instance(); },
+                    py::return_value_policy::reference, "The existing Simulation, or None")
+        .def_property_readonly("threads", &Simulation::GetThreads)
+        .def_property_readonly("seed", &Simulation::GetSeed)
+        .def_property_readonly("initialized", &Simulation::IsInitialized)
+        .def("command", &Apply, py::arg("command"), "Apply a macro command, e.g. '/ebl/psf/nBins 200'")
+        .def("set_resist", [](Simulation& s, std::optional<G4double> thicknessNm,
+                              std::optional<G4double> density, std::optional<std::string> composition) {
+            if (thicknessNm) Apply(s, "/det/setResistThickness " + Number(*thicknessNm) + " nm");
+            if (density) Apply(s, "/det/setResistDensity " + Number(*density) + " g/cm3");
+            if (composition) Apply(s, "/det/setResistComposition " + *composition);
+            if (s.IsInitialized()) Apply(s, "/det/update");
+        }, py::kw_only(), py::arg("thickness_nm") = py::none(), py::arg("density_g_cm3") = py::none(),
+            py::arg("composition") = py::none(), "Resist layer, e.g. composition='Al:1,C:5,H:4,O:2'")
+        .def("set_beam", [](Simulation& s, std::optional<G4double> energyKeV,
+                            std::optional<G4double> sizeNm, std::optional<std::string> particle) {
+            if (particle) Apply(s, "/gun/particle " + *particle);
+            if (energyKeV) Apply(s, "/gun/energy " + Number(*energyKeV) + " keV");
+            if (sizeNm) Apply(s, "/gun/beamSize " + Number(*sizeNm) + " nm");
+        }, py::kw_only(), py::arg("energy_kev") = py::none(), py::arg("size_nm") = py::none(),
+            py::arg("particle") = py::none(), "Beam energy, spot size (FWHM) and particle")
+        .def("set_physics", [](Simulation& s, std::optional<std::string> preset, std::optional<G4bool> fluo,
+                               std::optional<G4bool> auger, std::optional<G4bool> pixe) {
+            if (preset) Apply(s, "/process/em/preset " + *preset);
+            if (fluo) Apply(s, std::string("/process/em/fluo ") + (*fluo ? "1" : "0"));
+            if (auger) Apply(s, std::string("/process/em/auger ") + (*auger ? "1" : "0"));
+            if (pixe) Apply(s, std::string("/process/em/pixe ") + (*pixe ? "true" : "false"));
+        }, py::kw_only(), py::arg("preset") = py::none(), py::arg("fluo") = py::none(),
+            py::arg("auger") = py::none(), py::arg("pixe") = py::none(),
+            "EM physics; the preset (livermore, hybrid, fast) only before the first run")
+        .def("set_binning", [](Simulation& s, std::optional<std::string> mode, std::optional<G4int> bins,
+                               std::optional<G4double> minRadiusNm, std::optional<G4double> maxRadiusNm,
+                               std::optional<G4bool> depth, std::optional<G4int> depthBins) {
+            if (mode) Apply(s, "/ebl/psf/binning " + *mode);
+            if (bins) Apply(s, "/ebl/psf/nBins " + std::to_string(*bins));
+            if (minRadiusNm) Apply(s, "/ebl/psf/minRadius " + Number(*minRadiusNm) + " nm");
+            if (maxRadiusNm) Apply(s, "/ebl/psf/maxRadius " + Number(*maxRadiusNm) + " nm");
+            if (depth) Apply(s, std::string("/ebl/psf/depth ") + (*depth ? "true" : "false"));
+            if (depthBins) Apply(s, "/ebl/psf/depthBins " + std::to_string(*depthBins));
+        }, py::kw_only(), py::arg("mode") = py::none(), py::arg("n_bins") = py::none(),
+            py::arg("min_radius_nm") = py::none(), py::arg("max_radius_nm") = py::none(),
+            py::arg("depth") = py::none(), py::arg("depth_bins") = py::none(),
+            "Radial (log or linear) and depth binning of the next run")
+        .def("set_output", [](Simulation& s, std::optional<std::string> directory,
+                              std::optional<G4bool> async) {
+            if (directory) Apply(s, "/ebl/output/setDirectory " + *directory);
+            if (async) Apply(s, std::string("/ebl/output/async ") + (*async ? "true" : "false"));
+        }, py::kw_only(), py::arg("directory") = py::none(), py::arg("async_write") = py::none(),
+            "Where the runs write their output files, and whether in the background")
+        .def("run", [](Simulation& s, G4int events, std::optional<G4int> threads) {
+            SetThreads(s, threads);
+            return RunWithoutGIL(s, [&]() { return s.Run(events); });
+        }, py::arg("n_events"), py::arg("threads") = py::none(),
+            "One run (/run/beamOn); returns its Result, None if it wrote no PSF")
+        .def("sweep", [](Simulation& s, const std::vector<G4double>& energiesKeV, G4int events,
+                         std::optional<G4int> threads) {
+            if (energiesKeV.empty()) throw std::invalid_argument("no sweep energies");
+            SetThreads(s, threads);
+            std::vector<G4double> energies;
+            for (G4double energy : energiesKeV) energies.push_back(energy * keV);
+            return RunWithoutGIL(s, [&]() { return s.Sweep(energies, events); });
+        }, py::arg("energies_kev"), py::arg("n_events"), py::arg("threads") = py::none(),
+            "One run over several beam energies (/ebl/sweep/energies, cleared afterwards)")
+        .def("converge", [](Simulation& simulation, G4double targetError, std::optional<G4double> minRadiusNm,
+                            std::optional<G4double> maxRadiusNm, std::optional<G4int> batchSize,
+                            std::optional<G4long> maxEvents, std::optional<G4double> maxTime,
+                            std::optional<G4int> threads) {
+            ConvergenceControl* control = ConvergenceControl::Instance();
+            control->SetTargetError(targetError);
+            if (minRadiusNm || maxRadiusNm) {
+                control->SetRadiusRange(minRadiusNm ? *minRadiusNm * nm : control->GetMinRadius(),
+                                        maxRadiusNm ? *maxRadiusNm * nm : control->GetMaxRadius());
+            }
+            if (batchSize) control->SetBatchSize(*batchSize);
+            if (maxEvents) control->SetMaxEvents(*maxEvents);
+            if (maxTime) control->SetMaxTime(*maxTime * s);
+            SetThreads(simulation, threads);
+            return RunWithoutGIL(simulation, [&]() { return simulation.Converge(); });
+        }, py::arg("target_error"), py::kw_only(), py::arg("min_radius_nm") = py::none(),
+            py::arg("max_radius_nm") = py::none(), py::arg("batch_size") = py::none(),
+            py::arg("max_events") = py::none(), py::arg("max_time_s") = py::none(),
+            py::arg("threads") = py::none(),
+            "Batches until every bin in the radius range reaches the target relative error\n"
+            "(/ebl/run/converge), or the event or time budget is used up");
+
+    // Queued output files are written before the interpreter exits
+    py::module_::import("atexit").attr("register")(py::cpp_function([]() {
+        py::gil_scoped_release release;
+        AsyncWriter::Instance()->Flush();
+    }));
+}
@@ -0,0 +1,185 @@
+// Simulation.cc - In-process ebl_sim set-up for the Python module
+#include "Simulation.hh"
+#include "DetectorConstruction.hh"
+#include "ActionInitialization.hh"
+#include "ScoringPipeline.hh"
+#include "PhysicsList.hh"
+#include "DataManager.hh"
+#include "PerfMonitor.hh"
+#include "TraceRecorder.hh"
+#include "ImportanceBiasing.hh"
+#include "BackscatterFastSim.hh"
+#include "ParameterSweep.hh"
+#include "ConvergenceControl.hh"
+#include "ShotList.hh"
+#include "ResultLibrary.hh"
+#include "PhaseSpace.hh"
+#include "PhysicsTableCache.hh"
+#include "DistributedRun.hh"
+#include "MasterSeed.hh"
+
+#include "G4RunManager.hh"
+#include "G4RunManagerFactory.hh"
+#include "G4MTRunManager.hh"
+#include "G4StateManager.hh"
+#include "G4Threading.hh"
+#include "G4UImanager.hh"
+#include "Randomize.hh"
+#include <ctime>
+
+namespace {
+    G4bool ParseRunManager(const G4String& name, G4RunManagerType& type)
+    {
+        if (name == "tasking") type = G4RunManagerType::Tasking;
+        else if (name == "mt") type = G4RunManagerType::MT;
+        else if (name == "serial") type = G4RunManagerType::SerialOnly;
+        else return false;
+        return true;
+    }
+}
+
+Simulation* Simulation::fInstance = nullptr;
+
+Simulation* Simulation::Create(const Options& options, G4String& error)
+{
+    G4RunManagerType type;
+    Scoring::Mode mode;
+    if (fInstance) {
+        error = "a Simulation exists already (one Geant4 run manager per process)";
+    }
+    else if (!ParseRunManager(options.runManager, type)) {
+        error = "unknown run manager " + options.runManager + " (tasking, mt or serial)";
+    }
+    else if (!Scoring::ParseMode(options.scoring, mode)) {
+        error = "unknown scoring mode " + options.scoring;
+    }
+    else if (options.threads < 0) {
+        error = "the thread count must not be negative";
+    }
+    else {
+        fInstance = new Simulation(options);
+    }
+    return fInstance && error.empty() ? fInstance : nullptr;
+}
+
+Simulation::Simulation(const Options& options)
+    : fRunManager(nullptr),
+    fSeed(options.seed),
+    fThread(std::this_thread::get_id())
+{
+    // As in ebl_sim's main, with no macro, UI session or visualization
+    TraceRecorder::Instance();
+
+    Scoring::Mode mode;
+    Scoring::ParseMode(options.scoring, mode);
+    Scoring::SetMode(mode);
+
+    G4RunManagerType type;
+    ParseRunManager(options.runManager, type);
+    G4int threads = options.threads > 0 ? options.threads : G4Threading::G4GetNumberOfCores();
+    if (threads == 1 && type != G4RunManagerType::SerialOnly) {
+        type = G4RunManagerType::Serial;
+    }
+
+    CLHEP::HepRandom::setTheEngine(new CLHEP::RanecuEngine());
+    if (!options.seedGiven) {
+        fSeed = static_cast<std::uint64_t>(time(NULL));
+    }
+    MasterSeed::Apply(fSeed, DistributedRun::Instance()->GetRank());
+    DataManager::Instance()->SetRunSeed(static_cast<G4long>(fSeed));
+    G4cout << "====> Random seed: " << fSeed
+        << (options.seedGiven ? "" : " (time-based, pass seed= to reproduce)") << G4endl;
+
+    fRunManager = G4RunManagerFactory::CreateRunManager(type, threads);
+    if (auto* mtRunManager = dynamic_cast<G4MTRunManager*>(fRunManager)) {
+        // Seeds per event, as in ebl_sim
+        mtRunManager->SetSeedOncePerCommunication(0);
+    }
+
+    PerfMonitor::Instance();
+    ImportanceBiasing::Instance();
+    BackscatterFastSim::Instance();
+    ParameterSweep::Instance();
+    PhysicsTableCache::Instance();
+    ConvergenceControl::Instance();
+    ShotList::Instance();
+    ResultLibrary::Instance();
+    PhaseSpace::Instance();
+
+    DetectorConstruction* detConstruction = new DetectorConstruction();
+    fRunManager->SetUserInitialization(detConstruction);
+    fRunManager->SetUserInitialization(new PhysicsList());
+    fRunManager->SetUserInitialization(new ActionInitialization(detConstruction));
+}
+
+G4int Simulation::ApplyCommand(const G4String& command)
+{
+    return G4UImanager::GetUIpointer()->ApplyCommand(command);
+}
+
+G4bool Simulation::IsInitialized() const
+{
+    return G4StateManager::GetStateManager()->GetCurrentState() != G4State_PreInit;
+}
+
+G4bool Simulation::SetThreads(G4int threads)
+{
+    if (threads <= 0 || threads == GetThreads()) return true;
+    auto* mtRunManager = dynamic_cast<G4MTRunManager*>(fRunManager);
+    if (!mtRunManager || IsInitialized()) return false;
+    mtRunManager->SetNumberOfThreads(threads);
+    return true;
+}
+
+G4int Simulation::GetThreads() const
+{
+    auto* mtRunManager = dynamic_cast<G4MTRunManager*>(fRunManager);
+    return mtRunManager ? mtRunManager->GetNumberOfThreads() : 1;
+}
+
+void Simulation::Initialize()
+{
+    // Deferred to the first run, so PreInit-only commands (e.g.
+    // /process/em/preset) can still be given after Create
+    if (!IsInitialized()) {
+        fRunManager->Initialize();
+    }
+}
+
+RunAction::ResultSnapshot Simulation::Run(G4int events)
+{
+    Initialize();
+    fRunManager->BeamOn(events);
+    const RunAction* runAction = GetMasterRunAction();
+    return runAction ? runAction->GetLastResult() : nullptr;
+}
+
+RunAction::ResultSnapshot Simulation::Sweep(const std::vector<G4double>& energies, G4int events)
+{
+    ParameterSweep* sweep = ParameterSweep::Instance();
+    sweep->SetEnergies(energies);
+    sweep->Print();
+    RunAction::ResultSnapshot result = Run(events);
+    sweep->Clear();
+    return result;
+}
+
+RunAction::ResultSnapshot Simulation::Converge()
+{
+    Initialize();
+    ConvergenceControl::Instance()->Run();
+    const RunAction* runAction = GetMasterRunAction();
+    return runAction ? runAction->GetLastResult() : nullptr;
+}
+
+RunAction::DepthSnapshot Simulation::GetDepthResult() const
+{
+    const RunAction* runAction = GetMasterRunAction();
+    return runAction ? runAction->GetLastDepthResult() : nullptr;
+}
+
+const RunAction* Simulation::GetMasterRunAction() const
+{
+    // The master's own run action (ActionInitialization::BuildForMaster)
+    return dynamic_cast<const RunAction*>(fRunManager->GetUserRunAction());
+}